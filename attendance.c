@@ -0,0 +1,561 @@
+/**
+ * @file attendance.c
+ * @brief This file contains the implementation of the attendance import from clock-in logs.
+ *
+ * The log is read in ATTENDANCE_BLOCK_SIZE blocks; the bytes after the last newline of a
+ * block are moved to the front and completed by the next read. Each event is parsed in place,
+ * its employee is found through a hash index of the stored IDs (the previous ID is checked
+ * first, since logs usually list the events of one badge or one door together) and its day
+ * is added to two bit masks of that employee.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdio.h>              /* Include standard input and output library for printf, FILE, ... */
+#include <stdlib.h>             /* Include standard library for malloc, calloc, free */
+#include <string.h>             /* Include string manipulation library for memchr, memcpy, memmove, strcmp */
+#include "attendance.h"         /* Include header file */
+#include "input_handler.h"      /* Include input handler header file for handling user input */
+#include "id_index.h"           /* Include ID index header file for looking employees up by ID */
+#include "perf_stats.h"         /* Include instrumentation header file for measuring hot operations */
+#include "change_feed.h"        /* Include change feed header file for committing the attendance as one operation */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define ATTENDANCE_BLOCK_SIZE (1u << 20)    /* Bytes read from the log at a time, longer lines are rejected */
+#define ATTENDANCE_SECONDS_PER_DAY 86400u   /* Seconds in a day */
+#define ATTENDANCE_NO_EMPLOYEE 0xFFFFFFFFu  /* Position of an ID that is not stored */
+#define ATTENDANCE_BATCH 32u                /* Events looked up together, so their cache misses overlap */
+
+/**
+ * @brief Days of the month of one employee.
+ */
+typedef struct AttendanceDays {
+    uint32_t present;                       /* Bit d - 1 set if the employee came in on day d */
+    uint32_t on_time;                       /* Bit d - 1 set if an event of day d is not late */
+} AttendanceDays_t;
+
+/**
+ * @brief Event of the month waiting for its employee to be looked up.
+ */
+typedef struct AttendanceEvent {
+    int8_t id[MAX_ID_LENGTH];               /* Employee ID of the event */
+    uint32_t hash;                          /* Hash of id in the ID index */
+    uint32_t position;                      /* Store position of the employee, ATTENDANCE_NO_EMPLOYEE if not stored */
+    uint32_t day_bit;                       /* Bit of the day of the event */
+    uint32_t on_time;                       /* 1 if the event is not after the cutoff */
+} AttendanceEvent_t;
+
+/**
+ * @brief State of an attendance import.
+ */
+typedef struct AttendanceState {
+    const AttendanceConfig_t *config;       /* Month to aggregate and lateness cutoff */
+    AttendanceReport_t *report;             /* Report being filled */
+    IdIndex_t employee_ids;                 /* Index from employee IDs to store positions */
+    AttendanceDays_t *days;                 /* Days of every stored employee */
+    AttendanceEvent_t pending[ATTENDANCE_BATCH];   /* Events not yet added to their employee */
+    uint32_t pending_count;                 /* Number of events in pending */
+} AttendanceState_t;
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static void addLine(AttendanceState_t *state, const int8_t *line, uint32_t length, uint64_t line_number);
+static void addPendingEvents(AttendanceState_t *state);
+static void rejectLine(AttendanceReport_t *report, uint64_t line_number);
+static uint32_t parseTimestamp(const int8_t *text, uint32_t length, uint32_t *year, uint32_t *month,
+                               uint32_t *day, uint32_t *seconds);
+static uint32_t parseClock(const int8_t *text, uint32_t length, uint32_t *seconds);
+static uint32_t parseDigits(const int8_t *text, uint32_t count, uint32_t *value);
+static uint32_t daysInMonth(uint32_t year, uint32_t month);
+static const int8_t* storedEmployeeKey(uint32_t value, const void *context);
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Sets the working days and late coming days of every stored employee from a clock-in log.
+ */
+ManageStatus_t importAttendanceLog(const char *path, const AttendanceConfig_t *config, AttendanceReport_t *report)
+{
+    AttendanceReport_t unused_report;       /* Report used when the caller does not want one */
+    AttendanceState_t state;                /* Masks and index of the import */
+    FILE *file = NULL;                      /* The log file */
+    int8_t *block = NULL;                   /* Bytes read from the log */
+    const int8_t *newline = NULL;           /* End of the current line */
+    uint32_t employee_count = getTotalEmployees();     /* Number of stored employees */
+    uint32_t fill = 0;                      /* Bytes in block */
+    uint32_t start = 0;                     /* Start of the current line in block */
+    uint32_t read_bytes = 0;                /* Bytes returned by the last read */
+    uint32_t skipping = 0;                  /* Flag set while skipping the rest of a line longer than a block */
+    uint64_t line_number = 0;               /* Number of the current line */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the import */
+    uint32_t i = 0;                         /* Index for looping through employees */
+    PERF_START(perf_start);                 /* Start time of the import */
+
+    if (report == NULL)
+    {
+        report = &unused_report;
+    }
+    memset(report, 0, sizeof(*report));
+    if (config == NULL || config->year == 0 || config->month < 1 || config->month > 12
+        || config->cutoff_seconds >= ATTENDANCE_SECONDS_PER_DAY)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+
+    memset(&state, 0, sizeof(state));
+    state.config = config;
+    state.report = report;
+    idIndexInit(&state.employee_ids, storedEmployeeKey, NULL);
+    state.days = calloc((size_t)employee_count + 1, sizeof(*state.days));
+    block = malloc(ATTENDANCE_BLOCK_SIZE);
+    if (state.days == NULL || block == NULL
+        || idIndexReserve(&state.employee_ids, employee_count) != MANAGE_OK)
+    {
+        status = MANAGE_ERR_NO_MEMORY;
+    }
+    for (i = 0; i < employee_count && status == MANAGE_OK; i++)
+    {
+        status = idIndexInsert(&state.employee_ids, getEmployeeAt(i)->id, i);
+    }
+    if (status == MANAGE_OK)
+    {
+        file = fopen(path, "rb");
+        if (file == NULL)
+        {
+            status = MANAGE_ERR_IO;
+        }
+    }
+
+    while (status == MANAGE_OK)
+    {
+        read_bytes = (uint32_t)fread(block + fill, 1, ATTENDANCE_BLOCK_SIZE - fill, file);
+        fill += read_bytes;
+        start = 0;
+        while ((newline = memchr(block + start, '\n', fill - start)) != NULL)
+        {
+            line_number += 1;
+            if (skipping == 1)
+            {
+                /* End of a line longer than a block */
+                rejectLine(report, line_number);
+                skipping = 0;
+            }
+            else
+            {
+                addLine(&state, block + start, (uint32_t)(newline - (block + start)), line_number);
+            }
+            start = (uint32_t)(newline - block) + 1;
+        }
+
+        if (read_bytes == 0)
+        {
+            /* Last line without a newline */
+            if (start < fill || skipping == 1)
+            {
+                line_number += 1;
+                if (skipping == 1)
+                {
+                    rejectLine(report, line_number);
+                }
+                else
+                {
+                    addLine(&state, block + start, fill - start, line_number);
+                }
+            }
+            addPendingEvents(&state);
+            if (ferror(file))
+            {
+                status = MANAGE_ERR_IO;
+            }
+            break;
+        }
+        if (start == 0 && fill == ATTENDANCE_BLOCK_SIZE)
+        {
+            /* No newline in a whole block: drop the line up to its newline */
+            skipping = 1;
+            fill = 0;
+        }
+        else
+        {
+            memmove(block, block + start, fill - start);
+            fill -= start;
+        }
+    }
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+    report->lines = line_number;
+
+    if (status == MANAGE_OK)
+    {
+        /* The whole log is read, the store can be changed */
+        for (i = 0; i < employee_count; i++)
+        {
+            setEmployeeAttendance(i, (uint32_t)__builtin_popcount(state.days[i].present),
+                                  (uint32_t)__builtin_popcount(state.days[i].present & ~state.days[i].on_time));
+            if (state.days[i].present != 0)
+            {
+                report->employees_present += 1;
+            }
+        }
+        report->employees_absent = employee_count - report->employees_present;
+        /* Every employee of the log is one operation of the change feed */
+        changeFeedCommit();
+    }
+
+    idIndexFree(&state.employee_ids);
+    free(state.days);
+    free(block);
+    PERF_STOP(PERF_OP_IMPORT_ATTENDANCE, perf_start);
+    return status;
+}
+
+
+/**
+ * @brief Prompts the user for a clock-in log, a month and a cutoff, and imports the attendance.
+ */
+void importAttendance()
+{
+    char path[260];                         /* File name entered by the user */
+    int8_t buffer[32];                      /* Cutoff entered by the user */
+    AttendanceConfig_t config;              /* Month and cutoff */
+    AttendanceReport_t report;              /* Result of the import */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the import */
+    uint32_t valid = 0;                     /* Flag set when the cutoff is valid */
+
+    if (getTotalEmployees() == 0)
+    {
+        printf("No employee to update attendance!!!\n");
+        return;
+    }
+    do
+    {
+        printf("Enter clock-in log file name: ");
+        fflush(stdin);
+        if (fgets(path, sizeof(path), stdin) == NULL)
+        {
+            return;
+        }
+        /* Remove newline character, spaces are allowed in file names */
+        path[strcspn(path, "\r\n")] = '\0';
+        if (path[0] == '\0')
+        {
+            printf("\nYou must not leave blank this information ...\n");
+            printf("\nPlease enter again ...\n");
+        }
+    } while (path[0] == '\0');
+
+    config.year = (uint16_t)promptUnsignedInput("Enter year: ", 9999);
+    do
+    {
+        config.month = (uint8_t)promptUnsignedInput("Enter month (1-12): ", 12);
+    } while (config.month == 0);
+    do
+    {
+        printf("Enter lateness cutoff HH:MM (empty for 08:00): ");
+        fflush(stdin);
+        if (fgets(buffer, sizeof(buffer), stdin) == NULL)
+        {
+            return;
+        }
+        buffer[strcspn(buffer, "\r\n")] = '\0';
+        config.cutoff_seconds = ATTENDANCE_DEFAULT_CUTOFF;
+        valid = (buffer[0] == '\0' || parseClock(buffer, (uint32_t)strlen(buffer), &config.cutoff_seconds) == 1) ? 1u : 0u;
+        if (valid == 0)
+        {
+            printf("You must enter a time such as 08:30 !!!\n");
+        }
+    } while (valid == 0);
+
+    status = importAttendanceLog(path, &config, &report);
+    if (status == MANAGE_ERR_IO)
+    {
+        printf("Cannot read file %s\n", path);
+        return;
+    }
+    if (status != MANAGE_OK)
+    {
+        printf("Not enough memory to import attendance!!!\n");
+        return;
+    }
+
+    printf("Read %s lines, ", formatNumberWithCommas(report.lines));
+    printf("%s events counted.\n", formatNumberWithCommas(report.events));
+    printf("Updated %u employees, %u employees without any event now have 0 working days.\n",
+           report.employees_present, report.employees_absent);
+    if (report.other_month > 0)
+    {
+        printf("Ignored %s events outside %02u/%04u.\n", formatNumberWithCommas(report.other_month),
+               (uint32_t)config.month, (uint32_t)config.year);
+    }
+    if (report.unknown_employee > 0)
+    {
+        printf("Ignored %s events of unknown employees.\n", formatNumberWithCommas(report.unknown_employee));
+    }
+    if (report.rejected > 0)
+    {
+        printf("Skipped %s invalid lines", formatNumberWithCommas(report.rejected));
+        printf(" (first at line %llu).\n", (unsigned long long)report.first_rejected_line);
+    }
+}
+
+
+/**
+ * @brief Parses one line of the log and queues its event for its employee.
+ *
+ * @param state The import.
+ * @param line First character of the line.
+ * @param length Number of characters, without the newline.
+ * @param line_number Number of the line, starting at 1.
+ */
+static void addLine(AttendanceState_t *state, const int8_t *line, uint32_t length, uint64_t line_number)
+{
+    const int8_t *comma = NULL;             /* Separator between the ID and the timestamp */
+    const int8_t *stamp = NULL;             /* First character of the timestamp */
+    uint32_t id_length = 0;                 /* Number of characters of the ID */
+    uint32_t stamp_length = 0;              /* Number of characters of the timestamp */
+    uint32_t year = 0;                      /* Date and time of the event */
+    uint32_t month = 0;
+    uint32_t day = 0;
+    uint32_t seconds = 0;
+    AttendanceEvent_t *event = NULL;        /* Queued event */
+
+    /* Skip the blanks around the line */
+    while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == ' ' || line[length - 1] == '\t'))
+    {
+        length--;
+    }
+    while (length > 0 && (line[0] == ' ' || line[0] == '\t'))
+    {
+        line++;
+        length--;
+    }
+    if (length == 0 || line[0] == '#')
+    {
+        return;
+    }
+
+    comma = memchr(line, ',', length);
+    if (comma == NULL)
+    {
+        rejectLine(state->report, line_number);
+        return;
+    }
+    id_length = (uint32_t)(comma - line);
+    while (id_length > 0 && (line[id_length - 1] == ' ' || line[id_length - 1] == '\t'))
+    {
+        id_length--;
+    }
+    stamp = comma + 1;
+    stamp_length = length - (uint32_t)(stamp - line);
+    while (stamp_length > 0 && (stamp[0] == ' ' || stamp[0] == '\t'))
+    {
+        stamp++;
+        stamp_length--;
+    }
+
+    /* Header line */
+    if (line_number == 1 && ((id_length == 11 && memcmp(line, "employee_id", 11) == 0)
+                             || (id_length == 2 && memcmp(line, "id", 2) == 0)))
+    {
+        return;
+    }
+    if (id_length == 0 || parseTimestamp(stamp, stamp_length, &year, &month, &day, &seconds) == 0)
+    {
+        rejectLine(state->report, line_number);
+        return;
+    }
+    if (year != state->config->year || month != state->config->month)
+    {
+        state->report->other_month += 1;
+        return;
+    }
+
+    if (id_length >= MAX_ID_LENGTH)
+    {
+        /* Too long to be a stored ID */
+        state->report->unknown_employee += 1;
+        return;
+    }
+
+    event = &state->pending[state->pending_count];
+    memcpy(event->id, line, id_length);
+    event->id[id_length] = '\0';
+    event->day_bit = (uint32_t)1 << (day - 1);
+    event->on_time = (seconds <= state->config->cutoff_seconds) ? 1 : 0;
+    state->pending_count += 1;
+    if (state->pending_count == ATTENDANCE_BATCH)
+    {
+        addPendingEvents(state);
+    }
+}
+
+
+/**
+ * @brief Adds the queued events to the days of their employees.
+ *
+ * The batch is looked up in stages, each prefetching what the next one reads, so the cache
+ * misses of the ID index and of the day masks overlap instead of adding up.
+ */
+static void addPendingEvents(AttendanceState_t *state)
+{
+    AttendanceEvent_t *event = NULL;        /* Event being added */
+    AttendanceDays_t *days = NULL;          /* Days of the employee of the event */
+    uint32_t i = 0;                         /* Index for looping through the events */
+
+    for (i = 0; i < state->pending_count; i++)
+    {
+        event = &state->pending[i];
+        event->hash = idIndexHash(event->id);
+        idIndexPrefetch(&state->employee_ids, event->hash);
+    }
+    for (i = 0; i < state->pending_count; i++)
+    {
+        event = &state->pending[i];
+        if (idIndexFindHashed(&state->employee_ids, event->id, event->hash, &event->position) == 0)
+        {
+            event->position = ATTENDANCE_NO_EMPLOYEE;
+            continue;
+        }
+        __builtin_prefetch(&state->days[event->position], 1);
+    }
+    for (i = 0; i < state->pending_count; i++)
+    {
+        event = &state->pending[i];
+        if (event->position == ATTENDANCE_NO_EMPLOYEE)
+        {
+            state->report->unknown_employee += 1;
+            continue;
+        }
+        days = &state->days[event->position];
+        days->present |= event->day_bit;
+        if (event->on_time == 1)
+        {
+            days->on_time |= event->day_bit;
+        }
+        state->report->events += 1;
+    }
+    state->pending_count = 0;
+}
+
+
+/**
+ * @brief Counts a line that is not a valid event.
+ */
+static void rejectLine(AttendanceReport_t *report, uint64_t line_number)
+{
+    if (report->rejected == 0)
+    {
+        report->first_rejected_line = line_number;
+    }
+    report->rejected += 1;
+}
+
+
+/**
+ * @brief Parses "YYYY-MM-DD HH:MM" or "YYYY-MM-DD HH:MM:SS" ('T' may replace the space).
+ *
+ * @return 1 if the timestamp is a valid date and time, 0 otherwise.
+ */
+static uint32_t parseTimestamp(const int8_t *text, uint32_t length, uint32_t *year, uint32_t *month,
+                               uint32_t *day, uint32_t *seconds)
+{
+    if (length < 16 || text[4] != '-' || text[7] != '-' || (text[10] != ' ' && text[10] != 'T')
+        || parseDigits(text, 4, year) == 0 || parseDigits(text + 5, 2, month) == 0
+        || parseDigits(text + 8, 2, day) == 0)
+    {
+        return 0;
+    }
+    if (*year == 0 || *month < 1 || *month > 12 || *day < 1 || *day > daysInMonth(*year, *month))
+    {
+        return 0;
+    }
+    return parseClock(text + 11, length - 11, seconds);
+}
+
+
+/**
+ * @brief Parses a time of day "HH:MM" or "HH:MM:SS".
+ *
+ * @param text The time.
+ * @param length Number of characters.
+ * @param seconds Receives the number of seconds after midnight.
+ * @return 1 if the time is valid, 0 otherwise.
+ */
+static uint32_t parseClock(const int8_t *text, uint32_t length, uint32_t *seconds)
+{
+    uint32_t hours = 0;                     /* Parts of the time */
+    uint32_t minutes = 0;
+    uint32_t secs = 0;
+
+    if ((length != 5 && length != 8) || text[2] != ':' || parseDigits(text, 2, &hours) == 0
+        || parseDigits(text + 3, 2, &minutes) == 0)
+    {
+        return 0;
+    }
+    if (length == 8 && (text[5] != ':' || parseDigits(text + 6, 2, &secs) == 0))
+    {
+        return 0;
+    }
+    if (hours > 23 || minutes > 59 || secs > 59)
+    {
+        return 0;
+    }
+    *seconds = hours * 3600 + minutes * 60 + secs;
+    return 1;
+}
+
+
+/**
+ * @brief Parses a fixed number of decimal digits.
+ *
+ * @return 1 if every character is a digit, 0 otherwise.
+ */
+static uint32_t parseDigits(const int8_t *text, uint32_t count, uint32_t *value)
+{
+    uint32_t i = 0;                         /* Index for looping through digits */
+
+    *value = 0;
+    for (i = 0; i < count; i++)
+    {
+        if (text[i] < '0' || text[i] > '9')
+        {
+            return 0;
+        }
+        *value = *value * 10 + (uint32_t)(text[i] - '0');
+    }
+    return 1;
+}
+
+
+/**
+ * @brief Returns the number of days of a month of the Gregorian calendar.
+ */
+static uint32_t daysInMonth(uint32_t year, uint32_t month)
+{
+    static const uint8_t days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};  /* Days of each month */
+
+    if (month == 2 && (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)))
+    {
+        return 29;
+    }
+    return days[month - 1];
+}
+
+
+/**
+ * @brief Returns the ID of a stored employee for the employee index.
+ */
+static const int8_t* storedEmployeeKey(uint32_t value, const void *context)
+{
+    (void)context;
+    return getEmployeeAt(value)->id;
+} /* EOF */
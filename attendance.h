@@ -0,0 +1,85 @@
+/**
+ * @file attendance.h
+ * @brief This file contains the function prototypes for deriving attendance from clock-in logs.
+ *
+ * A clock-in log holds one badge event per line. The log is read once, in fixed-size blocks,
+ * and every event of the chosen month is added to its employee: one bit per day of the month
+ * records that the employee came in, and a second bit records that one of the day's events
+ * was not after the lateness cutoff. Repeated badges, late corrections and the order of the
+ * events therefore make no difference, and the memory used is 8 bytes per stored employee plus
+ * the ID index, whatever the number of events.
+ *
+ * When the whole log is read, every stored employee gets:
+ *     working_days      number of days with at least one event
+ *     late_coming_days  number of those days whose first event is after the cutoff
+ * Employees without any event in the month get 0 and 0.
+ *
+ * Log format (one event per line):
+ *     employee_id,YYYY-MM-DD HH:MM[:SS]
+ * The date and time may also be separated by 'T'. Blank lines and lines starting with '#'
+ * are ignored, and the first line is skipped if its first field is "employee_id" or "id".
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef ATTENDANCE_H
+#define ATTENDANCE_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for ManageStatus_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define ATTENDANCE_DEFAULT_CUTOFF (8u * 3600u)  /* Default lateness cutoff: 08:00:00, in seconds after midnight */
+
+/**
+ * @brief Month to aggregate and lateness rule.
+ */
+typedef struct AttendanceConfig {
+    uint16_t year;                          /* Year of the payroll, e.g. 2024 */
+    uint8_t month;                          /* Month of the payroll, 1 to 12 */
+    uint32_t cutoff_seconds;                /* A day is late if its first event is after this time of day */
+} AttendanceConfig_t;
+
+/**
+ * @brief Result of an attendance import.
+ */
+typedef struct AttendanceReport {
+    uint64_t lines;                         /* Number of lines in the log */
+    uint64_t events;                        /* Events of the month counted for a stored employee */
+    uint64_t other_month;                   /* Valid events outside the month, ignored */
+    uint64_t unknown_employee;              /* Events of IDs that are not stored, ignored */
+    uint64_t rejected;                      /* Lines that are not a valid event */
+    uint64_t first_rejected_line;           /* Line number of the first rejected line, 0 if none */
+    uint32_t employees_present;             /* Stored employees with at least one event */
+    uint32_t employees_absent;              /* Stored employees without any event, set to 0 days */
+} AttendanceReport_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Sets the working days and late coming days of every stored employee from a clock-in log.
+ *
+ * The store is only changed once the whole log has been read, so a log that cannot be read
+ * leaves every employee as it was.
+ *
+ * @param path The log file.
+ * @param config Month to aggregate and lateness cutoff.
+ * @param report Receives the counts of the import (may be NULL).
+ * @return MANAGE_OK, MANAGE_ERR_INVALID_ARGUMENT if the month or the cutoff is not valid,
+ *         MANAGE_ERR_IO if the file cannot be read, or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t importAttendanceLog(const char *path, const AttendanceConfig_t *config, AttendanceReport_t *report);
+
+/**
+ * @brief Prompts the user for a clock-in log, a month and a cutoff, and imports the attendance.
+ */
+void importAttendance();
+
+#endif /* ATTENDANCE_H */
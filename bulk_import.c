@@ -0,0 +1,1333 @@
+/**
+ * @file bulk_import.c
+ * @brief This file contains the implementation of the parallel CSV import.
+ *
+ * Pipeline:
+ *     reader thread   reads IMPORT_CHUNK_SIZE bytes, cuts after the last newline and carries
+ *                     the rest over to the next chunk
+ *     worker threads  parse and validate whole chunks into Employee_t / Department_t arrays
+ *     calling thread  merges parsed chunks in file order, detects duplicate IDs and adds the
+ *                     accepted employees to the store IMPORT_COMMIT_ROWS at a time
+ * Chunks live in a ring of slots. The reader waits when the ring is full, so the memory used
+ * by raw and parsed chunks that are not merged yet stays bounded; accepted employees are only
+ * held until their batch is added, except those whose department is declared further down the
+ * file. If the import fails, the batches already added are deleted again. One mutex and one condition
+ * variable guard the ring; they are taken once per chunk, never per line.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdio.h>              /* Include standard input and output library for printf, FILE, ... */
+#include <stdlib.h>             /* Include standard library for malloc, realloc, free */
+#include <string.h>             /* Include string manipulation library for memcpy, memset, strcspn */
+#include <pthread.h>            /* Include POSIX threads library for the pipeline threads */
+#include "bulk_import.h"        /* Include header file */
+#include "input_handler.h"      /* Include input handler header file for the field parsers */
+#include "id_index.h"           /* Include ID index header file for duplicate detection */
+#include "perf_stats.h"         /* Include instrumentation header file for measuring hot operations */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define IMPORT_CHUNK_SIZE (4u << 20)        /* Bytes read per chunk, a chunk grows if a line is longer */
+#define IMPORT_SLOTS_PER_THREAD 2           /* Chunks in flight per worker thread */
+#define IMPORT_EMPLOYEE_FIELDS 8            /* Number of fields of an employee line */
+#define IMPORT_DEPARTMENT_FIELDS 2          /* Number of fields of a department line */
+#define IMPORT_MAX_FIELD 256                /* Largest quoted field, after removing the quotes */
+#define IMPORT_COMMIT_ROWS 16384u           /* Accepted employees added to the store at a time */
+
+/**
+ * @brief State of a slot of the chunk ring.
+ */
+typedef enum ChunkState {
+    CHUNK_FREE = 0,                         /* No chunk */
+    CHUNK_READ,                             /* Read, waiting for or being parsed by a worker */
+    CHUNK_PARSED                            /* Parsed, waiting to be merged */
+} ChunkState_t;
+
+/**
+ * @brief A newline-aligned part of the file and the records parsed from it.
+ */
+typedef struct ImportChunk {
+    int8_t *text;                           /* Raw bytes of the chunk */
+    uint32_t length;                        /* Number of raw bytes */
+    uint64_t sequence;                      /* Position of the chunk in the file */
+    uint32_t line_count;                    /* Number of lines in the chunk */
+    Employee_t *employees;                  /* Valid employee lines */
+    uint32_t *employee_lines;               /* Line of each employee, counted from the chunk start */
+    uint32_t employee_count;                /* Number of employees */
+    uint32_t employee_capacity;             /* Number of allocated employees */
+    Department_t *departments;              /* Valid department lines */
+    uint32_t *department_lines;             /* Line of each department, counted from the chunk start */
+    uint32_t department_count;              /* Number of departments */
+    uint32_t department_capacity;           /* Number of allocated departments */
+    ImportError_t errors[IMPORT_MAX_ERRORS];/* First errors of the chunk, lines counted from the chunk start */
+    uint32_t error_count;                   /* Number of entries in errors */
+    uint64_t rejected;                      /* Number of rejected lines */
+    uint32_t out_of_memory;                 /* Flag set if parsing ran out of memory */
+} ImportChunk_t;
+
+/**
+ * @brief State shared by the pipeline threads.
+ */
+typedef struct ImportPipeline {
+    pthread_mutex_t lock;                   /* Guards every field below */
+    pthread_cond_t changed;                 /* Signalled whenever a field below changes */
+    FILE *file;                             /* The CSV file, used by the reader only */
+    ImportChunk_t **slots;                  /* Ring of chunks, indexed by sequence % window */
+    ChunkState_t *states;                   /* State of every slot */
+    uint32_t window;                        /* Number of slots */
+    uint64_t read_count;                    /* Number of chunks read */
+    uint64_t next_to_parse;                 /* Sequence of the next chunk a worker takes */
+    uint64_t merged_count;                  /* Number of chunks merged */
+    uint32_t reader_done;                   /* Flag set when the whole file is read */
+    uint32_t failed;                        /* Flag set to stop every thread */
+    ManageStatus_t status;                  /* Error that stopped the pipeline */
+} ImportPipeline_t;
+
+/**
+ * @brief Records accepted by the merge stage.
+ */
+typedef struct ImportMerge {
+    Employee_t *batch;                      /* Accepted employees not added yet, in file order, IMPORT_COMMIT_ROWS slots */
+    uint32_t batch_count;                   /* Number of employees in batch */
+    Employee_t *pending;                    /* Accepted employees whose department is not declared yet, in file order */
+    uint64_t *pending_lines;                /* Line of each pending employee */
+    uint32_t pending_count;                 /* Number of pending employees */
+    uint32_t pending_capacity;              /* Number of allocated pending employees */
+    Department_t *departments;              /* Departments declared by the file */
+    uint32_t department_count;              /* Number of declared departments */
+    uint32_t department_capacity;           /* Number of allocated departments */
+    IdIndex_t employee_ids;                 /* IDs of the accepted employees that are not in the store yet,
+                                               stored ones are looked up in the store */
+    IdIndex_t department_ids;               /* IDs of declared departments, stored ones are looked up in the store */
+    uint64_t line_base;                     /* Number of lines in the chunks merged so far */
+    uint32_t employees_added;               /* Number of employees added to the store so far */
+    uint32_t departments_created;           /* Number of departments created so far */
+    ImportReport_t *report;                 /* Report being filled */
+} ImportMerge_t;
+
+/**
+ * @brief Position of a field inside a line.
+ */
+typedef struct ImportField {
+    const int8_t *text;                     /* First character, after the opening quote if quoted */
+    uint32_t length;                        /* Number of characters */
+    uint32_t quoted;                        /* Flag set if the field was enclosed in quotes */
+    uint32_t valid;                         /* Flag cleared if a quoted field is malformed */
+} ImportField_t;
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static void* readerThread(void *argument);
+static void* workerThread(void *argument);
+static void parseChunk(ImportChunk_t *chunk);
+static void parseLine(ImportChunk_t *chunk, const int8_t *line, uint32_t length, uint32_t line_number);
+static uint32_t splitFields(const int8_t *line, uint32_t length, ImportField_t *fields, uint32_t max_fields);
+static const int8_t* fieldText(const ImportField_t *field, int8_t *scratch, uint32_t *length);
+static uint32_t parseErrorCode(ParseStatus_t status);
+static void addChunkError(ImportChunk_t *chunk, uint32_t line, uint32_t field, ImportErrorCode_t code);
+static void addReportError(ImportReport_t *report, uint64_t line, uint32_t field, ImportErrorCode_t code);
+static ManageStatus_t mergeChunk(ImportMerge_t *merge, const ImportChunk_t *chunk);
+static ManageStatus_t acceptEmployee(ImportMerge_t *merge, const Employee_t *employee, uint64_t line);
+static ManageStatus_t commitEmployees(ImportMerge_t *merge, const Employee_t *employees, uint32_t count);
+static ManageStatus_t commitBatch(ImportMerge_t *merge);
+static ManageStatus_t commitPending(ImportMerge_t *merge);
+static int compareDepartmentPositions(const void *first, const void *second);
+static void removeImportedEmployees(uint32_t added);
+static void removeCreatedDepartments(uint32_t created);
+static void freeChunk(ImportChunk_t *chunk);
+static const int8_t* mergedEmployeeKey(uint32_t value, const void *context);
+static const int8_t* mergedDepartmentKey(uint32_t value, const void *context);
+static const char* importErrorText(ImportErrorCode_t code);
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Imports employees and departments from a CSV file.
+ *
+ * @return MANAGE_OK if the file was read (some lines may have been rejected),
+ *         MANAGE_ERR_IO if the file cannot be read, or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t importEmployeesCsv(const char *path, uint32_t thread_count, ImportReport_t *report)
+{
+    ImportPipeline_t pipeline;              /* State shared with the threads */
+    ImportMerge_t merge;                    /* Records accepted so far */
+    ImportReport_t local_report;            /* Report used when the caller passes NULL */
+    pthread_t reader;                       /* Reader thread */
+    pthread_t workers[IMPORT_MAX_THREADS];  /* Worker threads */
+    uint32_t started = 0;                   /* Number of worker threads started */
+    uint32_t reader_started = 0;            /* Flag set if the reader thread started */
+    ImportChunk_t *chunk = NULL;            /* Chunk being merged */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the import */
+    uint32_t i = 0;                         /* Index for looping through threads and slots */
+    PERF_START(perf_start);                 /* Start time of the import */
+
+    if (report == NULL)
+    {
+        report = &local_report;
+    }
+    memset(report, 0, sizeof(*report));
+    if (thread_count == 0)
+    {
+        thread_count = getProcessorCount();
+    }
+    if (thread_count > IMPORT_MAX_THREADS)
+    {
+        thread_count = IMPORT_MAX_THREADS;
+    }
+    report->thread_count = thread_count;
+
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.file = fopen(path, "rb");
+    if (pipeline.file == NULL)
+    {
+        return MANAGE_ERR_IO;
+    }
+    pipeline.window = thread_count * IMPORT_SLOTS_PER_THREAD;
+    pipeline.slots = calloc(pipeline.window, sizeof(*pipeline.slots));
+    pipeline.states = calloc(pipeline.window, sizeof(*pipeline.states));
+
+    memset(&merge, 0, sizeof(merge));
+    merge.report = report;
+    merge.batch = malloc(IMPORT_COMMIT_ROWS * sizeof(*merge.batch));
+    idIndexInit(&merge.employee_ids, mergedEmployeeKey, &merge);
+    idIndexInit(&merge.department_ids, mergedDepartmentKey, &merge);
+
+    if (pipeline.slots == NULL || pipeline.states == NULL || merge.batch == NULL)
+    {
+        status = MANAGE_ERR_NO_MEMORY;
+    }
+
+    if (status == MANAGE_OK)
+    {
+        pthread_mutex_init(&pipeline.lock, NULL);
+        pthread_cond_init(&pipeline.changed, NULL);
+        reader_started = (pthread_create(&reader, NULL, readerThread, &pipeline) == 0) ? 1 : 0;
+        for (started = 0; started < thread_count && reader_started == 1; started++)
+        {
+            if (pthread_create(&workers[started], NULL, workerThread, &pipeline) != 0)
+            {
+                break;
+            }
+        }
+        if (reader_started == 0 || started == 0)
+        {
+            status = MANAGE_ERR_NO_MEMORY;
+        }
+        report->thread_count = started;
+
+        /* Merge stage: take the parsed chunks in file order */
+        while (status == MANAGE_OK)
+        {
+            pthread_mutex_lock(&pipeline.lock);
+            while (pipeline.failed == 0 && pipeline.states[pipeline.merged_count % pipeline.window] != CHUNK_PARSED
+                   && !(pipeline.reader_done == 1 && pipeline.merged_count == pipeline.read_count))
+            {
+                pthread_cond_wait(&pipeline.changed, &pipeline.lock);
+            }
+            if (pipeline.failed == 1)
+            {
+                status = pipeline.status;
+            }
+            chunk = (status == MANAGE_OK && pipeline.merged_count < pipeline.read_count)
+                    ? pipeline.slots[pipeline.merged_count % pipeline.window] : NULL;
+            pthread_mutex_unlock(&pipeline.lock);
+            if (chunk == NULL)
+            {
+                break;
+            }
+
+            status = (chunk->out_of_memory == 1) ? MANAGE_ERR_NO_MEMORY : mergeChunk(&merge, chunk);
+            freeChunk(chunk);
+
+            pthread_mutex_lock(&pipeline.lock);
+            pipeline.slots[pipeline.merged_count % pipeline.window] = NULL;
+            pipeline.states[pipeline.merged_count % pipeline.window] = CHUNK_FREE;
+            pipeline.merged_count += 1;
+            if (status != MANAGE_OK)
+            {
+                pipeline.failed = 1;
+            }
+            pthread_cond_broadcast(&pipeline.changed);
+            pthread_mutex_unlock(&pipeline.lock);
+        }
+
+        /* Stop the other threads if the merge stopped early */
+        pthread_mutex_lock(&pipeline.lock);
+        if (status != MANAGE_OK)
+        {
+            pipeline.failed = 1;
+        }
+        pthread_cond_broadcast(&pipeline.changed);
+        pthread_mutex_unlock(&pipeline.lock);
+        for (i = 0; i < started; i++)
+        {
+            pthread_join(workers[i], NULL);
+        }
+        if (reader_started == 1)
+        {
+            pthread_join(reader, NULL);
+        }
+        pthread_cond_destroy(&pipeline.changed);
+        pthread_mutex_destroy(&pipeline.lock);
+    }
+
+    for (i = 0; pipeline.slots != NULL && i < pipeline.window; i++)
+    {
+        freeChunk(pipeline.slots[i]);
+    }
+    free(pipeline.slots);
+    free(pipeline.states);
+    fclose(pipeline.file);
+    report->lines = merge.line_base;
+
+    /* Add the last batch, then the employees whose department was declared after them */
+    if (status == MANAGE_OK)
+    {
+        status = commitBatch(&merge);
+    }
+    if (status == MANAGE_OK)
+    {
+        status = commitPending(&merge);
+    }
+    if (status == MANAGE_OK)
+    {
+        report->employees_added = merge.employees_added;
+        report->departments_added = merge.departments_created;
+    }
+    else
+    {
+        /* Nothing is added unless the whole file is */
+        removeImportedEmployees(merge.employees_added);
+        removeCreatedDepartments(merge.departments_created);
+    }
+
+    idIndexFree(&merge.employee_ids);
+    idIndexFree(&merge.department_ids);
+    free(merge.batch);
+    free(merge.pending);
+    free(merge.pending_lines);
+    free(merge.departments);
+    PERF_STOP(PERF_OP_IMPORT_CSV, perf_start);
+    return status;
+}
+
+
+/**
+ * @brief Prompts the user for a CSV file and imports it.
+ *
+ * This function asks for the name of the file, imports it with one parsing thread per
+ * processor and prints how many employees were added and the first rejected lines.
+ */
+void importEmployees()
+{
+    char path[260];                         /* File name entered by the user */
+    ImportReport_t report;                  /* Result of the import */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the import */
+    uint32_t i = 0;                         /* Index for looping through errors */
+
+    do
+    {
+        printf("Enter CSV file name to import: ");
+        fflush(stdin);
+        if (fgets(path, sizeof(path), stdin) == NULL)
+        {
+            return;
+        }
+        /* Remove newline character, spaces are allowed in file names */
+        path[strcspn(path, "\r\n")] = '\0';
+        if (path[0] == '\0')
+        {
+            printf("\nYou must not leave blank this information ...\n");
+            printf("\nPlease enter again ...\n");
+        }
+    } while (path[0] == '\0');
+
+    status = importEmployeesCsv(path, 0, &report);
+    if (status == MANAGE_ERR_IO)
+    {
+        printf("Cannot read file %s\n", path);
+        return;
+    }
+    if (status != MANAGE_OK)
+    {
+        printf("Not enough memory to import employees!!!\n");
+        return;
+    }
+
+    printf("Read %s lines using %u threads.\n", formatNumberWithCommas(report.lines), report.thread_count);
+    printf("Added %s employees", formatNumberWithCommas(report.employees_added));
+    printf(" and %s departments.\n", formatNumberWithCommas(report.departments_added));
+    if (report.rejected > 0)
+    {
+        printf("Skipped %s lines:\n", formatNumberWithCommas(report.rejected));
+        for (i = 0; i < report.error_count; i++)
+        {
+            printf("  line %llu", (unsigned long long)report.errors[i].line);
+            if (report.errors[i].field > 0)
+            {
+                printf(", field %u", report.errors[i].field);
+            }
+            printf(": %s\n", importErrorText(report.errors[i].code));
+        }
+    }
+}
+
+
+/**
+ * @brief Reader stage: cuts the file into chunks that end after a newline.
+ *
+ * The bytes after the last newline of a read are copied to the start of the next chunk.
+ * If a single line does not fit in a chunk, the chunk is doubled until it does.
+ */
+static void* readerThread(void *argument)
+{
+    ImportPipeline_t *pipeline = argument;  /* Shared state */
+    int8_t *buffer = NULL;                  /* Bytes of the chunk being read */
+    int8_t *next = NULL;                    /* Buffer of the next chunk, holding the carried bytes */
+    int8_t *grown = NULL;                   /* Reallocated buffer */
+    ImportChunk_t *chunk = NULL;            /* Chunk being published */
+    uint32_t capacity = 0;                  /* Size of buffer */
+    uint32_t length = 0;                    /* Bytes in buffer */
+    uint32_t cut = 0;                       /* Length of the chunk, up to and including the last newline */
+    uint32_t scanned = 0;                   /* Bytes already searched for a newline */
+    uint32_t end_of_file = 0;               /* Flag set when the whole file is read */
+    size_t got = 0;                         /* Bytes returned by fread */
+    ManageStatus_t status = MANAGE_OK;      /* Error that stops the reader */
+
+    while (end_of_file == 0 && status == MANAGE_OK)
+    {
+        /* Wait for a free slot */
+        pthread_mutex_lock(&pipeline->lock);
+        while (pipeline->failed == 0 && pipeline->read_count - pipeline->merged_count >= pipeline->window)
+        {
+            pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+        }
+        if (pipeline->failed == 1)
+        {
+            pthread_mutex_unlock(&pipeline->lock);
+            break;
+        }
+        pthread_mutex_unlock(&pipeline->lock);
+
+        if (buffer == NULL)
+        {
+            capacity = IMPORT_CHUNK_SIZE;
+            buffer = malloc(capacity);
+            length = 0;
+        }
+        chunk = calloc(1, sizeof(*chunk));
+        if (buffer == NULL || chunk == NULL)
+        {
+            free(chunk);
+            status = MANAGE_ERR_NO_MEMORY;
+            break;
+        }
+
+        /* Fill the buffer until it holds a newline or the file ends */
+        cut = 0;
+        scanned = 0;
+        while (cut == 0 && end_of_file == 0)
+        {
+            if (length == capacity)
+            {
+                grown = (capacity < 0x80000000u) ? realloc(buffer, (size_t)capacity * 2) : NULL;
+                if (grown == NULL)
+                {
+                    status = MANAGE_ERR_NO_MEMORY;
+                    break;
+                }
+                buffer = grown;
+                capacity *= 2;
+            }
+            got = fread(buffer + length, 1, capacity - length, pipeline->file);
+            length += (uint32_t)got;
+            if (got == 0)
+            {
+                if (ferror(pipeline->file))
+                {
+                    status = MANAGE_ERR_IO;
+                    break;
+                }
+                end_of_file = 1;
+                cut = length;
+            }
+            else if (length == capacity || feof(pipeline->file))
+            {
+                /* Search backwards for the last newline of the new bytes */
+                for (cut = length; cut > scanned && buffer[cut - 1] != '\n'; cut--)
+                {
+                }
+                if (cut == scanned)
+                {
+                    cut = 0;
+                }
+                scanned = length;
+            }
+        }
+        if (status != MANAGE_OK || length == 0)
+        {
+            free(chunk);
+            break;
+        }
+
+        /* Move the incomplete last line to the next buffer */
+        next = NULL;
+        if (cut < length)
+        {
+            next = malloc(IMPORT_CHUNK_SIZE + length - cut);
+            if (next == NULL)
+            {
+                free(chunk);
+                status = MANAGE_ERR_NO_MEMORY;
+                break;
+            }
+            memcpy(next, buffer + cut, length - cut);
+        }
+        chunk->text = buffer;
+        chunk->length = cut;
+        buffer = next;
+        capacity = IMPORT_CHUNK_SIZE + length - cut;
+        length -= cut;
+
+        /* Publish the chunk */
+        pthread_mutex_lock(&pipeline->lock);
+        chunk->sequence = pipeline->read_count;
+        pipeline->slots[pipeline->read_count % pipeline->window] = chunk;
+        pipeline->states[pipeline->read_count % pipeline->window] = CHUNK_READ;
+        pipeline->read_count += 1;
+        pthread_cond_broadcast(&pipeline->changed);
+        pthread_mutex_unlock(&pipeline->lock);
+    }
+    free(buffer);
+
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->reader_done = 1;
+    if (status != MANAGE_OK && pipeline->failed == 0)
+    {
+        pipeline->failed = 1;
+        pipeline->status = status;
+    }
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->lock);
+    return NULL;
+}
+
+
+/**
+ * @brief Worker stage: parses chunks in the order they were read.
+ */
+static void* workerThread(void *argument)
+{
+    ImportPipeline_t *pipeline = argument;  /* Shared state */
+    ImportChunk_t *chunk = NULL;            /* Chunk being parsed */
+    uint64_t sequence = 0;                  /* Sequence of the chunk */
+
+    for (;;)
+    {
+        pthread_mutex_lock(&pipeline->lock);
+        while (pipeline->failed == 0 && pipeline->next_to_parse == pipeline->read_count && pipeline->reader_done == 0)
+        {
+            pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+        }
+        if (pipeline->failed == 1 || pipeline->next_to_parse == pipeline->read_count)
+        {
+            pthread_mutex_unlock(&pipeline->lock);
+            break;
+        }
+        sequence = pipeline->next_to_parse;
+        pipeline->next_to_parse += 1;
+        chunk = pipeline->slots[sequence % pipeline->window];
+        pthread_mutex_unlock(&pipeline->lock);
+
+        parseChunk(chunk);
+
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->states[sequence % pipeline->window] = CHUNK_PARSED;
+        pthread_cond_broadcast(&pipeline->changed);
+        pthread_mutex_unlock(&pipeline->lock);
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Parses every line of a chunk. The raw text is freed afterwards.
+ */
+static void parseChunk(ImportChunk_t *chunk)
+{
+    uint32_t start = 0;                     /* Start of the current line */
+    uint32_t end = 0;                       /* End of the current line */
+    PERF_START(perf_start);                 /* Start time of the parsing */
+
+    /* Sized for short lines, grown by parseLine() if needed */
+    chunk->employee_capacity = chunk->length / 64 + 16;
+    chunk->employees = malloc((size_t)chunk->employee_capacity * sizeof(*chunk->employees));
+    chunk->employee_lines = malloc((size_t)chunk->employee_capacity * sizeof(*chunk->employee_lines));
+    if (chunk->employees == NULL || chunk->employee_lines == NULL)
+    {
+        chunk->out_of_memory = 1;
+    }
+
+    while (start < chunk->length && chunk->out_of_memory == 0)
+    {
+        for (end = start; end < chunk->length && chunk->text[end] != '\n'; end++)
+        {
+        }
+        chunk->line_count += 1;
+        parseLine(chunk, chunk->text + start, end - start, chunk->line_count);
+        start = end + 1;
+    }
+
+    free(chunk->text);
+    chunk->text = NULL;
+    PERF_STOP(PERF_OP_PARSE_IMPORT_CHUNK, perf_start);
+}
+
+
+/**
+ * @brief Parses one line into an employee or a department of the chunk.
+ */
+static void parseLine(ImportChunk_t *chunk, const int8_t *line, uint32_t length, uint32_t line_number)
+{
+    ImportField_t fields[IMPORT_EMPLOYEE_FIELDS + 1];   /* Fields of the line */
+    int8_t scratch[IMPORT_MAX_FIELD];      /* Unquoted copy of a quoted field */
+    const int8_t *text = NULL;              /* Text of the current field */
+    uint32_t text_length = 0;               /* Length of the current field */
+    uint32_t field_count = 0;               /* Number of fields */
+    uint32_t start = 0;                     /* Offset of an ID in its field */
+    uint32_t id_length = 0;                 /* Length of an ID */
+    uint64_t number = 0;                    /* Parsed number */
+    uint32_t code = 0;                      /* Error code of a field, 0 if valid */
+    uint32_t i = 0;                         /* Index for looping through fields and characters */
+    Employee_t *employee = NULL;            /* Employee being filled */
+    Department_t *department = NULL;        /* Department being filled */
+    void *grown = NULL;                     /* Reallocated array */
+
+    /* Skip blank lines and comments */
+    while (i < length && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r'))
+    {
+        i++;
+    }
+    if (i == length || line[i] == '#')
+    {
+        return;
+    }
+
+    field_count = splitFields(line, length, fields, IMPORT_EMPLOYEE_FIELDS + 1);
+    for (i = 0; i < field_count && i < IMPORT_EMPLOYEE_FIELDS; i++)
+    {
+        if (fields[i].valid == 0)
+        {
+            addChunkError(chunk, line_number, i + 1, IMPORT_ERR_INVALID_FIELD);
+            return;
+        }
+    }
+
+    /* Header line */
+    text = fieldText(&fields[0], scratch, &text_length);
+    if (chunk->sequence == 0 && line_number == 1 && text != NULL && parseIdField(text, text_length, 2, &start, &id_length) == PARSE_OK
+        && id_length == 2 && (text[start] | 0x20) == 'i' && (text[start + 1] | 0x20) == 'd')
+    {
+        return;
+    }
+
+    if (field_count == IMPORT_DEPARTMENT_FIELDS)
+    {
+        if (chunk->department_count == chunk->department_capacity)
+        {
+            chunk->department_capacity = chunk->department_capacity * 2 + 8;
+            grown = realloc(chunk->departments, (size_t)chunk->department_capacity * sizeof(*chunk->departments));
+            chunk->departments = (grown != NULL) ? grown : chunk->departments;
+            grown = (grown != NULL) ? realloc(chunk->department_lines, (size_t)chunk->department_capacity * sizeof(uint32_t)) : NULL;
+            chunk->department_lines = (grown != NULL) ? grown : chunk->department_lines;
+            if (grown == NULL)
+            {
+                chunk->out_of_memory = 1;
+                return;
+            }
+        }
+        department = &chunk->departments[chunk->department_count];
+        memset(department, 0, sizeof(*department));
+
+        text = fieldText(&fields[0], scratch, &text_length);
+        code = (text == NULL) ? IMPORT_ERR_FIELD_TOO_LARGE
+                              : parseErrorCode(parseIdField(text, text_length, MAX_ID_LENGTH - 1, &start, &id_length));
+        if (code != 0)
+        {
+            addChunkError(chunk, line_number, 1, code);
+            return;
+        }
+        memcpy(department->id, text + start, id_length);
+
+        text = fieldText(&fields[1], scratch, &text_length);
+        code = (text == NULL) ? IMPORT_ERR_FIELD_TOO_LARGE
+                              : parseErrorCode(parseUnsignedField(text, text_length, UINT64_MAX, &department->bonus_salary));
+        if (code != 0)
+        {
+            addChunkError(chunk, line_number, 2, code);
+            return;
+        }
+        department->raise_factor = DEPARTMENT_NO_RAISE;
+        chunk->department_lines[chunk->department_count] = line_number;
+        chunk->department_count += 1;
+        return;
+    }
+    if (field_count != IMPORT_EMPLOYEE_FIELDS)
+    {
+        addChunkError(chunk, line_number, 0, IMPORT_ERR_FIELD_COUNT);
+        return;
+    }
+
+    if (chunk->employee_count == chunk->employee_capacity)
+    {
+        chunk->employee_capacity *= 2;
+        grown = realloc(chunk->employees, (size_t)chunk->employee_capacity * sizeof(*chunk->employees));
+        chunk->employees = (grown != NULL) ? grown : chunk->employees;
+        grown = (grown != NULL) ? realloc(chunk->employee_lines, (size_t)chunk->employee_capacity * sizeof(uint32_t)) : NULL;
+        chunk->employee_lines = (grown != NULL) ? grown : chunk->employee_lines;
+        if (grown == NULL)
+        {
+            chunk->out_of_memory = 1;
+            return;
+        }
+    }
+    employee = &chunk->employees[chunk->employee_count];
+    memset(employee, 0, sizeof(*employee));
+
+    for (i = 0; i < IMPORT_EMPLOYEE_FIELDS; i++)
+    {
+        text = fieldText(&fields[i], scratch, &text_length);
+        if (text == NULL)
+        {
+            addChunkError(chunk, line_number, i + 1, IMPORT_ERR_FIELD_TOO_LARGE);
+            return;
+        }
+        switch (i)
+        {
+            case 0:
+                code = parseErrorCode(parseIdField(text, text_length, MAX_ID_LENGTH - 1, &start, &id_length));
+                memcpy(employee->id, text + start, (code == 0) ? id_length : 0);
+                break;
+            case 1:
+                code = parseErrorCode(parseIdField(text, text_length, MAX_ID_LENGTH - 1, &start, &id_length));
+                memcpy(employee->department_id, text + start, (code == 0) ? id_length : 0);
+                break;
+            case 2:
+                /* Names keep their inner spaces, only the blanks around them are dropped */
+                while (text_length > 0 && (text[0] == ' ' || text[0] == '\t'))
+                {
+                    text++;
+                    text_length--;
+                }
+                while (text_length > 0 && (text[text_length - 1] == ' ' || text[text_length - 1] == '\t' || text[text_length - 1] == '\r'))
+                {
+                    text_length--;
+                }
+                code = (text_length == 0) ? IMPORT_ERR_EMPTY_FIELD
+                       : (text_length >= MAX_NAME_LENGTH) ? IMPORT_ERR_FIELD_TOO_LARGE : 0;
+                for (start = 0; start < text_length && code == 0; start++)
+                {
+                    code = ((uint8_t)text[start] < ' ' || text[start] == 0x7f) ? IMPORT_ERR_INVALID_FIELD : 0;
+                }
+                memcpy(employee->name, text, (code == 0) ? text_length : 0);
+                break;
+            case 3:
+                code = parseErrorCode(parseUnsignedField(text, text_length, EMPLOYEE_MAX_AMOUNT, &number));
+                employee->salary_base = (EmployeeAmount_t)number;
+                break;
+            case 4:
+                code = parseErrorCode(parseUnsignedField(text, text_length, EMPLOYEE_MAX_DAYS, &number));
+                employee->working_days = (EmployeeDays_t)number;
+                break;
+            case 5:
+                code = parseErrorCode(parseDecimalField(text, text_length, &employee->working_performance));
+                if (code == 0 && !(employee->working_performance > 0))
+                {
+                    code = IMPORT_ERR_PERFORMANCE;
+                }
+                break;
+            case 6:
+                code = parseErrorCode(parseUnsignedField(text, text_length, EMPLOYEE_MAX_AMOUNT, &number));
+                employee->bonus = (EmployeeAmount_t)number;
+                break;
+            default:
+                code = parseErrorCode(parseUnsignedField(text, text_length, EMPLOYEE_MAX_DAYS, &number));
+                employee->late_coming_days = (EmployeeDays_t)number;
+                break;
+        }
+        if (code != 0)
+        {
+            addChunkError(chunk, line_number, i + 1, code);
+            return;
+        }
+    }
+    chunk->employee_lines[chunk->employee_count] = line_number;
+    chunk->employee_count += 1;
+}
+
+
+/**
+ * @brief Splits a line at the commas that are not inside quotes.
+ *
+ * @return The number of fields, at most max_fields (a line with more fields returns max_fields).
+ */
+static uint32_t splitFields(const int8_t *line, uint32_t length, ImportField_t *fields, uint32_t max_fields)
+{
+    uint32_t count = 0;                     /* Number of fields found */
+    uint32_t i = 0;                         /* Position in the line */
+    uint32_t start = 0;                     /* Start of the current field */
+
+    while (count < max_fields)
+    {
+        start = i;
+        while (i < length && (line[i] == ' ' || line[i] == '\t'))
+        {
+            i++;
+        }
+        fields[count].valid = 1;
+        fields[count].quoted = 0;
+        if (i < length && line[i] == '"')
+        {
+            /* Quoted field: runs to the closing quote, "" stands for one quote */
+            fields[count].quoted = 1;
+            fields[count].text = line + i + 1;
+            for (i = i + 1; i < length; i++)
+            {
+                if (line[i] == '"')
+                {
+                    if (i + 1 < length && line[i + 1] == '"')
+                    {
+                        i++;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+            }
+            fields[count].length = (uint32_t)(line + i - fields[count].text);
+            if (i == length)
+            {
+                fields[count].valid = 0;
+            }
+            else
+            {
+                i++;
+            }
+            /* Only blanks may follow the closing quote */
+            while (i < length && line[i] != ',')
+            {
+                if (line[i] != ' ' && line[i] != '\t' && line[i] != '\r')
+                {
+                    fields[count].valid = 0;
+                }
+                i++;
+            }
+        }
+        else
+        {
+            fields[count].text = line + start;
+            while (i < length && line[i] != ',')
+            {
+                i++;
+            }
+            fields[count].length = i - start;
+        }
+        count++;
+        if (i >= length)
+        {
+            break;
+        }
+        i++;                                /* Skip the comma */
+    }
+    return count;
+}
+
+
+/**
+ * @brief Returns the text of a field, with the quotes of a quoted field removed.
+ *
+ * @return The text, or NULL if a quoted field does not fit in the scratch buffer.
+ */
+static const int8_t* fieldText(const ImportField_t *field, int8_t *scratch, uint32_t *length)
+{
+    uint32_t i = 0;                         /* Position in the field */
+    uint32_t j = 0;                         /* Position in the scratch buffer */
+
+    if (field->quoted == 0)
+    {
+        *length = field->length;
+        return field->text;
+    }
+    for (i = 0; i < field->length; i++)
+    {
+        if (j == IMPORT_MAX_FIELD)
+        {
+            return NULL;
+        }
+        scratch[j++] = field->text[i];
+        if (field->text[i] == '"')
+        {
+            i++;                            /* Skip the second quote of "" */
+        }
+    }
+    *length = j;
+    return scratch;
+}
+
+
+/**
+ * @brief Converts the result of a field parser to an import error code, 0 if the field is valid.
+ */
+static uint32_t parseErrorCode(ParseStatus_t status)
+{
+    switch (status)
+    {
+        case PARSE_OK:
+            return 0;
+        case PARSE_EMPTY:
+            return IMPORT_ERR_EMPTY_FIELD;
+        case PARSE_OUT_OF_RANGE:
+            return IMPORT_ERR_FIELD_TOO_LARGE;
+        default:
+            return IMPORT_ERR_INVALID_FIELD;
+    }
+}
+
+
+/**
+ * @brief Counts a rejected line of a chunk and keeps it if there is room.
+ */
+static void addChunkError(ImportChunk_t *chunk, uint32_t line, uint32_t field, ImportErrorCode_t code)
+{
+    chunk->rejected += 1;
+    if (chunk->error_count < IMPORT_MAX_ERRORS)
+    {
+        chunk->errors[chunk->error_count].line = line;
+        chunk->errors[chunk->error_count].field = field;
+        chunk->errors[chunk->error_count].code = code;
+        chunk->error_count += 1;
+    }
+}
+
+
+/**
+ * @brief Counts a rejected line of the file and keeps it if there is room.
+ */
+static void addReportError(ImportReport_t *report, uint64_t line, uint32_t field, ImportErrorCode_t code)
+{
+    report->rejected += 1;
+    if (report->error_count < IMPORT_MAX_ERRORS)
+    {
+        report->errors[report->error_count].line = line;
+        report->errors[report->error_count].field = field;
+        report->errors[report->error_count].code = code;
+        report->error_count += 1;
+    }
+}
+
+
+/**
+ * @brief Merge stage: accepts the records of a chunk whose IDs were not seen before.
+ *
+ * Employees, departments and errors of the chunk are each sorted by line, so they are
+ * merged by line number and the report lists the errors in file order. A department line
+ * counts from its line on, so employees after it go to the batch like those of stored
+ * departments.
+ *
+ * @return MANAGE_OK or MANAGE_ERR_NO_MEMORY.
+ */
+static ManageStatus_t mergeChunk(ImportMerge_t *merge, const ImportChunk_t *chunk)
+{
+    uint32_t e = 0;                         /* Next employee of the chunk */
+    uint32_t d = 0;                         /* Next department of the chunk */
+    uint32_t r = 0;                         /* Next kept error of the chunk */
+    uint32_t employee_line = 0;             /* Line of the next employee, UINT32_MAX if none */
+    uint32_t department_line = 0;           /* Line of the next department, UINT32_MAX if none */
+    uint32_t error_line = 0;                /* Line of the next error, UINT32_MAX if none */
+    uint32_t new_capacity = 0;              /* Grown capacity */
+    void *grown = NULL;                     /* Reallocated array */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the merge */
+
+    if ((uint64_t)merge->department_count + chunk->department_count > merge->department_capacity)
+    {
+        new_capacity = merge->department_count + chunk->department_count + 16;
+        grown = realloc(merge->departments, (size_t)new_capacity * sizeof(*merge->departments));
+        if (grown == NULL)
+        {
+            return MANAGE_ERR_NO_MEMORY;
+        }
+        merge->departments = grown;
+        merge->department_capacity = new_capacity;
+    }
+    if (idIndexReserve(&merge->employee_ids, merge->batch_count + merge->pending_count + chunk->employee_count) != MANAGE_OK
+        || idIndexReserve(&merge->department_ids, merge->department_count + chunk->department_count) != MANAGE_OK)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+
+    while (status == MANAGE_OK)
+    {
+        employee_line = (e < chunk->employee_count) ? chunk->employee_lines[e] : UINT32_MAX;
+        department_line = (d < chunk->department_count) ? chunk->department_lines[d] : UINT32_MAX;
+        error_line = (r < chunk->error_count) ? (uint32_t)chunk->errors[r].line : UINT32_MAX;
+
+        if (error_line < employee_line && error_line < department_line)
+        {
+            if (merge->report->error_count < IMPORT_MAX_ERRORS)
+            {
+                merge->report->errors[merge->report->error_count] = chunk->errors[r];
+                merge->report->errors[merge->report->error_count].line += merge->line_base;
+                merge->report->error_count += 1;
+            }
+            r++;
+        }
+        else if (employee_line < department_line)
+        {
+            if (findEmployee(chunk->employees[e].id) != NULL
+                || idIndexFind(&merge->employee_ids, chunk->employees[e].id, NULL) == 1)
+            {
+                addReportError(merge->report, merge->line_base + employee_line, 1, IMPORT_ERR_DUPLICATE_ID);
+            }
+            else
+            {
+                status = acceptEmployee(merge, &chunk->employees[e], merge->line_base + employee_line);
+            }
+            e++;
+        }
+        else if (department_line != UINT32_MAX)
+        {
+            if (findDepartment(chunk->departments[d].id) != NULL
+                || idIndexFind(&merge->department_ids, chunk->departments[d].id, NULL) == 1)
+            {
+                addReportError(merge->report, merge->line_base + department_line, 1, IMPORT_ERR_DUPLICATE_ID);
+            }
+            else
+            {
+                merge->departments[merge->department_count] = chunk->departments[d];
+                status = idIndexInsert(&merge->department_ids, merge->departments[merge->department_count].id,
+                                       merge->department_count);
+                merge->department_count += 1;
+            }
+            d++;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    /* Kept errors were copied above, the others are only counted */
+    merge->report->rejected += chunk->rejected;
+    merge->line_base += chunk->line_count;
+    return status;
+}
+
+
+/**
+ * @brief Adds an employee whose ID was not seen before to the batch, or to the pending list
+ *        if its department is neither stored nor declared yet.
+ *
+ * A full batch is added to the store first.
+ *
+ * @return MANAGE_OK or MANAGE_ERR_NO_MEMORY.
+ */
+static ManageStatus_t acceptEmployee(ImportMerge_t *merge, const Employee_t *employee, uint64_t line)
+{
+    uint32_t new_capacity = 0;              /* Grown capacity */
+    void *grown = NULL;                     /* Reallocated array */
+    ManageStatus_t status = MANAGE_OK;      /* Result of adding the batch */
+
+    if (findDepartment(employee->department_id) != NULL
+        || idIndexFind(&merge->department_ids, employee->department_id, NULL) == 1)
+    {
+        if (merge->batch_count == IMPORT_COMMIT_ROWS)
+        {
+            status = commitBatch(merge);
+        }
+        if (status == MANAGE_OK)
+        {
+            merge->batch[merge->batch_count] = *employee;
+            status = idIndexInsert(&merge->employee_ids, employee->id, merge->batch_count);
+            merge->batch_count += 1;
+        }
+        return status;
+    }
+
+    /* The department may be declared further down the file */
+    if (merge->pending_count == merge->pending_capacity)
+    {
+        new_capacity = merge->pending_capacity * 2 + 1024;
+        grown = realloc(merge->pending, (size_t)new_capacity * sizeof(*merge->pending));
+        merge->pending = (grown != NULL) ? grown : merge->pending;
+        grown = (grown != NULL) ? realloc(merge->pending_lines, (size_t)new_capacity * sizeof(*merge->pending_lines)) : NULL;
+        merge->pending_lines = (grown != NULL) ? grown : merge->pending_lines;
+        if (grown == NULL)
+        {
+            return MANAGE_ERR_NO_MEMORY;
+        }
+        merge->pending_capacity = new_capacity;
+    }
+    merge->pending[merge->pending_count] = *employee;
+    merge->pending_lines[merge->pending_count] = line;
+    status = idIndexInsert(&merge->employee_ids, employee->id, IMPORT_COMMIT_ROWS + merge->pending_count);
+    merge->pending_count += 1;
+    return status;
+}
+
+
+/**
+ * @brief Adds accepted employees to the store, creating the declared departments they use.
+ *
+ * The departments are created in the order the file declares them, with one
+ * ensureDepartments() call, and the employees are added in file order with one
+ * addEmployeesBatch() call.
+ *
+ * @return MANAGE_OK or MANAGE_ERR_NO_MEMORY.
+ */
+static ManageStatus_t commitEmployees(ImportMerge_t *merge, const Employee_t *employees, uint32_t count)
+{
+    uint32_t *positions = NULL;             /* Positions in merge->departments of the departments to create */
+    Department_t *to_create = NULL;         /* Departments to create, in declaration order */
+    uint32_t position_count = 0;            /* Number of entries in positions */
+    uint32_t create_count = 0;              /* Number of entries in to_create */
+    uint32_t created = 0;                   /* Number of departments created */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the commit */
+    uint32_t i = 0;                         /* Index for looping through employees and departments */
+
+    if (count == 0)
+    {
+        return MANAGE_OK;
+    }
+    positions = malloc(count * sizeof(*positions));
+    to_create = malloc(count * sizeof(*to_create));
+    if (positions == NULL || to_create == NULL)
+    {
+        status = MANAGE_ERR_NO_MEMORY;
+    }
+    else
+    {
+        for (i = 0; i < count; i++)
+        {
+            if (findDepartment(employees[i].department_id) == NULL
+                && idIndexFind(&merge->department_ids, employees[i].department_id, &positions[position_count]) == 1)
+            {
+                position_count += 1;
+            }
+        }
+        qsort(positions, position_count, sizeof(*positions), compareDepartmentPositions);
+        for (i = 0; i < position_count; i++)
+        {
+            if (i == 0 || positions[i] != positions[i - 1])
+            {
+                to_create[create_count] = merge->departments[positions[i]];
+                create_count += 1;
+            }
+        }
+        status = ensureDepartments(to_create, create_count, &created);
+        merge->departments_created += created;
+    }
+    if (status == MANAGE_OK)
+    {
+        status = addEmployeesBatch(employees, count, NULL, 0);
+    }
+    if (status == MANAGE_OK)
+    {
+        merge->employees_added += count;
+    }
+    free(positions);
+    free(to_create);
+    return status;
+}
+
+
+/**
+ * @brief Adds the batch to the store and empties it.
+ *
+ * @return MANAGE_OK or MANAGE_ERR_NO_MEMORY.
+ */
+static ManageStatus_t commitBatch(ImportMerge_t *merge)
+{
+    ManageStatus_t status = commitEmployees(merge, merge->batch, merge->batch_count);  /* Result of the commit */
+    uint32_t i = 0;                         /* Index for looping through the batch */
+
+    if (status != MANAGE_OK)
+    {
+        return status;
+    }
+    /* The store finds these IDs from now on */
+    for (i = 0; i < merge->batch_count; i++)
+    {
+        idIndexRemove(&merge->employee_ids, merge->batch[i].id);
+    }
+    merge->batch_count = 0;
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Rejects the pending employees whose department is neither stored nor declared, and
+ *        adds the others to the store once the whole file is merged.
+ *
+ * @return MANAGE_OK or MANAGE_ERR_NO_MEMORY.
+ */
+static ManageStatus_t commitPending(ImportMerge_t *merge)
+{
+    uint32_t i = 0;                         /* Index for looping through pending employees */
+    uint32_t j = 0;                         /* Index of the next kept employee */
+
+    for (i = 0; i < merge->pending_count; i++)
+    {
+        if (findDepartment(merge->pending[i].department_id) == NULL
+            && idIndexFind(&merge->department_ids, merge->pending[i].department_id, NULL) == 0)
+        {
+            addReportError(merge->report, merge->pending_lines[i], 2, IMPORT_ERR_UNKNOWN_DEPARTMENT);
+        }
+        else
+        {
+            merge->pending[j] = merge->pending[i];
+            j++;
+        }
+    }
+    /* The pending IDs are not looked up any more, so the list can be compacted */
+    merge->pending_count = j;
+    return commitEmployees(merge, merge->pending, merge->pending_count);
+}
+
+
+/**
+ * @brief qsort() comparator for an array of department positions.
+ */
+static int compareDepartmentPositions(const void *first, const void *second)
+{
+    uint32_t left = *(const uint32_t *)first;      /* First position */
+    uint32_t right = *(const uint32_t *)second;    /* Second position */
+
+    return (left > right) - (left < right);
+}
+
+
+/**
+ * @brief Deletes the employees added by the import when it fails.
+ *
+ * @param added Number of employees added, they are the last ones of the store.
+ */
+static void removeImportedEmployees(uint32_t added)
+{
+    const int8_t **ids = malloc((added + 1) * sizeof(*ids));       /* IDs of the added employees */
+    uint32_t first = getTotalEmployees() - added;                  /* Position of the first added employee */
+    uint32_t i = 0;                         /* Index for looping through added employees */
+
+    if (ids == NULL)
+    {
+        return;
+    }
+    for (i = 0; i < added; i++)
+    {
+        ids[i] = getEmployeeAt(first + i)->id;
+    }
+    deleteEmployeesBatch(ids, added);
+    free(ids);
+}
+
+
+/**
+ * @brief Deletes the departments created by ensureDepartments() when the employees could not be added.
+ *
+ * @param created Number of departments created, they are the last ones of the store.
+ */
+static void removeCreatedDepartments(uint32_t created)
+{
+    const int8_t **ids = malloc((created + 1) * sizeof(*ids));     /* IDs of the created departments */
+    uint32_t first = getTotalDepartments() - created;              /* Position of the first created department */
+    uint32_t i = 0;                         /* Index for looping through created departments */
+
+    if (ids == NULL)
+    {
+        return;
+    }
+    for (i = 0; i < created; i++)
+    {
+        ids[i] = getDepartmentAt(first + i)->id;
+    }
+    deleteDepartmentsBatch(ids, created);
+    free(ids);
+}
+
+
+/**
+ * @brief Frees a chunk and everything it owns.
+ */
+static void freeChunk(ImportChunk_t *chunk)
+{
+    if (chunk == NULL)
+    {
+        return;
+    }
+    free(chunk->text);
+    free(chunk->employees);
+    free(chunk->employee_lines);
+    free(chunk->departments);
+    free(chunk->department_lines);
+    free(chunk);
+}
+
+
+/**
+ * @brief Returns the ID of an employee of the batch or of the pending list for the employee index.
+ */
+static const int8_t* mergedEmployeeKey(uint32_t value, const void *context)
+{
+    const ImportMerge_t *merge = context;   /* Merge state */
+
+    if (value < IMPORT_COMMIT_ROWS)
+    {
+        return merge->batch[value].id;
+    }
+    return merge->pending[value - IMPORT_COMMIT_ROWS].id;
+}
+
+
+/**
+ * @brief Returns the ID of a declared department for the department index.
+ */
+static const int8_t* mergedDepartmentKey(uint32_t value, const void *context)
+{
+    const ImportMerge_t *merge = context;   /* Merge state */
+
+    return merge->departments[value].id;
+}
+
+
+/**
+ * @brief Returns a message describing an import error.
+ */
+static const char* importErrorText(ImportErrorCode_t code)
+{
+    switch (code)
+    {
+        case IMPORT_ERR_FIELD_COUNT:
+            return "expected 8 fields (employee) or 2 fields (department)";
+        case IMPORT_ERR_EMPTY_FIELD:
+            return "field is blank";
+        case IMPORT_ERR_INVALID_FIELD:
+            return "field is not valid";
+        case IMPORT_ERR_FIELD_TOO_LARGE:
+            return "number is too large or text is too long";
+        case IMPORT_ERR_PERFORMANCE:
+            return "working performance must be more than 0";
+        case IMPORT_ERR_DUPLICATE_ID:
+            return "ID already exists";
+        case IMPORT_ERR_UNKNOWN_DEPARTMENT:
+            return "department does not exist";
+        default:
+            return "unknown error";
+    }
+} /* EOF */
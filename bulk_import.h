@@ -0,0 +1,98 @@
+/**
+ * @file bulk_import.h
+ * @brief This file contains the function prototypes for importing employees from a CSV file.
+ *
+ * The import runs as a pipeline: a reader thread cuts the file into chunks that end on a
+ * newline, worker threads parse and validate the chunks in parallel, and the calling thread
+ * merges the parsed chunks in file order, rejects IDs already seen in earlier chunks or in the
+ * store, and adds the accepted employees in batches of a bounded size, creating the declared
+ * departments each batch uses first. Employees are added in file order, except those whose
+ * department is declared further down the file: they are added last, once it is known.
+ *
+ * File format (one record per line, fields separated by commas):
+ *     id,department_id,name,salary_base,working_days,working_performance,bonus,late_coming_days
+ *     department_id,bonus
+ * A line with 8 fields is an employee, a line with 2 fields gives the bonus of a department
+ * that the import creates. A department is only created if an imported employee belongs to it,
+ * as in addEmployee(). Blank lines and lines starting with '#' are ignored, and the first line
+ * is skipped if its first field is "id". A field may be enclosed in double quotes (a quote
+ * inside is written twice) so names can contain commas; fields cannot contain newlines.
+ *
+ * Lines with errors are skipped and reported; the rest of the file is still imported.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef BULK_IMPORT_H
+#define BULK_IMPORT_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for Employee_t and ManageStatus_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define IMPORT_MAX_ERRORS 16                /* Number of errors kept in an import report */
+#define IMPORT_MAX_THREADS 64               /* Largest number of parsing threads */
+
+/**
+ * @brief Reason a line was rejected.
+ */
+typedef enum ImportErrorCode {
+    IMPORT_ERR_FIELD_COUNT = 1,             /* The line has neither 2 nor 8 fields */
+    IMPORT_ERR_EMPTY_FIELD,                 /* A field is blank */
+    IMPORT_ERR_INVALID_FIELD,               /* A field holds a character that is not allowed */
+    IMPORT_ERR_FIELD_TOO_LARGE,             /* A number is too large or a text is too long */
+    IMPORT_ERR_PERFORMANCE,                 /* The working performance is not more than 0 */
+    IMPORT_ERR_DUPLICATE_ID,                /* The ID is already stored or appears earlier in the file */
+    IMPORT_ERR_UNKNOWN_DEPARTMENT           /* The employee's department is neither stored nor in the file */
+} ImportErrorCode_t;
+
+/**
+ * @brief One rejected line.
+ */
+typedef struct ImportError {
+    uint64_t line;                          /* Line number in the file, starting at 1 */
+    uint32_t field;                         /* Field number starting at 1, or 0 for the whole line */
+    ImportErrorCode_t code;                 /* Reason the line was rejected */
+} ImportError_t;
+
+/**
+ * @brief Result of an import.
+ */
+typedef struct ImportReport {
+    uint64_t lines;                         /* Number of lines in the file */
+    uint64_t employees_added;               /* Number of employees added to the store */
+    uint64_t departments_added;             /* Number of departments added to the store */
+    uint64_t rejected;                      /* Number of lines skipped because of an error */
+    uint32_t thread_count;                  /* Number of parsing threads used */
+    uint32_t error_count;                   /* Number of entries in errors */
+    ImportError_t errors[IMPORT_MAX_ERRORS];/* First errors; duplicates come in file order,
+                                               unknown departments after them */
+} ImportReport_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Imports employees and departments from a CSV file.
+ *
+ * @param path Path of the file.
+ * @param thread_count Number of parsing threads, 0 to use one per processor.
+ * @param report Receives the result of the import (may be NULL).
+ * @return MANAGE_OK if the file was read (some lines may have been rejected),
+ *         MANAGE_ERR_IO if the file cannot be read, or MANAGE_ERR_NO_MEMORY.
+ *         Nothing is added to the store unless MANAGE_OK is returned.
+ */
+ManageStatus_t importEmployeesCsv(const char *path, uint32_t thread_count, ImportReport_t *report);
+
+/**
+ * @brief Prompts the user for a CSV file and imports it.
+ */
+void importEmployees();
+
+#endif /* BULK_IMPORT_H */
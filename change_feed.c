@@ -0,0 +1,1075 @@
+/**
+ * @file change_feed.c
+ * @brief This file contains the implementation of the change feed of the employee and department tables.
+ *
+ * The store calls changeFeedEmployee() and changeFeedDepartment() for every record it changes
+ * and changeFeedCommit() at the end of the operation. Events are encoded straight into one
+ * buffer; the commit marks the last one and writes the buffer with a single unbuffered write,
+ * so a reader never sees part of an operation unless it is larger than the buffer. Without an
+ * open feed the calls return at once.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdio.h>              /* Include standard input and output library for printf, FILE, fopen, fread, fwrite */
+#include <stdlib.h>             /* Include standard library for malloc, free, getenv */
+#include <string.h>             /* Include string manipulation library for memcpy, memcmp, memmove, strlen */
+#ifdef _WIN32
+#include <windows.h>            /* Include Windows header file for Sleep */
+#include <io.h>                 /* Include low-level I/O header file for _chsize_s, _fileno */
+#else
+#include <signal.h>             /* Include signal library for ignoring SIGPIPE on a pipe without reader */
+#include <time.h>               /* Include time library for nanosleep */
+#include <unistd.h>             /* Include POSIX header file for ftruncate, fileno */
+#include <sys/stat.h>           /* Include POSIX header file for stat, S_ISFIFO */
+#endif
+#include "change_feed.h"        /* Include header file */
+#include "input_handler.h"      /* Include input handler header file for getSingleCharInput, parseUnsignedField */
+#include "perf_stats.h"         /* Include instrumentation header file for measuring hot operations */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define CHANGE_FEED_MAGIC "MECDC001"        /* Magic bytes at the start of a feed */
+#define CHANGE_FEED_MAGIC_LENGTH 8          /* Length of the magic bytes */
+#define CHANGE_FEED_VERSION 1u              /* Version of the feed layout */
+#define CHANGE_FEED_READ_SIZE (1u << 16)    /* Bytes read from a feed at a time */
+#define CHANGE_FEED_NO_EVENT 0xFFFFFFFFu    /* No event in the write buffer */
+#define CHANGE_FEED_FOLLOW_DELAY_MS 200     /* Wait between two looks at the end of a followed feed */
+#define CHANGE_FEED_FNV_OFFSET 2166136261u  /* FNV-1a offset basis, start of the event checksum */
+#define CHANGE_FEED_FNV_PRIME 16777619u     /* FNV-1a prime */
+
+#ifdef _WIN32
+#define CHANGE_FEED_FSEEK _fseeki64         /* 64-bit seek, feeds can be larger than 2 GB */
+#define CHANGE_FEED_FTELL _ftelli64
+#else
+#define CHANGE_FEED_FSEEK fseeko
+#define CHANGE_FEED_FTELL ftello
+#endif
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static uint8_t* reserveEvent();
+static void finishEvent(ChangeKind_t kind, ChangeTable_t table, uint32_t fields, uint32_t length);
+static void writeBuffer();
+static void failFeed();
+static void writeStore();
+static uint32_t employeeFields(const Employee_t *before, const Employee_t *after);
+static uint32_t departmentFields(const Department_t *before, const Department_t *after);
+static uint32_t encodeEmployee(uint8_t *body, const Employee_t *employee);
+static uint32_t encodeDepartment(uint8_t *body, const Department_t *department);
+static uint32_t encodeString(uint8_t *bytes, const int8_t *text, uint32_t size);
+static uint32_t decodeEvent(const uint8_t *bytes, uint32_t length, ChangeEvent_t *event);
+static uint32_t decodeString(const uint8_t *bytes, uint32_t length, uint32_t *used, int8_t *text, uint32_t size);
+static uint32_t fillReader(ChangeFeedReader_t *reader);
+static uint32_t checksumEvent(const uint8_t *bytes, uint32_t length);
+static uint32_t isPipe(const char *path);
+static uint32_t truncateFeed(const char *path, uint64_t size);
+static void reportOpen(const char *path, ManageStatus_t status);
+static void printEvent(const ChangeEvent_t *event);
+static void pauseFollow();
+static void putU16(uint8_t *bytes, uint16_t value);
+static void putU32(uint8_t *bytes, uint32_t value);
+static void putU64(uint8_t *bytes, uint64_t value);
+static uint16_t getU16(const uint8_t *bytes);
+static uint32_t getU32(const uint8_t *bytes);
+static uint64_t getU64(const uint8_t *bytes);
+
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static FILE *feed_file = NULL;                  /* The open feed, NULL if none */
+static uint8_t *feed_buffer = NULL;             /* Events not written yet */
+static uint32_t feed_length = 0;                /* Number of bytes in feed_buffer */
+static uint32_t feed_last = CHANGE_FEED_NO_EVENT;   /* Offset in feed_buffer of the last event */
+static ChangeFeedStatus_t feed_status;          /* State reported by changeFeedGetStatus() */
+static EmployeeStore_t *feed_store = NULL;      /* Store whose changes are written to the feed */
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Starts writing the changes of the store to a feed.
+ *
+ * An existing feed is read to the end once to find the next sequence number; a half-written
+ * last event is cut off, a damaged or out-of-sequence one makes the feed refused.
+ */
+ManageStatus_t changeFeedOpen(const char *path)
+{
+    ChangeFeedReader_t reader;              /* Reads an existing feed to its end */
+    ChangeEvent_t event;                    /* Event read from an existing feed */
+    ManageStatus_t status = MANAGE_OK;      /* Result of reading the existing feed */
+    uint64_t next_sequence = 1;             /* Sequence of the first new event */
+    uint64_t size = 0;                      /* Bytes of whole events in an existing feed */
+    uint32_t created = 0;                   /* Flag set if a new feed is started */
+    uint32_t torn = 0;                      /* Flag set if a half-written event follows the last whole one */
+
+    if (feed_status.open == 1 || path == NULL || path[0] == '\0' || strlen(path) >= CHANGE_FEED_MAX_PATH)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+
+    if (isPipe(path) == 1)
+    {
+        created = 1;
+    }
+    else
+    {
+        status = changeFeedReaderOpen(&reader, path, 0);
+        if (status == MANAGE_ERR_NOT_FOUND)
+        {
+            /* No file, or a file whose header was never completely written */
+            created = 1;
+        }
+        else if (status != MANAGE_OK)
+        {
+            return status;
+        }
+        else
+        {
+            do
+            {
+                status = changeFeedNext(&reader, &event);
+            } while (status == MANAGE_OK);
+            next_sequence = (reader.next_sequence == 0) ? 1 : reader.next_sequence;
+            size = reader.offset;
+            torn = (reader.end > reader.start) ? 1u : 0u;
+            changeFeedReaderClose(&reader);
+            if (status != MANAGE_ERR_NOT_FOUND)
+            {
+                return MANAGE_ERR_IO;
+            }
+            if (torn == 1 && truncateFeed(path, size) == 0)
+            {
+                return MANAGE_ERR_IO;
+            }
+        }
+    }
+
+    feed_buffer = malloc(CHANGE_FEED_BUFFER_SIZE);
+    if (feed_buffer == NULL)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+#ifndef _WIN32
+    /* A reader that closes the pipe must fail the write, not end the program */
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    feed_file = fopen(path, (created == 1) ? "wb" : "ab");
+    if (feed_file == NULL)
+    {
+        free(feed_buffer);
+        feed_buffer = NULL;
+        return MANAGE_ERR_IO;
+    }
+    /* Unbuffered: each commit reaches the file with one write */
+    setvbuf(feed_file, NULL, _IONBF, 0);
+
+    memset(&feed_status, 0, sizeof(feed_status));
+    strcpy(feed_status.path, path);
+    feed_status.open = 1;
+    feed_status.created = created;
+    feed_status.next_sequence = next_sequence;
+    feed_status.size = size;
+    feed_length = 0;
+    feed_last = CHANGE_FEED_NO_EVENT;
+    feed_store = getActiveEmployeeStore();
+
+    if (created == 1)
+    {
+        memcpy(feed_buffer, CHANGE_FEED_MAGIC, CHANGE_FEED_MAGIC_LENGTH);
+        putU32(feed_buffer + 8, CHANGE_FEED_VERSION);
+        putU32(feed_buffer + 12, 0);
+        feed_length = CHANGE_FEED_HEADER_SIZE;
+        feed_status.size = CHANGE_FEED_HEADER_SIZE;
+        writeStore();
+        changeFeedCommit();
+        if (feed_status.open == 0)
+        {
+            return MANAGE_ERR_IO;
+        }
+    }
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Writes the events not written yet and closes the feed.
+ */
+void changeFeedClose()
+{
+    if (feed_status.open == 0)
+    {
+        return;
+    }
+    changeFeedCommit();
+    if (feed_status.open == 1)
+    {
+        fclose(feed_file);
+        free(feed_buffer);
+        feed_file = NULL;
+        feed_buffer = NULL;
+        feed_status.open = 0;
+    }
+}
+
+
+/**
+ * @brief Reports the state of the feed.
+ */
+void changeFeedGetStatus(ChangeFeedStatus_t *status)
+{
+    *status = feed_status;
+}
+
+
+/**
+ * @brief Records a change of an employee; called by the store.
+ */
+void changeFeedEmployee(ChangeKind_t kind, const Employee_t *before, const Employee_t *after)
+{
+    uint32_t fields = EMPLOYEE_FIELD_ALL;   /* Changed fields */
+    uint8_t *body = NULL;                   /* Where the record is encoded */
+
+    if (feed_status.open == 0 || getActiveEmployeeStore() != feed_store)
+    {
+        return;
+    }
+    if (kind == CHANGE_UPDATE)
+    {
+        fields = employeeFields(before, after);
+        if (fields == 0)
+        {
+            return;
+        }
+    }
+    body = reserveEvent();
+    if (body != NULL)
+    {
+        finishEvent(kind, CHANGE_TABLE_EMPLOYEE, fields,
+                    encodeEmployee(body, (kind == CHANGE_DELETE) ? before : after));
+    }
+}
+
+
+/**
+ * @brief Records a change of a department; called by the store.
+ */
+void changeFeedDepartment(ChangeKind_t kind, const Department_t *before, const Department_t *after)
+{
+    uint32_t fields = DEPARTMENT_FIELD_ALL; /* Changed fields */
+    uint8_t *body = NULL;                   /* Where the record is encoded */
+
+    if (feed_status.open == 0 || getActiveEmployeeStore() != feed_store)
+    {
+        return;
+    }
+    if (kind == CHANGE_UPDATE)
+    {
+        fields = departmentFields(before, after);
+        if (fields == 0)
+        {
+            return;
+        }
+    }
+    body = reserveEvent();
+    if (body != NULL)
+    {
+        finishEvent(kind, CHANGE_TABLE_DEPARTMENT, fields,
+                    encodeDepartment(body, (kind == CHANGE_DELETE) ? before : after));
+    }
+}
+
+
+/**
+ * @brief Ends a store operation: its events are written with one write and flushed.
+ *
+ * The flags of the last event change, so its checksum is computed again.
+ */
+void changeFeedCommit()
+{
+    uint8_t *last = NULL;                   /* Last event of the operation */
+    PERF_START(perf_start);                 /* Start time of the write */
+
+    if (feed_status.open == 0 || feed_length == 0 || getActiveEmployeeStore() != feed_store)
+    {
+        return;
+    }
+    if (feed_last != CHANGE_FEED_NO_EVENT)
+    {
+        last = feed_buffer + feed_last;
+        last[19] |= CHANGE_FLAG_LAST;
+        putU32(last + 4, checksumEvent(last + 8, 12 + getU32(last)));
+    }
+    writeBuffer();
+    PERF_STOP(PERF_OP_CHANGE_FEED_COMMIT, perf_start);
+}
+
+
+/**
+ * @brief Opens a feed for reading.
+ */
+ManageStatus_t changeFeedReaderOpen(ChangeFeedReader_t *reader, const char *path, uint64_t offset)
+{
+    int64_t end = 0;                        /* Size of the feed */
+
+    memset(reader, 0, sizeof(*reader));
+    reader->file = fopen(path, "rb");
+    if (reader->file == NULL)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    reader->buffer = malloc(CHANGE_FEED_READ_SIZE);
+    if (reader->buffer == NULL)
+    {
+        changeFeedReaderClose(reader);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+
+    /* A pipe only returns fewer bytes than asked once its writer is gone */
+    while (reader->end < CHANGE_FEED_HEADER_SIZE && fillReader(reader) > 0)
+    {
+        /* Do nothing */
+    }
+    if (reader->end < CHANGE_FEED_HEADER_SIZE)
+    {
+        changeFeedReaderClose(reader);
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    if (memcmp(reader->buffer, CHANGE_FEED_MAGIC, CHANGE_FEED_MAGIC_LENGTH) != 0
+        || getU32(reader->buffer + 8) != CHANGE_FEED_VERSION)
+    {
+        changeFeedReaderClose(reader);
+        return MANAGE_ERR_IO;
+    }
+    if (offset != 0 && offset < CHANGE_FEED_HEADER_SIZE)
+    {
+        changeFeedReaderClose(reader);
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+
+    reader->start = CHANGE_FEED_HEADER_SIZE;
+    reader->offset = CHANGE_FEED_HEADER_SIZE;
+    if (offset > CHANGE_FEED_HEADER_SIZE && isPipe(path) == 0)
+    {
+        if (CHANGE_FEED_FSEEK(reader->file, 0, SEEK_END) != 0 || (end = (int64_t)CHANGE_FEED_FTELL(reader->file)) < 0
+            || (uint64_t)end < offset || CHANGE_FEED_FSEEK(reader->file, (int64_t)offset, SEEK_SET) != 0)
+        {
+            changeFeedReaderClose(reader);
+            return MANAGE_ERR_IO;
+        }
+        reader->start = 0;
+        reader->end = 0;
+        reader->offset = offset;
+    }
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Reads the next event.
+ */
+ManageStatus_t changeFeedNext(ChangeFeedReader_t *reader, ChangeEvent_t *event)
+{
+    const uint8_t *bytes = NULL;            /* The next event */
+    uint32_t length = 0;                    /* Length of its body */
+
+    for (;;)
+    {
+        bytes = reader->buffer + reader->start;
+        if (reader->end - reader->start >= CHANGE_FEED_EVENT_HEADER_SIZE)
+        {
+            length = getU32(bytes);
+            if (length > CHANGE_FEED_MAX_BODY)
+            {
+                return MANAGE_ERR_IO;
+            }
+            if (reader->end - reader->start >= CHANGE_FEED_EVENT_HEADER_SIZE + length)
+            {
+                break;
+            }
+        }
+        if (fillReader(reader) == 0)
+        {
+            return MANAGE_ERR_NOT_FOUND;
+        }
+    }
+
+    if (getU32(bytes + 4) != checksumEvent(bytes + 8, 12 + length) || decodeEvent(bytes, length, event) == 0
+        || (reader->next_sequence != 0 && event->sequence != reader->next_sequence))
+    {
+        return MANAGE_ERR_IO;
+    }
+    event->offset = reader->offset;
+    reader->start += CHANGE_FEED_EVENT_HEADER_SIZE + length;
+    reader->offset += CHANGE_FEED_EVENT_HEADER_SIZE + length;
+    reader->next_sequence = event->sequence + 1;
+    event->next_offset = reader->offset;
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Closes a reader.
+ */
+void changeFeedReaderClose(ChangeFeedReader_t *reader)
+{
+    if (reader->file != NULL)
+    {
+        fclose(reader->file);
+    }
+    free(reader->buffer);
+    reader->file = NULL;
+    reader->buffer = NULL;
+}
+
+
+/**
+ * @brief Opens the feed named by the MANAGE_CHANGE_FEED environment variable, if set. Called at start.
+ */
+void startChangeFeed()
+{
+    const char *path = getenv("MANAGE_CHANGE_FEED");    /* Feed to open, none if not set */
+
+    if (path != NULL && path[0] != '\0')
+    {
+        reportOpen(path, changeFeedOpen(path));
+    }
+}
+
+
+/**
+ * @brief Prompts the user to start the change feed, or shows it and offers to stop it.
+ */
+void manageChangeFeed()
+{
+    char path[CHANGE_FEED_MAX_PATH];        /* File entered by the user */
+    ChangeFeedStatus_t status;              /* State of the feed */
+    int8_t choice = 0;                      /* Action chosen by the user */
+
+    changeFeedGetStatus(&status);
+    if (status.open == 1)
+    {
+        printf("Change feed %s is open: next sequence %llu, %llu bytes.\n", status.path,
+               (unsigned long long)status.next_sequence, (unsigned long long)status.size);
+        printf("Enter 's' to stop the change feed or any other key to keep it: ");
+        choice = getSingleCharInput();
+        if (choice == 's')
+        {
+            changeFeedClose();
+            printf("Stopped the change feed, changes are not recorded any more.\n");
+        }
+        return;
+    }
+    if (status.failed == 1)
+    {
+        printf("Change feed %s stopped because it could not be written, its readers must copy the data again.\n",
+               status.path);
+    }
+
+    printf("Enter change feed file (or press Enter for %s): ", CHANGE_FEED_DEFAULT_PATH);
+    fflush(stdin);
+    if (fgets(path, sizeof(path), stdin) == NULL)
+    {
+        return;
+    }
+    /* Remove newline character, spaces are allowed in file names */
+    path[strcspn(path, "\r\n")] = '\0';
+    if (path[0] == '\0')
+    {
+        strcpy(path, CHANGE_FEED_DEFAULT_PATH);
+    }
+    reportOpen(path, changeFeedOpen(path));
+}
+
+
+/**
+ * @brief Closes the feed, if any. Called when the program exits.
+ */
+void stopChangeFeed()
+{
+    changeFeedClose();
+}
+
+
+/**
+ * @brief Prints the events of a feed from the command line, one line each.
+ */
+int32_t changeFeedCommand(int argc, char *argv[])
+{
+    ChangeFeedReader_t reader;              /* The feed */
+    ChangeEvent_t event;                    /* Event read */
+    uint64_t offset = 0;                    /* Offset to start at */
+    uint32_t follow = 0;                    /* Flag set to wait for new events at the end */
+    uint32_t printed = 0;                   /* Number of events printed */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the last read */
+
+    if (argc > 3 && strcmp(argv[argc - 1], "--follow") == 0)
+    {
+        follow = 1;
+        argc -= 1;
+    }
+    if (argc < 3 || argc > 4
+        || (argc == 4 && parseUnsignedField((const int8_t *)argv[3], strlen(argv[3]), UINT64_MAX, &offset) != PARSE_OK))
+    {
+        printf("Usage: %s --change-feed <path> [offset] [--follow]\n", argv[0]);
+        return 2;
+    }
+    status = changeFeedReaderOpen(&reader, argv[2], offset);
+    if (status == MANAGE_ERR_NOT_FOUND)
+    {
+        printf("Cannot read change feed %s\n", argv[2]);
+        return 2;
+    }
+    if (status == MANAGE_ERR_INVALID_ARGUMENT)
+    {
+        printf("Offset %llu is inside the header, use 0 to read from the first event\n", (unsigned long long)offset);
+        return 2;
+    }
+    if (status != MANAGE_OK)
+    {
+        printf("%s is not a change feed, or offset %llu is past its end\n", argv[2], (unsigned long long)offset);
+        return 2;
+    }
+
+    do
+    {
+        status = changeFeedNext(&reader, &event);
+        if (status == MANAGE_OK)
+        {
+            printEvent(&event);
+            printed += 1;
+        }
+        else if (status == MANAGE_ERR_NOT_FOUND && follow == 1)
+        {
+            fflush(stdout);
+            pauseFollow();
+            status = MANAGE_OK;
+        }
+    } while (status == MANAGE_OK);
+
+    printf("%u events, next offset %llu\n", printed, (unsigned long long)reader.offset);
+    if (status == MANAGE_ERR_IO)
+    {
+        printf("The event at offset %llu is damaged or out of sequence\n", (unsigned long long)reader.offset);
+    }
+    changeFeedReaderClose(&reader);
+    return (status == MANAGE_ERR_IO) ? 2 : 0;
+}
+
+
+/**
+ * @brief Returns where the next event is encoded, writing the buffer first if it may not fit.
+ *
+ * @return The body of the event, or NULL if the feed failed.
+ */
+static uint8_t* reserveEvent()
+{
+    if (feed_length + CHANGE_FEED_EVENT_HEADER_SIZE + CHANGE_FEED_MAX_BODY > CHANGE_FEED_BUFFER_SIZE)
+    {
+        writeBuffer();
+        if (feed_status.open == 0)
+        {
+            return NULL;
+        }
+    }
+    return feed_buffer + feed_length + CHANGE_FEED_EVENT_HEADER_SIZE;
+}
+
+
+/**
+ * @brief Writes the header of the event whose body was encoded at reserveEvent().
+ */
+static void finishEvent(ChangeKind_t kind, ChangeTable_t table, uint32_t fields, uint32_t length)
+{
+    uint8_t *bytes = feed_buffer + feed_length;     /* The event */
+
+    putU32(bytes, length);
+    putU64(bytes + 8, feed_status.next_sequence);
+    bytes[16] = (uint8_t)kind;
+    bytes[17] = (uint8_t)table;
+    bytes[18] = (uint8_t)fields;
+    bytes[19] = 0;
+    putU32(bytes + 4, checksumEvent(bytes + 8, 12 + length));
+    feed_last = feed_length;
+    feed_length += CHANGE_FEED_EVENT_HEADER_SIZE + length;
+    feed_status.next_sequence += 1;
+    feed_status.size += CHANGE_FEED_EVENT_HEADER_SIZE + length;
+}
+
+
+/**
+ * @brief Writes the buffer to the feed and empties it.
+ */
+static void writeBuffer()
+{
+    if (fwrite(feed_buffer, 1, feed_length, feed_file) != feed_length)
+    {
+        failFeed();
+        return;
+    }
+    feed_length = 0;
+    feed_last = CHANGE_FEED_NO_EVENT;
+}
+
+
+/**
+ * @brief Closes a feed that could not be written; the events in memory are lost.
+ */
+static void failFeed()
+{
+    fclose(feed_file);
+    free(feed_buffer);
+    feed_file = NULL;
+    feed_buffer = NULL;
+    feed_length = 0;
+    feed_last = CHANGE_FEED_NO_EVENT;
+    feed_status.open = 0;
+    feed_status.failed = 1;
+}
+
+
+/**
+ * @brief Records every stored department and employee as inserted, to start a new feed.
+ */
+static void writeStore()
+{
+    uint32_t i = 0;                         /* Index for looping through the store */
+
+    for (i = 0; i < getTotalDepartments() && feed_status.open == 1; i++)
+    {
+        changeFeedDepartment(CHANGE_INSERT, NULL, getDepartmentAt(i));
+    }
+    for (i = 0; i < getTotalEmployees() && feed_status.open == 1; i++)
+    {
+        changeFeedEmployee(CHANGE_INSERT, NULL, getEmployeeAt(i));
+    }
+}
+
+
+/**
+ * @brief Returns the EMPLOYEE_FIELD_* flags of the fields that differ between two records.
+ */
+static uint32_t employeeFields(const Employee_t *before, const Employee_t *after)
+{
+    uint32_t fields = 0;                    /* Changed fields */
+
+    fields |= (strcmp(before->name, after->name) != 0) ? EMPLOYEE_FIELD_NAME : 0u;
+    fields |= (strcmp(before->department_id, after->department_id) != 0) ? EMPLOYEE_FIELD_DEPARTMENT : 0u;
+    fields |= (before->salary_base != after->salary_base) ? EMPLOYEE_FIELD_SALARY_BASE : 0u;
+    fields |= (before->working_days != after->working_days) ? EMPLOYEE_FIELD_WORKING_DAYS : 0u;
+    fields |= (memcmp(&before->working_performance, &after->working_performance, sizeof(float)) != 0)
+              ? EMPLOYEE_FIELD_WORKING_PERFORMANCE : 0u;
+    fields |= (before->bonus != after->bonus) ? EMPLOYEE_FIELD_BONUS : 0u;
+    fields |= (before->late_coming_days != after->late_coming_days) ? EMPLOYEE_FIELD_LATE_COMING_DAYS : 0u;
+    return fields;
+}
+
+
+/**
+ * @brief Returns the DEPARTMENT_FIELD_* flags of the fields that differ between two records.
+ */
+static uint32_t departmentFields(const Department_t *before, const Department_t *after)
+{
+    uint32_t fields = 0;                    /* Changed fields */
+
+    fields |= (before->bonus_salary != after->bonus_salary) ? DEPARTMENT_FIELD_BONUS : 0u;
+    fields |= (before->raise_factor != after->raise_factor) ? DEPARTMENT_FIELD_RAISE : 0u;
+    return fields;
+}
+
+
+/**
+ * @brief Encodes the body of an employee event.
+ *
+ * @return Length of the body.
+ */
+static uint32_t encodeEmployee(uint8_t *body, const Employee_t *employee)
+{
+    uint32_t length = 0;                    /* Bytes encoded */
+    uint32_t performance = 0;               /* Bits of the working performance */
+
+    length += encodeString(body + length, employee->id, MAX_ID_LENGTH);
+    length += encodeString(body + length, employee->department_id, MAX_ID_LENGTH);
+    length += encodeString(body + length, employee->name, MAX_NAME_LENGTH);
+    memcpy(&performance, &employee->working_performance, sizeof(performance));
+    putU64(body + length, (uint64_t)employee->salary_base);
+    putU64(body + length + 8, (uint64_t)employee->bonus);
+    putU32(body + length + 16, performance);
+    putU16(body + length + 20, (uint16_t)employee->working_days);
+    putU16(body + length + 22, (uint16_t)employee->late_coming_days);
+    return length + 24;
+}
+
+
+/**
+ * @brief Encodes the body of a department event.
+ *
+ * @return Length of the body.
+ */
+static uint32_t encodeDepartment(uint8_t *body, const Department_t *department)
+{
+    uint32_t length = encodeString(body, department->id, MAX_ID_LENGTH);   /* Bytes encoded */
+
+    putU64(body + length, department->bonus_salary);
+    putU32(body + length + 8, department->raise_factor);
+    return length + 12;
+}
+
+
+/**
+ * @brief Encodes a string field as its length and its bytes.
+ *
+ * @param bytes Where to encode.
+ * @param text The field.
+ * @param size Size of the field; a field without terminator is cut at 255 bytes or its size.
+ * @return Bytes encoded.
+ */
+static uint32_t encodeString(uint8_t *bytes, const int8_t *text, uint32_t size)
+{
+    uint32_t length = 0;                    /* Length of the string */
+
+    while (length < size && length < UINT8_MAX && text[length] != '\0')
+    {
+        length++;
+    }
+    bytes[0] = (uint8_t)length;
+    memcpy(bytes + 1, text, length);
+    return length + 1;
+}
+
+
+/**
+ * @brief Decodes an event whose checksum was verified.
+ *
+ * @param bytes The event.
+ * @param length Length of its body.
+ * @param event Receives the event; offsets are left to the caller.
+ * @return 1 on success, 0 if the event is malformed or a value does not fit this build.
+ */
+static uint32_t decodeEvent(const uint8_t *bytes, uint32_t length, ChangeEvent_t *event)
+{
+    const uint8_t *body = bytes + CHANGE_FEED_EVENT_HEADER_SIZE;   /* The body */
+    uint32_t used = 0;                      /* Bytes of the body decoded */
+    uint32_t part = 0;                      /* Bytes of the last string decoded */
+    uint64_t salary_base = 0;               /* Decoded salary base */
+    uint64_t bonus = 0;                     /* Decoded bonus */
+    uint16_t working_days = 0;              /* Decoded working days */
+    uint16_t late_coming_days = 0;          /* Decoded late coming days */
+    uint32_t performance = 0;               /* Bits of the working performance */
+
+    event->sequence = getU64(bytes + 8);
+    event->kind = (ChangeKind_t)bytes[16];
+    event->table = (ChangeTable_t)bytes[17];
+    event->fields = bytes[18];
+    event->flags = bytes[19];
+    if (event->kind < CHANGE_INSERT || event->kind > CHANGE_DELETE)
+    {
+        return 0;
+    }
+
+    if (event->table == CHANGE_TABLE_EMPLOYEE)
+    {
+        memset(&event->employee, 0, sizeof(event->employee));
+        if (decodeString(body, length, &part, event->employee.id, MAX_ID_LENGTH) == 0)
+        {
+            return 0;
+        }
+        used = part;
+        if (decodeString(body + used, length - used, &part, event->employee.department_id, MAX_ID_LENGTH) == 0)
+        {
+            return 0;
+        }
+        used += part;
+        if (decodeString(body + used, length - used, &part, event->employee.name, MAX_NAME_LENGTH) == 0
+            || length - used - part != 24)
+        {
+            return 0;
+        }
+        used += part;
+        salary_base = getU64(body + used);
+        bonus = getU64(body + used + 8);
+        performance = getU32(body + used + 16);
+        working_days = getU16(body + used + 20);
+        late_coming_days = getU16(body + used + 22);
+        if (salary_base > EMPLOYEE_MAX_AMOUNT || bonus > EMPLOYEE_MAX_AMOUNT)
+        {
+            return 0;
+        }
+#if MANAGE_COMPACT_MODE
+        /* Day counts are 16 bits in the feed, a compact record only holds 8 */
+        if (working_days > EMPLOYEE_MAX_DAYS || late_coming_days > EMPLOYEE_MAX_DAYS)
+        {
+            return 0;
+        }
+#endif
+        event->employee.salary_base = (EmployeeAmount_t)salary_base;
+        event->employee.bonus = (EmployeeAmount_t)bonus;
+        memcpy(&event->employee.working_performance, &performance, sizeof(performance));
+        event->employee.working_days = (EmployeeDays_t)working_days;
+        event->employee.late_coming_days = (EmployeeDays_t)late_coming_days;
+        return 1;
+    }
+    if (event->table == CHANGE_TABLE_DEPARTMENT)
+    {
+        memset(&event->department, 0, sizeof(event->department));
+        if (decodeString(body, length, &used, event->department.id, MAX_ID_LENGTH) == 0 || length - used != 12)
+        {
+            return 0;
+        }
+        event->department.bonus_salary = getU64(body + used);
+        event->department.raise_factor = getU32(body + used + 8);
+        return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Decodes a string field.
+ *
+ * @param bytes The encoded string.
+ * @param length Bytes left in the body.
+ * @param used Receives the bytes of the encoded string.
+ * @param text Receives the string, terminated by '\0'.
+ * @param size Size of text.
+ * @return 1 on success, 0 if the string runs past the body or does not fit text.
+ */
+static uint32_t decodeString(const uint8_t *bytes, uint32_t length, uint32_t *used, int8_t *text, uint32_t size)
+{
+    if (length == 0 || (uint32_t)bytes[0] + 1 > length || bytes[0] >= size)
+    {
+        return 0;
+    }
+    memcpy(text, bytes + 1, bytes[0]);
+    text[bytes[0]] = '\0';
+    *used = (uint32_t)bytes[0] + 1;
+    return 1;
+}
+
+
+/**
+ * @brief Moves the bytes not decoded yet to the start of the buffer and reads more after them.
+ *
+ * @return Number of bytes read, 0 at the end of the feed.
+ */
+static uint32_t fillReader(ChangeFeedReader_t *reader)
+{
+    uint32_t count = 0;                     /* Bytes read */
+
+    if (reader->start > 0)
+    {
+        memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+    count = (uint32_t)fread(reader->buffer + reader->end, 1, CHANGE_FEED_READ_SIZE - reader->end, reader->file);
+    if (count == 0)
+    {
+        /* Forget the end of the file, the writer may append after it */
+        clearerr(reader->file);
+    }
+    reader->end += count;
+    return count;
+}
+
+
+/**
+ * @brief Returns the FNV-1a checksum of the bytes of an event from its sequence number on.
+ */
+static uint32_t checksumEvent(const uint8_t *bytes, uint32_t length)
+{
+    uint32_t hash = CHANGE_FEED_FNV_OFFSET; /* Running checksum */
+    uint32_t i = 0;                         /* Index for looping through bytes */
+
+    for (i = 0; i < length; i++)
+    {
+        hash = (hash ^ bytes[i]) * CHANGE_FEED_FNV_PRIME;
+    }
+    return hash;
+}
+
+
+/**
+ * @brief Returns 1 if a path names a pipe, which is written and read without seeking.
+ */
+static uint32_t isPipe(const char *path)
+{
+#ifdef _WIN32
+    return (strncmp(path, "\\\\.\\pipe\\", 9) == 0) ? 1u : 0u;
+#else
+    struct stat info;                       /* Type of the file */
+
+    return (stat(path, &info) == 0 && S_ISFIFO(info.st_mode)) ? 1u : 0u;
+#endif
+}
+
+
+/**
+ * @brief Cuts a feed after its last whole event.
+ *
+ * @return 1 on success, 0 on error.
+ */
+static uint32_t truncateFeed(const char *path, uint64_t size)
+{
+    FILE *file = fopen(path, "r+b");        /* The feed */
+    uint32_t ok = 0;                        /* Result of the truncation */
+
+    if (file == NULL)
+    {
+        return 0;
+    }
+#ifdef _WIN32
+    ok = (_chsize_s(_fileno(file), (__int64)size) == 0) ? 1u : 0u;
+#else
+    ok = (ftruncate(fileno(file), (off_t)size) == 0) ? 1u : 0u;
+#endif
+    fclose(file);
+    return ok;
+}
+
+
+/**
+ * @brief Tells the user what changeFeedOpen() did.
+ */
+static void reportOpen(const char *path, ManageStatus_t status)
+{
+    ChangeFeedStatus_t feed;                /* State of the opened feed */
+
+    if (status == MANAGE_ERR_INVALID_ARGUMENT)
+    {
+        printf("Change feed file name %s is not valid\n", path);
+        return;
+    }
+    if (status == MANAGE_ERR_NO_MEMORY)
+    {
+        printf("Not enough memory to open change feed %s!!!\n", path);
+        return;
+    }
+    if (status != MANAGE_OK)
+    {
+        printf("Cannot write change feed %s, or the file is damaged or is not a change feed\n", path);
+        return;
+    }
+    changeFeedGetStatus(&feed);
+    if (feed.created == 1)
+    {
+        printf("Started change feed %s with %u departments and %u employees.\n", path,
+               getTotalDepartments(), getTotalEmployees());
+    }
+    else
+    {
+        printf("Continuing change feed %s from sequence %llu.\n", path, (unsigned long long)feed.next_sequence);
+    }
+    printf("Other programs can read it with --change-feed %s [offset] [--follow].\n", path);
+}
+
+
+/**
+ * @brief Prints one event on one line.
+ */
+static void printEvent(const ChangeEvent_t *event)
+{
+    static const char *kinds[] = {"", "insert", "update", "delete"};   /* Name of each kind */
+
+    if (event->table == CHANGE_TABLE_EMPLOYEE)
+    {
+        printf("#%llu @%llu %s employee %s: department %s, name %s, salary base %llu, working days %u, "
+               "performance %.2f, bonus %llu, late days %u, fields 0x%02X%s\n",
+               (unsigned long long)event->sequence, (unsigned long long)event->offset, kinds[event->kind],
+               event->employee.id, event->employee.department_id, event->employee.name,
+               (unsigned long long)event->employee.salary_base, (uint32_t)event->employee.working_days,
+               event->employee.working_performance, (unsigned long long)event->employee.bonus,
+               (uint32_t)event->employee.late_coming_days, event->fields,
+               ((event->flags & CHANGE_FLAG_LAST) != 0) ? " (end of operation)" : "");
+    }
+    else
+    {
+        printf("#%llu @%llu %s department %s: bonus %llu, raise factor %u, fields 0x%02X%s\n",
+               (unsigned long long)event->sequence, (unsigned long long)event->offset, kinds[event->kind],
+               event->department.id, (unsigned long long)event->department.bonus_salary,
+               event->department.raise_factor, event->fields,
+               ((event->flags & CHANGE_FLAG_LAST) != 0) ? " (end of operation)" : "");
+    }
+}
+
+
+/**
+ * @brief Waits before the end of a followed feed is read again.
+ */
+static void pauseFollow()
+{
+#ifdef _WIN32
+    Sleep(CHANGE_FEED_FOLLOW_DELAY_MS);
+#else
+    struct timespec delay = {0, CHANGE_FEED_FOLLOW_DELAY_MS * 1000000L};   /* Time to wait */
+
+    nanosleep(&delay, NULL);
+#endif
+}
+
+
+/**
+ * @brief Stores a 16-bit value in little-endian order.
+ */
+static void putU16(uint8_t *bytes, uint16_t value)
+{
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+}
+
+
+/**
+ * @brief Stores a 32-bit value in little-endian order.
+ */
+static void putU32(uint8_t *bytes, uint32_t value)
+{
+    uint32_t i = 0;                         /* Index for looping through bytes */
+
+    for (i = 0; i < 4; i++)
+    {
+        bytes[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+
+/**
+ * @brief Stores a 64-bit value in little-endian order.
+ */
+static void putU64(uint8_t *bytes, uint64_t value)
+{
+    putU32(bytes, (uint32_t)value);
+    putU32(bytes + 4, (uint32_t)(value >> 32));
+}
+
+
+/**
+ * @brief Reads a little-endian 16-bit value.
+ */
+static uint16_t getU16(const uint8_t *bytes)
+{
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+
+/**
+ * @brief Reads a little-endian 32-bit value.
+ */
+static uint32_t getU32(const uint8_t *bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+
+/**
+ * @brief Reads a little-endian 64-bit value.
+ */
+static uint64_t getU64(const uint8_t *bytes)
+{
+    return (uint64_t)getU32(bytes) | ((uint64_t)getU32(bytes + 4) << 32);
+} /* EOF */
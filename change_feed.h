@@ -0,0 +1,236 @@
+/**
+ * @file change_feed.h
+ * @brief This file contains the function prototypes of the change feed of the employee and department tables.
+ *
+ * While a feed is open, every change of the store is appended to it as an event: an employee
+ * or a department inserted, updated or deleted. Other programs read the feed from the start to
+ * copy the tables, then from where they stopped to stay in sync, instead of exporting the whole
+ * tables again. A new feed starts with one insert event per stored department and employee, so
+ * reading it from the start rebuilds the current tables.
+ *
+ * Events are numbered from 1 without gaps and written in the order of the changes. The events
+ * of one store operation (a batch, a menu action) are written together with a single write,
+ * and the last one carries CHANGE_FLAG_LAST, so a reader can apply whole operations. A reader
+ * keeps the offset after the last event it applied and opens the feed there next time. The
+ * feed may also be a named pipe, read as it is written.
+ *
+ * Layout, all numbers little-endian, strings without terminator:
+ *     header: 8 magic "MECDC001", 4 version (1), 4 reserved (0)
+ *     event:  4 length of the body, 4 checksum of the bytes from the sequence to the end of the
+ *             body, 8 sequence, 1 kind, 1 table, 1 changed fields, 1 flags, then the body
+ *     employee body:   id, department_id and name, each a 1-byte length and the bytes, then
+ *                      8 salary_base, 8 bonus, 4 working_performance (IEEE 754 single),
+ *                      2 working_days, 2 late_coming_days
+ *     department body: id as a 1-byte length and the bytes, 8 bonus_salary, 4 raise_factor
+ * Insert and update events carry the new record, delete events the deleted record. Department
+ * employee counts are not part of the feed: a reader derives them from the employees.
+ *
+ * A feed that is opened again is continued: an event left half-written by a crash is cut off
+ * first. Changes made while no feed is open, or before a snapshot was loaded, are not in it.
+ * The feed follows the store selected when it was opened (see selectEmployeeStore()); changes
+ * of other stores are not recorded.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef CHANGE_FEED_H
+#define CHANGE_FEED_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdio.h>              /* Include standard input and output library for FILE */
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for Employee_t, Department_t and ManageStatus_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define CHANGE_FEED_DEFAULT_PATH "employees.cdc"    /* Feed opened from the menu when no file is given */
+#define CHANGE_FEED_HEADER_SIZE 16u         /* Bytes before the first event */
+#define CHANGE_FEED_EVENT_HEADER_SIZE 20u   /* Bytes of an event before its body */
+#define CHANGE_FEED_MAX_BODY 792u           /* Longest body the layout allows: three 255-byte strings and the numbers */
+#define CHANGE_FEED_BUFFER_SIZE (1u << 20)  /* Events kept in memory before they are written */
+#define CHANGE_FEED_MAX_PATH 260            /* Size of a file name */
+#define CHANGE_FLAG_LAST 0x01u              /* Last event of a store operation */
+
+/**
+ * @brief What happened to a record.
+ */
+typedef enum ChangeKind {
+    CHANGE_INSERT = 1,                      /* The record was added */
+    CHANGE_UPDATE = 2,                      /* Some fields of the record changed */
+    CHANGE_DELETE = 3                       /* The record was deleted */
+} ChangeKind_t;
+
+/**
+ * @brief Table of the changed record.
+ */
+typedef enum ChangeTable {
+    CHANGE_TABLE_EMPLOYEE = 1,              /* An employee, fields are EMPLOYEE_FIELD_* flags */
+    CHANGE_TABLE_DEPARTMENT = 2             /* A department, fields are DEPARTMENT_FIELD_* flags */
+} ChangeTable_t;
+
+/**
+ * @brief Fields of a department in the changed fields of an event.
+ */
+typedef enum DepartmentField {
+    DEPARTMENT_FIELD_BONUS = 0x01,          /* bonus_salary */
+    DEPARTMENT_FIELD_RAISE = 0x02,          /* raise_factor */
+    DEPARTMENT_FIELD_ALL = 0x03             /* Every field above */
+} DepartmentField_t;
+
+/**
+ * @brief One event read from a feed.
+ */
+typedef struct ChangeEvent {
+    uint64_t sequence;                      /* Number of the event, the first one is 1 */
+    uint64_t offset;                        /* Offset of the event in the feed */
+    uint64_t next_offset;                   /* Offset of the next event, where to resume after this one */
+    ChangeKind_t kind;                      /* What happened to the record */
+    ChangeTable_t table;                    /* Which of employee and department is set */
+    uint32_t fields;                        /* Changed fields; every field for inserts and deletes */
+    uint32_t flags;                         /* CHANGE_FLAG_* flags */
+    Employee_t employee;                    /* The employee, if table is CHANGE_TABLE_EMPLOYEE */
+    Department_t department;                /* The department (employee_count is 0), if table is CHANGE_TABLE_DEPARTMENT */
+} ChangeEvent_t;
+
+/**
+ * @brief Reader of a feed.
+ */
+typedef struct ChangeFeedReader {
+    FILE *file;                             /* The feed */
+    uint8_t *buffer;                        /* Bytes read and not decoded yet */
+    uint32_t start;                         /* First byte of buffer not decoded yet */
+    uint32_t end;                           /* End of the bytes read into buffer */
+    uint64_t offset;                        /* Offset in the feed of buffer[start] */
+    uint64_t next_sequence;                 /* Sequence expected next, 0 before the first event */
+} ChangeFeedReader_t;
+
+/**
+ * @brief State of the feed the store writes to.
+ */
+typedef struct ChangeFeedStatus {
+    char path[CHANGE_FEED_MAX_PATH];        /* File of the feed */
+    uint32_t open;                          /* 1 while changes are written to the feed */
+    uint32_t failed;                        /* 1 if the feed was closed because it could not be written */
+    uint32_t created;                       /* 1 if the feed was started by the last changeFeedOpen() */
+    uint64_t next_sequence;                 /* Sequence of the next event */
+    uint64_t size;                          /* Bytes in the feed, including events not written yet */
+} ChangeFeedStatus_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Starts writing the changes of the store to a feed.
+ *
+ * A file that does not exist or is empty, and a named pipe, start a new feed with the stored
+ * departments and employees; an existing feed is checked and continued.
+ *
+ * @param path The file or named pipe; opening a pipe waits for its reader.
+ * @return MANAGE_OK, MANAGE_ERR_INVALID_ARGUMENT if a feed is already open, MANAGE_ERR_IO if
+ *         the file cannot be written or is not a feed or is damaged, or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t changeFeedOpen(const char *path);
+
+/**
+ * @brief Writes the events not written yet and closes the feed.
+ */
+void changeFeedClose();
+
+/**
+ * @brief Reports the state of the feed.
+ */
+void changeFeedGetStatus(ChangeFeedStatus_t *status);
+
+/**
+ * @brief Records a change of an employee; called by the store.
+ *
+ * The event is kept in memory until changeFeedCommit(). Nothing is done if no feed is open or
+ * an update changes nothing.
+ *
+ * @param kind What happened.
+ * @param before The record before the change, NULL for an insert.
+ * @param after The record after the change, NULL for a delete.
+ */
+void changeFeedEmployee(ChangeKind_t kind, const Employee_t *before, const Employee_t *after);
+
+/**
+ * @brief Records a change of a department; called by the store.
+ *
+ * The employee count is not compared: an update that only changes it records nothing.
+ *
+ * @param kind What happened.
+ * @param before The record before the change, NULL for an insert.
+ * @param after The record after the change, NULL for a delete.
+ */
+void changeFeedDepartment(ChangeKind_t kind, const Department_t *before, const Department_t *after);
+
+/**
+ * @brief Ends a store operation: its events are written with one write and flushed.
+ *
+ * If the feed cannot be written it is closed and marked failed; readers then have to copy the
+ * tables again, as events are missing.
+ */
+void changeFeedCommit();
+
+/**
+ * @brief Opens a feed for reading.
+ *
+ * @param reader The reader.
+ * @param path The file or named pipe.
+ * @param offset Offset to start at: 0 for the first event, or the next_offset of the last
+ *        event applied. A named pipe is always read from where it is.
+ * @return MANAGE_OK, MANAGE_ERR_NOT_FOUND if the file cannot be opened or its header is not
+ *         written yet, MANAGE_ERR_IO if it is not a feed or the offset is past its end,
+ *         MANAGE_ERR_INVALID_ARGUMENT if the offset is inside the header, or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t changeFeedReaderOpen(ChangeFeedReader_t *reader, const char *path, uint64_t offset);
+
+/**
+ * @brief Reads the next event.
+ *
+ * At the end of the feed, or when the next event is not completely written yet, the reader
+ * stays where it is and may be called again later to see new events.
+ *
+ * @return MANAGE_OK, MANAGE_ERR_NOT_FOUND if no complete event follows yet, or MANAGE_ERR_IO
+ *         if the event is damaged, out of sequence or does not fit the records of this build.
+ */
+ManageStatus_t changeFeedNext(ChangeFeedReader_t *reader, ChangeEvent_t *event);
+
+/**
+ * @brief Closes a reader.
+ */
+void changeFeedReaderClose(ChangeFeedReader_t *reader);
+
+/**
+ * @brief Opens the feed named by the MANAGE_CHANGE_FEED environment variable, if set. Called at start.
+ */
+void startChangeFeed();
+
+/**
+ * @brief Prompts the user to start the change feed, or shows it and offers to stop it.
+ */
+void manageChangeFeed();
+
+/**
+ * @brief Closes the feed, if any. Called when the program exits.
+ */
+void stopChangeFeed();
+
+/**
+ * @brief Prints the events of a feed from the command line, one line each.
+ *
+ *     --change-feed <path> [offset] [--follow]
+ *
+ * With --follow, the command keeps waiting for new events instead of stopping at the end.
+ *
+ * @param argc Number of arguments, as given to main().
+ * @param argv Arguments, as given to main().
+ * @return Exit code: 0 on success, 2 on error.
+ */
+int32_t changeFeedCommand(int argc, char *argv[]);
+
+#endif /* CHANGE_FEED_H */
@@ -0,0 +1,540 @@
+/**
+ * @file employee_sort.c
+ * @brief This file contains the implementation of the employee sort orders.
+ *
+ * The keys of an order are applied from the least significant to the most significant one
+ * with a stable sort, so each key only has to order the employees it finds equal. A key is
+ * extracted into 64 bits that compare like the field (floats are turned into ordered
+ * integers, strings keep their first 8 bytes) and sorted with a least-significant-digit radix
+ * sort, one byte per pass; a pass is skipped when all values share that byte. Strings longer
+ * than 8 bytes can still be equal on those bytes, so each run of equal values is then radix
+ * sorted on the next 8 bytes, and so on; short runs are merge sorted on the rest of the strings.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdlib.h>             /* Include standard library for malloc, realloc, free */
+#include <string.h>             /* Include string manipulation library for memcpy, memset, strcmp */
+#include "employee_sort.h"      /* Include header file */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define SORT_RADIX_BITS 8                   /* Bits sorted per radix pass */
+#define SORT_RADIX_BUCKETS (1u << SORT_RADIX_BITS)     /* Buckets per radix pass */
+#define SORT_RADIX_PASSES (64 / SORT_RADIX_BITS)       /* Passes over a 64-bit value */
+#define SORT_KEY_LENGTH MAX_NAME_LENGTH     /* Size of a name's sort key, including the terminator */
+#define SORT_MERGE_THRESHOLD 64             /* Runs up to this length are merge sorted instead of radix sorted */
+
+/**
+ * @brief Sort value of an employee and its store position.
+ */
+typedef struct SortPair {
+    uint64_t value;                         /* Value compared by the radix sort */
+    uint32_t position;                      /* Store position of the employee */
+} SortPair_t;
+
+/**
+ * @brief Entry of a run of equal values, sorted on the full string.
+ */
+typedef struct SortRunEntry {
+    const int8_t *text;                     /* Full string compared */
+    uint32_t position;                      /* Store position of the employee */
+} SortRunEntry_t;
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static ManageStatus_t sortByKey(const EmployeeSortKey_t *key, uint32_t *order, uint32_t count,
+                                uint64_t *values, SortPair_t *pairs, SortPair_t *scratch);
+static uint64_t extractValue(EmployeeSortField_t field, const Employee_t *employee);
+static SortPair_t* radixSort(SortPair_t *pairs, SortPair_t *scratch, uint32_t count);
+static ManageStatus_t sortEqualRuns(const EmployeeSortKey_t *key, SortPair_t *pairs, uint32_t count);
+static void refineRun(SortRunEntry_t *entries, SortRunEntry_t *entry_scratch, SortPair_t *pairs,
+                      SortPair_t *pair_scratch, uint32_t count, uint32_t offset, uint8_t descending);
+static void mergeSortRun(SortRunEntry_t *entries, SortRunEntry_t *scratch, uint32_t count, uint32_t offset,
+                         uint8_t descending);
+static uint32_t nameSortKey(const int8_t *name, int8_t *key);
+static uint64_t packPrefix(const int8_t *text);
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Sorts the stored employees without moving them.
+ */
+ManageStatus_t sortEmployeeOrder(const EmployeeSortKey_t *keys, uint32_t key_count, uint32_t *order)
+{
+    uint32_t count = getTotalEmployees();   /* Number of employees to sort */
+    SortPair_t *pairs = NULL;               /* Values being sorted */
+    SortPair_t *scratch = NULL;             /* Second buffer of the radix sort */
+    uint64_t *values = NULL;                /* Value of each employee, in store order */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the sort */
+    uint32_t i = 0;                         /* Index for looping through employees and keys */
+
+    if (key_count == 0 || key_count > EMPLOYEE_SORT_MAX_KEYS)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    for (i = 0; i < key_count; i++)
+    {
+        if ((uint32_t)keys[i].field >= SORT_FIELD_COUNT)
+        {
+            return MANAGE_ERR_INVALID_ARGUMENT;
+        }
+    }
+    for (i = 0; i < count; i++)
+    {
+        order[i] = i;
+    }
+    if (count < 2)
+    {
+        return MANAGE_OK;
+    }
+
+    pairs = malloc((size_t)count * sizeof(*pairs));
+    scratch = malloc((size_t)count * sizeof(*scratch));
+    values = malloc((size_t)count * sizeof(*values));
+    if (pairs == NULL || scratch == NULL || values == NULL)
+    {
+        status = MANAGE_ERR_NO_MEMORY;
+    }
+    /* Least significant key first; each sort is stable, so earlier keys break the ties of later ones */
+    for (i = key_count; i > 0 && status == MANAGE_OK; i--)
+    {
+        status = sortByKey(&keys[i - 1], order, count, values, pairs, scratch);
+    }
+    free(pairs);
+    free(scratch);
+    free(values);
+    return status;
+}
+
+
+/**
+ * @brief Compares two full names the way SORT_BY_NAME orders them.
+ */
+int32_t compareEmployeeNames(const int8_t *first, const int8_t *second)
+{
+    int8_t first_key[SORT_KEY_LENGTH];      /* Sort key of the first name */
+    int8_t second_key[SORT_KEY_LENGTH];     /* Sort key of the second name */
+
+    nameSortKey(first, first_key);
+    nameSortKey(second, second_key);
+    return strcmp((const char*)first_key, (const char*)second_key);
+}
+
+
+/**
+ * @brief Stable sort of an order by one key.
+ *
+ * The values are extracted in store order, which reads the records sequentially, and only
+ * then gathered in the current order.
+ *
+ * @return MANAGE_OK or MANAGE_ERR_NO_MEMORY.
+ */
+static ManageStatus_t sortByKey(const EmployeeSortKey_t *key, uint32_t *order, uint32_t count,
+                                uint64_t *values, SortPair_t *pairs, SortPair_t *scratch)
+{
+    SortPair_t *sorted = NULL;              /* Buffer holding the sorted pairs */
+    uint64_t flip = (key->descending != 0) ? UINT64_MAX : 0;  /* Inverts the values of a descending key */
+    ManageStatus_t status = MANAGE_OK;      /* Result of sorting the equal runs */
+    uint32_t i = 0;                         /* Index for looping through the order */
+
+    for (i = 0; i < count; i++)
+    {
+        values[i] = extractValue(key->field, getEmployeeAt(i)) ^ flip;
+    }
+    for (i = 0; i < count; i++)
+    {
+        pairs[i].value = values[order[i]];
+        pairs[i].position = order[i];
+    }
+    sorted = radixSort(pairs, scratch, count);
+    if (key->field == SORT_BY_NAME || key->field == SORT_BY_DEPARTMENT)
+    {
+        status = sortEqualRuns(key, sorted, count);
+    }
+    for (i = 0; i < count; i++)
+    {
+        order[i] = sorted[i].position;
+    }
+    return status;
+}
+
+
+/**
+ * @brief Returns a value that orders employees like the field does.
+ */
+static uint64_t extractValue(EmployeeSortField_t field, const Employee_t *employee)
+{
+    SalaryBreakdown_t breakdown;            /* Salary of the employee */
+    int8_t key[SORT_KEY_LENGTH];            /* Sort key of the name */
+    float performance = 0;                  /* Working performance, -0 folded into 0 */
+    uint32_t bits = 0;                      /* Bits of the working performance */
+
+    switch (field)
+    {
+        case SORT_BY_PERFORMANCE:
+            performance = (employee->working_performance == 0) ? 0.0f : employee->working_performance;
+            memcpy(&bits, &performance, sizeof(bits));
+            /* Negative floats order backwards, so their bits are inverted; positive ones get the top bit */
+            bits = ((bits & 0x80000000u) != 0) ? ~bits : (bits | 0x80000000u);
+            return bits;
+        case SORT_BY_NET_SALARY:
+            calculateSalaryBreakdown(employee, &breakdown);
+            return breakdown.actual_salary;
+        case SORT_BY_NAME:
+            nameSortKey(employee->name, key);
+            return packPrefix(key);
+        case SORT_BY_DEPARTMENT:
+            return packPrefix(employee->department_id);
+        case SORT_BY_LATE_DAYS:
+        default:
+            return employee->late_coming_days;
+    }
+}
+
+
+/**
+ * @brief Stable least-significant-digit radix sort of pairs by value.
+ *
+ * @return The buffer (pairs or scratch) that holds the sorted pairs.
+ */
+static SortPair_t* radixSort(SortPair_t *pairs, SortPair_t *scratch, uint32_t count)
+{
+    uint32_t counts[SORT_RADIX_PASSES][SORT_RADIX_BUCKETS];    /* Values per byte of each pass */
+    SortPair_t *source = pairs;             /* Pairs read by the current pass */
+    SortPair_t *target = scratch;           /* Pairs written by the current pass */
+    SortPair_t *swap = NULL;                /* Temporary pointer to exchange the buffers */
+    uint32_t offset = 0;                    /* Next position of the current bucket */
+    uint32_t total = 0;                     /* Number of pairs in the buckets before the current one */
+    uint32_t shift = 0;                     /* Position of the pass's byte in the value */
+    uint32_t pass = 0;                      /* Index for looping through passes */
+    uint32_t i = 0;                         /* Index for looping through pairs and buckets */
+
+    /* One read counts the bytes of every pass */
+    memset(counts, 0, sizeof(counts));
+    for (i = 0; i < count; i++)
+    {
+        for (pass = 0; pass < SORT_RADIX_PASSES; pass++)
+        {
+            counts[pass][(pairs[i].value >> (pass * SORT_RADIX_BITS)) & (SORT_RADIX_BUCKETS - 1)] += 1;
+        }
+    }
+
+    for (pass = 0; pass < SORT_RADIX_PASSES; pass++)
+    {
+        shift = pass * SORT_RADIX_BITS;
+        /* Every value has the same byte here: the pass would not move anything */
+        if (counts[pass][(source[0].value >> shift) & (SORT_RADIX_BUCKETS - 1)] == count)
+        {
+            continue;
+        }
+        total = 0;
+        for (i = 0; i < SORT_RADIX_BUCKETS; i++)
+        {
+            offset = counts[pass][i];
+            counts[pass][i] = total;
+            total += offset;
+        }
+        for (i = 0; i < count; i++)
+        {
+            target[counts[pass][(source[i].value >> shift) & (SORT_RADIX_BUCKETS - 1)]++] = source[i];
+        }
+        swap = source;
+        source = target;
+        target = swap;
+    }
+    return source;
+}
+
+
+/**
+ * @brief Sorts each run of pairs with equal values on the full string of the field.
+ *
+ * @return MANAGE_OK or MANAGE_ERR_NO_MEMORY.
+ */
+static ManageStatus_t sortEqualRuns(const EmployeeSortKey_t *key, SortPair_t *pairs, uint32_t count)
+{
+    SortRunEntry_t *entries = NULL;         /* Entries of the current run */
+    SortRunEntry_t *entry_scratch = NULL;   /* Second buffer of the entries */
+    SortPair_t *run_pairs = NULL;           /* Values of the next bytes of the run */
+    SortPair_t *pair_scratch = NULL;        /* Second buffer of the run's radix sort */
+    int8_t *name_keys = NULL;               /* Sort keys of the names of the current run */
+    uint32_t capacity = 0;                  /* Number of entries the buffers can hold */
+    uint32_t start = 0;                     /* First pair of the current run */
+    uint32_t end = 0;                       /* Pair after the current run */
+    uint32_t length = 0;                    /* Number of pairs in the current run */
+    const Employee_t *employee = NULL;      /* Employee of an entry */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the sort */
+    uint32_t i = 0;                         /* Index for looping through the run */
+
+    for (start = 0; start < count && status == MANAGE_OK; start = end)
+    {
+        end = start + 1;
+        while (end < count && pairs[end].value == pairs[start].value)
+        {
+            end++;
+        }
+        length = end - start;
+        if (length < 2)
+        {
+            continue;
+        }
+
+        if (length > capacity)
+        {
+            free(entries);
+            free(entry_scratch);
+            free(run_pairs);
+            free(pair_scratch);
+            free(name_keys);
+            entries = malloc((size_t)length * sizeof(*entries));
+            entry_scratch = malloc((size_t)length * sizeof(*entry_scratch));
+            run_pairs = malloc((size_t)length * sizeof(*run_pairs));
+            pair_scratch = malloc((size_t)length * sizeof(*pair_scratch));
+            name_keys = (key->field == SORT_BY_NAME) ? malloc((size_t)length * SORT_KEY_LENGTH) : NULL;
+            capacity = length;
+            if (entries == NULL || entry_scratch == NULL || run_pairs == NULL || pair_scratch == NULL
+                || (key->field == SORT_BY_NAME && name_keys == NULL))
+            {
+                status = MANAGE_ERR_NO_MEMORY;
+                break;
+            }
+        }
+
+        for (i = 0; i < length; i++)
+        {
+            employee = getEmployeeAt(pairs[start + i].position);
+            if (key->field == SORT_BY_NAME)
+            {
+                nameSortKey(employee->name, &name_keys[(size_t)i * SORT_KEY_LENGTH]);
+                entries[i].text = &name_keys[(size_t)i * SORT_KEY_LENGTH];
+            }
+            else
+            {
+                entries[i].text = employee->department_id;
+            }
+            entries[i].position = pairs[start + i].position;
+        }
+        refineRun(entries, entry_scratch, run_pairs, pair_scratch, length, 8, key->descending);
+        for (i = 0; i < length; i++)
+        {
+            pairs[start + i].position = entries[i].position;
+        }
+    }
+    free(entries);
+    free(entry_scratch);
+    free(run_pairs);
+    free(pair_scratch);
+    free(name_keys);
+    return status;
+}
+
+
+/**
+ * @brief Sorts a run of strings that are equal on their first bytes.
+ *
+ * Large runs are radix sorted on the next 8 bytes, then each run that is still equal is
+ * refined on the 8 bytes after; small runs are merge sorted on the rest of the strings.
+ *
+ * @param entries The run.
+ * @param entry_scratch Buffer of the same length.
+ * @param pairs Buffer of the same length.
+ * @param pair_scratch Buffer of the same length.
+ * @param count Number of entries.
+ * @param offset Number of leading bytes that are equal in every string, a multiple of 8.
+ * @param descending 1 to put the largest strings first.
+ */
+static void refineRun(SortRunEntry_t *entries, SortRunEntry_t *entry_scratch, SortPair_t *pairs,
+                      SortPair_t *pair_scratch, uint32_t count, uint32_t offset, uint8_t descending)
+{
+    SortPair_t *sorted = NULL;              /* Buffer holding the sorted pairs */
+    uint32_t start = 0;                     /* First entry of a run that is still equal */
+    uint32_t end = 0;                       /* Entry after that run */
+    uint32_t i = 0;                         /* Index for looping through the run */
+
+    /* The strings ended within the equal bytes, so they are all the same */
+    if (count < 2 || memchr(entries[0].text + offset - 8, '\0', 8) != NULL)
+    {
+        return;
+    }
+    if (count <= SORT_MERGE_THRESHOLD)
+    {
+        mergeSortRun(entries, entry_scratch, count, offset, descending);
+        return;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        pairs[i].value = packPrefix(entries[i].text + offset);
+        if (descending != 0)
+        {
+            pairs[i].value = ~pairs[i].value;
+        }
+        pairs[i].position = i;
+    }
+    sorted = radixSort(pairs, pair_scratch, count);
+    for (i = 0; i < count; i++)
+    {
+        entry_scratch[i] = entries[sorted[i].position];
+    }
+    memcpy(entries, entry_scratch, (size_t)count * sizeof(*entries));
+
+    /* Each refinement only uses its own part of the buffers, so the values after it stay valid */
+    for (start = 0; start < count; start = end)
+    {
+        end = start + 1;
+        while (end < count && sorted[end].value == sorted[start].value)
+        {
+            end++;
+        }
+        if (end - start > 1)
+        {
+            refineRun(&entries[start], &entry_scratch[start], &pairs[start], &pair_scratch[start],
+                      end - start, offset + 8, descending);
+        }
+    }
+}
+
+
+/**
+ * @brief Stable bottom-up merge sort of run entries by their strings.
+ *
+ * @param offset Number of leading bytes that are equal in every string.
+ */
+static void mergeSortRun(SortRunEntry_t *entries, SortRunEntry_t *scratch, uint32_t count, uint32_t offset,
+                         uint8_t descending)
+{
+    SortRunEntry_t *source = entries;       /* Entries read by the current pass */
+    SortRunEntry_t *target = scratch;       /* Entries written by the current pass */
+    SortRunEntry_t *swap = NULL;            /* Temporary pointer to exchange the buffers */
+    uint32_t width = 0;                     /* Length of the sorted blocks being merged */
+    uint32_t left = 0;                      /* Next entry of the left block */
+    uint32_t right = 0;                     /* Next entry of the right block */
+    uint32_t middle = 0;                    /* End of the left block */
+    uint32_t end = 0;                       /* End of the right block */
+    uint32_t out = 0;                       /* Next position written */
+    int32_t order = 0;                      /* Comparison of the two candidates */
+
+    for (width = 1; width < count; width *= 2)
+    {
+        for (out = 0; out < count; )
+        {
+            left = out;
+            middle = (out + width < count) ? out + width : count;
+            end = (middle + width < count) ? middle + width : count;
+            right = middle;
+            while (left < middle || right < end)
+            {
+                if (left < middle && right < end)
+                {
+                    order = strcmp((const char*)source[left].text + offset, (const char*)source[right].text + offset);
+                    /* Taking the left entry on equal strings keeps the sort stable */
+                    if ((descending == 0) ? (order <= 0) : (order >= 0))
+                    {
+                        target[out++] = source[left++];
+                    }
+                    else
+                    {
+                        target[out++] = source[right++];
+                    }
+                }
+                else if (left < middle)
+                {
+                    target[out++] = source[left++];
+                }
+                else
+                {
+                    target[out++] = source[right++];
+                }
+            }
+        }
+        swap = source;
+        source = target;
+        target = swap;
+    }
+    if (source != entries)
+    {
+        memcpy(entries, source, (size_t)count * sizeof(*entries));
+    }
+}
+
+
+/**
+ * @brief Builds the sort key of a full name: the given name, a blank, then the other words,
+ *        in lower case and separated by single blanks.
+ *
+ * @param name Full name.
+ * @param key Receives the key, SORT_KEY_LENGTH bytes.
+ * @return Length of the key.
+ */
+static uint32_t nameSortKey(const int8_t *name, int8_t *key)
+{
+    uint32_t length = (uint32_t)strlen((const char*)name);     /* Length of the name */
+    uint32_t last_start = 0;                /* Start of the last word */
+    uint32_t last_end = 0;                  /* End of the last word */
+    uint32_t written = 0;                   /* Length of the key */
+    uint32_t i = 0;                         /* Position in the name */
+
+    if (length > SORT_KEY_LENGTH - 1)
+    {
+        length = SORT_KEY_LENGTH - 1;
+    }
+    /* Find the last word */
+    last_end = length;
+    while (last_end > 0 && (name[last_end - 1] == ' ' || name[last_end - 1] == '\t'))
+    {
+        last_end--;
+    }
+    last_start = last_end;
+    while (last_start > 0 && name[last_start - 1] != ' ' && name[last_start - 1] != '\t')
+    {
+        last_start--;
+    }
+
+    for (i = last_start; i < last_end; i++)
+    {
+        key[written++] = (name[i] >= 'A' && name[i] <= 'Z') ? (int8_t)(name[i] + ('a' - 'A')) : name[i];
+    }
+    /* The other words, each after a single blank */
+    for (i = 0; i < last_start; i++)
+    {
+        if (name[i] == ' ' || name[i] == '\t')
+        {
+            continue;
+        }
+        if (i == 0 || name[i - 1] == ' ' || name[i - 1] == '\t')
+        {
+            key[written++] = ' ';
+        }
+        key[written++] = (name[i] >= 'A' && name[i] <= 'Z') ? (int8_t)(name[i] + ('a' - 'A')) : name[i];
+    }
+    key[written] = '\0';
+    return written;
+}
+
+
+/**
+ * @brief Packs the first 8 bytes of a string so that the numbers compare like the strings.
+ */
+static uint64_t packPrefix(const int8_t *text)
+{
+    uint64_t value = 0;                     /* Packed bytes, first byte most significant */
+    uint32_t ended = 0;                     /* Flag set after the terminator */
+    uint32_t i = 0;                         /* Position in the string */
+
+    for (i = 0; i < 8; i++)
+    {
+        if (ended == 0 && text[i] == '\0')
+        {
+            ended = 1;
+        }
+        value = (value << 8) | ((ended == 0) ? (uint8_t)text[i] : 0u);
+    }
+    return value;
+} /* EOF */
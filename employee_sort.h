@@ -0,0 +1,73 @@
+/**
+ * @file employee_sort.h
+ * @brief This file contains the function prototypes of the employee sort orders.
+ *
+ * An order is a list of sort keys; employees equal on the first key are ordered by the second
+ * one, and so on, and employees equal on every key keep their store order. For each key a
+ * compact fixed-width value is extracted once per employee and the (value, position) pairs
+ * are radix sorted, so sorting does not depend on comparing records.
+ *
+ * Names are compared the way Vietnamese lists are ordered: by given name (the last word)
+ * first, then by the rest of the full name, ignoring case and extra blanks.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef EMPLOYEE_SORT_H
+#define EMPLOYEE_SORT_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for ManageStatus_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define EMPLOYEE_SORT_MAX_KEYS 5            /* Largest number of keys in a sort order */
+
+/**
+ * @brief Field an employee list can be sorted by.
+ */
+typedef enum EmployeeSortField {
+    SORT_BY_PERFORMANCE = 0,                /* Working performance */
+    SORT_BY_NET_SALARY,                     /* Actual salary, see calculateSalaryBreakdown() */
+    SORT_BY_NAME,                           /* Full name, given name first */
+    SORT_BY_DEPARTMENT,                     /* Department's ID */
+    SORT_BY_LATE_DAYS,                      /* Number of late coming days */
+    SORT_FIELD_COUNT                        /* Number of fields, must stay last */
+} EmployeeSortField_t;
+
+/**
+ * @brief One key of a sort order.
+ */
+typedef struct EmployeeSortKey {
+    EmployeeSortField_t field;              /* Field compared */
+    uint8_t descending;                     /* 1 to put the largest values first */
+} EmployeeSortKey_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Sorts the stored employees without moving them.
+ *
+ * @param keys Sort keys, the first one is the most significant.
+ * @param key_count Number of keys, 1 to EMPLOYEE_SORT_MAX_KEYS.
+ * @param order Receives the store position of each employee in sorted order
+ *              (getTotalEmployees() entries).
+ * @return MANAGE_OK, MANAGE_ERR_INVALID_ARGUMENT if a key or the number of keys is not valid,
+ *         or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t sortEmployeeOrder(const EmployeeSortKey_t *keys, uint32_t key_count, uint32_t *order);
+
+/**
+ * @brief Compares two full names the way SORT_BY_NAME orders them.
+ *
+ * @return A negative number, 0 or a positive number if first sorts before, with or after second.
+ */
+int32_t compareEmployeeNames(const int8_t *first, const int8_t *second);
+
+#endif /* EMPLOYEE_SORT_H */
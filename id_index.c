@@ -0,0 +1,352 @@
+/**
+ * @file id_index.c
+ * @brief This file contains the implementation of the hash index keyed by ID strings.
+ *
+ * Slots are kept in two parallel arrays (hashes and values). The stored hash is compared
+ * before the key string, so most probes never touch the indexed records.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdlib.h>             /* Include standard library for malloc, free */
+#include <string.h>             /* Include string manipulation library for strcmp */
+#include "id_index.h"           /* Include header file */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define ID_INDEX_EMPTY 0xFFFFFFFFu          /* Value of a slot that was never used */
+#define ID_INDEX_DELETED 0xFFFFFFFEu        /* Value of a slot whose key was removed */
+#define ID_INDEX_MIN_CAPACITY 16u           /* Smallest number of slots */
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static uint32_t hashId(const int8_t *key);
+static int64_t findSlot(const IdIndex_t *index, const int8_t *key, uint32_t hash);
+static ManageStatus_t resize(IdIndex_t *index, uint32_t capacity);
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Initializes an empty index.
+ */
+void idIndexInit(IdIndex_t *index, IdIndexKeyFn_t key_of, const void *context)
+{
+    index->hashes = NULL;
+    index->values = NULL;
+    index->capacity = 0;
+    index->count = 0;
+    index->deleted = 0;
+    index->key_of = key_of;
+    index->context = context;
+}
+
+
+/**
+ * @brief Frees the memory of an index and leaves it empty.
+ */
+void idIndexFree(IdIndex_t *index)
+{
+    free(index->hashes);
+    free(index->values);
+    index->hashes = NULL;
+    index->values = NULL;
+    index->capacity = 0;
+    index->count = 0;
+    index->deleted = 0;
+}
+
+
+/**
+ * @brief Removes every value from an index, keeping its memory.
+ */
+void idIndexClear(IdIndex_t *index)
+{
+    uint32_t i = 0;                         /* Index for looping through slots */
+
+    for (i = 0; i < index->capacity; i++)
+    {
+        index->values[i] = ID_INDEX_EMPTY;
+    }
+    index->count = 0;
+    index->deleted = 0;
+}
+
+
+/**
+ * @brief Makes sure the index can hold the given number of values without growing.
+ *
+ * The load factor is kept at or below 3/4, deleted markers included, so up to count values
+ * can then be inserted without allocating memory.
+ */
+ManageStatus_t idIndexReserve(IdIndex_t *index, uint32_t count)
+{
+    uint64_t capacity = (index->capacity == 0) ? ID_INDEX_MIN_CAPACITY : index->capacity;    /* Needed slots */
+
+    while ((uint64_t)count * 4 > capacity * 3)
+    {
+        capacity *= 2;
+    }
+    if (capacity > 0x80000000u)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    if (capacity == index->capacity && ((uint64_t)count + index->deleted) * 4 <= capacity * 3)
+    {
+        return MANAGE_OK;
+    }
+    /* Growing, or rebuilding at the same size to drop deleted markers, so inserts cannot allocate */
+    return resize(index, (uint32_t)capacity);
+}
+
+
+/**
+ * @brief Looks up a key.
+ *
+ * @return 1 if the key is found, 0 otherwise.
+ */
+uint32_t idIndexFind(const IdIndex_t *index, const int8_t *key, uint32_t *value)
+{
+    return idIndexFindHashed(index, key, hashId(key), value);
+}
+
+
+/**
+ * @brief Returns the hash of a key, for idIndexPrefetch() and idIndexFindHashed().
+ */
+uint32_t idIndexHash(const int8_t *key)
+{
+    return hashId(key);
+}
+
+
+/**
+ * @brief Starts loading the slot a lookup of the given hash probes first.
+ */
+void idIndexPrefetch(const IdIndex_t *index, uint32_t hash)
+{
+    if (index->capacity > 0)
+    {
+        __builtin_prefetch(&index->values[hash & (index->capacity - 1)]);
+        __builtin_prefetch(&index->hashes[hash & (index->capacity - 1)]);
+    }
+}
+
+
+/**
+ * @brief Looks up a key whose hash was returned by idIndexHash().
+ *
+ * @return 1 if the key is found, 0 otherwise.
+ */
+uint32_t idIndexFindHashed(const IdIndex_t *index, const int8_t *key, uint32_t hash, uint32_t *value)
+{
+    int64_t slot = findSlot(index, key, hash);            /* Slot of the key */
+
+    if (slot < 0)
+    {
+        return 0;
+    }
+    if (value != NULL)
+    {
+        *value = index->values[slot];
+    }
+    return 1;
+}
+
+
+/**
+ * @brief Inserts a key and its value.
+ *
+ * @return MANAGE_OK, MANAGE_ERR_DUPLICATE_ID if the key is already present,
+ *         or MANAGE_ERR_NO_MEMORY if memory could not be allocated.
+ */
+ManageStatus_t idIndexInsert(IdIndex_t *index, const int8_t *key, uint32_t value)
+{
+    uint32_t hash = hashId(key);            /* Hash of the key */
+    uint32_t mask = 0;                      /* capacity - 1 */
+    uint32_t slot = 0;                      /* Current probe position */
+    ManageStatus_t status = MANAGE_OK;      /* Result of growing the table */
+
+    if (value >= ID_INDEX_DELETED)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    if (findSlot(index, key, hash) >= 0)
+    {
+        return MANAGE_ERR_DUPLICATE_ID;
+    }
+    /* Grow, or just clean the deleted markers, when the table gets too full */
+    if ((uint64_t)(index->count + index->deleted + 1) * 4 > (uint64_t)index->capacity * 3)
+    {
+        if ((uint64_t)(index->count + 1) * 2 <= index->capacity)
+        {
+            status = resize(index, index->capacity);
+        }
+        else
+        {
+            status = idIndexReserve(index, index->count + 1);
+        }
+        if (status != MANAGE_OK)
+        {
+            return status;
+        }
+    }
+
+    mask = index->capacity - 1;
+    slot = hash & mask;
+    while (index->values[slot] != ID_INDEX_EMPTY && index->values[slot] != ID_INDEX_DELETED)
+    {
+        slot = (slot + 1) & mask;
+    }
+    if (index->values[slot] == ID_INDEX_DELETED)
+    {
+        index->deleted -= 1;
+    }
+    index->hashes[slot] = hash;
+    index->values[slot] = value;
+    index->count += 1;
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Changes the value stored for a key that is already present.
+ *
+ * @return 1 if the key was found and updated, 0 otherwise.
+ */
+uint32_t idIndexUpdate(IdIndex_t *index, const int8_t *key, uint32_t value)
+{
+    int64_t slot = findSlot(index, key, hashId(key));     /* Slot of the key */
+
+    if (slot < 0 || value >= ID_INDEX_DELETED)
+    {
+        return 0;
+    }
+    index->values[slot] = value;
+    return 1;
+}
+
+
+/**
+ * @brief Removes a key.
+ *
+ * @return 1 if the key was found and removed, 0 otherwise.
+ */
+uint32_t idIndexRemove(IdIndex_t *index, const int8_t *key)
+{
+    int64_t slot = findSlot(index, key, hashId(key));     /* Slot of the key */
+
+    if (slot < 0)
+    {
+        return 0;
+    }
+    index->values[slot] = ID_INDEX_DELETED;
+    index->count -= 1;
+    index->deleted += 1;
+    return 1;
+}
+
+
+/**
+ * @brief Returns the number of bytes allocated by an index.
+ */
+uint64_t idIndexMemoryUsage(const IdIndex_t *index)
+{
+    return (uint64_t)index->capacity * (sizeof(*index->hashes) + sizeof(*index->values));
+}
+
+
+/**
+ * @brief FNV-1a hash of an ID string.
+ */
+static uint32_t hashId(const int8_t *key)
+{
+    uint32_t hash = 2166136261u;            /* FNV offset basis */
+
+    while (*key != '\0')
+    {
+        hash ^= (uint8_t)*key++;
+        hash *= 16777619u;                  /* FNV prime */
+    }
+    return hash;
+}
+
+
+/**
+ * @brief Finds the slot holding a key.
+ *
+ * @return The slot, or -1 if the key is not present.
+ */
+static int64_t findSlot(const IdIndex_t *index, const int8_t *key, uint32_t hash)
+{
+    uint32_t mask = index->capacity - 1;    /* capacity - 1 */
+    uint32_t slot = hash & mask;            /* Current probe position */
+    uint32_t probes = 0;                    /* Number of probed slots */
+
+    if (index->capacity == 0)
+    {
+        return -1;
+    }
+    while (index->values[slot] != ID_INDEX_EMPTY && probes < index->capacity)
+    {
+        if (index->values[slot] != ID_INDEX_DELETED && index->hashes[slot] == hash
+            && strcmp(index->key_of(index->values[slot], index->context), key) == 0)
+        {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+        probes++;
+    }
+    return -1;
+}
+
+
+/**
+ * @brief Moves every value into a new table of the given capacity, dropping deleted markers.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_NO_MEMORY if memory could not be allocated.
+ */
+static ManageStatus_t resize(IdIndex_t *index, uint32_t capacity)
+{
+    uint32_t *hashes = malloc((size_t)capacity * sizeof(*hashes));    /* New hash array */
+    uint32_t *values = malloc((size_t)capacity * sizeof(*values));    /* New value array */
+    uint32_t mask = capacity - 1;           /* capacity - 1 */
+    uint32_t slot = 0;                      /* Probe position in the new table */
+    uint32_t i = 0;                         /* Index for looping through old slots */
+
+    if (hashes == NULL || values == NULL)
+    {
+        free(hashes);
+        free(values);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    for (i = 0; i < capacity; i++)
+    {
+        values[i] = ID_INDEX_EMPTY;
+    }
+    for (i = 0; i < index->capacity; i++)
+    {
+        if (index->values[i] != ID_INDEX_EMPTY && index->values[i] != ID_INDEX_DELETED)
+        {
+            slot = index->hashes[i] & mask;
+            while (values[slot] != ID_INDEX_EMPTY)
+            {
+                slot = (slot + 1) & mask;
+            }
+            hashes[slot] = index->hashes[i];
+            values[slot] = index->values[i];
+        }
+    }
+    free(index->hashes);
+    free(index->values);
+    index->hashes = hashes;
+    index->values = values;
+    index->capacity = capacity;
+    index->deleted = 0;
+    return MANAGE_OK;
+} /* EOF */
@@ -0,0 +1,135 @@
+/**
+ * @file id_index.h
+ * @brief This file contains the function prototypes of a hash index keyed by ID strings.
+ *
+ * The index maps an ID string to a 32-bit value (usually a position or a handle). It does not
+ * copy the keys: the owner of the index provides a function that returns the key of a stored
+ * value, so keys can live inside the indexed records. Lookups, insertions and removals take
+ * constant time on average (open addressing with linear probing).
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef ID_INDEX_H
+#define ID_INDEX_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for ManageStatus_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/**
+ * @brief Returns the key of a stored value.
+ *
+ * @param value A value stored in the index.
+ * @param context The context given to idIndexInit().
+ * @return The ID string the value was inserted with.
+ */
+typedef const int8_t* (*IdIndexKeyFn_t)(uint32_t value, const void *context);
+
+/**
+ * @brief Hash index from ID strings to 32-bit values.
+ */
+typedef struct IdIndex {
+    uint32_t *hashes;                       /* Hash of the key in each slot */
+    uint32_t *values;                       /* Value in each slot, or an empty/deleted marker */
+    uint32_t capacity;                      /* Number of slots, a power of two */
+    uint32_t count;                         /* Number of stored values */
+    uint32_t deleted;                       /* Number of slots holding a deleted marker */
+    IdIndexKeyFn_t key_of;                  /* Returns the key of a stored value */
+    const void *context;                    /* Context given to key_of */
+} IdIndex_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Initializes an empty index.
+ *
+ * @param index The index to initialize.
+ * @param key_of Function that returns the key of a stored value.
+ * @param context Context given to key_of.
+ */
+void idIndexInit(IdIndex_t *index, IdIndexKeyFn_t key_of, const void *context);
+
+/**
+ * @brief Frees the memory of an index and leaves it empty.
+ */
+void idIndexFree(IdIndex_t *index);
+
+/**
+ * @brief Removes every value from an index, keeping its memory.
+ */
+void idIndexClear(IdIndex_t *index);
+
+/**
+ * @brief Makes sure the index can hold the given number of values without growing.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_NO_MEMORY if memory could not be allocated.
+ */
+ManageStatus_t idIndexReserve(IdIndex_t *index, uint32_t count);
+
+/**
+ * @brief Looks up a key.
+ *
+ * @param index The index to search.
+ * @param key The ID to look for.
+ * @param value Receives the value of the key if it is found (may be NULL).
+ * @return 1 if the key is found, 0 otherwise.
+ */
+uint32_t idIndexFind(const IdIndex_t *index, const int8_t *key, uint32_t *value);
+
+/**
+ * @brief Returns the hash of a key, for idIndexPrefetch() and idIndexFindHashed().
+ */
+uint32_t idIndexHash(const int8_t *key);
+
+/**
+ * @brief Starts loading the slot a lookup of the given hash probes first.
+ *
+ * Prefetching a batch of hashes before looking them up lets their cache misses overlap.
+ */
+void idIndexPrefetch(const IdIndex_t *index, uint32_t hash);
+
+/**
+ * @brief Looks up a key whose hash was returned by idIndexHash().
+ * @return 1 if the key is found, 0 otherwise.
+ */
+uint32_t idIndexFindHashed(const IdIndex_t *index, const int8_t *key, uint32_t hash, uint32_t *value);
+
+/**
+ * @brief Inserts a key and its value.
+ *
+ * @param index The index to update.
+ * @param key The ID of the value; key_of(value) must return an equal string.
+ * @param value The value to store, must be less than 0xFFFFFFFE.
+ * @return MANAGE_OK, MANAGE_ERR_DUPLICATE_ID if the key is already present,
+ *         or MANAGE_ERR_NO_MEMORY if memory could not be allocated.
+ */
+ManageStatus_t idIndexInsert(IdIndex_t *index, const int8_t *key, uint32_t value);
+
+/**
+ * @brief Changes the value stored for a key that is already present.
+ *
+ * @return 1 if the key was found and updated, 0 otherwise.
+ */
+uint32_t idIndexUpdate(IdIndex_t *index, const int8_t *key, uint32_t value);
+
+/**
+ * @brief Removes a key.
+ *
+ * @return 1 if the key was found and removed, 0 otherwise.
+ */
+uint32_t idIndexRemove(IdIndex_t *index, const int8_t *key);
+
+/**
+ * @brief Returns the number of bytes allocated by an index.
+ */
+uint64_t idIndexMemoryUsage(const IdIndex_t *index);
+
+#endif /* ID_INDEX_H */
@@ -11,6 +11,28 @@
  * @bug No known bugs
  */
 #include "input_handler.h"		/* Include header file */
+#include "perf_stats.h"         /* Include instrumentation header file for measuring hot operations */
+#include <float.h>              /* Include float limits library for FLT_MAX */
+#ifdef _WIN32
+#include <windows.h>            /* Include Windows header file for GetSystemInfo */
+#else
+#include <unistd.h>             /* Include POSIX header file for sysconf */
+#endif
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define IS_BLANK(c) ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')   /* Characters trimmed around a field */
+#define MAX_INPUT_LINE 256              /* Size of the buffer used by the prompt functions */
+#define MAX_SIGNIFICANT_DIGITS 19       /* Digits of a decimal that fit in a uint64_t mantissa */
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static uint32_t trimField(const int8_t *text, uint32_t length, uint32_t *start);
+static uint32_t isEightDigits(uint64_t chunk);
+static uint32_t eightDigitsValue(uint64_t chunk);
+
 /*******************************************************************************
  * Definition
  ******************************************************************************/
@@ -77,6 +99,7 @@ int8_t* formatNumberWithCommas(uint64_t number)
     uint32_t commaCount;                        /* Variable to count number of comma to insert */
     uint32_t j = 0;                             /* Index for formattedStr */
     uint32_t i = 0;
+    PERF_START(perf_start);                     /* Start time of the formatting */
 
     /* Convert the number to a string */
     sprintf(numStr, "%llu", number);
@@ -100,6 +123,7 @@ int8_t* formatNumberWithCommas(uint64_t number)
     /* Insert Null-terminate the string */
     formattedStr[j] = '\0';
 
+    PERF_STOP(PERF_OP_FORMAT_NUMBER, perf_start);
     return formattedStr; /* Return the formatted string instead of printing it */
 }
 
@@ -116,42 +140,308 @@ int8_t* formatNumberWithCommas(uint64_t number)
  */
 uint32_t isStringEmpty(int8_t *str)
 {
-    /* Remove newline and space characters */
-    str[strcspn(str, "\n")] = 0;
-    str[strcspn(str, " ")] = 0;
+    /* Cut the string at the first newline or space character */
+    str[strcspn(str, "\n ")] = 0;
     /* Check if the string is empty */
-    if (strlen(str) == 0)
+    if (str[0] == '\0')
     {
         return 1;
     }
+    return 0;
 }
 
 
 /**
- * @brief This function checks if a string represents a whole number more than 0.
+ * @brief This function checks if a string represents a whole number (0 or more).
  * @param string_number The string to be checked.
- * @return 1 if the string represents a whole number more than 0, 0 otherwise.
+ * @return 1 if the string represents a whole number (0 or more), 0 otherwise.
  */
 uint32_t isWholeNumber(int8_t *string_number)
 {
-    int8_t *end;               /* Pointer to the end of the string */
-    uint32_t isNumber = 0;      /* Flag to check if the string is a number */
-    int64_t num = 0;            /* Variable to store the converted number */
+    /* The string is a whole number if it parses as one in the range of uint64_t */
+    if (parseUnsignedField(string_number, strlen(string_number), UINT64_MAX, NULL) == PARSE_OK)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Parses an unsigned decimal integer.
+ *
+ * Digits are checked and converted eight at a time while the value is small enough that
+ * the next eight digits cannot overflow, then one at a time with an overflow check.
+ *
+ * @return PARSE_OK, PARSE_EMPTY, PARSE_INVALID or PARSE_OUT_OF_RANGE.
+ */
+ParseStatus_t parseUnsignedField(const int8_t *text, uint32_t length, uint64_t max_value, uint64_t *value)
+{
+    uint32_t i = 0;                         /* Position of the next digit */
+    uint32_t end = 0;                       /* Position after the last digit */
+    uint64_t result = 0;                    /* Value of the digits read so far */
+    uint64_t chunk = 0;                     /* Eight characters loaded at once */
+    uint32_t digit = 0;                     /* Value of the current digit */
+    uint32_t overflow = 0;                  /* Flag to check if the value exceeded max_value */
+
+    end = trimField(text, length, &i);
+    if (end == 0)
+    {
+        return PARSE_EMPTY;
+    }
+    end += i;
+
+    /* 10^10 * 10^8 + 99999999 still fits in 64 bits */
+    while (end - i >= 8 && result < 10000000000ull)
+    {
+        memcpy(&chunk, text + i, sizeof(chunk));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        chunk = __builtin_bswap64(chunk);
+#endif
+        if (isEightDigits(chunk) == 0)
+        {
+            break;
+        }
+        result = result * 100000000u + eightDigitsValue(chunk);
+        i += 8;
+    }
+    for (; i < end; i++)
+    {
+        digit = (uint32_t)((uint8_t)text[i]) - '0';
+        if (digit > 9)
+        {
+            return PARSE_INVALID;
+        }
+        if (result > (UINT64_MAX - digit) / 10)
+        {
+            overflow = 1;
+        }
+        else
+        {
+            result = result * 10 + digit;
+        }
+    }
+    if (overflow == 1 || result > max_value)
+    {
+        return PARSE_OUT_OF_RANGE;
+    }
+    if (value != NULL)
+    {
+        *value = result;
+    }
+    return PARSE_OK;
+}
+
+
+/**
+ * @brief Parses a non-negative decimal number such as 12, 0.5, 3. or .25
+ *
+ * The digits are collected into an integer mantissa (at most 19 significant digits, later
+ * fraction digits are dropped) and scaled once by a power of ten.
+ *
+ * @return PARSE_OK, PARSE_EMPTY, PARSE_INVALID or PARSE_OUT_OF_RANGE.
+ */
+ParseStatus_t parseDecimalField(const int8_t *text, uint32_t length, float *value)
+{
+    static const double powers_of_ten[] = {     /* Exactly representable powers of ten */
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    uint32_t i = 0;                         /* Position of the next character */
+    uint32_t end = 0;                       /* Position after the last character */
+    uint64_t mantissa = 0;                  /* Significant digits */
+    uint32_t significant = 0;               /* Number of digits in the mantissa, without leading zeros */
+    int32_t exponent = 0;                   /* Power of ten applied to the mantissa */
+    uint32_t digits = 0;                    /* Number of digits in the field */
+    uint32_t seen_point = 0;                /* Flag to check if the decimal point was read */
+    uint32_t digit = 0;                     /* Value of the current digit */
+    double result = 0;                      /* Scaled value */
+
+    end = trimField(text, length, &i);
+    if (end == 0)
+    {
+        return PARSE_EMPTY;
+    }
+    end += i;
+
+    for (; i < end; i++)
+    {
+        if (text[i] == '.' && seen_point == 0)
+        {
+            seen_point = 1;
+            continue;
+        }
+        digit = (uint32_t)((uint8_t)text[i]) - '0';
+        if (digit > 9)
+        {
+            return PARSE_INVALID;
+        }
+        digits += 1;
+        if (significant < MAX_SIGNIFICANT_DIGITS)
+        {
+            mantissa = mantissa * 10 + digit;
+            significant += (mantissa != 0) ? 1 : 0;
+            /* Below 10^-400 every value rounds to 0, so the exponent stops there */
+            exponent -= (seen_point == 1 && exponent > -400) ? 1 : 0;
+        }
+        else if (seen_point == 0 && exponent <= 22)
+        {
+            /* Integer digits beyond the mantissa only scale it */
+            exponent += 1;
+        }
+    }
+    if (digits == 0)
+    {
+        return PARSE_INVALID;
+    }
+
+    if (exponent > 22)
+    {
+        return PARSE_OUT_OF_RANGE;
+    }
+    result = (double)mantissa;
+    while (exponent < -22)
+    {
+        result /= powers_of_ten[22];
+        exponent += 22;
+    }
+    result = (exponent >= 0) ? result * powers_of_ten[exponent] : result / powers_of_ten[-exponent];
+    if (result > FLT_MAX)
+    {
+        return PARSE_OUT_OF_RANGE;
+    }
+    if (value != NULL)
+    {
+        *value = (float)result;
+    }
+    return PARSE_OK;
+}
 
-    /* Convert the string to a long long integer and store the result in 'num' */
-    num = strtoll(string_number, &end, 10);
 
-    /* If the end of the string is not reached, the number is negative,
-    or the number is not the same as the original string, it is not a whole number. */
-    if (*end != '\0' || num < 0 || num != strtoull(string_number, &end, 10))
+/**
+ * @brief Validates an ID.
+ *
+ * @return PARSE_OK, PARSE_EMPTY, PARSE_INVALID or PARSE_OUT_OF_RANGE.
+ */
+ParseStatus_t parseIdField(const int8_t *text, uint32_t length, uint32_t max_length,
+                           uint32_t *start, uint32_t *id_length)
+{
+    uint32_t first = 0;                     /* Position of the first character of the ID */
+    uint32_t count = 0;                     /* Length of the ID */
+    uint32_t i = 0;                         /* Index for looping through the ID */
+    uint8_t c = 0;                          /* Current character */
+
+    count = trimField(text, length, &first);
+    if (count == 0)
+    {
+        return PARSE_EMPTY;
+    }
+    for (i = first; i < first + count; i++)
     {
-        isNumber = 0;
+        c = (uint8_t)text[i];
+        if (c <= ' ' || c == 0x7f)
+        {
+            return PARSE_INVALID;
+        }
+    }
+    if (count > max_length)
+    {
+        return PARSE_OUT_OF_RANGE;
+    }
+    if (start != NULL)
+    {
+        *start = first;
     }
-    else
+    if (id_length != NULL)
     {
-        isNumber = 1;
+        *id_length = count;
     }
-    return isNumber;
+    return PARSE_OK;
+}
+
+
+/**
+ * @brief Prompts until the user enters a whole number not larger than max_value.
+ *
+ * @return The number entered by the user.
+ */
+uint64_t promptUnsignedInput(const int8_t *prompt, uint64_t max_value)
+{
+    int8_t buffer[MAX_INPUT_LINE];         /* Buffer to store input temporarily */
+    uint64_t value = 0;                     /* Number entered by the user */
+    ParseStatus_t status = PARSE_EMPTY;     /* Result of parsing the input */
+
+    do
+    {
+        printf("%s", prompt);
+        fflush(stdin);
+        if (fgets(buffer, sizeof(buffer), stdin) == NULL)
+        {
+            buffer[0] = '\0';
+        }
+        /* Validate and convert the input in one pass */
+        status = parseUnsignedField(buffer, strlen(buffer), max_value, &value);
+        if (status == PARSE_EMPTY)
+        {
+            /* Print a message if the input is empty */
+            printf("\nYou must not leave blank this information ...\n");
+            printf("\nPlease enter again ...\n");
+        }
+        else if (status == PARSE_INVALID)
+        {
+            /* Print a message if the input is not a whole number */
+            printf("\nPlease enter a whole number (0 or more) !!!\n");
+        }
+        else if (status == PARSE_OUT_OF_RANGE)
+        {
+            /* Print a message if the number does not fit the field */
+            printf("\nPlease enter a number not more than %s !!!\n", formatNumberWithCommas(max_value));
+        }
+    } /* Repeat if input is empty, is not a whole number or is too large */
+    while (status != PARSE_OK);
+
+    return value;
+}
+
+
+/**
+ * @brief Prompts until the user enters a valid ID.
+ */
+void promptIdInput(const int8_t *prompt, int8_t *id, uint32_t size)
+{
+    int8_t buffer[MAX_INPUT_LINE];         /* Buffer to store input temporarily */
+    uint32_t start = 0;                     /* Offset of the ID in the buffer */
+    uint32_t id_length = 0;                 /* Length of the ID */
+    ParseStatus_t status = PARSE_EMPTY;     /* Result of validating the input */
+
+    do
+    {
+        printf("%s", prompt);
+        fflush(stdin);
+        if (fgets(buffer, sizeof(buffer), stdin) == NULL)
+        {
+            buffer[0] = '\0';
+        }
+        status = parseIdField(buffer, strlen(buffer), size - 1, &start, &id_length);
+        if (status == PARSE_EMPTY)
+        {
+            /* Print a message if the input is empty */
+            printf("\nYou must not leave blank this information ...\n");
+            printf("\nPlease enter again ...\n");
+        }
+        else if (status == PARSE_INVALID)
+        {
+            printf("\nID must not contain spaces !!!\n");
+        }
+        else if (status == PARSE_OUT_OF_RANGE)
+        {
+            printf("\nID must not be longer than %u characters !!!\n", size - 1);
+        }
+    } /* Repeat if the ID is empty, contains spaces or is too long */
+    while (status != PARSE_OK);
+
+    memcpy(id, buffer + start, id_length);
+    id[id_length] = '\0';
 }
 
 
@@ -168,5 +458,80 @@ void clear_console()
     fflush(stdin);
     getch();
     system("cls");
+}
+
+
+/**
+ * @brief Returns the number of processors that can run threads of this program.
+ *
+ * @return The number of processors online, at least 1.
+ */
+uint32_t getProcessorCount()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;                       /* Description of the system */
+
+    GetSystemInfo(&info);
+    return (info.dwNumberOfProcessors > 0) ? (uint32_t)info.dwNumberOfProcessors : 1u;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);    /* Processors online */
+
+    return (count > 0) ? (uint32_t)count : 1u;
+#endif
+}
+
+
+/**
+ * @brief Skips the blanks around a field.
+ *
+ * @param text The field.
+ * @param length Number of bytes in the field.
+ * @param start Receives the position of the first character that is not blank.
+ * @return The number of characters between the first and the last character that are not blank.
+ */
+static uint32_t trimField(const int8_t *text, uint32_t length, uint32_t *start)
+{
+    uint32_t first = 0;                     /* Position of the first character that is not blank */
+
+    while (first < length && IS_BLANK(text[first]))
+    {
+        first++;
+    }
+    while (length > first && IS_BLANK(text[length - 1]))
+    {
+        length--;
+    }
+    *start = first;
+    return length - first;
+}
+
+
+/**
+ * @brief Checks if the eight bytes of a little-endian chunk are all ASCII digits.
+ *
+ * A byte is a digit when its high nibble is 3 and adding 6 to it keeps the high nibble at 3.
+ */
+static uint32_t isEightDigits(uint64_t chunk)
+{
+    return (((chunk & 0xF0F0F0F0F0F0F0F0ull)
+             | (((chunk + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull) ? 1u : 0u;
+}
+
+
+/**
+ * @brief Converts eight ASCII digits (first digit in the lowest byte) with three multiplications.
+ */
+static uint32_t eightDigitsValue(uint64_t chunk)
+{
+    const uint64_t mask = 0x000000FF000000FFull;            /* Keeps two pairs of two-digit values */
+    const uint64_t multiplier_1 = 100 + (1000000ull << 32); /* Weights of the first and third pairs */
+    const uint64_t multiplier_2 = 1 + (10000ull << 32);     /* Weights of the second and fourth pairs */
+
+    chunk -= 0x3030303030303030ull;
+    /* Combine neighbouring digits into two-digit values */
+    chunk = (chunk * 10) + (chunk >> 8);
+    /* Combine the four two-digit values */
+    chunk = (((chunk & mask) * multiplier_1) + (((chunk >> 16) & mask) * multiplier_2)) >> 32;
+    return (uint32_t)chunk;
 } /* EOF */
 
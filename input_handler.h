@@ -4,7 +4,12 @@
  *
  * This file contains the function prototypes for handling user input. It includes
  * functions to get a single character input, format a number with commas, check if a string is empty,
- * and check if a string is a whole number.
+ * and check if a string is a whole number, and small system helpers (clearing the console,
+ * counting processors).
+ *
+ * The parse*Field() functions validate and convert a field in a single pass. They take a
+ * pointer and a length, so they work on fgets() buffers as well as on fields inside a large
+ * import buffer without copying, and they are defined for every input.
  *
  * @author Viet Ha Nguyen
  * @date 3/30/2024
@@ -22,6 +27,19 @@
 #include <ctype.h>           /* for isdigit () function */
 #include <stdint.h>          /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
 
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/**
+ * @brief Result of parsing a field.
+ */
+typedef enum ParseStatus {
+    PARSE_OK = 0,               /* The field is valid and the value was stored */
+    PARSE_EMPTY,                /* The field holds only blanks */
+    PARSE_INVALID,              /* The field holds a character that is not allowed */
+    PARSE_OUT_OF_RANGE          /* The value is too large or the ID is too long */
+} ParseStatus_t;
+
 /*******************************************************************************
  * Prototype
  ******************************************************************************/
@@ -63,13 +81,77 @@ uint32_t isStringEmpty(int8_t *str);
 
 
 /**
- * @brief This function checks if a string represents a whole number more than 0.
+ * @brief This function checks if a string represents a whole number (0 or more).
  * @param string_number The string to be checked.
- * @return 1 if the string represents a whole number more than 0, 0 otherwise.
+ * @return 1 if the string represents a whole number (0 or more), 0 otherwise.
  */
 uint32_t isWholeNumber(int8_t *string_number);
 
 
+/**
+ * @brief Parses an unsigned decimal integer.
+ *
+ * Leading and trailing blanks (space, tab, CR, LF) are ignored. Only the digits 0-9 are
+ * allowed; there is no sign. Eight digits are checked and converted at a time.
+ *
+ * @param text The field, not necessarily null-terminated.
+ * @param length Number of bytes in the field.
+ * @param max_value Largest accepted value.
+ * @param value Receives the value on success (may be NULL).
+ * @return PARSE_OK, PARSE_EMPTY, PARSE_INVALID or PARSE_OUT_OF_RANGE.
+ */
+ParseStatus_t parseUnsignedField(const int8_t *text, uint32_t length, uint64_t max_value, uint64_t *value);
+
+
+/**
+ * @brief Parses a non-negative decimal number such as 12, 0.5, 3. or .25
+ *
+ * Leading and trailing blanks are ignored. Signs and exponents are not allowed.
+ *
+ * @param text The field, not necessarily null-terminated.
+ * @param length Number of bytes in the field.
+ * @param value Receives the value on success (may be NULL).
+ * @return PARSE_OK, PARSE_EMPTY, PARSE_INVALID or PARSE_OUT_OF_RANGE.
+ */
+ParseStatus_t parseDecimalField(const int8_t *text, uint32_t length, float *value);
+
+
+/**
+ * @brief Validates an ID.
+ *
+ * Leading and trailing blanks are ignored. The ID must not contain blanks or control characters.
+ *
+ * @param text The field, not necessarily null-terminated.
+ * @param length Number of bytes in the field.
+ * @param max_length Largest accepted ID length, without the null terminator.
+ * @param start Receives the offset of the ID inside the field (may be NULL).
+ * @param id_length Receives the length of the ID (may be NULL).
+ * @return PARSE_OK, PARSE_EMPTY, PARSE_INVALID or PARSE_OUT_OF_RANGE.
+ */
+ParseStatus_t parseIdField(const int8_t *text, uint32_t length, uint32_t max_length,
+                           uint32_t *start, uint32_t *id_length);
+
+
+/**
+ * @brief Prompts until the user enters a whole number not larger than max_value.
+ *
+ * @param prompt The message printed before each attempt.
+ * @param max_value Largest accepted value.
+ * @return The number entered by the user.
+ */
+uint64_t promptUnsignedInput(const int8_t *prompt, uint64_t max_value);
+
+
+/**
+ * @brief Prompts until the user enters a valid ID.
+ *
+ * @param prompt The message printed before each attempt.
+ * @param id Receives the ID, null-terminated.
+ * @param size Size of the id buffer; the ID is at most size - 1 characters.
+ */
+void promptIdInput(const int8_t *prompt, int8_t *id, uint32_t size);
+
+
 /**
  * @brief Clears the console screen.
  *
@@ -78,5 +160,13 @@ uint32_t isWholeNumber(int8_t *string_number);
  */
 void clear_console();
 
+
+/**
+ * @brief Returns the number of processors that can run threads of this program.
+ *
+ * @return The number of processors online, at least 1.
+ */
+uint32_t getProcessorCount();
+
 #endif /* INPUT_HANDLER_H */
 
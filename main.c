@@ -11,8 +11,25 @@
  */
 #include <stdio.h>            /* Include standard input and output library for printf, scanf, ... */
 #include <stdint.h>           /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include <string.h>           /* Include string manipulation library for strcmp */
 #include "input_handler.h"    /* Include input handler header file for handling user input */
 #include "manage_employee.h"  /* Include manage employee header file for managing employees */
+#include "perf_stats.h"       /* Include instrumentation header file for the statistics menu and the dump on exit */
+#include "payroll_export.h"   /* Include payroll export header file for the columnar export */
+#include "payroll_history.h"  /* Include payroll history header file for the multi-month history */
+#include "bulk_import.h"      /* Include bulk import header file for the CSV import */
+#include "payroll_golden.h"   /* Include payroll golden header file for the command line payroll check */
+#include "payroll_simulation.h" /* Include payroll simulation header file for the what-if simulation */
+#include "store_snapshot.h"   /* Include store snapshot header file for saving and loading the data */
+#include "attendance.h"       /* Include attendance header file for the clock-in log import */
+#include "org_hierarchy.h"    /* Include organization hierarchy header file for the subtree payroll totals */
+#include "payroll_diff.h"     /* Include payroll diff header file for comparing two payroll runs */
+#include "shared_table.h"     /* Include shared table header file for publishing the data to other processes */
+#include "payslip.h"          /* Include payslip header file for writing the payslip files */
+#include "name_index.h"       /* Include name index header file for searching employees by name */
+#include "change_feed.h"      /* Include change feed header file for recording the changes for other programs */
+#include "tenant_store.h"     /* Include tenant store header file for keeping several companies */
+#include "mutation_queue.h"   /* Include mutation queue header file for the command line queue check */
 
 /*******************************************************************************
  * Code
@@ -23,16 +40,59 @@
  * This function is the entry point of the program. It initializes a variable to hold the user's choice,
  * and then enters a loop to display the main menu, get the user's choice, and execute the corresponding function.
  * The loop continues until the user chooses to exit the program.
+ * If arguments are given, the payroll golden-file check runs instead of the menu, or with
+ * --shared-report, a reader of the tables published by another instance of the program, or with
+ * --change-feed, a reader of the change feed written by another instance, or with --queue-check,
+ * a stress test of the mutation queue.
+ * Otherwise the data saved by the last snapshot, if any, is loaded before the menu appears, and
+ * the change feed named by MANAGE_CHANGE_FEED, if set, is opened.
  *
+ * @param argc Number of command line arguments.
+ * @param argv Command line arguments.
  * @return 0 if the program exits successfully.
  */
 
-int main(void)
+int main(int argc, char *argv[])
 {
     int8_t choice;             /* Variable to hold the user's choice */
 
+    /* Switch instrumentation on if MANAGE_PERF_STATS is set */
+    perfStatsInit();
+
+    /* Read the tables published by another instance instead of the menu */
+    if (argc > 1 && strcmp(argv[1], "--shared-report") == 0)
+    {
+        return sharedTableCommand(argc, argv);
+    }
+
+    /* Print the events of a change feed instead of the menu */
+    if (argc > 1 && strcmp(argv[1], "--change-feed") == 0)
+    {
+        return changeFeedCommand(argc, argv);
+    }
+
+    /* Stress-test the mutation queue instead of the menu */
+    if (argc > 1 && strcmp(argv[1], "--queue-check") == 0)
+    {
+        return mutationQueueCommand(argc, argv);
+    }
+
+    /* Run the payroll golden-file check instead of the menu if arguments are given */
+    if (argc > 1)
+    {
+        return payrollGoldenCommand(argc, argv);
+    }
+
+    /* Start from the saved data, the department index is built on first use */
+    loadStartupSnapshot();
+
+    /* Record the changes for other programs if MANAGE_CHANGE_FEED is set */
+    startChangeFeed();
+
     do
     {
+        /* Tell the result of the snapshot check once the background thread has it */
+        reportSnapshotCheck();
         /* Display the main menu */
         showMenu();
         printf("Please select your desired function: ");
@@ -80,6 +140,108 @@ int main(void)
                 /* Exit the program */
                 printf("Exit program.\n");
                 break;
+            case '8':
+                /* Export the payroll to a columnar file */
+                exportPayroll();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case '9':
+                /* Update a department's bonus or grant it a raise */
+                adjustDepartment();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case 'a':
+                /* Record, show, save or load the payroll history */
+                managePayrollHistory();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case 'b':
+                /* Import employees and departments from a CSV file */
+                importEmployees();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case 'c':
+                /* Compare the payroll under other rules */
+                simulatePayrollScenarios();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case 'd':
+                /* Save the data so the next start loads it */
+                saveDataSnapshot();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case 'e':
+                /* Show the memory used by the employees and departments */
+                showMemoryUsage();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case 'f':
+                /* Set working and late coming days from a clock-in log */
+                importAttendance();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case 'g':
+                /* Manage the manager to report hierarchy and its payroll totals */
+                manageOrganization();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case 'h':
+                /* Compare two payroll runs exported with '8' */
+                comparePayrolls();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case 'i':
+                /* Publish the data to shared memory for reader processes */
+                publishSharedTables();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case 'j':
+                /* Write a payslip file for every employee */
+                generatePayslipFiles();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case 'k':
+                /* Find employees by name, with or without accents */
+                searchEmployeesByName();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case 'l':
+                /* Change some fields of an employee in place */
+                updateEmployee();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case 'm':
+                /* Start the change feed, or show and stop it */
+                manageChangeFeed();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case 'n':
+                /* Add, select or delete a company, or run the payroll of every company */
+                manageTenants();
+                /* Clear the console screen */
+                clear_console();
+                break;
+            case 'o':
+                /* Show, clear or switch the performance statistics */
+                managePerfStats();
+                /* Clear the console screen */
+                clear_console();
+                break;
             default:
                 /* Prompt the user to enter a valid choice */
                 printf("Input is not valid. Please enter again!!!\n");
@@ -89,6 +251,15 @@ int main(void)
     } /* Repeat until the user chooses to exit the program */
     while (choice != '7');
 
+    /* Remove the published tables, readers keep the data they have mapped */
+    stopSharedTables();
+
+    /* Write the last changes and close the change feed */
+    stopChangeFeed();
+
+    /* Free the companies added from the menu */
+    stopTenants();
+
     /* Return 0 to indicate successful program exit */
     return 0;
 } /* EOF */
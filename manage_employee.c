@@ -5,11 +5,18 @@
  * This file contains the implementation of functions to manage employees and departments. It includes functions to:
  * - Display a main menu to the user.
  * - Add a new employee to the system.
- * - Display a list of employees sorted by working performance.
+ * - Display a list of employees sorted by working performance, salary, name, department or late days.
  * - Display a list of departments.
  * - Delete an employee from the system.
+ * - Update some fields of an employee in place, found through an employee ID index.
  * - Delete a department from the system.
  * - Display the payroll of all employees.
+ * - Display the memory used by the store.
+ * - Add or delete employees and departments in batches.
+ * - Look departments up by ID in constant time and create missing ones in bulk.
+ * - Start from records loaded from a snapshot, building the ID indexes on first use.
+ * - Keep several stores, one per company, and let each thread select the store it works on.
+ * - Record every change of the employees and departments in the change feed.
  * - Check if a string is empty.
  * - Calculate the salary of an employee.
  * - Clear the console screen.
@@ -25,60 +32,89 @@
 #include <stdio.h>              /* Include standard input and output library for printf, printf, ... */
 #include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
 #include <string.h>             /* Include string manipulation library for functions like strlen, strcmp,... */
+#include <stdlib.h>             /* Include standard library for malloc, realloc, qsort, bsearch */
+#include <pthread.h>            /* Include POSIX threads library for building the department index once */
 #include "manage_employee.h"    /* Include the header file for this specific employee management module. */
 #include "input_handler.h"		/* Include input handler header file for handling user input */
+#include "perf_stats.h"         /* Include instrumentation header file for measuring hot operations */
+#include "record_pool.h"        /* Include pool allocator header file for storing records */
+#include "id_index.h"           /* Include hash index header file for looking up employees and departments by ID */
+#include "employee_sort.h"      /* Include employee sort header file for the list orders */
+#include "payroll_stream.h"     /* Include payroll stream header file for printing in batches */
+#include "change_feed.h"        /* Include change feed header file for recording every change of the store */
 
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
-#define MAX_EMPLOYEES 100       /* Maximum number of employees that can be handled. */
-#define MAX_DEPARTMENTS 50      /* Maximum number of departments that can be handled. */
-#define MAX_ID_LENGTH 100       /* Maximum length of ID strings for employees and departments. */
-#define MAX_NAME_LENGTH 50      /* Maximum length of name strings for employees. */
+#define INITIAL_EMPLOYEES 100   /* Initial capacity of the employee handle array, it grows when full. */
+#define INITIAL_DEPARTMENTS 50  /* Initial capacity of the department handle array, it grows when full. */
+#define FIELD_SIZE(type, field) sizeof(((type*)0)->field)  /* Size of one field of a structure */
+#define PROJECTED_EMPLOYEES 100000000ull    /* Number of employees the memory report projects to */
 
 /**
- * @brief Structure to represent an employee.
- *
- * This structure holds information about an employee including their ID, name,
- * base salary, number of working days, department ID, working performance, bonus,
- * and number of days they came late to work.
- */
-typedef struct Employee {
-    int8_t id[MAX_ID_LENGTH];              /* Employee's ID. */
-    int8_t name[MAX_NAME_LENGTH];          /* Employee's name. */
-    uint64_t salary_base;                   /* Employee's base salary. */
-    uint16_t working_days;                  /* Number of days the employee worked. */
-    int8_t department_id[MAX_ID_LENGTH];   /* ID of the department that the employee belongs to. */
-    float working_performance;              /* Employee's working performance. */
-    uint64_t bonus;                         /* Bonus received by the employee. */
-    uint16_t late_coming_days;              /* Number of days the employee came late to work. */
-} Employee_t;
-
-/**
- * @brief Structure to represent a department.
- *
- * This structure holds information about a department including its ID and the bonus salary
- * allocated to the department.
+ * @brief Employees and departments of one store, with their indexes.
  */
-typedef struct Department {
-    int8_t id[MAX_ID_LENGTH];              /* Department's ID. */
-    uint64_t bonus_salary;                  /* Bonus salary allocated to the department. */
-} Department_t;
+struct EmployeeStore {
+    RecordPool_t employee_pool;             /* Slabs holding the employee records */
+    RecordPool_t department_pool;           /* Slabs holding the department records */
+    RecordHandle_t *employee_handles;       /* Handles of the stored employees, in store order */
+    RecordHandle_t *department_handles;     /* Handles of the stored departments, in store order */
+    IdIndex_t employee_ids;                 /* Index from employee IDs to employee handles, see employeeIndex() */
+    uint32_t employee_ids_stale;            /* Flag set while employee_ids is missing the adopted employees */
+    pthread_mutex_t employee_ids_lock;      /* Lets one thread build employee_ids */
+    IdIndex_t department_ids;               /* Index from department IDs to department handles, see departmentIndex() */
+    uint32_t department_ids_stale;          /* Flag set while department_ids is missing the adopted departments */
+    pthread_mutex_t department_ids_lock;    /* Lets one thread build department_ids */
+    uint32_t total_employees;               /* Counter for the total number of employees currently stored */
+    uint32_t total_departments;             /* Counter for the total number of departments currently stored */
+    uint32_t employees_capacity;            /* Number of employee handles the array can hold */
+    uint32_t departments_capacity;          /* Number of department handles the array can hold */
+    uint64_t employee_changes;              /* Value of store_change_clock at the last time employees were added or deleted */
+    EmployeeRename_t *renames;              /* Renames since employee_changes last changed, EMPLOYEE_RENAME_LOG_LENGTH slots */
+    uint32_t rename_count;                  /* Number of renames kept in renames */
+};
 
 
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
-static uint64_t calculateSalary(struct Employee Employee_param);
+static uint32_t ensureEmployeeCapacity(uint32_t required);
+static uint32_t ensureDepartmentCapacity(uint32_t required);
+static uint32_t growHandles(RecordHandle_t **handles, uint32_t *capacity, uint32_t initial, uint32_t required);
+static IdIndex_t* employeeIndex();
+static IdIndex_t* departmentIndex();
+static void countEmployeeChange();
+static void logEmployeeRename(const Employee_t *employee, const int8_t *old_name);
+static Employee_t* employeeAt(uint32_t index);
+static Department_t* departmentAt(uint32_t index);
+static Employee_t* findEmployeeRecord(const int8_t *employee_id);
+static Department_t* findDepartmentRecord(const int8_t *department_id);
+static Department_t* createDepartment(const Department_t *department, uint32_t employee_count);
+static const int8_t* employeeKey(uint32_t value, const void *context);
+static const int8_t* departmentKey(uint32_t value, const void *context);
+static const int8_t* newDepartmentKey(uint32_t value, const void *context);
+static int compareIdPointers(const void *first, const void *second);
+static int compareEmployeeIdPointers(const void *first, const void *second);
+static int compareEmployeeDepartmentPointers(const void *first, const void *second);
+static int compareUpdatePointers(const void *first, const void *second);
+static void applyEmployeeUpdate(Employee_t *employee, const EmployeeUpdate_t *update);
+static ParseStatus_t promptFieldChange(const char *label, const int8_t *current, int8_t *buffer, uint32_t size);
+static uint32_t promptUnsignedChange(const char *label, uint64_t current, uint64_t max_value, uint64_t *value);
+static uint32_t promptPerformanceChange(float current, float *value);
+static void copyName(int8_t *name, const int8_t *text);
+static uint32_t promptSortOrder(EmployeeSortKey_t *keys);
+static uint32_t printEmployeeLines(const PayrollLine_t *lines, uint32_t count, void *context);
+static uint32_t printPayrollLines(const PayrollLine_t *lines, uint32_t count, void *context);
+static void printUsageLine(const char *name, uint64_t count, uint64_t live_bytes, uint64_t reserved_bytes);
 
 
 /*******************************************************************************
  * Variables
  ******************************************************************************/
-Employee_t employees_arr[MAX_EMPLOYEES];        /* Array to store employee records */
-Department_t departments_arr[MAX_DEPARTMENTS];  /* Array to store department records */
-uint32_t total_employees = 0;                   /* Counter for the total number of employees currently stored */
-uint32_t total_departments = 0;                 /* Counter for the total number of departments currently stored */
+static EmployeeStore_t default_store = { .employee_ids_lock = PTHREAD_MUTEX_INITIALIZER,
+                                         .department_ids_lock = PTHREAD_MUTEX_INITIALIZER };   /* Store used until a thread selects another one */
+static __thread EmployeeStore_t *active_store = &default_store;    /* Store the functions of this file work on in the calling thread */
+static uint64_t store_change_clock = 0; /* Counter of employee changes over all stores, see getEmployeeChangeCount() */
 
 
 /*******************************************************************************
@@ -104,71 +140,81 @@ void showMenu()
     printf("| 5. Delete department by department's ID.      |\n");
     printf("| 6. Shows payroll.                             |\n");
     printf("| 7. Exit program.                              |\n");
+    printf("| 8. Export payroll to columnar file.           |\n");
+    printf("| 9. Update department's bonus or raise.        |\n");
+    printf("| a. Payroll history (record/show/save/load).   |\n");
+    printf("| b. Import employees from CSV file.            |\n");
+    printf("| c. Simulate payroll rules (what-if).          |\n");
+    printf("| d. Save data snapshot (loaded at startup).    |\n");
+    printf("| e. Show memory usage.                         |\n");
+    printf("| f. Import attendance from clock-in log.       |\n");
+    printf("| g. Organization hierarchy and payroll totals. |\n");
+    printf("| h. Compare two payroll exports.               |\n");
+    printf("| i. Publish data to shared memory.             |\n");
+    printf("| j. Generate payslip files.                    |\n");
+    printf("| k. Search employees by name.                  |\n");
+    printf("| l. Update employee's information.             |\n");
+    printf("| m. Start or stop the change feed.             |\n");
+    printf("| n. Companies (add/select/delete/payroll).     |\n");
+    printf("| o. Performance stats (show/clear/on/off).     |\n");
     printf("|_______________________________________________|\n");
     printf("\n");
 }
 
 /**
- * @brief Shows the list of employees sorted by working performance.
+ * @brief Shows the list of employees in an order chosen by the user.
  *
- * This function checks if there are employees to show or not and then sorts them
- * based on working performance.
+ * This function checks if there are employees to show or not, asks for the sort order
+ * (working performance by default) and sorts them. The store keeps the new order.
  * It then prints out each employee's details. Fields such as bonus, salary base
  * will be formatted with "," to illustrate money unit
  * If there are no employee, it prints a message indicating so.
  */
 void showEmployees()
 {
-    uint32_t i = 0;         /* Initialize loop counter */
-    uint32_t j = 0;         /* Initialize loop counter */
-    Employee_t temp;        /* Temporary variable to hold employee details during sorting */
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
+    uint32_t i = 0;                         /* Initialize loop counter */
+    EmployeeSortKey_t keys[EMPLOYEE_SORT_MAX_KEYS];    /* Sort order chosen by the user */
+    uint32_t key_count = 0;                 /* Number of sort keys */
+    uint32_t *order = NULL;                 /* Store position of each employee in sorted order */
+    RecordHandle_t *sorted = NULL;          /* Handles in sorted order */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the sort */
 
     /* Check if employees have */
-    if (total_employees == 0)
+    if (store->total_employees == 0)
     {
         /* Print a message if there are no employees */
         printf("No employees to show!!!\n");
     }
     else
     {
-        // Loop to sort employees based on working performance
-        for (i = 0; i < total_employees - 1; i++)
+        key_count = promptSortOrder(keys);
+
+        PERF_START(perf_start);     /* Start time of the sort */
+
+        order = malloc((size_t)store->total_employees * sizeof(*order));
+        sorted = malloc((size_t)store->total_employees * sizeof(*sorted));
+        status = (order == NULL || sorted == NULL) ? MANAGE_ERR_NO_MEMORY : sortEmployeeOrder(keys, key_count, order);
+        if (status == MANAGE_OK)
         {
-            for (j = i + 1; j < total_employees; j++)
+            /* Reorder the handles, the records themselves never move */
+            for (i = 0; i < store->total_employees; i++)
             {
-                if (employees_arr[i].working_performance < employees_arr[j].working_performance)
-                {
-                    temp = employees_arr[i];
-                    employees_arr[i] = employees_arr[j];
-                    employees_arr[j] = temp;
-                }
+                sorted[i] = store->employee_handles[order[i]];
             }
+            memcpy(store->employee_handles, sorted, (size_t)store->total_employees * sizeof(*sorted));
         }
+        free(order);
+        free(sorted);
+        PERF_STOP(PERF_OP_SORT_EMPLOYEES, perf_start);
 
-        /* Loop to show each employee's details */
-        for (i = 0; i < total_employees; i++)
+        if (status != MANAGE_OK)
         {
-            printf("----\n");
-            /* Print the employee's ID */
-            printf("ID: %s\n", employees_arr[i].id);
-            /* Print the department's ID */
-            printf("Department's ID: %s\n", employees_arr[i].department_id);
-            /* Print the employee's full name */
-            printf("Full name: %s\n", employees_arr[i].name);
-            /* Print the employee's salary base in VND, value formatted with ","
-            (using formatNumberWithCommas() function) to illustrate money unit */
-            printf("Salary base: %s (VND)\n", formatNumberWithCommas(employees_arr[i].salary_base));
-            /* Print the number of working days */
-            printf("Number of working days: %hu (days)\n", employees_arr[i].working_days);
-            /* Print the employee's working performance */
-            printf("Working performance: %.1f\n", employees_arr[i].working_performance);
-            /* Print the employee's bonus in VND, value formatted with ","
-            (using formatNumberWithCommas() function) to illustrate money unit */
-            printf("Bonus: %s (VND)\n", formatNumberWithCommas(employees_arr[i].bonus));
-            /* Print the number of late working days */
-            printf("Number of late working days: %hu (days)\n", employees_arr[i].late_coming_days);
-            printf("----\n");
+            printf("Not enough memory to sort employees, they are shown unsorted.\n");
         }
+
+        /* Show each employee's details, one batch at a time */
+        forEachPayrollBatch(NULL, 0, 0, printEmployeeLines, NULL);
     }
 }
 
@@ -184,7 +230,7 @@ void showDepartments()
     uint32_t i = 0;             /* Index for looping through departments */
 
     /* Check if there are any departments */
-    if (total_departments == 0)
+    if (active_store->total_departments == 0)
     {
         /* Print a message if there are no departments */
         printf("No department to show!!!\n");
@@ -192,13 +238,19 @@ void showDepartments()
     else
     {
         /* Loop through each department */
-        for (i = 0; i < total_departments; i++)
+        for (i = 0; i < active_store->total_departments; i++)
         {
             printf("----\n");
             /* Print the department's ID */
-            printf("Department's ID: %s\n", departments_arr[i].id);
+            printf("Department's ID: %s\n", departmentAt(i)->id);
             /* Print the department's bonus, value formatted with "," to illustrate money */
-            printf("Department's bonus: %s (VND)\n", formatNumberWithCommas(departments_arr[i].bonus_salary));
+            printf("Department's bonus: %s (VND)\n", formatNumberWithCommas(departmentAt(i)->bonus_salary));
+            /* Print the department's salary raise if it has one */
+            if (departmentAt(i)->raise_factor != 0 && departmentAt(i)->raise_factor != DEPARTMENT_NO_RAISE)
+            {
+                printf("Department's salary raise: %.2f%%\n",
+                       ((double)departmentAt(i)->raise_factor - DEPARTMENT_NO_RAISE) / 100.0);
+            }
             printf("----\n");
         }
     }
@@ -209,17 +261,25 @@ void showDepartments()
  * @brief Adds a new employee to the program
  *
  * This function prompts the user for employee details, checks for unique ID,
- * and adds the employee to the global employees array. If the department ID
+ * and adds the employee to the store. If the department ID
  * does not exist, it prompts for department details and adds a new department.
  */
 void addEmployee()
 {
-    uint32_t i = 0;                         /* Index for looping through employees */
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
     uint16_t id_exists = 0;                 /* Flag to check if ID already exists */
-    uint16_t department_id_exists = 1;      /* Flag to check if department ID exists */
     int8_t buffer[100];                    /* Buffer to store input temporarily */
     Employee_t newEmployee;                 /* Struct to store new employee details */
     uint16_t validInput = 0;                /* Flag to check if input is valid */
+    Department_t *department = NULL;        /* The employee's department */
+    ParseStatus_t status = PARSE_EMPTY;     /* Result of parsing the working performance */
+
+    /* Make sure there is room for the new employee and its department before asking for details */
+    if (ensureEmployeeCapacity(store->total_employees + 1) == 0 || ensureDepartmentCapacity(store->total_departments + 1) == 0)
+    {
+        printf("Not enough memory to add new employee!!!\n");
+        return;
+    }
 
     printf("Adding new employee . . . \n");
     /* Loop to ensure unique and non-empty employee's ID is entered */
@@ -227,57 +287,21 @@ void addEmployee()
     {
         id_exists = 0;                      /* Reset flag for each iteration */
 
-        printf("Enter ID: ");
-        fflush(stdin);
-        /* Get ID from user */
-        fgets(newEmployee.id, sizeof(newEmployee.id), stdin);
-        /* Check if ID field is empty */
-        if (isStringEmpty(newEmployee.id) == 1)
-        {
-            /* Print a message if the input is empty */
-            printf("\nYou must not leave blank this information ...\n");
-            printf("\nPlease enter again ...\n");
-        }
-        else
+        /* Get a non-empty ID from user */
+        promptIdInput("Enter ID: ", newEmployee.id, sizeof(newEmployee.id));
+        /* Look the ID up in the employee index */
+        if (findEmployeeRecord(newEmployee.id) != NULL)
         {
-            /* Loop through existing employees */
-            for (i = 0; i < total_employees; i++)
-            {
-                /* ID match found */
-                if (strcmp(newEmployee.id, employees_arr[i].id) == 0)
-                {
-                    /* Set flag if ID match found */
-                    id_exists = 1;
-                    printf("\nID already exists!!!\n\n");
-                    printf("Please enter another ID again.\n");
-                    /* Exit loop instead of using break statement*/
-                    i = total_employees;
-                }
-            }
+            /* Set flag if ID match found */
+            id_exists = 1;
+            printf("\nID already exists!!!\n\n");
+            printf("Please enter another ID again.\n");
         }
-    } /* Repeat if ID is empty or exists */
-    while (isStringEmpty(newEmployee.id) == 1 || id_exists == 1);
+    } /* Repeat if ID exists */
+    while (id_exists == 1);
 
-    /* This loop ensures that the employee's department ID is entered and is not left blank */
-    do
-    {
-        printf("Enter department's ID: ");
-        fflush(stdin);
-        /* Get department ID from user */
-        fgets(newEmployee.department_id, sizeof(newEmployee.department_id), stdin);
-        /* Check if department ID is empty */
-        if (isStringEmpty(newEmployee.department_id) == 1)
-        {
-            /* Print a message if the input is empty */
-            printf("\nYou must not leave blank this information ...\n");
-            printf("\nPlease enter again ...\n");
-        }
-        else
-        {
-            /* Do nothing */
-        }
-    } /* Repeat if department ID is empty */
-    while ((isStringEmpty(newEmployee.department_id) == 1));
+    /* Get the employee's department ID, it must not be left blank */
+    promptIdInput("Enter department's ID: ", newEmployee.department_id, sizeof(newEmployee.department_id));
 
     /* This loop ensures that the employee's full name is entered and is not left blank */
     do
@@ -301,60 +325,11 @@ void addEmployee()
     } /* Repeat if input is empty*/
     while (validInput == 0);
 
-    /* This loop ensures that the employee's salary base is entered and is not left blank */
-    do
-    {
-        printf("Enter salary base: ");
-        fflush(stdin);
-        /* Get salary base from user */
-        fgets(buffer, sizeof(buffer), stdin);
-        /* Check if input is empty */
-        if (isStringEmpty(buffer) == 1)
-        {
-            /* Print a message if the input is empty */
-            printf("\nYou must not leave blank this information ...\n");
-            printf("\nPlease enter again ...\n");
-        }
-        else if (isWholeNumber(buffer) == 0)
-        {
-            /* Print a message if the input is not a whole number more than 0 */
-            printf("\nPlease enter a whole number more than 0 !!!\n");
-        }
-        else
-        {
-            /* Parse salary base from buffer */
-            sscanf(buffer, "%llu", &newEmployee.salary_base);
-        }
-    } /* Repeat if input is empty or is not a whole number more than 0 */
-    while ((isStringEmpty(buffer) == 1) || (isWholeNumber(buffer) == 0));
+    /* Get the employee's salary base, validated and parsed in one pass */
+    newEmployee.salary_base = (EmployeeAmount_t)promptUnsignedInput("Enter salary base: ", EMPLOYEE_MAX_AMOUNT);
 
-    /* This loop ensures that the employee's working day is entered and is not left blank */
-    do
-    {
-        printf("Enter number of working days: ");
-        fflush(stdin);
-        /* Get number of working days from user */
-        fgets(buffer, sizeof(buffer), stdin);
-        /* Check if input is empty */
-        if (isStringEmpty(buffer) == 1)
-        {
-            /* Print a message if the input is empty */
-            printf("\nYou must not leave blank this information ...\n");
-            printf("\nPlease enter again ...\n");
-        }
-        /* Check if input is whole number more than 0 */
-        else if (isWholeNumber(buffer) == 0)
-        {
-            /* Print a message if the input is not a whole number more than 0 */
-            printf("\nPlease enter a whole number more than 0 !!!\n");
-        }
-        else
-        {
-            /* Parse number of working days from buffer */
-            sscanf(buffer, "%hu", &newEmployee.working_days);
-        }
-    } /* Repeat if input is empty or is not a whole number more than 0 */
-    while ((isStringEmpty(buffer) == 1) || (isWholeNumber(buffer) == 0));
+    /* Get the employee's number of working days, it must fit in EmployeeDays_t */
+    newEmployee.working_days = (EmployeeDays_t)promptUnsignedInput("Enter number of working days: ", EMPLOYEE_MAX_DAYS);
 
     /* This loop ensures that the employee's working performance is entered and is not left blank */
     do
@@ -364,151 +339,73 @@ void addEmployee()
         fflush(stdin);
         /* Get working performance from user */
         fgets(buffer, sizeof(buffer), stdin);
-        /* Check if input is empty */
-        if (isStringEmpty(buffer) == 1)
-        {
-            /* Print a message if the input is empty */
-            printf("\nYou must not leave blank this information ...\n");
-            printf("\nPlease enter again ...\n");
-        }
-        else
-        {
-            /* Parse working performance from buffer */
-            sscanf(buffer, "%f", &newEmployee.working_performance);
-            /* Check if input more than 0 */
-            if (newEmployee.working_performance > 0)
-            {
-                /* If input more than 0, set flag to exit loop */
-                validInput = 1;
-            }
-            else
-            {
-                printf("You must enter a number that more than 0 !!!\n");
-            }
-        }
-    } while (validInput == 0);   /* Repeat if input is empty */
-
-    /* This loop ensures that the employee's bonus is entered and is not left blank */
-    do
-    {
-        printf("Enter bonus: ");
-        fflush(stdin);
-        /* Get bonus from user */
-        fgets(buffer, sizeof(buffer), stdin);
-        /* Check if input is empty */
-        if (isStringEmpty(buffer) == 1)
+        /* Validate and parse working performance in one pass */
+        status = parseDecimalField(buffer, strlen(buffer), &newEmployee.working_performance);
+        if (status == PARSE_EMPTY)
         {
             /* Print a message if the input is empty */
             printf("\nYou must not leave blank this information ...\n");
             printf("\nPlease enter again ...\n");
         }
-        else if (isWholeNumber(buffer) == 0)
+        /* Check if input is a number more than 0 */
+        else if (status == PARSE_OK && newEmployee.working_performance > 0)
         {
-            /* Print a message if the input is not a whole number more than 0 */
-            printf("\nPlease enter a whole number more than 0 !!!\n");
+            /* If input more than 0, set flag to exit loop */
+            validInput = 1;
         }
         else
         {
-            /* Parse bonus from buffer */
-            sscanf(buffer, "%llu", &newEmployee.bonus);
+            printf("You must enter a number that more than 0 !!!\n");
         }
-    } /* Repeat if input is empty or is not a whole number more than 0 */
-    while ((isStringEmpty(buffer) == 1) || (isWholeNumber(buffer) == 0));
+    } while (validInput == 0);   /* Repeat if input is empty or not valid */
 
-    /* This loop ensures that the employee's late coming days is entered and is not left blank */
-    do
-    {
-        printf("Enter number of late coming days: ");
-        fflush(stdin);
-        /* Get number of late coming days from user */
-        fgets(buffer, sizeof(buffer), stdin);
-        /* Check if input is empty */
-        if (isStringEmpty(buffer) == 1)
-        {
-            /* Print a message if the input is empty */
-            printf("\nYou must not leave blank this information ...\n");
-            printf("\nPlease enter again ...\n");
-        }
-        else if (isWholeNumber(buffer) == 0)
-        {
-            /* Print a message if the input is not a whole number more than 0 */
-            printf("\nPlease enter a whole number more than 0 !!!\n");
-        }
-        else
-        {
-            /* Parse number of late coming days from buffer */
-            sscanf(buffer, "%hu", &newEmployee.late_coming_days);
-        }
-    } /* Repeat if input is empty or is not a whole number more than 0 */
-    while ((isStringEmpty(buffer) == 1) || (isWholeNumber(buffer) == 0));
+    /* Get the employee's bonus */
+    newEmployee.bonus = (EmployeeAmount_t)promptUnsignedInput("Enter bonus: ", EMPLOYEE_MAX_AMOUNT);
+
+    /* Get the employee's number of late coming days, it must fit in EmployeeDays_t */
+    newEmployee.late_coming_days = (EmployeeDays_t)promptUnsignedInput("Enter number of late coming days: ", EMPLOYEE_MAX_DAYS);
 
-    /* Add new employee to array */
-    employees_arr[total_employees] = newEmployee;
+    /* Add new employee to the pool, memory was reserved by ensureEmployeeCapacity() */
+    store->employee_handles[store->total_employees] = recordPoolAlloc(&store->employee_pool);
+    *employeeAt(store->total_employees) = newEmployee;
+    idIndexInsert(employeeIndex(), newEmployee.id, store->employee_handles[store->total_employees]);
     /* Increment total employees count */
-    total_employees += 1;
+    store->total_employees += 1;
+    countEmployeeChange();
     printf("----\n");
     printf("Added new employee ...\n\n");
 
-    /* Check if department exists */
-    /* Loop through existing departments */
-    for (i = 0; i < total_departments; i++)
-    {
-        /* Check if department ID matches */
-        if (strcmp(newEmployee.department_id, employees_arr[i].department_id) != 0)
-        {
-            /* Set flag if department ID does not match */
-            department_id_exists = 0;
-            /* Exit loop */
-            i = total_departments;
-        }
-    }
-    /* If department ID does not exist or no departments exist */
-    if ((department_id_exists == 0) || (total_departments == 0))
+    /* Look the department up by its ID, the index holds at most one department per ID */
+    department = findDepartmentRecord(newEmployee.department_id);
+    if (department == NULL)
     {
         printf("Department's ID does not exist, create a new one ...\n");
 
         /* Struct to store new department details */
         Department_t newDepartment;
 
-        /* This loop ensures that the department bonus is entered and is not left blank */
-        do
-        {
-            printf("Enter department's bonus: ");
-            fflush(stdin);
-            /* Get department's bonus from user */
-            fgets(buffer, sizeof(buffer), stdin);
-            /* Check if input is empty */
-            if (isStringEmpty(buffer) == 1)
-            {
-                printf("You must not leave blank this information ...\n");
-                printf("Please enter again ...\n");
-            }
-            else if (isWholeNumber(buffer) == 0)
-            {
-                /* Print a message if the input is not a whole number more than 0 */
-                printf("\nPlease enter a whole number more than 0 !!!\n");
-            }
-            else
-            {
-                /* Parse department's bonus from buffer */
-                sscanf(buffer, "%llu", &newDepartment.bonus_salary);
-            }
-        } /* Repeat if input is empty or is not a whole number more than 0 */
-        while ((isStringEmpty(buffer) == 1) || (isWholeNumber(buffer) == 0));
+        /* Get the department's bonus */
+        newDepartment.bonus_salary = promptUnsignedInput("Enter department's bonus: ", UINT64_MAX);
 
         /* Copy department ID from employee to new department */
         strcpy(newDepartment.id, newEmployee.department_id);
+        newDepartment.raise_factor = DEPARTMENT_NO_RAISE;
 
-        /* Add new department to array */
-        departments_arr[total_departments] = newDepartment;
-
-        /* Increment total departments count */
-        total_departments += 1;
+        /* Add new department to the store, memory was reserved by ensureDepartmentCapacity() */
+        department = createDepartment(&newDepartment, 0);
+        changeFeedDepartment(CHANGE_INSERT, NULL, department);
 
         printf("----\n");
         printf("Created new department ...\n");
         printf("Added new employee ...\n");
     }
+
+    /* Count the new employee in its department */
+    department->employee_count += 1;
+
+    /* Record the employee after its department, so readers of the feed know both */
+    changeFeedEmployee(CHANGE_INSERT, NULL, employeeAt(store->total_employees - 1));
+    changeFeedCommit();
 }
 
 
@@ -516,18 +413,21 @@ void addEmployee()
  * @brief Deletes an employee from program.
  *
  * This function prompts the user for the ID of the employee they want to delete.
- * If the ID is found, the employee is removed from the global employees array.
+ * If the ID is found, the employee is removed from the store.
  * If the ID is not found, a message is printed indicating so.
  */
 void deleteEmployee()
 {
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
     int8_t id_to_Delete[MAX_ID_LENGTH];    /* Buffer to store the ID of the employee to delete */
     uint32_t i = 0;                         /* Index for looping through employees */
     uint32_t j = 0;                         /* Index for shifting employees after the deleted one */
     int16_t found = 0;                      /* Flag to check if the employee with the given ID is found */
+    RecordHandle_t handle = RECORD_POOL_INVALID_HANDLE;    /* Handle of the employee to delete */
+    Department_t *department = NULL;        /* The deleted employee's department */
 
     /* Check if there are any employees */
-    if (total_employees == 0)
+    if (store->total_employees == 0)
     {
         /* Print a message if there are no employees */
         printf("No employee to delete!!!");
@@ -554,30 +454,49 @@ void deleteEmployee()
             }
         } while (isStringEmpty(id_to_Delete) == 1);  /* Repeat if input is empty */
 
-        /* Loop through each employee */
-        for (i = 0; i < total_employees; i++)
+        PERF_START(perf_start);     /* Start time of the search and shift */
+
+        /* Look the ID up in the employee index, then find the position of its handle */
+        if (idIndexFind(employeeIndex(), id_to_Delete, &handle) == 0)
+        {
+            /* Skip the loop, no employee has this ID */
+            i = store->total_employees;
+        }
+        for (; i < store->total_employees; i++)
         {
-            /* Check if the employee's ID matches the ID to delete */
-            if (strcmp(id_to_Delete, employees_arr[i].id) == 0)
+            /* Check if this is the handle of the employee to delete */
+            if (store->employee_handles[i] == handle)
             {
-                /* Shift the employees after the deleted one */
-                for (j = i; j < total_employees - 1; j++)
+                /* Remove the employee from its department's count */
+                department = findDepartmentRecord(employeeAt(i)->department_id);
+                if (department != NULL && department->employee_count > 0)
+                {
+                    department->employee_count -= 1;
+                }
+                /* Give the record back to the pool and shift the handles after the deleted one */
+                changeFeedEmployee(CHANGE_DELETE, employeeAt(i), NULL);
+                idIndexRemove(employeeIndex(), employeeAt(i)->id);
+                recordPoolRelease(&store->employee_pool, store->employee_handles[i]);
+                for (j = i; j < store->total_employees - 1; j++)
                 {
-                    employees_arr[j] = employees_arr[j + 1];
+                    store->employee_handles[j] = store->employee_handles[j + 1];
                 }
                 /* Decrement the total number of employees */
-                total_employees -= 1;
+                store->total_employees -= 1;
+                countEmployeeChange();
+                changeFeedCommit();
                 /* Set the flag to indicate that the employee with the given ID is found */
                 found = 1;
 
                 /* Exit for-loop instead of using break statement */
-                i = total_employees;
+                i = store->total_employees;
             }
             else
             {
                 /* Do nothing */
             }
         }
+        PERF_STOP(PERF_OP_DELETE_EMPLOYEE, perf_start);
 
         /* Check if the employee with the given ID is found */
         if (found == 1)
@@ -593,6 +512,120 @@ void deleteEmployee()
     }
 }
 
+/**
+ * @brief Changes some fields of an employee.
+ *
+ * This function prompts the user for the ID of the employee, then for each field shows the
+ * current value and asks for a new one; pressing Enter keeps the value. The record is changed
+ * in place, without deleting and adding the employee again.
+ */
+void updateEmployee()
+{
+    EmployeeUpdate_t update;                /* Fields chosen by the user and their new values */
+    const Employee_t *employee = NULL;      /* The employee to update */
+    int8_t buffer[100];                     /* Buffer to store input temporarily */
+    uint64_t value = 0;                     /* Number entered by the user */
+    uint32_t start = 0;                     /* Offset of the department's ID in buffer */
+    uint32_t id_length = 0;                 /* Length of the department's ID */
+    ParseStatus_t status = PARSE_EMPTY;     /* Result of validating the department's ID */
+    ManageStatus_t result = MANAGE_OK;      /* Result of the update */
+
+    /* Check if there are any employees */
+    if (active_store->total_employees == 0)
+    {
+        printf("No employee to update!!!\n");
+        return;
+    }
+    memset(&update, 0, sizeof(update));
+    promptIdInput("Input employee's ID which you want to update: ", update.employee.id, sizeof(update.employee.id));
+    employee = findEmployeeRecord(update.employee.id);
+    if (employee == NULL)
+    {
+        printf("No employee has ID %s\n", update.employee.id);
+        return;
+    }
+    printf("Updating employee %s, press Enter to keep the value in brackets . . .\n", employee->id);
+
+    /* The new department must already exist */
+    do
+    {
+        status = promptFieldChange("Department's ID", employee->department_id, buffer, sizeof(buffer));
+        if (status == PARSE_OK)
+        {
+            status = parseIdField(buffer, (uint32_t)strlen(buffer), MAX_ID_LENGTH - 1, &start, &id_length);
+            if (status != PARSE_OK)
+            {
+                printf("\nID must not contain spaces or be longer than %u characters !!!\n", MAX_ID_LENGTH - 1);
+                status = PARSE_INVALID;
+            }
+            else
+            {
+                memcpy(update.employee.department_id, buffer + start, id_length);
+                update.employee.department_id[id_length] = '\0';
+                if (findDepartmentRecord(update.employee.department_id) == NULL)
+                {
+                    printf("\nDepartment's ID does not exist !!!\n");
+                    status = PARSE_INVALID;
+                }
+                else
+                {
+                    update.fields |= EMPLOYEE_FIELD_DEPARTMENT;
+                }
+            }
+        }
+    } while (status == PARSE_INVALID);
+
+    if (promptFieldChange("Full name", employee->name, buffer, sizeof(buffer)) == PARSE_OK)
+    {
+        /* Longer names are cut, as addEmployee() does */
+        copyName(update.employee.name, buffer);
+        update.fields |= EMPLOYEE_FIELD_NAME;
+    }
+    if (promptUnsignedChange("Salary base", employee->salary_base, EMPLOYEE_MAX_AMOUNT, &value) == 1)
+    {
+        update.employee.salary_base = (EmployeeAmount_t)value;
+        update.fields |= EMPLOYEE_FIELD_SALARY_BASE;
+    }
+    if (promptUnsignedChange("Number of working days", employee->working_days, EMPLOYEE_MAX_DAYS, &value) == 1)
+    {
+        update.employee.working_days = (EmployeeDays_t)value;
+        update.fields |= EMPLOYEE_FIELD_WORKING_DAYS;
+    }
+    if (promptPerformanceChange(employee->working_performance, &update.employee.working_performance) == 1)
+    {
+        update.fields |= EMPLOYEE_FIELD_WORKING_PERFORMANCE;
+    }
+    if (promptUnsignedChange("Bonus", employee->bonus, EMPLOYEE_MAX_AMOUNT, &value) == 1)
+    {
+        update.employee.bonus = (EmployeeAmount_t)value;
+        update.fields |= EMPLOYEE_FIELD_BONUS;
+    }
+    if (promptUnsignedChange("Number of late coming days", employee->late_coming_days, EMPLOYEE_MAX_DAYS, &value) == 1)
+    {
+        update.employee.late_coming_days = (EmployeeDays_t)value;
+        update.fields |= EMPLOYEE_FIELD_LATE_COMING_DAYS;
+    }
+
+    if (update.fields == 0)
+    {
+        printf("Nothing changed . . .\n");
+        return;
+    }
+    result = updateEmployeesBatch(&update, 1);
+    if (result == MANAGE_OK)
+    {
+        printf("Updated successfully . . .\n");
+    }
+    else if (result == MANAGE_ERR_NO_MEMORY)
+    {
+        printf("Not enough memory to update employee!!!\n");
+    }
+    else
+    {
+        printf("Employee could not be updated!!!\n");
+    }
+}
+
 /**
  * @brief Deletes a department from the program.
  *
@@ -603,15 +636,16 @@ void deleteEmployee()
  */
 void deleteDepartment()
 {
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
     int8_t idDepartment_to_Delete[MAX_ID_LENGTH];  /* Buffer to store the ID of the department to delete */
     uint32_t i = 0;                 /* Index for looping through departments */
-    uint32_t j = 0;                 /* Index for looping through employees */
     uint32_t k = 0;                 /* Index for shifting departments after the deleted one */
     int16_t found = 0;              /* Flag to indicate if the department with the given ID is found */
     int16_t employee_exist = 0;     /* Flag to indicate if the department has employees */
+    RecordHandle_t handle = RECORD_POOL_INVALID_HANDLE;    /* Handle of the department to delete */
 
     /* Check if there are any departments to delete */
-    if (total_departments == 0)
+    if (store->total_departments == 0)
     {
         /* Print a message if there are no departments to delete */
         printf("No department to delete!!!");
@@ -638,55 +672,40 @@ void deleteDepartment()
             }
         } while (isStringEmpty(idDepartment_to_Delete) == 1);   /* Repeat if input is empty */
 
-        /* Loop through each department */
-        for (i = 0; i < total_departments; i++)
+        PERF_START(perf_start);     /* Start time of the search and shift */
+
+        /* Look the department up by its ID */
+        if (idIndexFind(departmentIndex(), idDepartment_to_Delete, &handle) == 1)
         {
-            /* Check if the department's ID matches the ID to delete */
-            if (strcmp(idDepartment_to_Delete, departments_arr[i].id) == 0)
+            /* Set the flag to indicate that the department with the given ID is found */
+            found = 1;
+            /* The membership count tells if the department has employees, no need to scan them */
+            if (((Department_t*)recordPoolGet(&store->department_pool, handle))->employee_count > 0)
             {
-                /* Loop through each employee */
-                for (j = 0; j < total_employees; j++)
-                {
-                    /* Check if there are employee who is in department want to delete */
-                    if (strcmp(departments_arr[i].id, employees_arr[j].department_id) == 0)
-                    {
-                        /* Set the flag to indicate that the department has employees */
-                        employee_exist = 1;
-                        /* Set the flag to indicate that the department with the given ID is found */
-                        found = 1;
-                        /* Exit for-loop instead of using break statement */
-                        j = total_employees;
-                        i = total_departments;
-                    }
-                    else
-                    {
-                        /* Do nothing */
-                    }
-                }
-
-                /* Check if the department has no employees */
-                if (employee_exist == 0)
+                /* Set the flag to indicate that the department has employees */
+                employee_exist = 1;
+            }
+            else
+            {
+                /* Find the handle's position and shift the handles after it */
+                for (i = 0; store->department_handles[i] != handle; i++)
                 {
-                    /* Shift the departments after the deleted one */
-                    for (k = i; k < total_departments - 1; k++)
-                    {
-                        departments_arr[k] = departments_arr[k+1];
-                    }
-                    /* Decrement the total number of departments */
-                    total_departments -= 1;
-                    /* Set the flag to indicate that the department with the given ID is found */
-                    found = 1;
+                    /* Do nothing */
                 }
-                else
+                for (k = i; k < store->total_departments - 1; k++)
                 {
-                    /* Do nothing */
+                    store->department_handles[k] = store->department_handles[k+1];
                 }
-            }
-            else
-            {
-                /* code */
+                /* Remove the ID from the index before the record is given back to the pool */
+                changeFeedDepartment(CHANGE_DELETE, recordPoolGet(&store->department_pool, handle), NULL);
+                idIndexRemove(departmentIndex(), idDepartment_to_Delete);
+                recordPoolRelease(&store->department_pool, handle);
+                /* Decrement the total number of departments */
+                store->total_departments -= 1;
+                changeFeedCommit();
             }
         }
+        PERF_STOP(PERF_OP_DELETE_DEPARTMENT, perf_start);
 
         /* Check if the department with the given ID is found and has no employees */
         if (found == 1 && employee_exist == 0)
@@ -712,110 +731,1878 @@ void deleteDepartment()
  * @brief Shows the payroll of all employees.
  *
  * This function checks if there are any employees to show the payroll.
- * If there are, it loops through each employee, calculates their actual salary by using
- * static function calculateSalary() and prints their details.
+ * If there are, it walks through the employees in batches, calculating the actual salary
+ * of each batch only, and prints their details.
  * If there are no employees, it prints a message indicating so.
  */
 void showPayroll()
 {
-    uint32_t i = 0;                     /* Index for looping through employees */
-    uint64_t actual_salary = 0;         /* Actual salary of the employee */
-
     /* Check if there are any employees */
-    if (total_employees == 0)
+    if (active_store->total_employees == 0)
     {
         /* Print a message if there are no employees */
         printf("No employee to show payroll!!!\n");
     }
     else
     {
-        /* Loop through each employee */
-        for (i = 0; i < total_employees; i++)
-        {
-            /* Calculate the actual salary of the employee using calculateSalary() function */
-            actual_salary = calculateSalary(employees_arr[i]);
-
-            printf("\n----\n");
-            /* Print the employee's ID */
-            printf("ID: %s\n", employees_arr[i].id);
-            /* Print the actual salary of the employee, this value is formatted with commas
-            to illustrate money */
-            printf("Actual salary received: %s (VND)\n", formatNumberWithCommas(actual_salary));
-            printf("----\n");
-        }
+        forEachPayrollBatch(NULL, 0, PAYROLL_CURSOR_SALARY, printPayrollLines, NULL);
     }
 }
 
 /**
- * @brief This function calculates the salary of an employee based on their performance and other factors.
- *
- * This function takes an Employee_t struct as a parameter and calculates the salary based on
- * the employee's performance, working days, bonus, and other factors.
- * It returns the calculated salary as a unsigned long long integer.
+ * @brief Prompts the user for a department and updates its bonus or grants it a salary raise.
  *
- * @param Employee_param The employee for whom the salary is to be calculated.
- * @return unsigned long long integer The calculated salary.
+ * This function prompts the user for the ID of an existing department, then asks whether to
+ * change the department's bonus or to grant a percentage raise to all of its employees.
+ * Both changes are recorded on the department only.
  */
-static uint64_t calculateSalary(struct Employee Employee_param)
+void adjustDepartment()
 {
-    uint32_t i = 0;                         /* Index for looping through departments */
-    uint64_t bonus_department = 0;          /* Bonus allocated to the department */
-    uint64_t late_coming_penalty = 0;       /* Penalty for late coming */
-    uint64_t income_without_bonus = 0;      /* Income without bonus */
-    uint64_t total_income = 0;              /* Total income */
-    uint64_t totalIncome_without_tax = 0;   /* Total income without tax */
-    uint64_t tax = 0;                       /* Tax */
-    uint64_t actual_salary = 0;             /* Actual salary */
+    int8_t department_id[MAX_ID_LENGTH];   /* Buffer to store the ID of the department */
+    int8_t buffer[100];                    /* Buffer to store input temporarily */
+    int8_t choice = 0;                      /* Kind of adjustment chosen by the user */
+    uint64_t bonus_salary = 0;              /* New bonus of the department */
+    float raise_percent = 0;                /* Raise entered by the user, in percent */
+    uint16_t validInput = 0;                /* Flag to check if input is valid */
+    ParseStatus_t status = PARSE_EMPTY;     /* Result of parsing the raise */
 
-    /* Find department's bonus */
-    /* Loop through existing departments */
-    for (i = 0; i < total_departments; i++)
+    /* Check if there are any departments */
+    if (active_store->total_departments == 0)
     {
-        /* Check if department ID matches */
-        if (strcmp(Employee_param.department_id, departments_arr[i].id) == 0)
-        {
-            /* Set bonus_department to the bonus of the matching department */
-            bonus_department = departments_arr[i].bonus_salary;
-        }
+        printf("No department to adjust!!!\n");
+        return;
     }
 
-    /* Calculate late_coming_penalty */
-    /* Check if the number of late coming days is less than or equal to 3 */
-    if (Employee_param.late_coming_days <= 3)
-    {
-        late_coming_penalty = Employee_param.late_coming_days * 10000;
-    }
-    else
+    /* Get the department ID, it must not be left blank */
+    promptIdInput("Input department's ID which you want to adjust: ", department_id, sizeof(department_id));
+
+    if (findDepartmentRecord(department_id) == NULL)
     {
-        late_coming_penalty = Employee_param.late_coming_days * 20000;
+        printf("No department has ID %s\n", department_id);
+        return;
     }
 
-    /* Calculate income_without_bonus */
-    income_without_bonus = (Employee_param.salary_base * Employee_param.working_days) * Employee_param.working_performance;
-    /* Calculate total_income */
-    total_income = income_without_bonus + Employee_param.bonus + bonus_department - late_coming_penalty;
-    /* Calculate totalIncome_without_tax */
-    totalIncome_without_tax = total_income * 0.895;
-
-    /* Calculate tax */
-    /* Check if totalIncome_without_tax is greater than 0 and less than or equal to 11000000 */
-    if (totalIncome_without_tax > 0 && totalIncome_without_tax <= 11000000)
+    printf("Enter 'b' to update department's bonus or 'r' to raise department's salary: ");
+    choice = getSingleCharInput();
+    if (choice == 'b' || choice == 'B')
     {
-        tax = 0;
+        bonus_salary = promptUnsignedInput("Enter department's bonus: ", UINT64_MAX);
+        updateDepartmentBonus(department_id, bonus_salary);
+        printf("Updated department's bonus ...\n");
     }
-    /* Check if totalIncome_without_tax is greater than 11000000 and less than or equal to 16000000 */
-    else if (totalIncome_without_tax > 11000000 && totalIncome_without_tax <= 16000000)
+    else if (choice == 'r' || choice == 'R')
     {
-        tax = totalIncome_without_tax * 0.05;
+        /* This loop ensures that the raise is entered and is more than 0 */
+        do
+        {
+            validInput = 0;
+            printf("Enter raise in percent (e.g. 2.5): ");
+            fflush(stdin);
+            fgets(buffer, sizeof(buffer), stdin);
+            status = parseDecimalField(buffer, strlen(buffer), &raise_percent);
+            if (status == PARSE_EMPTY)
+            {
+                printf("\nYou must not leave blank this information ...\n");
+                printf("\nPlease enter again ...\n");
+            }
+            else if (status == PARSE_OK && raise_percent >= 0.01f && raise_percent <= 1000.0f)
+            {
+                validInput = 1;
+            }
+            else
+            {
+                printf("You must enter a number between 0.01 and 1000 !!!\n");
+            }
+        } while (validInput == 0);     /* Repeat if input is not valid */
+
+        if (raiseDepartmentSalary(department_id, (uint32_t)(raise_percent * 100.0f + 0.5f)) == MANAGE_OK)
+        {
+            printf("Raised department's salary by %.2f%% ...\n", raise_percent);
+        }
+        else
+        {
+            printf("The department's raise is too large!!!\n");
+        }
     }
     else
     {
-        tax = totalIncome_without_tax * 0.1;
+        printf("Input is not valid!!!\n");
     }
+}
 
-    /* Calculate actual_salary */
-    actual_salary = totalIncome_without_tax - tax;
 
-    return actual_salary;
-} /* EOF */
+/**
+ * @brief Prints the memory used by each structure and index of the store.
+ *
+ * Live bytes are used by stored records, reserved bytes are all the memory held for the
+ * structure, including free records, unused capacity and bookkeeping. The cost of one more
+ * employee (record, handle and pool bookkeeping) is projected to PROJECTED_EMPLOYEES employees.
+ */
+void showMemoryUsage()
+{
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
+    StoreMemoryUsage_t usage;               /* Memory used by the store */
+    uint64_t field_bytes = 0;               /* Bytes of the fields of one employee, without padding */
+    uint64_t per_employee = 0;              /* Bytes taken by one more employee */
+
+    getStoreMemoryUsage(&usage);
+    field_bytes = FIELD_SIZE(Employee_t, salary_base) + FIELD_SIZE(Employee_t, bonus)
+                  + FIELD_SIZE(Employee_t, working_performance) + FIELD_SIZE(Employee_t, working_days)
+                  + FIELD_SIZE(Employee_t, late_coming_days) + FIELD_SIZE(Employee_t, id)
+                  + FIELD_SIZE(Employee_t, department_id) + FIELD_SIZE(Employee_t, name);
+
+    printf("%-24s%16s%18s%18s\n", "Structure", "Count", "Live bytes", "Reserved bytes");
+    printUsageLine("Employee records", usage.employees.live_records, usage.employees.live_bytes,
+                   usage.employees.reserved_bytes);
+    printUsageLine("Department records", usage.departments.live_records, usage.departments.live_bytes,
+                   usage.departments.reserved_bytes);
+    printUsageLine("Employee handles", store->total_employees, (uint64_t)store->total_employees * sizeof(RecordHandle_t),
+                   usage.employee_handle_bytes);
+    printUsageLine("Department handles", store->total_departments, (uint64_t)store->total_departments * sizeof(RecordHandle_t),
+                   usage.department_handle_bytes);
+    printUsageLine("Employee ID index", store->total_employees, usage.employee_index_bytes, usage.employee_index_bytes);
+    printUsageLine("Department ID index", store->total_departments, usage.index_bytes, usage.index_bytes);
+    printUsageLine("Total", (uint64_t)store->total_employees + store->total_departments,
+                   usage.employees.live_bytes + usage.departments.live_bytes
+                   + ((uint64_t)store->total_employees + store->total_departments) * sizeof(RecordHandle_t)
+                   + usage.employee_index_bytes + usage.index_bytes,
+                   usage.employees.reserved_bytes + usage.departments.reserved_bytes
+                   + usage.employee_handle_bytes + usage.department_handle_bytes
+                   + usage.employee_index_bytes + usage.index_bytes);
+
+    printf("\nEmployee record: %u bytes, %u of them padding", (uint32_t)sizeof(Employee_t),
+           (uint32_t)(sizeof(Employee_t) - field_bytes));
+    printf(" (compact mode %s)\n", (MANAGE_COMPACT_MODE != 0) ? "on" : "off");
+    printf("Department record: %u bytes\n", (uint32_t)sizeof(Department_t));
+    if (usage.employees.adopted_bytes + usage.departments.adopted_bytes > 0)
+    {
+        printf("Mapped from the snapshot: %s bytes\n",
+               formatNumberWithCommas(usage.employees.adopted_bytes + usage.departments.adopted_bytes));
+    }
+
+    /* Record, handle and ID index slot (hash and value) of one employee, plus one live bit per record */
+    per_employee = sizeof(Employee_t) + sizeof(RecordHandle_t) + 2 * sizeof(uint32_t);
+    printf("About %u bytes per employee, ", (uint32_t)per_employee);
+    printf("%s employees need about ", formatNumberWithCommas(PROJECTED_EMPLOYEES));
+    printf("%s MB\n", formatNumberWithCommas((per_employee * PROJECTED_EMPLOYEES + PROJECTED_EMPLOYEES / 8) >> 20));
+}
+
+
+/**
+ * @brief Sets the bonus of a department.
+ *
+ * @param department_id The department to update.
+ * @param bonus_salary The new bonus of the department.
+ * @return MANAGE_OK on success, MANAGE_ERR_NOT_FOUND if the department does not exist.
+ */
+ManageStatus_t updateDepartmentBonus(const int8_t *department_id, uint64_t bonus_salary)
+{
+    Department_t *department = findDepartmentRecord(department_id);   /* The department to update */
+    Department_t before;                    /* The department before the change, for the change feed */
+
+    if (department == NULL)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    before = *department;
+    department->bonus_salary = bonus_salary;
+    changeFeedDepartment(CHANGE_UPDATE, &before, department);
+    changeFeedCommit();
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Grants a percentage raise to every employee of a department.
+ *
+ * The new factor is the old factor multiplied by (100% + raise), rounded to the nearest
+ * basis point, so successive raises compound.
+ *
+ * @param department_id The department to update.
+ * @param raise_basis_points The raise in basis points (1% = 100), must be more than 0.
+ * @return MANAGE_OK on success, MANAGE_ERR_NOT_FOUND if the department does not exist,
+ *         MANAGE_ERR_INVALID_ARGUMENT if the raise is 0 or the factor would overflow.
+ */
+ManageStatus_t raiseDepartmentSalary(const int8_t *department_id, uint32_t raise_basis_points)
+{
+    Department_t *department = findDepartmentRecord(department_id);   /* The department to update */
+    Department_t before;                    /* The department before the change, for the change feed */
+    uint64_t factor = 0;                    /* New net salary multiplier */
+
+    if (department == NULL)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    if (raise_basis_points == 0)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    factor = department->raise_factor;
+    if (factor == 0)
+    {
+        factor = DEPARTMENT_NO_RAISE;
+    }
+    factor = (factor * (DEPARTMENT_NO_RAISE + (uint64_t)raise_basis_points) + DEPARTMENT_NO_RAISE / 2)
+             / DEPARTMENT_NO_RAISE;
+    if (factor > UINT32_MAX)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    before = *department;
+    department->raise_factor = (uint32_t)factor;
+    changeFeedDepartment(CHANGE_UPDATE, &before, department);
+    changeFeedCommit();
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Checks the fields of an employee record as addEmployeesBatch() does.
+ */
+ManageStatus_t checkEmployeeRecord(const Employee_t *employee)
+{
+    if (memchr(employee->id, '\0', MAX_ID_LENGTH) == NULL || employee->id[0] == '\0'
+        || memchr(employee->department_id, '\0', MAX_ID_LENGTH) == NULL || employee->department_id[0] == '\0'
+        || memchr(employee->name, '\0', MAX_NAME_LENGTH) == NULL || employee->name[0] == '\0'
+        || !(employee->working_performance > 0))
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Adds many employees in one pass.
+ *
+ * Every record is validated before anything is changed. The batch is sorted by ID once to
+ * find duplicates inside the batch and against the stored employees, then sorted by
+ * department ID so each department is looked up, created and counted once per batch.
+ * If any record fails, nothing is added.
+ *
+ * @param employees Array of employees to add.
+ * @param count Number of employees in the array.
+ * @param new_departments Departments to create when an employee refers to them (may be NULL).
+ * @param department_count Number of departments in new_departments.
+ * @return MANAGE_OK on success, otherwise the reason the batch was rejected.
+ */
+ManageStatus_t addEmployeesBatch(const Employee_t *employees, uint32_t count,
+                                 const Department_t *new_departments, uint32_t department_count)
+{
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
+    const Employee_t **batch = NULL;        /* Batch employees, sorted by ID and then by department */
+    Department_t **group_department = NULL; /* Stored department of each group, NULL if the batch creates it */
+    uint32_t *group_new = NULL;             /* Position in new_departments of each department to create */
+    IdIndex_t new_ids;                      /* Index from IDs to positions in new_departments */
+    uint32_t *group_size = NULL;            /* Number of batch employees in each department group */
+    uint32_t total_groups = 0;              /* Number of distinct departments referenced by the batch */
+    uint32_t departments_to_create = 0;     /* Number of departments the batch creates */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the batch */
+    uint32_t i = 0;                         /* Index for looping through the batch */
+    PERF_START(perf_start);                 /* Start time of the batch */
+
+    if (count == 0)
+    {
+        return MANAGE_OK;
+    }
+    if (employees == NULL)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+
+    /* Validate the fields of every record */
+    for (i = 0; i < count; i++)
+    {
+        if (checkEmployeeRecord(&employees[i]) != MANAGE_OK)
+        {
+            return MANAGE_ERR_INVALID_ARGUMENT;
+        }
+    }
+
+    batch = malloc(count * sizeof(*batch));
+    group_department = malloc(count * sizeof(*group_department));
+    group_new = malloc(count * sizeof(*group_new));
+    group_size = malloc(count * sizeof(*group_size));
+    idIndexInit(&new_ids, newDepartmentKey, new_departments);
+    if (batch == NULL || group_department == NULL || group_new == NULL || group_size == NULL
+        || (new_departments != NULL && idIndexReserve(&new_ids, department_count) != MANAGE_OK))
+    {
+        status = MANAGE_ERR_NO_MEMORY;
+    }
+    else
+    {
+        for (i = 0; i < count; i++)
+        {
+            batch[i] = &employees[i];
+        }
+
+        /* Sort by ID: duplicates inside the batch become neighbours */
+        qsort(batch, count, sizeof(*batch), compareEmployeeIdPointers);
+        for (i = 1; i < count && status == MANAGE_OK; i++)
+        {
+            if (strcmp(batch[i - 1]->id, batch[i]->id) == 0)
+            {
+                status = MANAGE_ERR_DUPLICATE_ID;
+            }
+        }
+
+        /* Look every ID up in the employee index to find IDs that already exist */
+        for (i = 0; i < count && status == MANAGE_OK; i++)
+        {
+            if (findEmployeeRecord(batch[i]->id) != NULL)
+            {
+                status = MANAGE_ERR_DUPLICATE_ID;
+            }
+        }
+    }
+
+    /* Index the departments to create, each ID may appear only once */
+    for (i = 0; i < department_count && new_departments != NULL && status == MANAGE_OK; i++)
+    {
+        status = idIndexInsert(&new_ids, new_departments[i].id, i);
+    }
+
+    if (status == MANAGE_OK)
+    {
+        /* Sort by department: each department is resolved once for its whole group */
+        qsort(batch, count, sizeof(*batch), compareEmployeeDepartmentPointers);
+        for (i = 0; i < count && status == MANAGE_OK; i++)
+        {
+            if (i > 0 && strcmp(batch[i - 1]->department_id, batch[i]->department_id) == 0)
+            {
+                group_size[total_groups - 1] += 1;
+            }
+            else
+            {
+                group_size[total_groups] = 1;
+                group_department[total_groups] = findDepartmentRecord(batch[i]->department_id);
+                if (group_department[total_groups] == NULL)
+                {
+                    /* Look for the department in the list of departments to create */
+                    if (idIndexFind(&new_ids, batch[i]->department_id, &group_new[total_groups]) == 0)
+                    {
+                        status = MANAGE_ERR_UNKNOWN_DEPARTMENT;
+                    }
+                    departments_to_create += 1;
+                }
+                total_groups += 1;
+            }
+        }
+    }
+
+    /* Reserve memory for the whole batch before changing anything */
+    if (status == MANAGE_OK
+        && (ensureEmployeeCapacity(store->total_employees + count) == 0
+            || ensureDepartmentCapacity(store->total_departments + departments_to_create) == 0))
+    {
+        status = MANAGE_ERR_NO_MEMORY;
+    }
+
+    if (status == MANAGE_OK)
+    {
+        /* Create the new departments and update membership counts once per department */
+        for (i = 0; i < total_groups; i++)
+        {
+            if (group_department[i] == NULL)
+            {
+                changeFeedDepartment(CHANGE_INSERT, NULL,
+                                     createDepartment(&new_departments[group_new[i]], group_size[i]));
+            }
+            else
+            {
+                group_department[i]->employee_count += group_size[i];
+            }
+        }
+
+        /* Append all employees in their original order */
+        for (i = 0; i < count; i++)
+        {
+            store->employee_handles[store->total_employees] = recordPoolAlloc(&store->employee_pool);
+            *employeeAt(store->total_employees) = employees[i];
+            idIndexInsert(employeeIndex(), employees[i].id, store->employee_handles[store->total_employees]);
+            changeFeedEmployee(CHANGE_INSERT, NULL, employeeAt(store->total_employees));
+            store->total_employees += 1;
+        }
+        countEmployeeChange();
+        changeFeedCommit();
+    }
+
+    free(batch);
+    free(group_department);
+    free(group_new);
+    free(group_size);
+    idIndexFree(&new_ids);
+    PERF_STOP(PERF_OP_ADD_EMPLOYEES_BATCH, perf_start);
+    return status;
+}
+
+
+/**
+ * @brief Makes sure that every department of a list exists.
+ *
+ * Missing departments are created without employees in list order; stored departments
+ * are left unchanged. Memory is reserved for the whole list first.
+ *
+ * @param departments Array of departments.
+ * @param count Number of departments in the array.
+ * @param created Receives the number of departments created (may be NULL).
+ * @return MANAGE_OK on success, otherwise the reason nothing was created.
+ */
+ManageStatus_t ensureDepartments(const Department_t *departments, uint32_t count, uint32_t *created)
+{
+    uint32_t total_created = 0;             /* Number of departments created */
+    uint32_t i = 0;                         /* Index for looping through the list */
+    PERF_START(perf_start);                 /* Start time of the operation */
+
+    if (created != NULL)
+    {
+        *created = 0;
+    }
+    if (count == 0)
+    {
+        return MANAGE_OK;
+    }
+    if (departments == NULL)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (memchr(departments[i].id, '\0', MAX_ID_LENGTH) == NULL || departments[i].id[0] == '\0')
+        {
+            return MANAGE_ERR_INVALID_ARGUMENT;
+        }
+    }
+    if (ensureDepartmentCapacity(active_store->total_departments + count) == 0)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+
+    /* One lookup per entry, a repeated ID is found after its first entry was created */
+    for (i = 0; i < count; i++)
+    {
+        if (findDepartmentRecord(departments[i].id) == NULL)
+        {
+            changeFeedDepartment(CHANGE_INSERT, NULL, createDepartment(&departments[i], 0));
+            total_created += 1;
+        }
+    }
+    changeFeedCommit();
+    if (created != NULL)
+    {
+        *created = total_created;
+    }
+    PERF_STOP(PERF_OP_ENSURE_DEPARTMENTS, perf_start);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Deletes many employees in one pass.
+ *
+ * The IDs are sorted once, every stored employee is marked by a binary search in that list,
+ * department counts are decremented once per department and the handle array is compacted
+ * in a single pass. If an ID is empty, repeated or unknown, nothing is deleted.
+ *
+ * @param ids Array of employee IDs to delete.
+ * @param count Number of IDs in the array.
+ * @return MANAGE_OK on success, otherwise the reason the batch was rejected.
+ */
+ManageStatus_t deleteEmployeesBatch(const int8_t *const *ids, uint32_t count)
+{
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
+    const int8_t **sorted_ids = NULL;       /* IDs to delete, sorted */
+    const Employee_t **deleted = NULL;      /* Employees to delete, sorted by department */
+    uint8_t *marked = NULL;                 /* Flag for every stored employee that must be deleted */
+    uint32_t total_marked = 0;              /* Number of stored employees that matched */
+    uint32_t group_size = 0;                /* Number of deleted employees in the current department */
+    Department_t *department = NULL;        /* The current department */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the batch */
+    uint32_t i = 0;                         /* Index for looping */
+    uint32_t j = 0;                         /* Index of the next kept employee */
+    PERF_START(perf_start);                 /* Start time of the batch */
+
+    if (count == 0)
+    {
+        return MANAGE_OK;
+    }
+    if (ids == NULL)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (ids[i] == NULL || ids[i][0] == '\0')
+        {
+            return MANAGE_ERR_INVALID_ARGUMENT;
+        }
+    }
+    if (count > store->total_employees)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+
+    sorted_ids = malloc(count * sizeof(*sorted_ids));
+    deleted = malloc(count * sizeof(*deleted));
+    marked = calloc(store->total_employees, sizeof(*marked));
+    if (sorted_ids == NULL || deleted == NULL || marked == NULL)
+    {
+        status = MANAGE_ERR_NO_MEMORY;
+    }
+    else
+    {
+        memcpy(sorted_ids, ids, count * sizeof(*sorted_ids));
+        qsort(sorted_ids, count, sizeof(*sorted_ids), compareIdPointers);
+        for (i = 1; i < count && status == MANAGE_OK; i++)
+        {
+            if (strcmp(sorted_ids[i - 1], sorted_ids[i]) == 0)
+            {
+                status = MANAGE_ERR_DUPLICATE_ID;
+            }
+        }
+    }
+
+    if (status == MANAGE_OK)
+    {
+        /* Mark every stored employee whose ID is in the batch */
+        for (i = 0; i < store->total_employees; i++)
+        {
+            const int8_t *key = employeeAt(i)->id;    /* Key for the binary search */
+
+            if (bsearch(&key, sorted_ids, count, sizeof(*sorted_ids), compareIdPointers) != NULL)
+            {
+                marked[i] = 1;
+                deleted[total_marked] = employeeAt(i);
+                total_marked += 1;
+            }
+        }
+        if (total_marked != count)
+        {
+            status = MANAGE_ERR_NOT_FOUND;
+        }
+    }
+
+    if (status == MANAGE_OK)
+    {
+        /* Update membership counts once per department */
+        qsort(deleted, count, sizeof(*deleted), compareEmployeeDepartmentPointers);
+        for (i = 0; i < count; i++)
+        {
+            group_size += 1;
+            if (i + 1 == count || strcmp(deleted[i]->department_id, deleted[i + 1]->department_id) != 0)
+            {
+                department = findDepartmentRecord(deleted[i]->department_id);
+                if (department != NULL)
+                {
+                    if (department->employee_count > group_size)
+                    {
+                        department->employee_count -= group_size;
+                    }
+                    else
+                    {
+                        department->employee_count = 0;
+                    }
+                }
+                group_size = 0;
+            }
+        }
+
+        /* Release the deleted records and compact the handle array once */
+        for (i = 0; i < store->total_employees; i++)
+        {
+            if (marked[i] == 1)
+            {
+                changeFeedEmployee(CHANGE_DELETE, employeeAt(i), NULL);
+                idIndexRemove(employeeIndex(), employeeAt(i)->id);
+                recordPoolRelease(&store->employee_pool, store->employee_handles[i]);
+            }
+            else
+            {
+                store->employee_handles[j] = store->employee_handles[i];
+                j++;
+            }
+        }
+        store->total_employees = j;
+        countEmployeeChange();
+        changeFeedCommit();
+    }
+
+    free(sorted_ids);
+    free(deleted);
+    free(marked);
+    PERF_STOP(PERF_OP_DELETE_EMPLOYEES_BATCH, perf_start);
+    return status;
+}
+
+
+/**
+ * @brief Deletes many departments in one pass.
+ *
+ * All IDs must exist, be unique and refer to departments without employees,
+ * otherwise nothing is deleted. The department handle array is compacted once.
+ *
+ * @param ids Array of department IDs to delete.
+ * @param count Number of IDs in the array.
+ * @return MANAGE_OK on success, otherwise the reason the batch was rejected.
+ */
+ManageStatus_t deleteDepartmentsBatch(const int8_t *const *ids, uint32_t count)
+{
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
+    const int8_t **sorted_ids = NULL;       /* IDs to delete, sorted */
+    uint8_t *marked = NULL;                 /* Flag for every stored department that must be deleted */
+    uint32_t total_marked = 0;              /* Number of stored departments that matched */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the batch */
+    uint32_t i = 0;                         /* Index for looping */
+    uint32_t j = 0;                         /* Index of the next kept department */
+    PERF_START(perf_start);                 /* Start time of the batch */
+
+    if (count == 0)
+    {
+        return MANAGE_OK;
+    }
+    if (ids == NULL)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (ids[i] == NULL || ids[i][0] == '\0')
+        {
+            return MANAGE_ERR_INVALID_ARGUMENT;
+        }
+    }
+    if (count > store->total_departments)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+
+    sorted_ids = malloc(count * sizeof(*sorted_ids));
+    marked = calloc(store->total_departments, sizeof(*marked));
+    if (sorted_ids == NULL || marked == NULL)
+    {
+        status = MANAGE_ERR_NO_MEMORY;
+    }
+    else
+    {
+        memcpy(sorted_ids, ids, count * sizeof(*sorted_ids));
+        qsort(sorted_ids, count, sizeof(*sorted_ids), compareIdPointers);
+        for (i = 1; i < count && status == MANAGE_OK; i++)
+        {
+            if (strcmp(sorted_ids[i - 1], sorted_ids[i]) == 0)
+            {
+                status = MANAGE_ERR_DUPLICATE_ID;
+            }
+        }
+    }
+
+    if (status == MANAGE_OK)
+    {
+        /* Mark every stored department whose ID is in the batch */
+        for (i = 0; i < store->total_departments && status == MANAGE_OK; i++)
+        {
+            const int8_t *key = departmentAt(i)->id;  /* Key for the binary search */
+
+            if (bsearch(&key, sorted_ids, count, sizeof(*sorted_ids), compareIdPointers) != NULL)
+            {
+                if (departmentAt(i)->employee_count > 0)
+                {
+                    status = MANAGE_ERR_DEPARTMENT_NOT_EMPTY;
+                }
+                marked[i] = 1;
+                total_marked += 1;
+            }
+        }
+        if (status == MANAGE_OK && total_marked != count)
+        {
+            status = MANAGE_ERR_NOT_FOUND;
+        }
+    }
+
+    if (status == MANAGE_OK)
+    {
+        /* Release the deleted records and compact the handle array once */
+        for (i = 0; i < store->total_departments; i++)
+        {
+            if (marked[i] == 1)
+            {
+                /* Remove the ID from the index before the record is given back to the pool */
+                changeFeedDepartment(CHANGE_DELETE, departmentAt(i), NULL);
+                idIndexRemove(departmentIndex(), departmentAt(i)->id);
+                recordPoolRelease(&store->department_pool, store->department_handles[i]);
+            }
+            else
+            {
+                store->department_handles[j] = store->department_handles[i];
+                j++;
+            }
+        }
+        store->total_departments = j;
+        changeFeedCommit();
+    }
+
+    free(sorted_ids);
+    free(marked);
+    PERF_STOP(PERF_OP_DELETE_DEPARTMENTS_BATCH, perf_start);
+    return status;
+}
+
+
+/**
+ * @brief Changes some fields of many stored employees in place.
+ *
+ * The updates are sorted by ID once and each distinct ID is looked up in the employee index,
+ * so the batch does not walk the store. The new record of each employee
+ * is built and checked after every update of its ID, as if the updates were applied one by
+ * one; records are only written once the whole batch is accepted.
+ *
+ * @param updates Array of updates.
+ * @param count Number of updates in the array.
+ * @return MANAGE_OK on success, otherwise the reason the batch was rejected.
+ */
+ManageStatus_t updateEmployeesBatch(const EmployeeUpdate_t *updates, uint32_t count)
+{
+    const EmployeeUpdate_t **sorted = NULL; /* Updates sorted by ID, then by batch order */
+    Employee_t **targets = NULL;            /* Stored record of the first update of each ID */
+    Employee_t *records = NULL;             /* New record of the first update of each ID */
+    Department_t *department = NULL;        /* Department an employee leaves or joins */
+    uint32_t first = 0;                     /* First update of the current ID */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the batch */
+    uint32_t i = 0;                         /* Index for looping */
+    PERF_START(perf_start);                 /* Start time of the batch */
+
+    if (count == 0)
+    {
+        return MANAGE_OK;
+    }
+    if (updates == NULL)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    for (i = 0; i < count; i++)
+    {
+        if ((updates[i].fields & ~(uint32_t)EMPLOYEE_FIELD_ALL) != 0
+            || memchr(updates[i].employee.id, '\0', MAX_ID_LENGTH) == NULL || updates[i].employee.id[0] == '\0')
+        {
+            return MANAGE_ERR_INVALID_ARGUMENT;
+        }
+    }
+
+    sorted = malloc(count * sizeof(*sorted));
+    targets = calloc(count, sizeof(*targets));
+    records = malloc(count * sizeof(*records));
+    if (sorted == NULL || targets == NULL || records == NULL)
+    {
+        status = MANAGE_ERR_NO_MEMORY;
+    }
+    else
+    {
+        for (i = 0; i < count; i++)
+        {
+            sorted[i] = &updates[i];
+        }
+        qsort(sorted, count, sizeof(*sorted), compareUpdatePointers);
+
+        /* Look up the stored record of every distinct ID in the employee index */
+        for (i = 0; i < count; i++)
+        {
+            if (i == 0 || strcmp(sorted[i - 1]->employee.id, sorted[i]->employee.id) != 0)
+            {
+                targets[i] = findEmployeeRecord(sorted[i]->employee.id);
+            }
+        }
+    }
+
+    /* Build and check the new records, update by update */
+    for (i = 0; i < count && status == MANAGE_OK; i++)
+    {
+        if (i == 0 || strcmp(sorted[i - 1]->employee.id, sorted[i]->employee.id) != 0)
+        {
+            first = i;
+            if (targets[first] == NULL)
+            {
+                status = MANAGE_ERR_NOT_FOUND;
+                continue;
+            }
+            records[first] = *targets[first];
+        }
+        applyEmployeeUpdate(&records[first], sorted[i]);
+        if (checkEmployeeRecord(&records[first]) != MANAGE_OK)
+        {
+            status = MANAGE_ERR_INVALID_ARGUMENT;
+        }
+        else if ((sorted[i]->fields & EMPLOYEE_FIELD_DEPARTMENT) != 0
+                 && findDepartmentRecord(records[first].department_id) == NULL)
+        {
+            status = MANAGE_ERR_UNKNOWN_DEPARTMENT;
+        }
+    }
+
+    if (status == MANAGE_OK)
+    {
+        /* Write the records; only department counts and name indexes depend on the changes */
+        for (i = 0; i < count; i++)
+        {
+            if (targets[i] == NULL)
+            {
+                continue;
+            }
+            if (strcmp(targets[i]->department_id, records[i].department_id) != 0)
+            {
+                department = findDepartmentRecord(targets[i]->department_id);
+                if (department != NULL && department->employee_count > 0)
+                {
+                    department->employee_count -= 1;
+                }
+                findDepartmentRecord(records[i].department_id)->employee_count += 1;
+            }
+            if (strcmp(targets[i]->name, records[i].name) != 0)
+            {
+                logEmployeeRename(targets[i], targets[i]->name);
+            }
+            changeFeedEmployee(CHANGE_UPDATE, targets[i], &records[i]);
+            *targets[i] = records[i];
+        }
+        changeFeedCommit();
+    }
+
+    free(sorted);
+    free(targets);
+    free(records);
+    PERF_STOP(PERF_OP_UPDATE_EMPLOYEES_BATCH, perf_start);
+    return status;
+}
+
+
+/**
+ * @brief Sets the working days and late coming days of a stored employee.
+ *
+ * The change is recorded in the change feed but not committed, so that a caller setting many
+ * employees writes them as one operation: it must call changeFeedCommit() once it is done.
+ *
+ * @param index Store position of the employee.
+ * @param working_days Number of days the employee worked.
+ * @param late_coming_days Number of days the employee came late to work.
+ * @return MANAGE_OK, MANAGE_ERR_NOT_FOUND if the position is out of range, or
+ *         MANAGE_ERR_INVALID_ARGUMENT if a count does not fit in EmployeeDays_t.
+ */
+ManageStatus_t setEmployeeAttendance(uint32_t index, uint32_t working_days, uint32_t late_coming_days)
+{
+    Employee_t *employee = NULL;            /* The employee to update */
+    Employee_t before;                      /* The employee before the change, for the change feed */
+
+    if (index >= active_store->total_employees)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    if (working_days > EMPLOYEE_MAX_DAYS || late_coming_days > EMPLOYEE_MAX_DAYS)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    employee = employeeAt(index);
+    before = *employee;
+    employee->working_days = (EmployeeDays_t)working_days;
+    employee->late_coming_days = (EmployeeDays_t)late_coming_days;
+    changeFeedEmployee(CHANGE_UPDATE, &before, employee);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Returns the number of employees currently stored.
+ */
+uint32_t getTotalEmployees()
+{
+    return active_store->total_employees;
+}
+
+
+/**
+ * @brief Returns the number of times employees were added to or deleted from the store.
+ */
+uint64_t getEmployeeChangeCount()
+{
+    return active_store->employee_changes;
+}
+
+
+/**
+ * @brief Returns the number of employees renamed since getEmployeeChangeCount() last changed.
+ */
+uint32_t getEmployeeRenameCount()
+{
+    return active_store->rename_count;
+}
+
+
+/**
+ * @brief Returns a rename kept since getEmployeeChangeCount() last changed, or NULL if out of range.
+ */
+const EmployeeRename_t* getEmployeeRename(uint32_t index)
+{
+    return (index < active_store->rename_count) ? &active_store->renames[index] : NULL;
+}
+
+
+/**
+ * @brief Returns the employee stored at the given position, or NULL if out of range.
+ */
+const Employee_t* getEmployeeAt(uint32_t index)
+{
+    return (index < active_store->total_employees) ? employeeAt(index) : NULL;
+}
+
+
+/**
+ * @brief Returns the number of departments currently stored.
+ */
+uint32_t getTotalDepartments()
+{
+    return active_store->total_departments;
+}
+
+
+/**
+ * @brief Returns the department stored at the given position, or NULL if out of range.
+ */
+const Department_t* getDepartmentAt(uint32_t index)
+{
+    return (index < active_store->total_departments) ? departmentAt(index) : NULL;
+}
+
+
+/**
+ * @brief Finds an employee by its ID.
+ *
+ * @param employee_id The employee ID to look for.
+ * @return Pointer to the employee, or NULL if no employee has this ID.
+ */
+const Employee_t* findEmployee(const int8_t *employee_id)
+{
+    return findEmployeeRecord(employee_id);
+}
+
+
+/**
+ * @brief Finds a department by its ID.
+ *
+ * @param department_id The department ID to look for.
+ * @return Pointer to the department, or NULL if no department has this ID.
+ */
+const Department_t* findDepartment(const int8_t *department_id)
+{
+    return findDepartmentRecord(department_id);
+}
+
+
+/**
+ * @brief Reports the memory used by the store.
+ */
+void getStoreMemoryUsage(StoreMemoryUsage_t *usage)
+{
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
+
+    recordPoolUsage(&store->employee_pool, &usage->employees);
+    recordPoolUsage(&store->department_pool, &usage->departments);
+    usage->employee_handle_bytes = (uint64_t)store->employees_capacity * sizeof(RecordHandle_t);
+    usage->department_handle_bytes = (uint64_t)store->departments_capacity * sizeof(RecordHandle_t);
+    usage->employee_index_bytes = idIndexMemoryUsage(&store->employee_ids);
+    usage->index_bytes = idIndexMemoryUsage(&store->department_ids);
+}
+
+
+/**
+ * @brief Makes the empty store use employee and department records that are already in memory.
+ *
+ * The records are used in place: nothing is copied and the ID indexes are only filled on the
+ * first lookup, so the time taken does not depend on the number of employees.
+ */
+ManageStatus_t adoptStoreRecords(uint8_t *employee_records, uint32_t employee_count,
+                                 uint8_t *department_records, uint32_t department_count)
+{
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
+
+    if (store->total_employees != 0 || store->total_departments != 0 || store->employee_pool.slab_count != 0
+        || store->department_pool.slab_count != 0)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    if (ensureEmployeeCapacity(0) == 0 || ensureDepartmentCapacity(0) == 0
+        || growHandles(&store->employee_handles, &store->employees_capacity, INITIAL_EMPLOYEES, employee_count) == 0
+        || growHandles(&store->department_handles, &store->departments_capacity, INITIAL_DEPARTMENTS, department_count) == 0
+        || idIndexReserve(&store->employee_ids, employee_count) != MANAGE_OK
+        || idIndexReserve(&store->department_ids, department_count) != MANAGE_OK)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    if (recordPoolAdopt(&store->department_pool, department_records, department_count) == 0)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    if (recordPoolAdopt(&store->employee_pool, employee_records, employee_count) == 0)
+    {
+        recordPoolFree(&store->department_pool);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+
+    /* Adopted records get handles 0, 1, 2, ... in store order */
+    for (store->total_employees = 0; store->total_employees < employee_count; store->total_employees++)
+    {
+        store->employee_handles[store->total_employees] = store->total_employees;
+    }
+    for (store->total_departments = 0; store->total_departments < department_count; store->total_departments++)
+    {
+        store->department_handles[store->total_departments] = store->total_departments;
+    }
+    __atomic_store_n(&store->employee_ids_stale, (employee_count > 0) ? 1u : 0u, __ATOMIC_RELEASE);
+    __atomic_store_n(&store->department_ids_stale, (department_count > 0) ? 1u : 0u, __ATOMIC_RELEASE);
+    countEmployeeChange();
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Copies the records given to adoptStoreRecords() into memory owned by the store.
+ */
+ManageStatus_t detachStoreRecords()
+{
+    if (recordPoolDetach(&active_store->employee_pool) == 0 || recordPoolDetach(&active_store->department_pool) == 0)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    /* The records moved, so indexes holding pointers to them must be built again */
+    countEmployeeChange();
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Creates an empty store, to be selected with selectEmployeeStore().
+ *
+ * The pools and the ID indexes are set up on the first insert, as for the default store.
+ */
+EmployeeStore_t* createEmployeeStore()
+{
+    EmployeeStore_t *store = calloc(1, sizeof(*store));    /* The new store */
+
+    if (store == NULL)
+    {
+        return NULL;
+    }
+    if (pthread_mutex_init(&store->employee_ids_lock, NULL) != 0)
+    {
+        free(store);
+        return NULL;
+    }
+    if (pthread_mutex_init(&store->department_ids_lock, NULL) != 0)
+    {
+        pthread_mutex_destroy(&store->employee_ids_lock);
+        free(store);
+        return NULL;
+    }
+    return store;
+}
+
+
+/**
+ * @brief Frees a store created by createEmployeeStore() and all its records.
+ */
+void destroyEmployeeStore(EmployeeStore_t *store)
+{
+    if (store == NULL || store == &default_store)
+    {
+        return;
+    }
+    recordPoolFree(&store->employee_pool);
+    recordPoolFree(&store->department_pool);
+    idIndexFree(&store->employee_ids);
+    idIndexFree(&store->department_ids);
+    free(store->employee_handles);
+    free(store->department_handles);
+    free(store->renames);
+    pthread_mutex_destroy(&store->employee_ids_lock);
+    pthread_mutex_destroy(&store->department_ids_lock);
+    free(store);
+}
+
+
+/**
+ * @brief Makes the functions of this file work on a store in the calling thread.
+ *
+ * @param store The store, or NULL for the default store.
+ * @return The store selected before.
+ */
+EmployeeStore_t* selectEmployeeStore(EmployeeStore_t *store)
+{
+    EmployeeStore_t *previous = active_store;   /* Store selected before */
+
+    active_store = (store != NULL) ? store : &default_store;
+    return previous;
+}
+
+
+/**
+ * @brief Returns the store selected by the calling thread.
+ */
+EmployeeStore_t* getActiveEmployeeStore()
+{
+    return active_store;
+}
+
+
+/**
+ * @brief Returns the default store, which holds the data of the program.
+ */
+EmployeeStore_t* getDefaultEmployeeStore()
+{
+    return &default_store;
+}
+
+
+/**
+ * @brief Calculates the salary of an employee and keeps every intermediate value.
+ *
+ * The employee's department is looked up among the stored departments.
+ *
+ * @param employee The employee for whom the salary is to be calculated.
+ * @param breakdown Receives the intermediate values and the actual salary.
+ */
+void calculateSalaryBreakdown(const Employee_t *employee, SalaryBreakdown_t *breakdown)
+{
+    calculateSalaryForDepartment(employee, findDepartmentRecord(employee->department_id), breakdown);
+}
+
+
+/**
+ * @brief Calculates the salary of an employee for a given department.
+ *
+ * This function does not read the stored tables, so it can be used on records that are not
+ * stored (imports, generated data, other processes' tables).
+ *
+ * @param employee The employee for whom the salary is to be calculated.
+ * @param department The employee's department, or NULL if it has none.
+ * @param breakdown Receives the intermediate values and the actual salary.
+ */
+void calculateSalaryForDepartment(const Employee_t *employee, const Department_t *department,
+                                  SalaryBreakdown_t *breakdown)
+{
+    uint64_t bonus_department = 0;          /* Bonus allocated to the department */
+    uint64_t late_coming_penalty = 0;       /* Penalty for late coming */
+    uint64_t income_without_bonus = 0;      /* Income without bonus */
+    uint64_t total_income = 0;              /* Total income */
+    uint64_t totalIncome_without_tax = 0;   /* Total income without tax */
+    uint64_t tax = 0;                       /* Tax */
+    uint64_t department_raise = 0;          /* Amount added by the department's raise */
+    uint64_t actual_salary = 0;             /* Actual salary */
+    PERF_START(perf_start);                 /* Start time of the calculation */
+
+    /* Find department's bonus */
+    if (department != NULL)
+    {
+        bonus_department = department->bonus_salary;
+    }
+
+    /* Calculate late_coming_penalty */
+    /* Check if the number of late coming days is less than or equal to 3 */
+    if (employee->late_coming_days <= 3)
+    {
+        late_coming_penalty = employee->late_coming_days * 10000;
+    }
+    else
+    {
+        late_coming_penalty = employee->late_coming_days * 20000;
+    }
+
+    /* Calculate income_without_bonus */
+    income_without_bonus = ((uint64_t)employee->salary_base * employee->working_days) * employee->working_performance;
+    /* Calculate total_income */
+    total_income = income_without_bonus + employee->bonus + bonus_department - late_coming_penalty;
+    /* Calculate totalIncome_without_tax */
+    totalIncome_without_tax = total_income * 0.895;
+
+    /* Calculate tax */
+    /* Check if totalIncome_without_tax is greater than 0 and less than or equal to 11000000 */
+    if (totalIncome_without_tax > 0 && totalIncome_without_tax <= TAX_FREE_LIMIT)
+    {
+        tax = 0;
+    }
+    /* Check if totalIncome_without_tax is greater than 11000000 and less than or equal to 16000000 */
+    else if (totalIncome_without_tax > TAX_FREE_LIMIT && totalIncome_without_tax <= TAX_LOW_RATE_LIMIT)
+    {
+        tax = totalIncome_without_tax * 0.05;
+    }
+    else
+    {
+        tax = totalIncome_without_tax * 0.1;
+    }
+
+    /* Calculate actual_salary */
+    actual_salary = totalIncome_without_tax - tax;
+
+    /* Apply the department's raise to the net salary */
+    if (department != NULL && department->raise_factor != 0 && department->raise_factor != DEPARTMENT_NO_RAISE)
+    {
+        department_raise = (actual_salary * department->raise_factor) / DEPARTMENT_NO_RAISE - actual_salary;
+        actual_salary += department_raise;
+    }
+
+    breakdown->department_bonus = bonus_department;
+    breakdown->late_coming_penalty = late_coming_penalty;
+    breakdown->income_without_bonus = income_without_bonus;
+    breakdown->total_income = total_income;
+    breakdown->insurance = total_income - totalIncome_without_tax;
+    breakdown->totalIncome_without_tax = totalIncome_without_tax;
+    breakdown->tax = tax;
+    breakdown->department_raise = department_raise;
+    breakdown->actual_salary = actual_salary;
+
+    PERF_STOP(PERF_OP_CALCULATE_SALARY, perf_start);
+}
+
+
+/**
+ * @brief Returns the tax bracket of an income after insurance.
+ *
+ * The brackets are the ones of calculateSalaryForDepartment(); an income of 0 is untaxed.
+ */
+uint32_t taxBracket(uint64_t income_after_insurance)
+{
+    if (income_after_insurance <= TAX_FREE_LIMIT)
+    {
+        return 0;
+    }
+    else if (income_after_insurance <= TAX_LOW_RATE_LIMIT)
+    {
+        return 1;
+    }
+    return 2;
+}
+
+/**
+ * @brief Makes sure the store can hold at least the required number of employees.
+ *
+ * The handle array capacity is doubled until it is large enough, so appending one handle at
+ * a time stays cheap on average, and pool and ID index memory is reserved for the new records,
+ * so recordPoolAlloc() and idIndexInsert() cannot fail afterwards.
+ *
+ * @param required Number of employees the store must be able to hold.
+ * @return 1 if the store is large enough, 0 if memory could not be allocated.
+ */
+static uint32_t ensureEmployeeCapacity(uint32_t required)
+{
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
+
+    if (store->employee_pool.record_size == 0)
+    {
+        recordPoolInit(&store->employee_pool, sizeof(Employee_t));
+        idIndexInit(&store->employee_ids, employeeKey, store);
+    }
+    if (growHandles(&store->employee_handles, &store->employees_capacity, INITIAL_EMPLOYEES, required) == 0)
+    {
+        return 0;
+    }
+    if (idIndexReserve(employeeIndex(), required) != MANAGE_OK)
+    {
+        return 0;
+    }
+    return (required <= store->total_employees) ? 1 : recordPoolReserve(&store->employee_pool, required - store->total_employees);
+}
+
+
+/**
+ * @brief Makes sure the store can hold at least the required number of departments.
+ *
+ * The handle array, the pool and the ID index are all grown, so createDepartment() cannot
+ * fail afterwards.
+ *
+ * @param required Number of departments the store must be able to hold.
+ * @return 1 if the store is large enough, 0 if memory could not be allocated.
+ */
+static uint32_t ensureDepartmentCapacity(uint32_t required)
+{
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
+
+    if (store->department_pool.record_size == 0)
+    {
+        recordPoolInit(&store->department_pool, sizeof(Department_t));
+        idIndexInit(&store->department_ids, departmentKey, store);
+    }
+    if (growHandles(&store->department_handles, &store->departments_capacity, INITIAL_DEPARTMENTS, required) == 0)
+    {
+        return 0;
+    }
+    if (idIndexReserve(departmentIndex(), required) != MANAGE_OK)
+    {
+        return 0;
+    }
+    return (required <= store->total_departments) ? 1 : recordPoolReserve(&store->department_pool, required - store->total_departments);
+}
+
+
+/**
+ * @brief Grows a handle array until it can hold the required number of handles.
+ *
+ * @param handles The array, reallocated if it grows.
+ * @param capacity Number of handles the array can hold, updated if it grows.
+ * @param initial Capacity of the array when it is first allocated.
+ * @param required Number of handles the array must be able to hold.
+ * @return 1 if the array is large enough, 0 if memory could not be allocated.
+ */
+static uint32_t growHandles(RecordHandle_t **handles, uint32_t *capacity, uint32_t initial, uint32_t required)
+{
+    uint32_t new_capacity = (*capacity == 0) ? initial : *capacity;    /* Grown capacity */
+    RecordHandle_t *grown = NULL;           /* Reallocated array */
+
+    if (required <= *capacity)
+    {
+        return 1;
+    }
+    while (new_capacity < required)
+    {
+        new_capacity *= 2;
+    }
+    grown = realloc(*handles, (size_t)new_capacity * sizeof(*grown));
+    if (grown == NULL)
+    {
+        return 0;
+    }
+    *handles = grown;
+    *capacity = new_capacity;
+    return 1;
+}
+
+
+/**
+ * @brief Returns the employee ID index, inserting the adopted employees first if needed.
+ *
+ * Built on first use after adoptStoreRecords(), under a lock, as departmentIndex() is.
+ */
+static IdIndex_t* employeeIndex()
+{
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
+    uint32_t i = 0;                         /* Index for looping through employees */
 
+    if (__atomic_load_n(&store->employee_ids_stale, __ATOMIC_ACQUIRE) != 0)
+    {
+        pthread_mutex_lock(&store->employee_ids_lock);
+        if (store->employee_ids_stale != 0)
+        {
+            for (i = 0; i < store->total_employees; i++)
+            {
+                idIndexInsert(&store->employee_ids, employeeAt(i)->id, store->employee_handles[i]);
+            }
+            __atomic_store_n(&store->employee_ids_stale, 0, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&store->employee_ids_lock);
+    }
+    return &store->employee_ids;
+}
+
+
+/**
+ * @brief Returns the department ID index, inserting the adopted departments first if needed.
+ *
+ * After adoptStoreRecords() the index is empty but already sized, so the first lookup only
+ * hashes the departments and cannot fail. Lookups may come from several threads (see
+ * simulatePayroll()), so the index is built under a lock and published with release order.
+ */
+static IdIndex_t* departmentIndex()
+{
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
+    uint32_t i = 0;                         /* Index for looping through departments */
+
+    if (__atomic_load_n(&store->department_ids_stale, __ATOMIC_ACQUIRE) != 0)
+    {
+        pthread_mutex_lock(&store->department_ids_lock);
+        if (store->department_ids_stale != 0)
+        {
+            for (i = 0; i < store->total_departments; i++)
+            {
+                idIndexInsert(&store->department_ids, departmentAt(i)->id, store->department_handles[i]);
+            }
+            __atomic_store_n(&store->department_ids_stale, 0, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&store->department_ids_lock);
+    }
+    return &store->department_ids;
+}
+
+
+/**
+ * @brief Records that employees of the active store were added or deleted.
+ *
+ * The store takes the next value of a counter shared by all stores, so indexes built from
+ * one store never look current for another one. Indexes are then built again, so the
+ * renames kept for them are dropped.
+ */
+static void countEmployeeChange()
+{
+    active_store->employee_changes = __atomic_add_fetch(&store_change_clock, 1, __ATOMIC_RELAXED);
+    active_store->rename_count = 0;
+}
+
+
+/**
+ * @brief Keeps a rename of an employee of the active store for the indexes built from it.
+ *
+ * Once EMPLOYEE_RENAME_LOG_LENGTH renames are kept, or if the log cannot be allocated, the
+ * rename is counted as a change so that the indexes are built again instead.
+ *
+ * @param employee The stored employee, not renamed yet.
+ * @param old_name The name of the employee before the rename.
+ */
+static void logEmployeeRename(const Employee_t *employee, const int8_t *old_name)
+{
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
+
+    if (store->renames == NULL)
+    {
+        store->renames = malloc(EMPLOYEE_RENAME_LOG_LENGTH * sizeof(*store->renames));
+    }
+    if (store->renames == NULL || store->rename_count == EMPLOYEE_RENAME_LOG_LENGTH)
+    {
+        countEmployeeChange();
+        return;
+    }
+    store->renames[store->rename_count].employee = employee;
+    memcpy(store->renames[store->rename_count].old_name, old_name, MAX_NAME_LENGTH);
+    store->rename_count += 1;
+}
+
+
+/**
+ * @brief Returns the employee stored at the given position, the position must be valid.
+ */
+static Employee_t* employeeAt(uint32_t index)
+{
+    return recordPoolGet(&active_store->employee_pool, active_store->employee_handles[index]);
+}
+
+
+/**
+ * @brief Returns the department stored at the given position, the position must be valid.
+ */
+static Department_t* departmentAt(uint32_t index)
+{
+    return recordPoolGet(&active_store->department_pool, active_store->department_handles[index]);
+}
+
+
+/**
+ * @brief Finds an employee by its ID in constant time.
+ *
+ * @param employee_id The employee ID to look for.
+ * @return Pointer to the employee, or NULL if no employee has this ID.
+ */
+static Employee_t* findEmployeeRecord(const int8_t *employee_id)
+{
+    RecordHandle_t handle = RECORD_POOL_INVALID_HANDLE;    /* Handle of the employee */
+
+    if (idIndexFind(employeeIndex(), employee_id, &handle) == 0)
+    {
+        return NULL;
+    }
+    return recordPoolGet(&active_store->employee_pool, handle);
+}
+
+
+/**
+ * @brief Finds a department by its ID in constant time.
+ *
+ * @param department_id The department ID to look for.
+ * @return Pointer to the department, or NULL if no department has this ID.
+ */
+static Department_t* findDepartmentRecord(const int8_t *department_id)
+{
+    RecordHandle_t handle = RECORD_POOL_INVALID_HANDLE;    /* Handle of the department */
+
+    if (idIndexFind(departmentIndex(), department_id, &handle) == 0)
+    {
+        return NULL;
+    }
+    return recordPoolGet(&active_store->department_pool, handle);
+}
+
+
+/**
+ * @brief Appends a department to the store and to the ID index.
+ *
+ * The caller checks that the ID is not stored yet and reserves room with
+ * ensureDepartmentCapacity() first.
+ *
+ * @param department The department to copy.
+ * @param employee_count Number of employees the department starts with.
+ * @return Pointer to the stored department.
+ */
+static Department_t* createDepartment(const Department_t *department, uint32_t employee_count)
+{
+    EmployeeStore_t *store = active_store;  /* Store of the calling thread */
+    RecordHandle_t handle = recordPoolAlloc(&store->department_pool);    /* Handle of the new record */
+    Department_t *created = recordPoolGet(&store->department_pool, handle);   /* The new record */
+
+    *created = *department;
+    created->employee_count = employee_count;
+    if (created->raise_factor == 0)
+    {
+        created->raise_factor = DEPARTMENT_NO_RAISE;
+    }
+    store->department_handles[store->total_departments] = handle;
+    store->total_departments += 1;
+    idIndexInsert(departmentIndex(), created->id, handle);
+    return created;
+}
+
+
+/**
+ * @brief Returns the ID of a stored employee for the employee index; context is the store.
+ */
+static const int8_t* employeeKey(uint32_t value, const void *context)
+{
+    return ((const Employee_t*)recordPoolGet(&((const EmployeeStore_t*)context)->employee_pool, value))->id;
+}
+
+
+/**
+ * @brief Returns the ID of a stored department for the department index; context is the store.
+ */
+static const int8_t* departmentKey(uint32_t value, const void *context)
+{
+    return ((const Department_t*)recordPoolGet(&((const EmployeeStore_t*)context)->department_pool, value))->id;
+}
+
+
+/**
+ * @brief Returns the ID of an entry of a department list for a temporary index.
+ */
+static const int8_t* newDepartmentKey(uint32_t value, const void *context)
+{
+    return ((const Department_t*)context)[value].id;
+}
+
+
+/**
+ * @brief qsort()/bsearch() comparator for an array of ID string pointers.
+ */
+static int compareIdPointers(const void *first, const void *second)
+{
+    return strcmp(*(const int8_t *const *)first, *(const int8_t *const *)second);
+}
+
+
+/**
+ * @brief qsort() comparator for an array of employee pointers, ordered by employee ID.
+ */
+static int compareEmployeeIdPointers(const void *first, const void *second)
+{
+    return strcmp((*(const Employee_t *const *)first)->id, (*(const Employee_t *const *)second)->id);
+}
+
+
+/**
+ * @brief qsort() comparator for an array of employee pointers, ordered by department ID.
+ */
+static int compareEmployeeDepartmentPointers(const void *first, const void *second)
+{
+    return strcmp((*(const Employee_t *const *)first)->department_id,
+                  (*(const Employee_t *const *)second)->department_id);
+}
+
+
+/**
+ * @brief qsort() comparator for an array of update pointers, ordered by employee ID, then by
+ *        position in the batch.
+ */
+static int compareUpdatePointers(const void *first, const void *second)
+{
+    const EmployeeUpdate_t *left = *(const EmployeeUpdate_t *const *)first;     /* First update */
+    const EmployeeUpdate_t *right = *(const EmployeeUpdate_t *const *)second;   /* Second update */
+    int order = strcmp(left->employee.id, right->employee.id);                 /* Order of the IDs */
+
+    if (order != 0)
+    {
+        return order;
+    }
+    return (left < right) ? -1 : (left > right);
+}
+
+
+/**
+ * @brief Copies the fields chosen by an update into an employee record.
+ */
+static void applyEmployeeUpdate(Employee_t *employee, const EmployeeUpdate_t *update)
+{
+    if ((update->fields & EMPLOYEE_FIELD_NAME) != 0)
+    {
+        memcpy(employee->name, update->employee.name, sizeof(employee->name));
+    }
+    if ((update->fields & EMPLOYEE_FIELD_DEPARTMENT) != 0)
+    {
+        memcpy(employee->department_id, update->employee.department_id, sizeof(employee->department_id));
+    }
+    if ((update->fields & EMPLOYEE_FIELD_SALARY_BASE) != 0)
+    {
+        employee->salary_base = update->employee.salary_base;
+    }
+    if ((update->fields & EMPLOYEE_FIELD_WORKING_DAYS) != 0)
+    {
+        employee->working_days = update->employee.working_days;
+    }
+    if ((update->fields & EMPLOYEE_FIELD_WORKING_PERFORMANCE) != 0)
+    {
+        employee->working_performance = update->employee.working_performance;
+    }
+    if ((update->fields & EMPLOYEE_FIELD_BONUS) != 0)
+    {
+        employee->bonus = update->employee.bonus;
+    }
+    if ((update->fields & EMPLOYEE_FIELD_LATE_COMING_DAYS) != 0)
+    {
+        employee->late_coming_days = update->employee.late_coming_days;
+    }
+}
+
+
+/**
+ * @brief Shows the current value of a field and reads its new value.
+ *
+ * @param label Name of the field.
+ * @param current Current value, shown in brackets.
+ * @param buffer Receives the line entered, without its newline.
+ * @param size Size of buffer.
+ * @return PARSE_OK if a value was entered, PARSE_EMPTY if the line is blank.
+ */
+static ParseStatus_t promptFieldChange(const char *label, const int8_t *current, int8_t *buffer, uint32_t size)
+{
+    printf("%s [%s]: ", label, current);
+    fflush(stdin);
+    if (fgets(buffer, size, stdin) == NULL)
+    {
+        buffer[0] = '\0';
+    }
+    buffer[strcspn(buffer, "\r\n")] = '\0';
+    return (buffer[strspn(buffer, " \t")] == '\0') ? PARSE_EMPTY : PARSE_OK;
+}
+
+
+/**
+ * @brief Reads the new value of a whole number field until it is valid or left blank.
+ *
+ * @return 1 if a new value was entered into value, 0 if the field is kept.
+ */
+static uint32_t promptUnsignedChange(const char *label, uint64_t current, uint64_t max_value, uint64_t *value)
+{
+    int8_t buffer[100];                     /* Buffer to store input temporarily */
+    ParseStatus_t status = PARSE_EMPTY;     /* Result of parsing the input */
+
+    do
+    {
+        status = promptFieldChange(label, formatNumberWithCommas(current), buffer, sizeof(buffer));
+        if (status == PARSE_EMPTY)
+        {
+            return 0;
+        }
+        status = parseUnsignedField(buffer, (uint32_t)strlen(buffer), max_value, value);
+        if (status == PARSE_INVALID)
+        {
+            printf("\nPlease enter a whole number (0 or more) !!!\n");
+        }
+        else if (status == PARSE_OUT_OF_RANGE)
+        {
+            printf("\nPlease enter a number not more than %s !!!\n", formatNumberWithCommas(max_value));
+        }
+    } while (status != PARSE_OK);
+    return 1;
+}
+
+
+/**
+ * @brief Reads the new working performance until it is a number more than 0 or left blank.
+ *
+ * @return 1 if a new value was entered into value, 0 if the field is kept.
+ */
+static uint32_t promptPerformanceChange(float current, float *value)
+{
+    int8_t buffer[100];                     /* Buffer to store input temporarily */
+    int8_t shown[32];                       /* Current value as text */
+    ParseStatus_t status = PARSE_EMPTY;     /* Result of parsing the input */
+
+    snprintf((char *)shown, sizeof(shown), "%.1f", current);
+    do
+    {
+        status = promptFieldChange("Working performance", shown, buffer, sizeof(buffer));
+        if (status == PARSE_EMPTY)
+        {
+            return 0;
+        }
+        status = parseDecimalField(buffer, (uint32_t)strlen(buffer), value);
+        if (status != PARSE_OK || !(*value > 0))
+        {
+            printf("You must enter a number that more than 0 !!!\n");
+            status = PARSE_INVALID;
+        }
+    } while (status != PARSE_OK);
+    return 1;
+}
+
+
+/**
+ * @brief Copies a name typed by the user into a name field.
+ *
+ * Names longer than the field are cut before the last UTF-8 character that does not fit, so
+ * the field never ends in the middle of a character.
+ *
+ * @param name The name field, MAX_NAME_LENGTH bytes.
+ * @param text The name typed by the user.
+ */
+static void copyName(int8_t *name, const int8_t *text)
+{
+    size_t length = strlen(text);           /* Number of bytes copied */
+
+    if (length >= MAX_NAME_LENGTH)
+    {
+        length = MAX_NAME_LENGTH - 1;
+        /* Go back to the first byte of the character that was cut */
+        while (length > 0 && ((uint8_t)text[length] & 0xC0) == 0x80)
+        {
+            length--;
+        }
+    }
+    memcpy(name, text, length);
+    name[length] = '\0';
+}
+
+
+/**
+ * @brief Prompts the user for the order of the employee list.
+ *
+ * Each digit is one sort key, the first one is the most important. Performance, salary and
+ * late days put the largest values first; names and departments are in alphabetical order.
+ * An empty answer sorts by working performance.
+ *
+ * @param keys Receives the sort keys, EMPLOYEE_SORT_MAX_KEYS entries.
+ * @return Number of sort keys.
+ */
+static uint32_t promptSortOrder(EmployeeSortKey_t *keys)
+{
+    static const uint8_t descending[SORT_FIELD_COUNT] = {1, 1, 0, 0, 1};  /* Direction of each field */
+    int8_t buffer[100];                     /* Buffer to store input temporarily */
+    uint32_t key_count = 0;                 /* Number of sort keys read */
+    uint32_t valid = 0;                     /* Flag to check if input is valid */
+    uint32_t i = 0;                         /* Position in the input */
+
+    do
+    {
+        printf("Sort by: 1. performance  2. net salary  3. name  4. department  5. late days\n");
+        printf("Enter up to %u choices, most important first (e.g. 42), or Enter for performance: ",
+               EMPLOYEE_SORT_MAX_KEYS);
+        fflush(stdin);
+        if (fgets((char*)buffer, sizeof(buffer), stdin) == NULL)
+        {
+            buffer[0] = '\0';
+        }
+        key_count = 0;
+        valid = 1;
+        for (i = 0; buffer[i] != '\0' && buffer[i] != '\n' && buffer[i] != '\r' && valid == 1; i++)
+        {
+            if (buffer[i] == ' ' || buffer[i] == ',')
+            {
+                continue;
+            }
+            if (buffer[i] < '1' || buffer[i] >= '1' + SORT_FIELD_COUNT || key_count == EMPLOYEE_SORT_MAX_KEYS)
+            {
+                valid = 0;
+                break;
+            }
+            keys[key_count].field = (EmployeeSortField_t)(buffer[i] - '1');
+            keys[key_count].descending = descending[keys[key_count].field];
+            key_count++;
+        }
+        if (valid == 0)
+        {
+            printf("\nInput is not valid. Please enter again!!!\n");
+        }
+    } while (valid == 0);
+
+    if (key_count == 0)
+    {
+        keys[0].field = SORT_BY_PERFORMANCE;
+        keys[0].descending = 1;
+        key_count = 1;
+    }
+    return key_count;
+}
+
+
+/**
+ * @brief Prints the details of a batch of employees.
+ *
+ * @return 1 to receive the next batch.
+ */
+static uint32_t printEmployeeLines(const PayrollLine_t *lines, uint32_t count, void *context)
+{
+    const Employee_t *employee = NULL;      /* Employee being printed */
+    uint32_t i = 0;                         /* Index for looping through the batch */
+
+    (void)context;
+    for (i = 0; i < count; i++)
+    {
+        employee = lines[i].employee;
+        printf("----\n");
+        /* Print the employee's ID */
+        printf("ID: %s\n", employee->id);
+        /* Print the department's ID */
+        printf("Department's ID: %s\n", employee->department_id);
+        /* Print the employee's full name */
+        printf("Full name: %s\n", employee->name);
+        /* Print the employee's salary base in VND, value formatted with ","
+        (using formatNumberWithCommas() function) to illustrate money unit */
+        printf("Salary base: %s (VND)\n", formatNumberWithCommas(employee->salary_base));
+        /* Print the number of working days */
+        printf("Number of working days: %hu (days)\n", employee->working_days);
+        /* Print the employee's working performance */
+        printf("Working performance: %.1f\n", employee->working_performance);
+        /* Print the employee's bonus in VND, value formatted with ","
+        (using formatNumberWithCommas() function) to illustrate money unit */
+        printf("Bonus: %s (VND)\n", formatNumberWithCommas(employee->bonus));
+        /* Print the number of late working days */
+        printf("Number of late working days: %hu (days)\n", employee->late_coming_days);
+        printf("----\n");
+    }
+    return 1;
+}
+
+
+/**
+ * @brief Prints the actual salary of a batch of employees.
+ *
+ * @return 1 to receive the next batch.
+ */
+static uint32_t printPayrollLines(const PayrollLine_t *lines, uint32_t count, void *context)
+{
+    uint32_t i = 0;                         /* Index for looping through the batch */
+
+    (void)context;
+    for (i = 0; i < count; i++)
+    {
+        printf("\n----\n");
+        /* Print the employee's ID */
+        printf("ID: %s\n", lines[i].employee->id);
+        /* Print the actual salary of the employee, this value is formatted with commas
+        to illustrate money */
+        printf("Actual salary received: %s (VND)\n", formatNumberWithCommas(lines[i].salary.actual_salary));
+        printf("----\n");
+    }
+    return 1;
+}
+
+
+/**
+ * @brief Prints one line of the memory report.
+ */
+static void printUsageLine(const char *name, uint64_t count, uint64_t live_bytes, uint64_t reserved_bytes)
+{
+    /* formatNumberWithCommas() reuses its buffer, so each number is printed on its own */
+    printf("%-24s", name);
+    printf("%16s", formatNumberWithCommas(count));
+    printf("%18s", formatNumberWithCommas(live_bytes));
+    printf("%18s\n", formatNumberWithCommas(reserved_bytes));
+} /* EOF */
@@ -14,6 +14,163 @@
 #ifndef MANAGE_EMPLOYEE_H
 #define MANAGE_EMPLOYEE_H
 
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "record_pool.h"        /* Include pool allocator header file for RecordPoolUsage_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#ifndef MANAGE_COMPACT_MODE
+#define MANAGE_COMPACT_MODE 0   /* Set to 1 (-DMANAGE_COMPACT_MODE=1) to build the compact employee record */
+#endif
+
+#if MANAGE_COMPACT_MODE
+/* Compact mode: short IDs and names, amounts up to 4,294,967,295 VND and day counts up to 255,
+   an employee record takes 80 bytes instead of 280 */
+#define MAX_ID_LENGTH 16        /* Maximum length of ID strings for employees and departments. */
+#define MAX_NAME_LENGTH 32      /* Maximum length of name strings for employees. */
+#define EMPLOYEE_MAX_AMOUNT UINT32_MAX  /* Largest salary base or bonus of an employee. */
+#define EMPLOYEE_MAX_DAYS UINT8_MAX     /* Largest number of working or late coming days. */
+typedef uint32_t EmployeeAmount_t;      /* Salary base and bonus of an employee. */
+typedef uint8_t EmployeeDays_t;         /* Working days and late coming days of an employee. */
+#else
+#define MAX_ID_LENGTH 100       /* Maximum length of ID strings for employees and departments. */
+#define MAX_NAME_LENGTH 50      /* Maximum length of name strings for employees. */
+#define EMPLOYEE_MAX_AMOUNT UINT64_MAX  /* Largest salary base or bonus of an employee. */
+#define EMPLOYEE_MAX_DAYS UINT16_MAX    /* Largest number of working or late coming days. */
+typedef uint64_t EmployeeAmount_t;      /* Salary base and bonus of an employee. */
+typedef uint16_t EmployeeDays_t;        /* Working days and late coming days of an employee. */
+#endif
+#define DEPARTMENT_NO_RAISE 10000u  /* raise_factor of a department without raise (100.00%). */
+#define TAX_FREE_LIMIT 11000000u    /* Largest income after insurance that is not taxed. */
+#define TAX_LOW_RATE_LIMIT 16000000u    /* Largest income after insurance taxed at 5%, above it 10%. */
+#define EMPLOYEE_RENAME_LOG_LENGTH 256u /* Renames a store keeps for its indexes before they must be built again. */
+
+/**
+ * @brief Structure to represent an employee.
+ *
+ * This structure holds information about an employee including their ID, name,
+ * base salary, number of working days, department ID, working performance, bonus,
+ * and number of days they came late to work.
+ *
+ * Fields are ordered from the widest to the narrowest so the compiler adds no padding
+ * between them; only the end of the record is padded to the alignment of salary_base.
+ */
+typedef struct Employee {
+    EmployeeAmount_t salary_base;           /* Employee's base salary. */
+    EmployeeAmount_t bonus;                 /* Bonus received by the employee. */
+    float working_performance;              /* Employee's working performance. */
+    EmployeeDays_t working_days;            /* Number of days the employee worked. */
+    EmployeeDays_t late_coming_days;        /* Number of days the employee came late to work. */
+    int8_t id[MAX_ID_LENGTH];              /* Employee's ID. */
+    int8_t department_id[MAX_ID_LENGTH];   /* ID of the department that the employee belongs to. */
+    int8_t name[MAX_NAME_LENGTH];          /* Employee's name. */
+} Employee_t;
+
+/**
+ * @brief Structure to represent a department.
+ *
+ * This structure holds information about a department including its ID, the bonus salary
+ * allocated to the department, the number of employees currently belonging to it and the
+ * salary raise granted to the whole department. The raise is not applied to the employees'
+ * records: it is applied to their net salary when the payroll is calculated.
+ */
+typedef struct Department {
+    int8_t id[MAX_ID_LENGTH];              /* Department's ID. */
+    uint64_t bonus_salary;                  /* Bonus salary allocated to the department. */
+    uint32_t employee_count;                /* Number of employees in the department. */
+    uint32_t raise_factor;                  /* Net salary multiplier in basis points, DEPARTMENT_NO_RAISE
+                                               (or 0) means no raise. */
+} Department_t;
+
+/**
+ * @brief Intermediate values of a salary calculation.
+ *
+ * All amounts are in VND. total_income is the gross income, insurance is the 10.5% that is
+ * deducted from it and actual_salary is the net salary received.
+ */
+typedef struct SalaryBreakdown {
+    uint64_t department_bonus;              /* Bonus of the employee's department. */
+    uint64_t late_coming_penalty;           /* Penalty for late coming days. */
+    uint64_t income_without_bonus;          /* salary_base * working_days * working_performance. */
+    uint64_t total_income;                  /* Gross income: income without bonus + bonuses - penalty. */
+    uint64_t insurance;                     /* Insurance deducted from the gross income. */
+    uint64_t totalIncome_without_tax;       /* Gross income after insurance. */
+    uint64_t tax;                           /* Personal income tax. */
+    uint64_t department_raise;              /* Amount added to the net salary by the department's raise. */
+    uint64_t actual_salary;                 /* Net salary received, including the department's raise. */
+} SalaryBreakdown_t;
+
+/**
+ * @brief Result codes returned by the non-interactive (batch) functions.
+ */
+typedef enum ManageStatus {
+    MANAGE_OK = 0,                          /* Operation completed successfully. */
+    MANAGE_ERR_INVALID_ARGUMENT,            /* A record has an empty or malformed field. */
+    MANAGE_ERR_DUPLICATE_ID,                /* An ID appears twice or already exists. */
+    MANAGE_ERR_UNKNOWN_DEPARTMENT,          /* An employee refers to a department that does not exist. */
+    MANAGE_ERR_NOT_FOUND,                   /* An ID to delete does not exist. */
+    MANAGE_ERR_DEPARTMENT_NOT_EMPTY,        /* A department to delete still has employees. */
+    MANAGE_ERR_NO_MEMORY,                   /* Memory allocation failed. */
+    MANAGE_ERR_IO                           /* A file could not be read or written. */
+} ManageStatus_t;
+
+/**
+ * @brief Memory used by the employee and department store.
+ */
+typedef struct StoreMemoryUsage {
+    RecordPoolUsage_t employees;            /* Pool holding the employee records. */
+    RecordPoolUsage_t departments;          /* Pool holding the department records. */
+    uint64_t employee_handle_bytes;         /* Array of handles that keeps the employee order. */
+    uint64_t department_handle_bytes;       /* Array of handles that keeps the department order. */
+    uint64_t employee_index_bytes;          /* Hash index from employee IDs to records. */
+    uint64_t index_bytes;                   /* Hash index from department IDs to records. */
+} StoreMemoryUsage_t;
+
+/**
+ * @brief Employees and departments of one company, with their indexes.
+ *
+ * Every function of this file works on the store selected by the calling thread (see
+ * selectEmployeeStore()); a thread that never selects one uses the default store, which holds
+ * the data of the program.
+ */
+typedef struct EmployeeStore EmployeeStore_t;
+
+/**
+ * @brief A rename kept by the store so that indexes can update the renamed employee only.
+ */
+typedef struct EmployeeRename {
+    const Employee_t *employee;             /* The renamed employee, it already has its new name. */
+    int8_t old_name[MAX_NAME_LENGTH];       /* The name the employee had before the rename. */
+} EmployeeRename_t;
+
+/**
+ * @brief Fields of an employee that updateEmployeesBatch() can change, combined with '|'.
+ *
+ * The ID cannot change: it identifies the employee to update.
+ */
+typedef enum EmployeeField {
+    EMPLOYEE_FIELD_NAME = 0x01,                 /* name */
+    EMPLOYEE_FIELD_DEPARTMENT = 0x02,           /* department_id, the department must exist */
+    EMPLOYEE_FIELD_SALARY_BASE = 0x04,          /* salary_base */
+    EMPLOYEE_FIELD_WORKING_DAYS = 0x08,         /* working_days */
+    EMPLOYEE_FIELD_WORKING_PERFORMANCE = 0x10,  /* working_performance */
+    EMPLOYEE_FIELD_BONUS = 0x20,                /* bonus */
+    EMPLOYEE_FIELD_LATE_COMING_DAYS = 0x40,     /* late_coming_days */
+    EMPLOYEE_FIELD_ALL = 0x7F                   /* Every field above */
+} EmployeeField_t;
+
+/**
+ * @brief Change of some fields of a stored employee.
+ */
+typedef struct EmployeeUpdate {
+    Employee_t employee;                    /* ID of the employee and the new values of the chosen fields. */
+    uint32_t fields;                        /* EMPLOYEE_FIELD_* flags of the fields to change. */
+} EmployeeUpdate_t;
+
 /*******************************************************************************
  * Prototype
  ******************************************************************************/
@@ -57,6 +214,15 @@ void addEmployee();
  */
 void deleteEmployee();
 
+/**
+ * @brief Changes some fields of an employee.
+ *
+ * This function prompts the user for the ID of the employee, then for each field shows the
+ * current value and asks for a new one; pressing Enter keeps the value. The record is changed
+ * in place with updateEmployeesBatch().
+ */
+void updateEmployee();
+
 /**
  * @brief Deletes a department from the program.
  *
@@ -77,5 +243,302 @@ void deleteDepartment();
  */
 void showPayroll();
 
+/**
+ * @brief Prompts the user for a department and updates its bonus or grants it a salary raise.
+ */
+void adjustDepartment();
+
+/**
+ * @brief Prints the memory used by each structure and index of the store.
+ */
+void showMemoryUsage();
+
+/**
+ * @brief Sets the bonus of a department.
+ *
+ * @param department_id The department to update.
+ * @param bonus_salary The new bonus of the department.
+ * @return MANAGE_OK on success, MANAGE_ERR_NOT_FOUND if the department does not exist.
+ */
+ManageStatus_t updateDepartmentBonus(const int8_t *department_id, uint64_t bonus_salary);
+
+/**
+ * @brief Grants a percentage raise to every employee of a department.
+ *
+ * The raise is recorded once on the department and compounds with earlier raises.
+ * It is applied to the net salary when the payroll is calculated.
+ *
+ * @param department_id The department to update.
+ * @param raise_basis_points The raise in basis points (1% = 100), must be more than 0.
+ * @return MANAGE_OK on success, MANAGE_ERR_NOT_FOUND if the department does not exist,
+ *         MANAGE_ERR_INVALID_ARGUMENT if the raise is 0 or the factor would overflow.
+ */
+ManageStatus_t raiseDepartmentSalary(const int8_t *department_id, uint32_t raise_basis_points);
+
+/**
+ * @brief Checks the fields of an employee record as addEmployeesBatch() does.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_INVALID_ARGUMENT if an ID or the name is empty or not
+ *         terminated, or the working performance is not more than 0.
+ */
+ManageStatus_t checkEmployeeRecord(const Employee_t *employee);
+
+/**
+ * @brief Adds many employees in one pass.
+ *
+ * Every record is validated before anything is changed: IDs and names must not be empty,
+ * working performance must be more than 0, employee IDs must be unique inside the batch and
+ * must not exist yet, and each department ID must either exist or be listed in
+ * new_departments. If any record fails, nothing is added.
+ * New departments are created once and membership counts are updated once per batch.
+ *
+ * @param employees Array of employees to add.
+ * @param count Number of employees in the array.
+ * @param new_departments Departments to create when an employee refers to them (may be NULL).
+ *        Their IDs must be unique. Entries whose ID already exists or that no employee
+ *        refers to are ignored.
+ * @param department_count Number of departments in new_departments.
+ * @return MANAGE_OK on success, otherwise the reason the batch was rejected.
+ */
+ManageStatus_t addEmployeesBatch(const Employee_t *employees, uint32_t count,
+                                 const Department_t *new_departments, uint32_t department_count);
+
+/**
+ * @brief Makes sure that every department of a list exists.
+ *
+ * Departments whose ID is not stored yet are created without employees; stored departments
+ * are left unchanged, and an ID repeated in the list is only created once. Each ID is looked
+ * up in constant time. Memory is reserved for the whole list first, so either every missing
+ * department is created or none is.
+ *
+ * @param departments Array of departments.
+ * @param count Number of departments in the array.
+ * @param created Receives the number of departments created (may be NULL). They are the last
+ *        ones of the store.
+ * @return MANAGE_OK on success, MANAGE_ERR_INVALID_ARGUMENT if an ID is empty or not
+ *         terminated, or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t ensureDepartments(const Department_t *departments, uint32_t count, uint32_t *created);
+
+/**
+ * @brief Deletes many employees in one pass.
+ *
+ * All IDs must exist and be unique, otherwise nothing is deleted. The employees array is
+ * compacted once and department membership counts are updated once per batch.
+ *
+ * @param ids Array of employee IDs to delete.
+ * @param count Number of IDs in the array.
+ * @return MANAGE_OK on success, otherwise the reason the batch was rejected.
+ */
+ManageStatus_t deleteEmployeesBatch(const int8_t *const *ids, uint32_t count);
+
+/**
+ * @brief Deletes many departments in one pass.
+ *
+ * All IDs must exist, be unique and refer to departments without employees,
+ * otherwise nothing is deleted. The departments array is compacted once.
+ *
+ * @param ids Array of department IDs to delete.
+ * @param count Number of IDs in the array.
+ * @return MANAGE_OK on success, otherwise the reason the batch was rejected.
+ */
+ManageStatus_t deleteDepartmentsBatch(const int8_t *const *ids, uint32_t count);
+
+/**
+ * @brief Changes some fields of many stored employees in place.
+ *
+ * Updates of the same ID are applied in batch order. Every updated record is checked as
+ * addEmployeesBatch() does before anything is changed; if one fails, nothing is changed.
+ * Records keep their place in the store, so only what depends on a changed field is updated:
+ * department membership counts when an employee changes department, and the renames listed
+ * by getEmployeeRename() when a name changes.
+ *
+ * @param updates Array of updates.
+ * @param count Number of updates in the array.
+ * @return MANAGE_OK, MANAGE_ERR_INVALID_ARGUMENT if an update has unknown fields or leaves a
+ *         field empty or malformed, MANAGE_ERR_NOT_FOUND if an ID is not stored,
+ *         MANAGE_ERR_UNKNOWN_DEPARTMENT if a new department does not exist, or
+ *         MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t updateEmployeesBatch(const EmployeeUpdate_t *updates, uint32_t count);
+
+/**
+ * @brief Sets the working days and late coming days of a stored employee.
+ *
+ * The change is recorded in the change feed but not committed, so that a caller setting many
+ * employees writes them as one operation: it must call changeFeedCommit() once it is done.
+ *
+ * @param index Store position of the employee.
+ * @param working_days Number of days the employee worked.
+ * @param late_coming_days Number of days the employee came late to work.
+ * @return MANAGE_OK, MANAGE_ERR_NOT_FOUND if the position is out of range, or
+ *         MANAGE_ERR_INVALID_ARGUMENT if a count does not fit in EmployeeDays_t.
+ */
+ManageStatus_t setEmployeeAttendance(uint32_t index, uint32_t working_days, uint32_t late_coming_days);
+
+/**
+ * @brief Returns the number of employees currently stored.
+ */
+uint32_t getTotalEmployees();
+
+/**
+ * @brief Returns a number that changes whenever employees are added to or deleted from the store.
+ *
+ * Indexes built from the stored employees compare it with the count they were built at to
+ * know whether they must be built again. Renames are listed by getEmployeeRename() instead,
+ * and only change it once EMPLOYEE_RENAME_LOG_LENGTH renames are listed. Reordering the
+ * employees or changing other fields does not change it. The numbers come from one counter
+ * shared by all stores, so selecting another store changes it too, unless both stores never
+ * had employees.
+ */
+uint64_t getEmployeeChangeCount();
+
+/**
+ * @brief Returns the number of employees renamed since getEmployeeChangeCount() last changed.
+ */
+uint32_t getEmployeeRenameCount();
+
+/**
+ * @brief Returns a rename made since getEmployeeChangeCount() last changed, oldest first.
+ *
+ * An employee renamed several times is listed once per rename.
+ *
+ * @param index Position of the rename, less than getEmployeeRenameCount().
+ * @return The rename, or NULL if out of range.
+ */
+const EmployeeRename_t* getEmployeeRename(uint32_t index);
+
+/**
+ * @brief Returns the employee stored at the given position, or NULL if out of range.
+ *
+ * Records live in a pool and never move: the pointer stays valid until the employee is
+ * deleted, even if other employees are added, deleted or reordered.
+ */
+const Employee_t* getEmployeeAt(uint32_t index);
+
+/**
+ * @brief Returns the number of departments currently stored.
+ */
+uint32_t getTotalDepartments();
+
+/**
+ * @brief Returns the department stored at the given position, or NULL if out of range.
+ */
+const Department_t* getDepartmentAt(uint32_t index);
+
+/**
+ * @brief Finds an employee by its ID.
+ *
+ * @param employee_id The employee ID to look for.
+ * @return Pointer to the employee, or NULL if no employee has this ID.
+ */
+const Employee_t* findEmployee(const int8_t *employee_id);
+
+/**
+ * @brief Finds a department by its ID.
+ *
+ * @param department_id The department ID to look for.
+ * @return Pointer to the department, or NULL if no department has this ID.
+ */
+const Department_t* findDepartment(const int8_t *department_id);
+
+/**
+ * @brief Reports the memory used by the store.
+ */
+void getStoreMemoryUsage(StoreMemoryUsage_t *usage);
+
+/**
+ * @brief Makes the empty store use employee and department records that are already in memory.
+ *
+ * Used to start from a snapshot (see loadStoreSnapshot()). The records are not copied: each
+ * array must hold whole pool slabs (the count rounded up to RECORD_POOL_SLAB_RECORDS records),
+ * be writable and stay valid until detachStoreRecords(). The department index is built on
+ * the first lookup.
+ *
+ * @param employee_records The employees, in store order.
+ * @param employee_count Number of employees.
+ * @param department_records The departments, in store order.
+ * @param department_count Number of departments.
+ * @return MANAGE_OK, MANAGE_ERR_INVALID_ARGUMENT if the store is not empty, or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t adoptStoreRecords(uint8_t *employee_records, uint32_t employee_count,
+                                 uint8_t *department_records, uint32_t department_count);
+
+/**
+ * @brief Copies the records given to adoptStoreRecords() into memory owned by the store.
+ *
+ * Pointers returned by getEmployeeAt(), getDepartmentAt(), findEmployee() and findDepartment()
+ * become invalid.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_NO_MEMORY (the store keeps using the adopted records).
+ */
+ManageStatus_t detachStoreRecords();
+
+/**
+ * @brief Creates an empty store, to be selected with selectEmployeeStore().
+ *
+ * @return The store, or NULL if memory could not be allocated.
+ */
+EmployeeStore_t* createEmployeeStore();
+
+/**
+ * @brief Frees a store created by createEmployeeStore() and all its records.
+ *
+ * No thread may have the store selected. The default store and NULL are ignored.
+ */
+void destroyEmployeeStore(EmployeeStore_t *store);
+
+/**
+ * @brief Makes the functions of this file work on a store in the calling thread.
+ *
+ * Other threads keep their own selection. Threads started by the store functions work on the
+ * store of the thread that started them.
+ *
+ * @param store The store, or NULL for the default store.
+ * @return The store selected before, to select it again when done.
+ */
+EmployeeStore_t* selectEmployeeStore(EmployeeStore_t *store);
+
+/**
+ * @brief Returns the store selected by the calling thread.
+ */
+EmployeeStore_t* getActiveEmployeeStore();
+
+/**
+ * @brief Returns the default store, which holds the data of the program.
+ */
+EmployeeStore_t* getDefaultEmployeeStore();
+
+/**
+ * @brief Calculates the salary of an employee and keeps every intermediate value.
+ *
+ * The employee's department is looked up among the stored departments.
+ *
+ * @param employee The employee for whom the salary is to be calculated.
+ * @param breakdown Receives the intermediate values and the actual salary.
+ */
+void calculateSalaryBreakdown(const Employee_t *employee, SalaryBreakdown_t *breakdown);
+
+/**
+ * @brief Calculates the salary of an employee for a given department.
+ *
+ * This function does not read the stored tables, so it can be used on records that are not
+ * stored (imports, generated data, other processes' tables).
+ *
+ * @param employee The employee for whom the salary is to be calculated.
+ * @param department The employee's department, or NULL if it has none.
+ * @param breakdown Receives the intermediate values and the actual salary.
+ */
+void calculateSalaryForDepartment(const Employee_t *employee, const Department_t *department,
+                                  SalaryBreakdown_t *breakdown);
+
+/**
+ * @brief Returns the tax bracket of an income after insurance.
+ *
+ * @param income_after_insurance Gross income minus insurance (totalIncome_without_tax).
+ * @return 0 for the untaxed bracket, 1 for the 5% bracket and 2 for the 10% bracket.
+ */
+uint32_t taxBracket(uint64_t income_after_insurance);
+
 #endif /* MANAGE_EMPLOYEE_H */
 
@@ -0,0 +1,989 @@
+/**
+ * @file mutation_queue.c
+ * @brief This file contains the implementation of the queue that applies store changes on one writer thread.
+ *
+ * The queue is an intrusive multi-producer single-consumer list: producers exchange the tail
+ * and then link the previous tail to their mutation, the writer follows the links from the
+ * head. Between the exchange and the link the list is briefly cut; the writer then yields and
+ * tries again. The lock and conditions are only used to put the writer, or a thread waiting
+ * for a result, to sleep.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdio.h>              /* Include standard input and output library for printf, snprintf */
+#include <stdlib.h>             /* Include standard library for malloc, free */
+#include <string.h>             /* Include string manipulation library for memset, strlen, memcpy */
+#include <sched.h>              /* Include scheduling library for sched_yield */
+#include <time.h>               /* Include time library for clock_gettime */
+#include "mutation_queue.h"     /* Include header file */
+#include "perf_stats.h"         /* Include instrumentation header file for measuring hot operations */
+#include "id_index.h"           /* Include ID index header file for screening rejected additions */
+#include "input_handler.h"      /* Include input handler header file for parseUnsignedField(), formatNumberWithCommas() */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define MUTATION_NO_EARLIER UINT32_MAX      /* No earlier addition of the run has the same ID */
+#define CHECK_EMPLOYEE_IDS 4096u            /* Number of employee IDs the check's mutations use */
+#define CHECK_DEPARTMENT_IDS 16u            /* Number of department IDs the check's mutations use */
+#define CHECK_MAX_RUN 32u                   /* Longest run of mutations of one kind a producer submits */
+#define CHECK_DEFAULT_PRODUCERS 4u          /* Producers used when none are given on the command line */
+#define CHECK_DEFAULT_MUTATIONS 10000u      /* Mutations per producer used when none are given */
+#define CHECK_DEFAULT_SEED 20240330u        /* Seed used when none is given on the command line */
+
+/**
+ * @brief State of mutationQueueCheck() shared with its producers.
+ */
+typedef struct MutationCheck {
+    MutationQueue_t queue;                  /* Queue under test */
+    Mutation_t *mutations;                  /* Mutations of every producer, producer after producer */
+    Mutation_t **order;                     /* Mutations in the order the writer applied them */
+    uint32_t applied;                       /* Number of mutations in order, written by the writer only */
+    uint32_t per_producer;                  /* Number of mutations of each producer */
+} MutationCheck_t;
+
+/**
+ * @brief One producer of mutationQueueCheck().
+ */
+typedef struct CheckProducer {
+    MutationCheck_t *check;                 /* The check */
+    uint32_t index;                         /* Index of the producer */
+} CheckProducer_t;
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static void* writerThread(void *argument);
+static void pushMutation(MutationQueue_t *queue, Mutation_t *mutation);
+static Mutation_t* popMutation(MutationQueue_t *queue);
+static void applyBatch(MutationQueue_t *queue, Mutation_t **batch, uint32_t count);
+static void applyRun(MutationQueue_t *queue, Mutation_t **run, uint32_t count, uint32_t screened);
+static void applyScreenedAdds(MutationQueue_t *queue, Mutation_t **run, uint32_t count);
+static ManageStatus_t applyOne(Mutation_t *mutation);
+static ManageStatus_t copyId(int8_t *copy, const int8_t *id);
+static const int8_t* runEmployeeKey(uint32_t value, const void *context);
+static void* checkProducerThread(void *argument);
+static void recordApplied(Mutation_t *mutation, void *context);
+static void generateMutations(Mutation_t *mutations, uint32_t count, uint64_t seed);
+static uint32_t compareStores(EmployeeStore_t *store, EmployeeStore_t *reference, MutationCheckReport_t *report);
+static uint32_t sameEmployee(const Employee_t *employee, const Employee_t *other);
+static uint64_t nextCheckRandom(uint64_t *state);
+static double secondsSince(const struct timespec *start);
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Starts a queue and its writer thread.
+ */
+ManageStatus_t mutationQueueStart(MutationQueue_t *queue)
+{
+    memset(queue, 0, sizeof(*queue));
+    queue->head = &queue->stub;
+    queue->tail = &queue->stub;
+    queue->employees = malloc(MUTATION_BATCH * sizeof(*queue->employees));
+    queue->departments = malloc(MUTATION_BATCH * sizeof(*queue->departments));
+    queue->ids = malloc(MUTATION_BATCH * sizeof(*queue->ids));
+    queue->updates = malloc(MUTATION_BATCH * sizeof(*queue->updates));
+    queue->pending = malloc(MUTATION_BATCH * sizeof(*queue->pending));
+    queue->earlier = malloc(MUTATION_BATCH * sizeof(*queue->earlier));
+    if (queue->employees == NULL || queue->departments == NULL || queue->ids == NULL
+        || queue->updates == NULL || queue->pending == NULL || queue->earlier == NULL)
+    {
+        free(queue->employees);
+        free(queue->departments);
+        free(queue->ids);
+        free(queue->updates);
+        free(queue->pending);
+        free(queue->earlier);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    queue->store = getActiveEmployeeStore();
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->wake, NULL);
+    pthread_cond_init(&queue->applied, NULL);
+    if (pthread_create(&queue->writer, NULL, writerThread, queue) != 0)
+    {
+        pthread_cond_destroy(&queue->applied);
+        pthread_cond_destroy(&queue->wake);
+        pthread_mutex_destroy(&queue->lock);
+        free(queue->employees);
+        free(queue->departments);
+        free(queue->ids);
+        free(queue->updates);
+        free(queue->pending);
+        free(queue->earlier);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Applies every submitted mutation, then stops the writer thread.
+ */
+void mutationQueueStop(MutationQueue_t *queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    __atomic_store_n(&queue->stopping, 1, __ATOMIC_SEQ_CST);
+    pthread_cond_signal(&queue->wake);
+    pthread_mutex_unlock(&queue->lock);
+    pthread_join(queue->writer, NULL);
+
+    pthread_cond_destroy(&queue->applied);
+    pthread_cond_destroy(&queue->wake);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->employees);
+    free(queue->departments);
+    free(queue->ids);
+    free(queue->updates);
+    free(queue->pending);
+    free(queue->earlier);
+}
+
+
+/**
+ * @brief Submits a mutation; never blocks.
+ */
+void mutationQueueSubmit(MutationQueue_t *queue, Mutation_t *mutation, MutationDoneFn_t done, void *context)
+{
+    mutation->done = done;
+    mutation->context = context;
+    mutation->status = MANAGE_OK;
+    mutation->completed = 0;
+    pushMutation(queue, mutation);
+
+    /* The writer only sleeps after it saw an empty queue, so only a sleeping writer needs a signal */
+    if (__atomic_load_n(&queue->sleeping, __ATOMIC_SEQ_CST) == 1)
+    {
+        pthread_mutex_lock(&queue->lock);
+        pthread_cond_signal(&queue->wake);
+        pthread_mutex_unlock(&queue->lock);
+    }
+}
+
+
+/**
+ * @brief Waits until a mutation submitted without a callback is applied.
+ */
+ManageStatus_t mutationWait(MutationQueue_t *queue, Mutation_t *mutation)
+{
+    if (__atomic_load_n(&mutation->completed, __ATOMIC_ACQUIRE) == 0)
+    {
+        pthread_mutex_lock(&queue->lock);
+        __atomic_add_fetch(&queue->waiting, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&mutation->completed, __ATOMIC_SEQ_CST) == 0)
+        {
+            pthread_cond_wait(&queue->applied, &queue->lock);
+        }
+        __atomic_sub_fetch(&queue->waiting, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&queue->lock);
+    }
+    return mutation->status;
+}
+
+
+/**
+ * @brief Submits a mutation and waits until it is applied.
+ */
+ManageStatus_t mutationQueueApply(MutationQueue_t *queue, Mutation_t *mutation)
+{
+    mutationQueueSubmit(queue, mutation, NULL, NULL);
+    return mutationWait(queue, mutation);
+}
+
+
+/**
+ * @brief Fills a mutation that adds an employee.
+ */
+void mutationAddEmployee(Mutation_t *mutation, const Employee_t *employee)
+{
+    mutation->kind = MUTATION_ADD_EMPLOYEE;
+    memcpy(&mutation->employee, employee, sizeof(*employee));
+}
+
+
+/**
+ * @brief Fills a mutation that deletes an employee.
+ */
+ManageStatus_t mutationDeleteEmployee(Mutation_t *mutation, const int8_t *employee_id)
+{
+    mutation->kind = MUTATION_DELETE_EMPLOYEE;
+    return copyId(mutation->id, employee_id);
+}
+
+
+/**
+ * @brief Fills a mutation that creates a department unless its ID is stored.
+ */
+void mutationEnsureDepartment(Mutation_t *mutation, const Department_t *department)
+{
+    mutation->kind = MUTATION_ENSURE_DEPARTMENT;
+    memcpy(&mutation->department, department, sizeof(*department));
+}
+
+
+/**
+ * @brief Fills a mutation that deletes a department without employees.
+ */
+ManageStatus_t mutationDeleteDepartment(Mutation_t *mutation, const int8_t *department_id)
+{
+    mutation->kind = MUTATION_DELETE_DEPARTMENT;
+    return copyId(mutation->id, department_id);
+}
+
+
+/**
+ * @brief Fills a mutation that sets the bonus of a department.
+ */
+ManageStatus_t mutationSetDepartmentBonus(Mutation_t *mutation, const int8_t *department_id, uint64_t bonus_salary)
+{
+    mutation->kind = MUTATION_SET_DEPARTMENT_BONUS;
+    mutation->department.bonus_salary = bonus_salary;
+    return copyId(mutation->department.id, department_id);
+}
+
+
+/**
+ * @brief Fills a mutation that changes some fields of an employee.
+ */
+void mutationUpdateEmployee(Mutation_t *mutation, const EmployeeUpdate_t *update)
+{
+    mutation->kind = MUTATION_UPDATE_EMPLOYEE;
+    memcpy(&mutation->employee, &update->employee, sizeof(update->employee));
+    mutation->fields = update->fields;
+}
+
+
+/**
+ * @brief Fills a mutation that calls a function on the writer thread, where the store can be read.
+ */
+void mutationCall(Mutation_t *mutation, MutationCallFn_t call, void *context)
+{
+    mutation->kind = MUTATION_CALL;
+    mutation->call = call;
+    mutation->call_context = context;
+}
+
+
+/**
+ * @brief Applies random mutations of several producers through a queue and compares the result
+ *        with applying them one by one.
+ *
+ * The mutations use few IDs, so many of them fail (duplicate additions, deletions of deleted
+ * employees, departments that still have employees, ...) and the writer has to split and
+ * screen its runs. Each producer submits runs of up to CHECK_MAX_RUN mutations of one kind,
+ * interleaved with the runs of the other producers. The writer records the order in which it
+ * applies them; applying them one by one in that order on a second store must give every
+ * mutation the same result and leave the same records in the same order.
+ *
+ * @return MANAGE_OK, MANAGE_ERR_INVALID_ARGUMENT or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t mutationQueueCheck(uint32_t producers, uint32_t mutations, uint64_t seed, MutationCheckReport_t *report)
+{
+    MutationCheck_t check;                  /* State shared with the producers */
+    CheckProducer_t producer[MUTATION_CHECK_MAX_PRODUCERS];    /* Arguments of the producers */
+    pthread_t threads[MUTATION_CHECK_MAX_PRODUCERS];           /* Producer threads */
+    uint32_t started[MUTATION_CHECK_MAX_PRODUCERS];            /* Set for producers that run on a thread */
+    EmployeeStore_t *store = NULL;          /* Store the queue applies the mutations to */
+    EmployeeStore_t *reference = NULL;      /* Store the mutations are applied to one by one */
+    EmployeeStore_t *previous = NULL;       /* Store selected by the caller */
+    struct timespec start;                  /* Time of the first submission */
+    uint64_t total = (uint64_t)producers * mutations;  /* Number of mutations */
+    ManageStatus_t status = MANAGE_OK;      /* Result of a mutation applied one by one */
+    uint32_t p = 0;                         /* Index for looping through producers */
+    uint32_t i = 0;                         /* Index for looping through mutations */
+
+    memset(report, 0, sizeof(*report));
+    if (producers == 0 || producers > MUTATION_CHECK_MAX_PRODUCERS || mutations == 0 || total > UINT32_MAX)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    check.mutations = malloc((size_t)total * sizeof(*check.mutations));
+    check.order = malloc((size_t)total * sizeof(*check.order));
+    store = createEmployeeStore();
+    reference = createEmployeeStore();
+    if (check.mutations == NULL || check.order == NULL || store == NULL || reference == NULL)
+    {
+        free(check.mutations);
+        free(check.order);
+        destroyEmployeeStore(store);
+        destroyEmployeeStore(reference);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    check.applied = 0;
+    check.per_producer = mutations;
+    for (p = 0; p < producers; p++)
+    {
+        generateMutations(&check.mutations[(size_t)p * mutations], mutations, seed + p);
+    }
+
+    previous = selectEmployeeStore(store);
+    status = mutationQueueStart(&check.queue);
+    selectEmployeeStore(previous);
+    if (status != MANAGE_OK)
+    {
+        free(check.mutations);
+        free(check.order);
+        destroyEmployeeStore(store);
+        destroyEmployeeStore(reference);
+        return status;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (p = 0; p < producers; p++)
+    {
+        producer[p].check = &check;
+        producer[p].index = p;
+        started[p] = (pthread_create(&threads[p], NULL, checkProducerThread, &producer[p]) == 0);
+        if (started[p] == 0)
+        {
+            checkProducerThread(&producer[p]);
+        }
+    }
+    for (p = 0; p < producers; p++)
+    {
+        if (started[p] != 0)
+        {
+            pthread_join(threads[p], NULL);
+        }
+    }
+    mutationQueueStop(&check.queue);
+    report->seconds = secondsSince(&start);
+    report->applied = check.queue.applied_count;
+    report->batches = check.queue.batch_count;
+
+    /* The writer has stopped, so the order it recorded is complete */
+    previous = selectEmployeeStore(reference);
+    for (i = 0; i < check.applied; i++)
+    {
+        status = applyOne(check.order[i]);
+        report->rejected += (check.order[i]->status != MANAGE_OK);
+        if (status != check.order[i]->status)
+        {
+            report->first_mismatch = (report->result_mismatches == 0) ? i : report->first_mismatch;
+            report->result_mismatches++;
+        }
+    }
+    if (check.applied != total)
+    {
+        /* A mutation was lost or applied twice */
+        report->first_mismatch = (report->result_mismatches == 0) ? check.applied : report->first_mismatch;
+        report->result_mismatches++;
+    }
+    report->record_mismatches = compareStores(store, reference, report);
+    selectEmployeeStore(previous);
+
+    free(check.mutations);
+    free(check.order);
+    destroyEmployeeStore(store);
+    destroyEmployeeStore(reference);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Runs mutationQueueCheck() from the command line.
+ */
+int32_t mutationQueueCommand(int argc, char *argv[])
+{
+    MutationCheckReport_t report;           /* Result of the check */
+    uint64_t producers = CHECK_DEFAULT_PRODUCERS;      /* Number of producers */
+    uint64_t mutations = CHECK_DEFAULT_MUTATIONS;      /* Number of mutations per producer */
+    uint64_t seed = CHECK_DEFAULT_SEED;     /* Seed of the mutations */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the check */
+
+    if (argc > 5
+        || (argc > 2 && parseUnsignedField((const int8_t *)argv[2], strlen(argv[2]), MUTATION_CHECK_MAX_PRODUCERS, &producers) != PARSE_OK)
+        || (argc > 3 && parseUnsignedField((const int8_t *)argv[3], strlen(argv[3]), UINT32_MAX, &mutations) != PARSE_OK)
+        || (argc > 4 && parseUnsignedField((const int8_t *)argv[4], strlen(argv[4]), UINT64_MAX, &seed) != PARSE_OK)
+        || producers == 0 || mutations == 0 || producers * mutations > UINT32_MAX)
+    {
+        printf("Usage: %s --queue-check [producers] [mutations per producer] [seed]\n", argv[0]);
+        printf("       producers: 1 to %d\n", MUTATION_CHECK_MAX_PRODUCERS);
+        return 2;
+    }
+    status = mutationQueueCheck((uint32_t)producers, (uint32_t)mutations, seed, &report);
+    if (status != MANAGE_OK)
+    {
+        printf("Cannot run the mutation queue check (status %d)\n", (int)status);
+        return 2;
+    }
+    printf("Mutation queue check: %u producers, seed %llu\n", (uint32_t)producers, (unsigned long long)seed);
+    printf("  %s mutations applied", formatNumberWithCommas(report.applied));
+    printf(" in %s batches (%.3f s)", formatNumberWithCommas(report.batches), report.seconds);
+    printf(", %s rejected\n", formatNumberWithCommas(report.rejected));
+    printf("  Store left with %u employees and %u departments\n", report.employee_count, report.department_count);
+    if (report.result_mismatches != 0 || report.record_mismatches != 0)
+    {
+        printf("  MISMATCH: %s results differ", formatNumberWithCommas(report.result_mismatches));
+        printf(" (first at mutation %llu), %u records differ\n",
+               (unsigned long long)report.first_mismatch, report.record_mismatches);
+        return 1;
+    }
+    printf("  OK: same results and records as applying the mutations one by one\n");
+    return 0;
+}
+
+
+/**
+ * @brief Writer thread: applies the mutations in batches until the queue is stopped.
+ */
+static void* writerThread(void *argument)
+{
+    MutationQueue_t *queue = argument;      /* The queue */
+    Mutation_t *batch[MUTATION_BATCH];      /* Mutations taken from the queue */
+    Mutation_t *mutation = NULL;            /* Mutation taken from the queue */
+    uint32_t count = 0;                     /* Number of mutations in batch */
+
+    selectEmployeeStore(queue->store);
+    for (;;)
+    {
+        count = 0;
+        while (count < MUTATION_BATCH && (mutation = popMutation(queue)) != NULL)
+        {
+            batch[count++] = mutation;
+        }
+        if (count > 0)
+        {
+            applyBatch(queue, batch, count);
+            continue;
+        }
+        if (__atomic_load_n(&queue->tail, __ATOMIC_SEQ_CST) != queue->head)
+        {
+            /* A producer has exchanged the tail but not linked its mutation yet */
+            sched_yield();
+            continue;
+        }
+        if (__atomic_load_n(&queue->stopping, __ATOMIC_SEQ_CST) == 1)
+        {
+            break;
+        }
+
+        /* Sleep only if the queue is still empty once producers can see that the writer sleeps */
+        pthread_mutex_lock(&queue->lock);
+        __atomic_store_n(&queue->sleeping, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&queue->tail, __ATOMIC_SEQ_CST) == queue->head
+            && __atomic_load_n(&queue->stopping, __ATOMIC_SEQ_CST) == 0)
+        {
+            pthread_cond_wait(&queue->wake, &queue->lock);
+        }
+        __atomic_store_n(&queue->sleeping, 0, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&queue->lock);
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Links a mutation to the end of the queue.
+ */
+static void pushMutation(MutationQueue_t *queue, Mutation_t *mutation)
+{
+    Mutation_t *previous = NULL;            /* Tail before the mutation */
+
+    __atomic_store_n(&mutation->next, NULL, __ATOMIC_RELAXED);
+    previous = __atomic_exchange_n(&queue->tail, mutation, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&previous->next, mutation, __ATOMIC_RELEASE);
+}
+
+
+/**
+ * @brief Takes the first mutation of the queue, on the writer thread.
+ *
+ * @return The mutation, or NULL if the queue is empty or a producer has not linked its mutation yet.
+ */
+static Mutation_t* popMutation(MutationQueue_t *queue)
+{
+    Mutation_t *head = queue->head;         /* First node of the list */
+    Mutation_t *next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);     /* Node after head */
+
+    if (head == &queue->stub)
+    {
+        if (next == NULL)
+        {
+            return NULL;
+        }
+        queue->head = next;
+        head = next;
+        next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+    }
+    if (next != NULL)
+    {
+        queue->head = next;
+        return head;
+    }
+    if (__atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE) != head)
+    {
+        return NULL;
+    }
+
+    /* head is the last mutation: put the stub behind it so that head can be handed out */
+    pushMutation(queue, &queue->stub);
+    next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+    if (next != NULL)
+    {
+        queue->head = next;
+        return head;
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Applies a batch run by run and reports the results.
+ */
+static void applyBatch(MutationQueue_t *queue, Mutation_t **batch, uint32_t count)
+{
+    Mutation_t *mutation = NULL;            /* Mutation being reported */
+    uint32_t start = 0;                     /* First mutation of the current run */
+    uint32_t end = 0;                       /* Index after the current run */
+    uint32_t i = 0;                         /* Index for looping through the batch */
+    PERF_START(perf_start);                 /* Start time of the batch */
+
+    for (start = 0; start < count; start = end)
+    {
+        end = start + 1;
+        while (end < count && batch[end]->kind == batch[start]->kind)
+        {
+            end++;
+        }
+        applyRun(queue, &batch[start], end - start, 0);
+    }
+    queue->applied_count += count;
+    queue->batch_count++;
+    PERF_STOP(PERF_OP_APPLY_MUTATIONS, perf_start);
+
+    for (i = 0; i < count; i++)
+    {
+        mutation = batch[i];
+        if (mutation->done != NULL)
+        {
+            mutation->done(mutation, mutation->context);
+        }
+        else
+        {
+            __atomic_store_n(&mutation->completed, 1, __ATOMIC_SEQ_CST);
+        }
+    }
+    if (__atomic_load_n(&queue->waiting, __ATOMIC_SEQ_CST) > 0)
+    {
+        pthread_mutex_lock(&queue->lock);
+        pthread_cond_broadcast(&queue->applied);
+        pthread_mutex_unlock(&queue->lock);
+    }
+}
+
+
+/**
+ * @brief Applies a run of mutations of the same kind with one batch call of the store.
+ *
+ * A batch call changes nothing when it rejects a record, and accepts a run exactly when every
+ * mutation of it would succeed in order. A rejected run is split in two halves applied one
+ * after the other, so every mutation gets the result it has on its own while a few failures
+ * among many mutations cost a few more batch calls, not one call per mutation. Rejected
+ * additions are screened for duplicate IDs first, the usual reason, see applyScreenedAdds().
+ *
+ * @param screened 1 if the additions of the run were screened already.
+ */
+static void applyRun(MutationQueue_t *queue, Mutation_t **run, uint32_t count, uint32_t screened)
+{
+    ManageStatus_t status = MANAGE_OK;      /* Result of the batch call */
+    uint32_t i = 0;                         /* Index for looping through the run */
+
+    if (count == 1)
+    {
+        run[0]->status = applyOne(run[0]);
+        return;
+    }
+    switch (run[0]->kind)
+    {
+        case MUTATION_ADD_EMPLOYEE:
+            for (i = 0; i < count; i++)
+            {
+                queue->employees[i] = run[i]->employee;
+            }
+            status = addEmployeesBatch(queue->employees, count, NULL, 0);
+            break;
+        case MUTATION_ENSURE_DEPARTMENT:
+            for (i = 0; i < count; i++)
+            {
+                queue->departments[i] = run[i]->department;
+            }
+            status = ensureDepartments(queue->departments, count, NULL);
+            break;
+        case MUTATION_DELETE_EMPLOYEE:
+        case MUTATION_DELETE_DEPARTMENT:
+            for (i = 0; i < count; i++)
+            {
+                queue->ids[i] = run[i]->id;
+            }
+            status = (run[0]->kind == MUTATION_DELETE_EMPLOYEE) ? deleteEmployeesBatch(queue->ids, count)
+                                                                : deleteDepartmentsBatch(queue->ids, count);
+            break;
+        case MUTATION_UPDATE_EMPLOYEE:
+            for (i = 0; i < count; i++)
+            {
+                queue->updates[i].employee = run[i]->employee;
+                queue->updates[i].fields = run[i]->fields;
+            }
+            status = updateEmployeesBatch(queue->updates, count);
+            break;
+        default:
+            /* No batch call: bonuses and calls are applied one by one */
+            for (i = 0; i < count; i++)
+            {
+                run[i]->status = applyOne(run[i]);
+            }
+            return;
+    }
+
+    if (status == MANAGE_OK)
+    {
+        for (i = 0; i < count; i++)
+        {
+            run[i]->status = MANAGE_OK;
+        }
+        return;
+    }
+    if (run[0]->kind == MUTATION_ADD_EMPLOYEE && screened == 0)
+    {
+        applyScreenedAdds(queue, run, count);
+        return;
+    }
+    applyRun(queue, run, count / 2, screened);
+    applyRun(queue, run + count / 2, count - count / 2, screened);
+}
+
+
+/**
+ * @brief Applies a rejected run of additions without the duplicate IDs that made it fail.
+ *
+ * Finding a few duplicates by splitting the run costs many batch calls. Instead each ID is
+ * looked up in the store: additions of a stored ID fail at once, and of several additions
+ * with the same ID only the first is batched with
+ * the rest of the run. The later ones are settled afterwards: they fail if an earlier one was
+ * added, and are applied on their own otherwise. Records are checked first, as the store
+ * does. Additions of different IDs do not depend on each other, so the results are those of
+ * applying the run in order.
+ */
+static void applyScreenedAdds(MutationQueue_t *queue, Mutation_t **run, uint32_t count)
+{
+    IdIndex_t seen;                         /* ID -> position of its last tried addition in the run */
+    uint32_t pending_count = 0;             /* Number of additions still to apply */
+    uint32_t position = 0;                  /* Position found in an index */
+    uint32_t i = 0;                         /* Index for looping through the run */
+
+    idIndexInit(&seen, runEmployeeKey, run);
+    if (idIndexReserve(&seen, count) != MANAGE_OK)
+    {
+        idIndexFree(&seen);
+        applyRun(queue, run, count / 2, 1);
+        applyRun(queue, run + count / 2, count - count / 2, 1);
+        return;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        queue->earlier[i] = MUTATION_NO_EARLIER;
+        if (checkEmployeeRecord(&run[i]->employee) != MANAGE_OK)
+        {
+            run[i]->status = MANAGE_ERR_INVALID_ARGUMENT;
+        }
+        else if (findEmployee(run[i]->employee.id) != NULL)
+        {
+            run[i]->status = MANAGE_ERR_DUPLICATE_ID;
+        }
+        else if (idIndexFind(&seen, run[i]->employee.id, &position) == 1)
+        {
+            queue->earlier[i] = position;
+        }
+        else
+        {
+            idIndexInsert(&seen, run[i]->employee.id, i);
+            queue->pending[pending_count++] = run[i];
+        }
+    }
+    if (pending_count > 0)
+    {
+        applyRun(queue, queue->pending, pending_count, 1);
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if (queue->earlier[i] != MUTATION_NO_EARLIER)
+        {
+            idIndexFind(&seen, run[i]->employee.id, &position);
+            if (run[position]->status == MANAGE_OK)
+            {
+                run[i]->status = MANAGE_ERR_DUPLICATE_ID;
+            }
+            else
+            {
+                run[i]->status = applyOne(run[i]);
+                idIndexUpdate(&seen, run[i]->employee.id, i);
+            }
+        }
+    }
+    idIndexFree(&seen);
+}
+
+
+/**
+ * @brief Applies one mutation.
+ *
+ * @return The status of the mutation.
+ */
+static ManageStatus_t applyOne(Mutation_t *mutation)
+{
+    const int8_t *id = mutation->id;        /* ID of a deletion */
+    EmployeeUpdate_t update;                /* Update of a MUTATION_UPDATE_EMPLOYEE */
+
+    switch (mutation->kind)
+    {
+        case MUTATION_ADD_EMPLOYEE:
+            return addEmployeesBatch(&mutation->employee, 1, NULL, 0);
+        case MUTATION_DELETE_EMPLOYEE:
+            return deleteEmployeesBatch(&id, 1);
+        case MUTATION_ENSURE_DEPARTMENT:
+            return ensureDepartments(&mutation->department, 1, NULL);
+        case MUTATION_DELETE_DEPARTMENT:
+            return deleteDepartmentsBatch(&id, 1);
+        case MUTATION_SET_DEPARTMENT_BONUS:
+            return updateDepartmentBonus(mutation->department.id, mutation->department.bonus_salary);
+        case MUTATION_UPDATE_EMPLOYEE:
+            update.employee = mutation->employee;
+            update.fields = mutation->fields;
+            return updateEmployeesBatch(&update, 1);
+        case MUTATION_CALL:
+            return mutation->call(mutation->call_context);
+        default:
+            return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+}
+
+
+/**
+ * @brief Copies an ID into a mutation.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_INVALID_ARGUMENT if the ID is empty or too long.
+ */
+static ManageStatus_t copyId(int8_t *copy, const int8_t *id)
+{
+    size_t length = strlen(id);             /* Length of the ID */
+
+    if (length == 0 || length >= MAX_ID_LENGTH)
+    {
+        copy[0] = '\0';
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    memcpy(copy, id, length + 1);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Returns the ID of an addition of a run for the ID index.
+ */
+static const int8_t* runEmployeeKey(uint32_t value, const void *context)
+{
+    return ((Mutation_t *const *)context)[value]->employee.id;
+}
+
+
+/**
+ * @brief Producer of mutationQueueCheck(): submits its mutations without waiting.
+ */
+static void* checkProducerThread(void *argument)
+{
+    CheckProducer_t *producer = argument;   /* The producer */
+    MutationCheck_t *check = producer->check;          /* The check */
+    Mutation_t *mutations = &check->mutations[(size_t)producer->index * check->per_producer];  /* Mutations of the producer */
+    uint32_t i = 0;                         /* Index for looping through the mutations */
+
+    for (i = 0; i < check->per_producer; i++)
+    {
+        mutationQueueSubmit(&check->queue, &mutations[i], recordApplied, check);
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Records the order in which the writer applies the check's mutations.
+ */
+static void recordApplied(Mutation_t *mutation, void *context)
+{
+    MutationCheck_t *check = context;       /* The check */
+
+    check->order[check->applied++] = mutation;
+}
+
+
+/**
+ * @brief Generates the mutations of one producer of the check, in runs of one kind.
+ */
+static void generateMutations(Mutation_t *mutations, uint32_t count, uint64_t seed)
+{
+    Employee_t employee;                    /* Employee of an addition */
+    EmployeeUpdate_t update;                /* Update of an employee */
+    Department_t department;                /* Department to create */
+    int8_t id[MAX_ID_LENGTH];               /* ID of a deletion or bonus */
+    uint64_t state = seed;                  /* State of the random generator */
+    uint64_t random = 0;                    /* Random bits of the current mutation */
+    uint32_t kind = 0;                      /* Kind of the current run, as a percentile */
+    uint32_t run = 0;                       /* Mutations left in the current run */
+    uint32_t i = 0;                         /* Index for looping through the mutations */
+
+    for (i = 0; i < count; i++)
+    {
+        if (run == 0)
+        {
+            random = nextCheckRandom(&state);
+            kind = (uint32_t)(random % 100);
+            run = 1 + (uint32_t)((random >> 8) % CHECK_MAX_RUN);
+        }
+        run--;
+        random = nextCheckRandom(&state);
+        memset(&mutations[i], 0, sizeof(mutations[i]));
+        memset(&employee, 0, sizeof(employee));
+        snprintf((char *)employee.id, sizeof(employee.id), "Q%04u", (uint32_t)(random % CHECK_EMPLOYEE_IDS));
+        snprintf((char *)employee.department_id, sizeof(employee.department_id), "QD%02u",
+                 (uint32_t)((random >> 16) % CHECK_DEPARTMENT_IDS));
+        snprintf((char *)employee.name, sizeof(employee.name), "Check %u", (uint32_t)(random >> 40));
+        employee.salary_base = 5000000 + (uint32_t)((random >> 20) % 1000) * 10000;
+        employee.bonus = (uint32_t)((random >> 30) % 100) * 10000;
+        /* One record in 64 is invalid, so screened additions are rejected for that too */
+        employee.working_performance = ((random >> 36) % 64 == 0) ? 0.0f : 0.5f + (float)((random >> 42) % 5) * 0.25f;
+        employee.working_days = (uint32_t)((random >> 48) % 27);
+        employee.late_coming_days = (uint32_t)((random >> 56) % 5);
+        snprintf((char *)id, sizeof(id), "QD%02u", (uint32_t)((random >> 16) % CHECK_DEPARTMENT_IDS));
+
+        if (kind < 40)
+        {
+            mutationAddEmployee(&mutations[i], &employee);
+        }
+        else if (kind < 55)
+        {
+            mutationDeleteEmployee(&mutations[i], employee.id);
+        }
+        else if (kind < 70)
+        {
+            update.employee = employee;
+            update.fields = 1 + (uint32_t)((random >> 60) % EMPLOYEE_FIELD_ALL);
+            mutationUpdateEmployee(&mutations[i], &update);
+        }
+        else if (kind < 82)
+        {
+            memset(&department, 0, sizeof(department));
+            memcpy(department.id, id, sizeof(id));
+            department.bonus_salary = (uint32_t)((random >> 24) % 100) * 100000;
+            mutationEnsureDepartment(&mutations[i], &department);
+        }
+        else if (kind < 88)
+        {
+            mutationDeleteDepartment(&mutations[i], id);
+        }
+        else
+        {
+            mutationSetDepartmentBonus(&mutations[i], id, (uint32_t)((random >> 24) % 100) * 100000);
+        }
+    }
+}
+
+
+/**
+ * @brief Compares the records of the queue's store with those of the reference store.
+ *
+ * @return The number of records that differ or are missing from one of the stores.
+ */
+static uint32_t compareStores(EmployeeStore_t *store, EmployeeStore_t *reference, MutationCheckReport_t *report)
+{
+    Employee_t employee;                    /* Employee of the queue's store */
+    Department_t department;                /* Department of the queue's store */
+    const Department_t *other = NULL;       /* Department at the same position of the reference */
+    uint32_t reference_employees = 0;       /* Number of employees of the reference */
+    uint32_t reference_departments = 0;     /* Number of departments of the reference */
+    uint32_t mismatches = 0;                /* Number of records that differ */
+    uint32_t i = 0;                         /* Index for looping through records */
+
+    selectEmployeeStore(reference);
+    reference_employees = getTotalEmployees();
+    reference_departments = getTotalDepartments();
+    selectEmployeeStore(store);
+    report->employee_count = getTotalEmployees();
+    report->department_count = getTotalDepartments();
+
+    for (i = 0; i < report->employee_count; i++)
+    {
+        selectEmployeeStore(store);
+        employee = *getEmployeeAt(i);
+        selectEmployeeStore(reference);
+        mismatches += (i >= reference_employees || sameEmployee(&employee, getEmployeeAt(i)) == 0);
+    }
+    for (i = 0; i < report->department_count; i++)
+    {
+        selectEmployeeStore(store);
+        department = *getDepartmentAt(i);
+        selectEmployeeStore(reference);
+        other = (i < reference_departments) ? getDepartmentAt(i) : NULL;
+        mismatches += (other == NULL || strcmp((const char *)department.id, (const char *)other->id) != 0
+                       || department.bonus_salary != other->bonus_salary
+                       || department.employee_count != other->employee_count
+                       || department.raise_factor != other->raise_factor);
+    }
+    if (reference_employees > report->employee_count)
+    {
+        mismatches += reference_employees - report->employee_count;
+    }
+    if (reference_departments > report->department_count)
+    {
+        mismatches += reference_departments - report->department_count;
+    }
+    return mismatches;
+}
+
+
+/**
+ * @brief Tells whether two employee records hold the same values.
+ *
+ * @return 1 if they do, 0 otherwise.
+ */
+static uint32_t sameEmployee(const Employee_t *employee, const Employee_t *other)
+{
+    return strcmp((const char *)employee->id, (const char *)other->id) == 0
+           && strcmp((const char *)employee->department_id, (const char *)other->department_id) == 0
+           && strcmp((const char *)employee->name, (const char *)other->name) == 0
+           && employee->salary_base == other->salary_base
+           && employee->bonus == other->bonus
+           && employee->working_performance == other->working_performance
+           && employee->working_days == other->working_days
+           && employee->late_coming_days == other->late_coming_days;
+}
+
+
+/**
+ * @brief Returns the next 64 random bits of a splitmix64 generator.
+ */
+static uint64_t nextCheckRandom(uint64_t *state)
+{
+    uint64_t value = (*state += 0x9E3779B97F4A7C15ull);    /* Next state */
+
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+
+/**
+ * @brief Returns the number of seconds elapsed since a time of the monotonic clock.
+ */
+static double secondsSince(const struct timespec *start)
+{
+    struct timespec now;                    /* Current time */
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+} /* EOF */
@@ -0,0 +1,242 @@
+/**
+ * @file mutation_queue.h
+ * @brief This file contains the function prototypes of the queue that applies store changes on one writer thread.
+ *
+ * Several front ends (the menu, batch jobs, a local service) may change the store at the same
+ * time. Instead of taking a lock around every change, they submit mutations to a queue and a
+ * single writer thread applies them in submission order. Submitting never blocks: a mutation is
+ * linked to the end of the queue with one atomic exchange, so producers never wait for each
+ * other or for the writer.
+ *
+ * The writer takes up to MUTATION_BATCH mutations at a time and applies every run of
+ * mutations of the same kind with one batch call of the store (addEmployeesBatch(),
+ * deleteEmployeesBatch(), updateEmployeesBatch(), ...). When a batch call rejects a run, the run is applied again in
+ * smaller parts, so each mutation gets the result it would have had on its own.
+ *
+ * The result of a mutation is either waited for with mutationWait(), or passed to a callback
+ * that the writer thread calls. While a queue runs, the store may only be read or changed from
+ * the writer thread: other threads read it with a MUTATION_CALL mutation, which runs between
+ * two batches.
+ *
+ * mutationQueueCheck() stress-tests the queue: several producers submit random mutations of a
+ * few IDs at the same time, then the result of every mutation and the final store are compared
+ * with those of applying the same mutations one by one, in the order the writer took them. The
+ * program runs it with --queue-check.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef MUTATION_QUEUE_H
+#define MUTATION_QUEUE_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include <pthread.h>            /* Include POSIX threads library for the writer thread */
+#include "manage_employee.h"    /* Include manage employee header file for Employee_t, Department_t and ManageStatus_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define MUTATION_BATCH 4096                  /* Largest number of mutations applied at once */
+#define MUTATION_CHECK_MAX_PRODUCERS 64      /* Largest number of producers of mutationQueueCheck() */
+
+/**
+ * @brief Kinds of mutation.
+ */
+typedef enum MutationKind {
+    MUTATION_ADD_EMPLOYEE = 0,              /* Adds employee, its department must exist */
+    MUTATION_DELETE_EMPLOYEE,               /* Deletes the employee id */
+    MUTATION_ENSURE_DEPARTMENT,             /* Creates department unless its ID is stored */
+    MUTATION_DELETE_DEPARTMENT,             /* Deletes the department id, which must have no employees */
+    MUTATION_SET_DEPARTMENT_BONUS,          /* Sets the bonus of department.id to department.bonus_salary */
+    MUTATION_UPDATE_EMPLOYEE,               /* Sets the fields of employee.id chosen by fields */
+    MUTATION_CALL                           /* Calls call(call_context) on the writer thread */
+} MutationKind_t;
+
+struct Mutation;
+
+/**
+ * @brief Called on the writer thread when a mutation is applied.
+ *
+ * The mutation belongs to the callback from then on; it may free it.
+ */
+typedef void (*MutationDoneFn_t)(struct Mutation *mutation, void *context);
+
+/**
+ * @brief Called on the writer thread by a MUTATION_CALL mutation.
+ *
+ * @return The status of the mutation.
+ */
+typedef ManageStatus_t (*MutationCallFn_t)(void *context);
+
+/**
+ * @brief One change of the store.
+ *
+ * The memory belongs to the producer and must stay valid until the mutation is applied. Only
+ * the fields used by the kind are read.
+ */
+typedef struct Mutation {
+    struct Mutation *next;                  /* Next mutation of the queue, used by the queue */
+    MutationKind_t kind;                    /* What to do */
+    Employee_t employee;                    /* Employee to add, or ID and new values of an update */
+    uint32_t fields;                        /* EMPLOYEE_FIELD_* flags of an update */
+    Department_t department;                /* Department to create, or whose bonus to set */
+    int8_t id[MAX_ID_LENGTH];               /* Employee or department to delete */
+    MutationCallFn_t call;                  /* Function of a MUTATION_CALL mutation */
+    void *call_context;                     /* Passed to call */
+    MutationDoneFn_t done;                  /* Called when applied, NULL to use mutationWait() */
+    void *context;                          /* Passed to done */
+    ManageStatus_t status;                  /* Result, set when applied */
+    uint32_t completed;                     /* Set to 1 when applied, if done is NULL */
+} Mutation_t;
+
+/**
+ * @brief A queue and its writer thread.
+ */
+typedef struct MutationQueue {
+    Mutation_t *tail;                       /* Last submitted mutation, exchanged by producers */
+    Mutation_t *head;                       /* Next mutation to apply, used by the writer only */
+    Mutation_t stub;                        /* Keeps the queue linked when it is empty */
+    uint32_t sleeping;                      /* Set while the writer waits for mutations */
+    uint32_t waiting;                       /* Number of threads in mutationWait() */
+    uint32_t stopping;                      /* Set by mutationQueueStop() */
+    pthread_t writer;                       /* The writer thread */
+    pthread_mutex_t lock;                   /* Guards the two conditions, never the store */
+    pthread_cond_t wake;                    /* Signalled when a mutation arrives for a sleeping writer */
+    pthread_cond_t applied;                 /* Broadcast when mutations some thread waits for are applied */
+    Employee_t *employees;                  /* Scratch records of a run of MUTATION_ADD_EMPLOYEE */
+    Department_t *departments;              /* Scratch records of a run of MUTATION_ENSURE_DEPARTMENT */
+    const int8_t **ids;                     /* Scratch IDs of a run of deletions */
+    EmployeeUpdate_t *updates;              /* Scratch updates of a run of MUTATION_UPDATE_EMPLOYEE */
+    Mutation_t **pending;                   /* Scratch additions of a rejected run that may still succeed */
+    uint32_t *earlier;                      /* Scratch position of the earlier addition with the same ID */
+    uint64_t applied_count;                 /* Number of mutations applied so far */
+    uint64_t batch_count;                   /* Number of batches taken by the writer so far */
+    EmployeeStore_t *store;                 /* Store the writer applies the mutations to */
+} MutationQueue_t;
+
+/**
+ * @brief Result of mutationQueueCheck().
+ */
+typedef struct MutationCheckReport {
+    uint64_t applied;                       /* Number of mutations applied by the queue */
+    uint64_t batches;                       /* Number of batches taken by the writer */
+    uint64_t rejected;                      /* Number of mutations the queue rejected */
+    uint64_t result_mismatches;             /* Mutations whose result differs from applying them one by one */
+    uint64_t first_mismatch;                /* Position in applying order of the first of them */
+    uint32_t record_mismatches;             /* Records that differ between the two stores, or are missing */
+    uint32_t employee_count;                /* Number of employees left by the queue */
+    uint32_t department_count;              /* Number of departments left by the queue */
+    double seconds;                         /* Time from the first submission until the queue stopped */
+} MutationCheckReport_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Starts a queue and its writer thread.
+ *
+ * The writer applies the mutations to the store selected by the calling thread.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_NO_MEMORY if the thread or its buffers cannot be created.
+ */
+ManageStatus_t mutationQueueStart(MutationQueue_t *queue);
+
+/**
+ * @brief Applies every submitted mutation, then stops the writer thread.
+ *
+ * No mutation may be submitted once this is called.
+ */
+void mutationQueueStop(MutationQueue_t *queue);
+
+/**
+ * @brief Submits a mutation; never blocks.
+ *
+ * @param queue The queue.
+ * @param mutation The mutation, filled by one of the mutation*() functions.
+ * @param done Called on the writer thread when the mutation is applied, NULL to use mutationWait().
+ * @param context Passed to done.
+ */
+void mutationQueueSubmit(MutationQueue_t *queue, Mutation_t *mutation, MutationDoneFn_t done, void *context);
+
+/**
+ * @brief Waits until a mutation submitted without a callback is applied.
+ *
+ * @return The status of the mutation.
+ */
+ManageStatus_t mutationWait(MutationQueue_t *queue, Mutation_t *mutation);
+
+/**
+ * @brief Submits a mutation and waits until it is applied.
+ *
+ * @return The status of the mutation.
+ */
+ManageStatus_t mutationQueueApply(MutationQueue_t *queue, Mutation_t *mutation);
+
+/**
+ * @brief Fills a mutation that adds an employee.
+ */
+void mutationAddEmployee(Mutation_t *mutation, const Employee_t *employee);
+
+/**
+ * @brief Fills a mutation that deletes an employee.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_INVALID_ARGUMENT if the ID is empty or too long.
+ */
+ManageStatus_t mutationDeleteEmployee(Mutation_t *mutation, const int8_t *employee_id);
+
+/**
+ * @brief Fills a mutation that creates a department unless its ID is stored.
+ */
+void mutationEnsureDepartment(Mutation_t *mutation, const Department_t *department);
+
+/**
+ * @brief Fills a mutation that deletes a department without employees.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_INVALID_ARGUMENT if the ID is empty or too long.
+ */
+ManageStatus_t mutationDeleteDepartment(Mutation_t *mutation, const int8_t *department_id);
+
+/**
+ * @brief Fills a mutation that sets the bonus of a department.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_INVALID_ARGUMENT if the ID is empty or too long.
+ */
+ManageStatus_t mutationSetDepartmentBonus(Mutation_t *mutation, const int8_t *department_id, uint64_t bonus_salary);
+
+/**
+ * @brief Fills a mutation that changes some fields of an employee.
+ */
+void mutationUpdateEmployee(Mutation_t *mutation, const EmployeeUpdate_t *update);
+
+/**
+ * @brief Fills a mutation that calls a function on the writer thread, where the store can be read.
+ */
+void mutationCall(Mutation_t *mutation, MutationCallFn_t call, void *context);
+
+/**
+ * @brief Applies random mutations of several producers through a queue and compares the result
+ *        with applying them one by one.
+ *
+ * Both stores are created for the check; the stores of the calling thread are not touched.
+ *
+ * @param producers Number of producer threads, 1 to MUTATION_CHECK_MAX_PRODUCERS.
+ * @param mutations Number of mutations submitted by each producer.
+ * @param seed Seed of the mutations; the same seed always gives the same mutations.
+ * @param report Receives the result.
+ * @return MANAGE_OK if the check ran (report tells whether it passed), MANAGE_ERR_INVALID_ARGUMENT
+ *         or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t mutationQueueCheck(uint32_t producers, uint32_t mutations, uint64_t seed, MutationCheckReport_t *report);
+
+/**
+ * @brief Runs mutationQueueCheck() from the command line: --queue-check [producers] [mutations] [seed].
+ *
+ * @return 0 if the queue matches applying the mutations one by one, 1 if not, 2 on errors.
+ */
+int32_t mutationQueueCommand(int argc, char *argv[]);
+
+#endif /* MUTATION_QUEUE_H */
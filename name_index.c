@@ -0,0 +1,997 @@
+/**
+ * @file name_index.c
+ * @brief This file contains the implementation of the search index over employee names.
+ *
+ * The tokens are sorted the way the employee lists are: the packed first 8 bytes are radix
+ * sorted, then every run of tokens that agree on those bytes is sorted again on the next 8
+ * bytes, and short runs are insertion sorted on the text. Both sorts are stable, so tokens
+ * with the same text stay in store order.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdio.h>              /* Include standard input and output library for printf, fgets */
+#include <stdlib.h>             /* Include standard library for malloc, realloc, free */
+#include <string.h>             /* Include string manipulation library for strcmp, strncmp, memcpy, memset */
+#include <time.h>               /* Include time library for clock_gettime */
+#include "name_index.h"         /* Include header file */
+#include "input_handler.h"      /* Include input handler header file for handling user input */
+#include "perf_stats.h"         /* Include instrumentation header file for measuring hot operations */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define NAME_RADIX_BITS 8                   /* Bits sorted per radix pass */
+#define NAME_RADIX_BUCKETS (1u << NAME_RADIX_BITS)     /* Buckets per radix pass */
+#define NAME_RADIX_PASSES (64 / NAME_RADIX_BITS)       /* Passes over a 64-bit key */
+#define NAME_INSERTION_THRESHOLD 32         /* Runs up to this length are insertion sorted instead of radix sorted */
+#define NAME_MAX_QUERY_WORDS (NAME_FOLDED_LENGTH / 2)  /* Most words of a folded query */
+#define NAME_QUERY_LENGTH 128               /* Longest query typed by the user */
+#define NAME_SHOWN_RESULTS 20               /* Most employees shown by the menu */
+#define NAME_NEVER_BUILT 0xFFFFFFFFFFFFFFFFull         /* change_count of an index that holds nothing */
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static uint32_t decodeUtf8(const uint8_t *text, uint32_t *code_point);
+static int8_t foldCodePoint(uint32_t code_point);
+static uint64_t packPrefix(const int8_t *text);
+static const int8_t* tokenText(const NameIndex_t *index, const NameToken_t *token);
+static void sortTokens(const NameIndex_t *index, NameToken_t *tokens, NameToken_t *scratch, uint32_t count,
+                       uint32_t depth);
+static NameToken_t* radixSort(NameToken_t *tokens, NameToken_t *scratch, uint32_t count);
+static void insertionSort(const NameIndex_t *index, NameToken_t *tokens, uint32_t count, uint32_t depth);
+static int32_t comparePrefix(const NameIndex_t *index, const NameToken_t *token, const int8_t *prefix,
+                             uint32_t length, uint64_t prefix_key);
+static uint32_t findRange(const NameIndex_t *index, const NameToken_t *tokens, uint32_t count,
+                          const int8_t *prefix, uint32_t length, uint32_t *first);
+static uint32_t findWord(const int8_t *name, const int8_t *word, uint32_t length);
+static uint32_t findRenamedEmployee(const NameIndex_t *index, const EmployeeRename_t *rename, uint32_t *slot);
+static uint32_t isRenamed(const NameIndex_t *index, uint32_t employee);
+
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static NameIndex_t name_index;                  /* Index used by the menu */
+static uint32_t name_index_ready = 0;           /* Flag to check if name_index is initialized */
+
+/* Folded letter of U+00C0 to U+00FF, '.' if the character is kept as it is */
+static const char latin1_letters[] = "aaaaaa.ceeeeiiiidnooooo.ouuuuy..aaaaaa.ceeeeiiiidnooooo.ouuuuy.y";
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Folds a name for comparison: no diacritics, lower case, words separated by one blank.
+ */
+uint32_t foldName(const int8_t *name, int8_t *folded, uint32_t size)
+{
+    const uint8_t *text = (const uint8_t *)name;    /* The name, read as bytes */
+    uint32_t position = 0;                  /* Position of the current character in the name */
+    uint32_t length = 0;                    /* Number of bytes of the current character */
+    uint32_t code_point = 0;                /* The current character */
+    uint32_t written = 0;                   /* Length of the folded name */
+    uint32_t blank = 0;                     /* Flag set when a blank must come before the next character */
+    int8_t letter = 0;                      /* Folded form of the current character, 0 if it is kept */
+
+    if (size == 0)
+    {
+        return 0;
+    }
+    while (text[position] != '\0')
+    {
+        length = decodeUtf8(text + position, &code_point);
+        if (length == 0)
+        {
+            /* Not UTF-8: the byte is kept as it is */
+            length = 1;
+            code_point = 0xFFFFFFFFu;
+        }
+
+        if (code_point < 0x80u || code_point == 0xA0u)
+        {
+            if (code_point >= 'A' && code_point <= 'Z')
+            {
+                letter = (int8_t)(code_point + ('a' - 'A'));
+            }
+            else if ((code_point >= 'a' && code_point <= 'z') || (code_point >= '0' && code_point <= '9'))
+            {
+                letter = (int8_t)code_point;
+            }
+            else
+            {
+                /* Blanks, punctuation and no-break spaces separate words */
+                blank = (written > 0) ? 1u : 0u;
+                position += length;
+                continue;
+            }
+        }
+        else if (code_point >= 0x300u && code_point <= 0x36Fu)
+        {
+            /* Combining marks of decomposed text (tones, breve, circumflex, horn) are dropped */
+            position += length;
+            continue;
+        }
+        else
+        {
+            letter = foldCodePoint(code_point);
+        }
+
+        if (written + blank + ((letter != 0) ? 1u : length) > size - 1)
+        {
+            break;
+        }
+        if (blank != 0)
+        {
+            folded[written++] = ' ';
+            blank = 0;
+        }
+        if (letter != 0)
+        {
+            folded[written++] = letter;
+        }
+        else
+        {
+            /* Never overlaps forward: every byte written was read before */
+            memmove(folded + written, text + position, length);
+            written += length;
+        }
+        position += length;
+    }
+    folded[written] = '\0';
+    return written;
+}
+
+
+/**
+ * @brief Initializes an empty index.
+ */
+void nameIndexInit(NameIndex_t *index)
+{
+    memset(index, 0, sizeof(*index));
+    index->change_count = NAME_NEVER_BUILT;
+}
+
+
+/**
+ * @brief Frees the memory of an index and leaves it empty.
+ */
+void nameIndexFree(NameIndex_t *index)
+{
+    free((void *)index->employees);
+    free(index->name_offsets);
+    free(index->text);
+    free(index->tokens);
+    free(index->names);
+    free(index->renamed);
+    free(index->renamed_employees);
+    free(index->renamed_names);
+    nameIndexInit(index);
+}
+
+
+/**
+ * @brief Builds the index from the stored employees, replacing its content.
+ */
+ManageStatus_t nameIndexBuild(NameIndex_t *index)
+{
+    uint32_t count = getTotalEmployees();   /* Number of employees to index */
+    const Employee_t *employee = NULL;      /* Current employee */
+    const int8_t *name = NULL;              /* Folded name of the current employee */
+    NameToken_t *scratch = NULL;            /* Second buffer of the radix sort */
+    int8_t *text = NULL;                    /* Folded names, shrunk once they are all known */
+    uint64_t token_count = 0;               /* Number of words of all names */
+    uint32_t length = 0;                    /* Length of the current folded name */
+    uint32_t token = 0;                     /* Next token to fill */
+    uint32_t name_count = 0;                /* Next first word to fill */
+    uint32_t i = 0;                         /* Index for looping through employees and tokens */
+    uint32_t j = 0;                         /* Position in the current name */
+
+    PERF_START(perf_start);
+    nameIndexFree(index);
+    /* A folded name is never longer than the name, so the text fits in one allocation */
+    index->employees = malloc((count > 0 ? count : 1) * sizeof(*index->employees));
+    index->name_offsets = malloc((count > 0 ? count : 1) * sizeof(*index->name_offsets));
+    index->text = malloc((count > 0 ? (uint64_t)count : 1u) * NAME_FOLDED_LENGTH);
+    if (index->employees == NULL || index->name_offsets == NULL || index->text == NULL)
+    {
+        nameIndexFree(index);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+
+    /* Fold every name and count its words */
+    for (i = 0; i < count; i++)
+    {
+        employee = getEmployeeAt(i);
+        index->employees[i] = employee;
+        index->name_offsets[i] = index->text_length;
+        length = foldName(employee->name, index->text + index->text_length, NAME_FOLDED_LENGTH);
+        if (length > 0)
+        {
+            token_count += 1;
+            index->name_count += 1;
+            for (j = 0; j < length; j++)
+            {
+                token_count += (index->text[index->text_length + j] == ' ') ? 1u : 0u;
+            }
+        }
+        index->text_length += length + 1;
+    }
+    index->employee_count = count;
+    text = realloc(index->text, (index->text_length > 0) ? index->text_length : 1u);
+    if (text != NULL)
+    {
+        index->text = text;
+    }
+
+    if (token_count > 0xFFFFFFFFull)
+    {
+        nameIndexFree(index);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    index->token_count = (uint32_t)token_count;
+    index->tokens = malloc((token_count > 0 ? token_count : 1u) * sizeof(NameToken_t));
+    index->names = malloc((index->name_count > 0 ? index->name_count : 1u) * sizeof(NameToken_t));
+    scratch = malloc((token_count > 0 ? token_count : 1u) * sizeof(NameToken_t));
+    if (index->tokens == NULL || index->names == NULL || scratch == NULL)
+    {
+        free(scratch);
+        nameIndexFree(index);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+
+    /* One token per word, in store order so that equal texts stay in store order */
+    for (i = 0; i < count; i++)
+    {
+        name = index->text + index->name_offsets[i];
+        for (j = 0; name[j] != '\0'; j++)
+        {
+            if (j == 0 || name[j - 1] == ' ')
+            {
+                index->tokens[token].key = packPrefix(name + j);
+                index->tokens[token].employee = i;
+                index->tokens[token].start = j;
+                token++;
+            }
+        }
+    }
+    sortTokens(index, index->tokens, scratch, index->token_count, 0);
+    free(scratch);
+
+    /* The first words, in token order, are the names sorted by their full text */
+    for (i = 0; i < index->token_count; i++)
+    {
+        if (index->tokens[i].start == 0)
+        {
+            index->names[name_count++] = index->tokens[i];
+        }
+    }
+    index->change_count = getEmployeeChangeCount();
+    index->rename_count = getEmployeeRenameCount();
+    PERF_STOP(PERF_OP_BUILD_NAME_INDEX, perf_start);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Brings the index up to date with the stored employees.
+ *
+ * A renamed employee keeps its tokens, which searches skip, and gets one slot in the list of
+ * renamed names; renaming it again only folds its name into the same slot.
+ */
+ManageStatus_t nameIndexUpdate(NameIndex_t *index)
+{
+    const EmployeeRename_t *rename = NULL;  /* Current rename */
+    uint32_t count = getEmployeeRenameCount();  /* Number of renames listed by the store */
+    uint32_t position = 0;                  /* Position of the renamed employee in the index */
+    uint32_t slot = 0;                      /* Slot of the renamed employee in the list of renamed names */
+
+    if (index->change_count != getEmployeeChangeCount() || count < index->rename_count)
+    {
+        return nameIndexBuild(index);
+    }
+    if (index->rename_count == count)
+    {
+        return MANAGE_OK;
+    }
+    if (index->renamed == NULL)
+    {
+        index->renamed = calloc((index->employee_count > 0) ? index->employee_count : 1u, sizeof(*index->renamed));
+        index->renamed_employees = malloc(EMPLOYEE_RENAME_LOG_LENGTH * sizeof(*index->renamed_employees));
+        index->renamed_names = malloc((uint64_t)EMPLOYEE_RENAME_LOG_LENGTH * NAME_FOLDED_LENGTH);
+        if (index->renamed == NULL || index->renamed_employees == NULL || index->renamed_names == NULL)
+        {
+            /* A full build reads the new names as well */
+            return nameIndexBuild(index);
+        }
+    }
+
+    for (; index->rename_count < count; index->rename_count++)
+    {
+        rename = getEmployeeRename(index->rename_count);
+        position = findRenamedEmployee(index, rename, &slot);
+        if (position == index->employee_count)
+        {
+            return nameIndexBuild(index);
+        }
+        if (slot == index->renamed_count)
+        {
+            index->renamed[position] = 1;
+            index->renamed_employees[slot] = position;
+            index->renamed_count += 1;
+        }
+        foldName(rename->employee->name, index->renamed_names + (uint64_t)slot * NAME_FOLDED_LENGTH,
+                 NAME_FOLDED_LENGTH);
+    }
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Returns 1 if no employee was added, deleted or renamed since the index was built or updated, 0 otherwise.
+ */
+uint32_t nameIndexIsCurrent(const NameIndex_t *index)
+{
+    return (index->change_count == getEmployeeChangeCount() && index->rename_count == getEmployeeRenameCount())
+           ? 1u : 0u;
+}
+
+
+/**
+ * @brief Finds the employees whose name matches a query.
+ */
+uint32_t nameIndexSearch(const NameIndex_t *index, const int8_t *query, NameMatch_t match,
+                         const Employee_t **results, uint32_t max_results)
+{
+    int8_t folded[NAME_FOLDED_LENGTH];      /* The folded query, then its words */
+    int8_t *words[NAME_MAX_QUERY_WORDS];    /* Start of each word of the query */
+    uint32_t lengths[NAME_MAX_QUERY_WORDS]; /* Length of each word of the query */
+    const NameToken_t *token = NULL;        /* Current token of the rarest word */
+    const int8_t *name = NULL;              /* Folded name of the current token or renamed employee */
+    uint32_t length = 0;                    /* Length of the folded query */
+    uint32_t word_count = 0;                /* Number of words of the query */
+    uint32_t rarest = 0;                    /* Word of the query starting the fewest tokens */
+    uint32_t first = 0;                     /* First token of a range */
+    uint32_t range = 0;                     /* Number of tokens of a range */
+    uint32_t rarest_first = 0;              /* First token of the rarest word */
+    uint32_t rarest_range = 0;              /* Number of tokens of the rarest word */
+    uint32_t found = 0;                     /* Number of results */
+    uint32_t matched = 0;                   /* Flag set while every word of the query is found */
+    uint32_t i = 0;                         /* Index for looping through tokens and words */
+    uint32_t w = 0;                         /* Index for looping through the words of the query */
+
+    PERF_START(perf_start);
+    length = foldName(query, folded, sizeof(folded));
+    if (length == 0 || max_results == 0)
+    {
+        return 0;
+    }
+
+    if (match == NAME_MATCH_PREFIX)
+    {
+        range = findRange(index, index->names, index->name_count, folded, length, &first);
+        for (i = first; i < first + range && found < max_results; i++)
+        {
+            if (isRenamed(index, index->names[i].employee) == 0)
+            {
+                results[found++] = index->employees[index->names[i].employee];
+            }
+        }
+        for (i = 0; i < index->renamed_count && found < max_results; i++)
+        {
+            name = index->renamed_names + (uint64_t)i * NAME_FOLDED_LENGTH;
+            if (strncmp((const char *)name, (const char *)folded, length) == 0)
+            {
+                results[found++] = index->employees[index->renamed_employees[i]];
+            }
+        }
+        PERF_STOP(PERF_OP_SEARCH_NAMES, perf_start);
+        return found;
+    }
+
+    /* Split the query into words, each terminated for packPrefix() */
+    for (i = 0; i < length; i++)
+    {
+        if (i == 0 || folded[i - 1] == ' ')
+        {
+            words[word_count++] = folded + i;
+        }
+    }
+    for (w = 0; w < word_count; w++)
+    {
+        lengths[w] = (uint32_t)strcspn((const char *)words[w], " ");
+        words[w][lengths[w]] = '\0';
+    }
+
+    /* Scan the tokens of the word that starts the fewest, checking the other words by name */
+    for (w = 0; w < word_count; w++)
+    {
+        range = findRange(index, index->tokens, index->token_count, words[w], lengths[w], &first);
+        if (w == 0 || range < rarest_range)
+        {
+            rarest = w;
+            rarest_first = first;
+            rarest_range = range;
+        }
+        if (range == 0)
+        {
+            /* No token matches the word, only renamed names may */
+            break;
+        }
+    }
+    for (i = rarest_first; i < rarest_first + rarest_range && found < max_results; i++)
+    {
+        token = &index->tokens[i];
+        if (isRenamed(index, token->employee) != 0)
+        {
+            continue;
+        }
+        name = index->text + index->name_offsets[token->employee];
+        /* Several words of a name may start with the word: only the first one counts */
+        if (findWord(name, words[rarest], lengths[rarest]) != token->start + 1)
+        {
+            continue;
+        }
+        matched = 1;
+        for (w = 0; w < word_count && matched != 0; w++)
+        {
+            if (w != rarest && findWord(name, words[w], lengths[w]) == 0)
+            {
+                matched = 0;
+            }
+        }
+        if (matched != 0)
+        {
+            results[found++] = index->employees[token->employee];
+        }
+    }
+    for (i = 0; i < index->renamed_count && found < max_results; i++)
+    {
+        name = index->renamed_names + (uint64_t)i * NAME_FOLDED_LENGTH;
+        matched = 1;
+        for (w = 0; w < word_count && matched != 0; w++)
+        {
+            if (findWord(name, words[w], lengths[w]) == 0)
+            {
+                matched = 0;
+            }
+        }
+        if (matched != 0)
+        {
+            results[found++] = index->employees[index->renamed_employees[i]];
+        }
+    }
+    PERF_STOP(PERF_OP_SEARCH_NAMES, perf_start);
+    return found;
+}
+
+
+/**
+ * @brief Returns the number of bytes allocated by an index.
+ */
+uint64_t nameIndexMemoryUsage(const NameIndex_t *index)
+{
+    uint64_t bytes = (uint64_t)index->employee_count * (sizeof(*index->employees) + sizeof(*index->name_offsets))
+                     + index->text_length + ((uint64_t)index->token_count + index->name_count) * sizeof(NameToken_t);
+
+    if (index->renamed != NULL)
+    {
+        bytes += (uint64_t)index->employee_count * sizeof(*index->renamed)
+                 + (uint64_t)EMPLOYEE_RENAME_LOG_LENGTH * (sizeof(*index->renamed_employees) + NAME_FOLDED_LENGTH);
+    }
+    return bytes;
+}
+
+
+/**
+ * @brief Prompts the user for a name and shows the matching employees.
+ */
+void searchEmployeesByName()
+{
+    char query[NAME_QUERY_LENGTH];          /* Name entered by the user */
+    int8_t folded[NAME_FOLDED_LENGTH];      /* Folded name, to reject a blank query */
+    const Employee_t *results[NAME_SHOWN_RESULTS];  /* Matching employees */
+    struct timespec start;                  /* Time the build or the search started */
+    struct timespec end;                    /* Time the build or the search ended */
+    uint32_t rebuild = 0;                   /* Flag set if the index is built, not only updated */
+    int8_t choice = 0;                      /* Kind of search chosen by the user */
+    uint32_t count = 0;                     /* Number of matching employees */
+    uint32_t i = 0;                         /* Index for looping through results */
+
+    if (getTotalEmployees() == 0)
+    {
+        printf("No employee to search!!!\n");
+        return;
+    }
+    if (name_index_ready == 0)
+    {
+        nameIndexInit(&name_index);
+        name_index_ready = 1;
+    }
+    if (nameIndexIsCurrent(&name_index) == 0)
+    {
+        rebuild = (name_index.change_count != getEmployeeChangeCount()) ? 1u : 0u;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (nameIndexUpdate(&name_index) != MANAGE_OK)
+        {
+            printf("Not enough memory to build the name index!!!\n");
+            return;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+    }
+    if (rebuild != 0)
+    {
+        printf("Indexed %s names", formatNumberWithCommas(name_index.employee_count));
+        printf(" (%s words) in %.2f s\n", formatNumberWithCommas(name_index.token_count),
+               (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+    }
+
+    printf("Enter 'f' to search by the start of the full name or 'w' by words of the name: ");
+    choice = getSingleCharInput();
+    if (choice != 'f' && choice != 'w')
+    {
+        printf("Input is not valid!!!\n");
+        return;
+    }
+    do
+    {
+        printf("Enter name (accents may be left out): ");
+        fflush(stdin);
+        if (fgets(query, sizeof(query), stdin) == NULL)
+        {
+            return;
+        }
+        query[strcspn(query, "\r\n")] = '\0';
+        if (foldName((const int8_t *)query, folded, sizeof(folded)) == 0)
+        {
+            printf("\nYou must not leave blank this information ...\n");
+            printf("\nPlease enter again ...\n");
+        }
+    } while (folded[0] == '\0');
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    count = nameIndexSearch(&name_index, (const int8_t *)query, (choice == 'f') ? NAME_MATCH_PREFIX : NAME_MATCH_WORDS,
+                            results, NAME_SHOWN_RESULTS);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (count == 0)
+    {
+        printf("No employee found!!!\n");
+        return;
+    }
+    for (i = 0; i < count; i++)
+    {
+        printf("----\n");
+        printf("Employee's ID: %s\n", results[i]->id);
+        printf("Department's ID: %s\n", results[i]->department_id);
+        printf("Name: %s\n", results[i]->name);
+    }
+    printf("----\n");
+    printf("Found %u employees in %.1f us", count,
+           (double)(end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3);
+    printf("%s\n", (count == NAME_SHOWN_RESULTS) ? " (only the first ones are shown)" : "");
+}
+
+
+/**
+ * @brief Decodes the UTF-8 character at the start of a text.
+ *
+ * @param text The text.
+ * @param code_point Receives the character.
+ * @return Number of bytes of the character, 0 if the bytes are not UTF-8.
+ */
+static uint32_t decodeUtf8(const uint8_t *text, uint32_t *code_point)
+{
+    uint32_t length = 0;                    /* Number of bytes of the character */
+    uint32_t value = 0;                     /* Bits of the character read so far */
+    uint32_t i = 0;                         /* Index for looping through continuation bytes */
+
+    if (text[0] < 0x80u)
+    {
+        *code_point = text[0];
+        return 1;
+    }
+    if (text[0] >= 0xC2u && text[0] <= 0xDFu)
+    {
+        length = 2;
+        value = text[0] & 0x1Fu;
+    }
+    else if (text[0] >= 0xE0u && text[0] <= 0xEFu)
+    {
+        length = 3;
+        value = text[0] & 0x0Fu;
+    }
+    else if (text[0] >= 0xF0u && text[0] <= 0xF4u)
+    {
+        length = 4;
+        value = text[0] & 0x07u;
+    }
+    else
+    {
+        return 0;
+    }
+    /* A terminator is not a continuation byte, so nothing is read past the end */
+    for (i = 1; i < length; i++)
+    {
+        if ((text[i] & 0xC0u) != 0x80u)
+        {
+            return 0;
+        }
+        value = (value << 6) | (text[i] & 0x3Fu);
+    }
+    *code_point = value;
+    return length;
+}
+
+
+/**
+ * @brief Returns the letter a character folds to, or 0 if the character is kept as it is.
+ *
+ * Covers Latin-1 and every letter of the Vietnamese alphabet, precomposed with its tone.
+ */
+static int8_t foldCodePoint(uint32_t code_point)
+{
+    if (code_point >= 0xC0u && code_point <= 0xFFu)
+    {
+        return (latin1_letters[code_point - 0xC0u] != '.') ? (int8_t)latin1_letters[code_point - 0xC0u] : 0;
+    }
+    switch (code_point)
+    {
+        case 0x102u: case 0x103u:           /* Ă ă */
+            return 'a';
+        case 0x110u: case 0x111u:           /* Đ đ */
+            return 'd';
+        case 0x128u: case 0x129u:           /* Ĩ ĩ */
+            return 'i';
+        case 0x168u: case 0x169u:           /* Ũ ũ */
+        case 0x1AFu: case 0x1B0u:           /* Ư ư */
+            return 'u';
+        case 0x1A0u: case 0x1A1u:           /* Ơ ơ */
+            return 'o';
+        default:
+            break;
+    }
+    /* Latin Extended Additional: the Vietnamese vowels with a tone, grouped by vowel */
+    if (code_point >= 0x1EA0u && code_point <= 0x1EF9u)
+    {
+        if (code_point <= 0x1EB7u)
+        {
+            return 'a';
+        }
+        if (code_point <= 0x1EC7u)
+        {
+            return 'e';
+        }
+        if (code_point <= 0x1ECBu)
+        {
+            return 'i';
+        }
+        if (code_point <= 0x1EE3u)
+        {
+            return 'o';
+        }
+        if (code_point <= 0x1EF1u)
+        {
+            return 'u';
+        }
+        return 'y';
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Packs the first 8 bytes of a string so that the numbers compare like the strings.
+ */
+static uint64_t packPrefix(const int8_t *text)
+{
+    uint64_t value = 0;                     /* Packed bytes, first byte most significant */
+    uint32_t ended = 0;                     /* Flag set after the terminator */
+    uint32_t i = 0;                         /* Position in the string */
+
+    for (i = 0; i < 8; i++)
+    {
+        if (ended == 0 && text[i] == '\0')
+        {
+            ended = 1;
+        }
+        value = (value << 8) | ((ended == 0) ? (uint8_t)text[i] : 0u);
+    }
+    return value;
+}
+
+
+/**
+ * @brief Returns the folded text of a name from a token's word to the end of the name.
+ */
+static const int8_t* tokenText(const NameIndex_t *index, const NameToken_t *token)
+{
+    return index->text + index->name_offsets[token->employee] + token->start;
+}
+
+
+/**
+ * @brief Sorts tokens whose texts agree on their first depth bytes, on the rest of the text.
+ *
+ * The keys of the tokens must hold the 8 bytes from depth on; they are left that way.
+ */
+static void sortTokens(const NameIndex_t *index, NameToken_t *tokens, NameToken_t *scratch, uint32_t count,
+                       uint32_t depth)
+{
+    NameToken_t *sorted = NULL;             /* Buffer holding the sorted tokens */
+    uint64_t key = 0;                       /* Key of the current run */
+    uint32_t run_start = 0;                 /* First token of the current run */
+    uint32_t i = 0;                         /* End of the current run */
+    uint32_t j = 0;                         /* Index for looping through the tokens of a run */
+
+    if (count <= NAME_INSERTION_THRESHOLD)
+    {
+        insertionSort(index, tokens, count, depth);
+        return;
+    }
+    sorted = radixSort(tokens, scratch, count);
+    if (sorted != tokens)
+    {
+        memcpy(tokens, sorted, (size_t)count * sizeof(NameToken_t));
+    }
+
+    /* Runs that agree on 8 more bytes and go on past them are sorted on the next 8 bytes */
+    for (run_start = 0; run_start < count; run_start = i)
+    {
+        key = tokens[run_start].key;
+        for (i = run_start + 1; i < count && tokens[i].key == key; i++)
+        {
+        }
+        if (i - run_start > 1 && (key & 0xFFu) != 0 && depth + 8 < NAME_FOLDED_LENGTH)
+        {
+            for (j = run_start; j < i; j++)
+            {
+                tokens[j].key = packPrefix(tokenText(index, &tokens[j]) + depth + 8);
+            }
+            sortTokens(index, tokens + run_start, scratch, i - run_start, depth + 8);
+            /* Give the run back the key of this depth, used by the searches at depth 0 */
+            for (j = run_start; j < i; j++)
+            {
+                tokens[j].key = key;
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Stable least-significant-digit radix sort of tokens by key.
+ *
+ * @return The buffer (tokens or scratch) that holds the sorted tokens.
+ */
+static NameToken_t* radixSort(NameToken_t *tokens, NameToken_t *scratch, uint32_t count)
+{
+    uint32_t counts[NAME_RADIX_PASSES][NAME_RADIX_BUCKETS];    /* Keys per byte of each pass */
+    NameToken_t *source = tokens;           /* Tokens read by the current pass */
+    NameToken_t *target = scratch;          /* Tokens written by the current pass */
+    NameToken_t *swap = NULL;               /* Temporary pointer to exchange the buffers */
+    uint32_t offset = 0;                    /* Next position of the current bucket */
+    uint32_t total = 0;                     /* Number of tokens in the buckets before the current one */
+    uint32_t shift = 0;                     /* Position of the pass's byte in the key */
+    uint32_t pass = 0;                      /* Index for looping through passes */
+    uint32_t i = 0;                         /* Index for looping through tokens and buckets */
+
+    /* One read counts the bytes of every pass */
+    memset(counts, 0, sizeof(counts));
+    for (i = 0; i < count; i++)
+    {
+        for (pass = 0; pass < NAME_RADIX_PASSES; pass++)
+        {
+            counts[pass][(tokens[i].key >> (pass * NAME_RADIX_BITS)) & (NAME_RADIX_BUCKETS - 1)] += 1;
+        }
+    }
+
+    for (pass = 0; pass < NAME_RADIX_PASSES; pass++)
+    {
+        shift = pass * NAME_RADIX_BITS;
+        /* Every key has the same byte here: the pass would not move anything */
+        if (counts[pass][(source[0].key >> shift) & (NAME_RADIX_BUCKETS - 1)] == count)
+        {
+            continue;
+        }
+        total = 0;
+        for (i = 0; i < NAME_RADIX_BUCKETS; i++)
+        {
+            offset = counts[pass][i];
+            counts[pass][i] = total;
+            total += offset;
+        }
+        for (i = 0; i < count; i++)
+        {
+            target[counts[pass][(source[i].key >> shift) & (NAME_RADIX_BUCKETS - 1)]++] = source[i];
+        }
+        swap = source;
+        source = target;
+        target = swap;
+    }
+    return source;
+}
+
+
+/**
+ * @brief Stable insertion sort of a few tokens on their text from depth on.
+ */
+static void insertionSort(const NameIndex_t *index, NameToken_t *tokens, uint32_t count, uint32_t depth)
+{
+    NameToken_t moving;                     /* Token being inserted */
+    const int8_t *text = NULL;              /* Text of the token being inserted */
+    uint32_t i = 0;                         /* Index for looping through tokens */
+    uint32_t j = 0;                         /* Position the token is inserted at */
+
+    for (i = 1; i < count; i++)
+    {
+        moving = tokens[i];
+        text = tokenText(index, &moving) + depth;
+        for (j = i; j > 0 && strcmp((const char *)(tokenText(index, &tokens[j - 1]) + depth),
+                                    (const char *)text) > 0; j--)
+        {
+            tokens[j] = tokens[j - 1];
+        }
+        tokens[j] = moving;
+    }
+}
+
+
+/**
+ * @brief Compares the start of a token's text with a prefix.
+ *
+ * @param index The index.
+ * @param token The token.
+ * @param prefix The prefix, at least 1 byte long.
+ * @param length Length of the prefix.
+ * @param prefix_key packPrefix() of the prefix.
+ * @return Negative, 0 or positive if the token's text sorts before, starts with or sorts after the prefix.
+ */
+static int32_t comparePrefix(const NameIndex_t *index, const NameToken_t *token, const int8_t *prefix,
+                             uint32_t length, uint64_t prefix_key)
+{
+    uint64_t key = token->key;              /* The bytes of the token compared with the prefix */
+
+    if (length < 8)
+    {
+        key &= ~0ull << (8 * (8 - length));
+    }
+    if (key != prefix_key)
+    {
+        return (key < prefix_key) ? -1 : 1;
+    }
+    if (length <= 8)
+    {
+        return 0;
+    }
+    return (int32_t)strncmp((const char *)(tokenText(index, token) + 8), (const char *)(prefix + 8), length - 8);
+}
+
+
+/**
+ * @brief Finds the sorted tokens whose text starts with a prefix.
+ *
+ * @param first Receives the first of them.
+ * @return Number of tokens.
+ */
+static uint32_t findRange(const NameIndex_t *index, const NameToken_t *tokens, uint32_t count,
+                          const int8_t *prefix, uint32_t length, uint32_t *first)
+{
+    uint64_t prefix_key = packPrefix(prefix);   /* Packed first bytes of the prefix */
+    uint32_t low = 0;                       /* First candidate position */
+    uint32_t high = count;                  /* Position after the last candidate */
+    uint32_t middle = 0;                    /* Position compared */
+    uint32_t start = 0;                     /* First token not before the prefix */
+
+    /* First token that does not sort before the prefix */
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+        if (comparePrefix(index, &tokens[middle], prefix, length, prefix_key) < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    start = low;
+    /* First token after the ones that start with the prefix */
+    high = count;
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+        if (comparePrefix(index, &tokens[middle], prefix, length, prefix_key) <= 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    *first = start;
+    return low - start;
+}
+
+
+/**
+ * @brief Finds the position in the index of a renamed employee.
+ *
+ * An employee renamed before is found in the list of renamed names, any other one among the
+ * names that fold like its old name.
+ *
+ * @param slot Receives the slot of the employee in the list of renamed names, renamed_count if
+ *        it is not listed yet.
+ * @return Position of the employee in index->employees, employee_count if it is not indexed.
+ */
+static uint32_t findRenamedEmployee(const NameIndex_t *index, const EmployeeRename_t *rename, uint32_t *slot)
+{
+    int8_t folded[NAME_FOLDED_LENGTH];      /* The folded old name */
+    uint32_t length = 0;                    /* Length of the folded old name */
+    uint32_t first = 0;                     /* First name that starts with the old name */
+    uint32_t range = 0;                     /* Number of names that start with the old name */
+    uint32_t i = 0;                         /* Index for looping through names and employees */
+
+    for (*slot = 0; *slot < index->renamed_count; *slot += 1)
+    {
+        if (index->employees[index->renamed_employees[*slot]] == rename->employee)
+        {
+            return index->renamed_employees[*slot];
+        }
+    }
+    length = foldName(rename->old_name, folded, sizeof(folded));
+    if (length > 0)
+    {
+        range = findRange(index, index->names, index->name_count, folded, length, &first);
+        for (i = first; i < first + range; i++)
+        {
+            if (index->employees[index->names[i].employee] == rename->employee)
+            {
+                return index->names[i].employee;
+            }
+        }
+    }
+    /* A name that folds to nothing has no token */
+    for (i = 0; i < index->employee_count; i++)
+    {
+        if (index->employees[i] == rename->employee)
+        {
+            return i;
+        }
+    }
+    return index->employee_count;
+}
+
+
+/**
+ * @brief Returns 1 if the tokens of an indexed employee are replaced by a renamed name, 0 otherwise.
+ */
+static uint32_t isRenamed(const NameIndex_t *index, uint32_t employee)
+{
+    return (index->renamed != NULL && index->renamed[employee] != 0) ? 1u : 0u;
+}
+
+
+/**
+ * @brief Finds the first word of a folded name that starts with a given word.
+ *
+ * @return Offset of that word plus one, 0 if no word of the name starts with it.
+ */
+static uint32_t findWord(const int8_t *name, const int8_t *word, uint32_t length)
+{
+    uint32_t i = 0;                         /* Position in the name */
+
+    for (i = 0; name[i] != '\0'; i++)
+    {
+        if ((i == 0 || name[i - 1] == ' ') && strncmp((const char *)(name + i), (const char *)word, length) == 0)
+        {
+            return i + 1;
+        }
+    }
+    return 0;
+} /* EOF */
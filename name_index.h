@@ -0,0 +1,159 @@
+/**
+ * @file name_index.h
+ * @brief This file contains the function prototypes of the search index over employee names.
+ *
+ * Names are compared in folded form: Vietnamese (and other Latin) letters lose their
+ * diacritics, "đ" becomes "d", letters are lower case and the words are separated by single
+ * blanks, so "Nguyễn  Văn A", "NGUYEN VAN A" and "nguyen van a" are the same name. Names are
+ * read as UTF-8, precomposed or with combining marks.
+ *
+ * Every word of every folded name is a token, kept in an array sorted by the folded text from
+ * the word to the end of the name (a suffix array restricted to word starts). The tokens that
+ * start with a given prefix are then one contiguous range, found by two binary searches. The
+ * first 8 bytes of each token are packed into a number, so most steps of a search compare
+ * numbers without reading the names.
+ *
+ * Two searches are offered:
+ * - NAME_MATCH_PREFIX: the full name starts with the query ("nguyen van" finds "Nguyễn Văn A").
+ * - NAME_MATCH_WORDS: every word of the query starts a word of the name, in any order, so a
+ *   family name, a given name or both find the employee ("an nguy" finds "Nguyễn Văn An").
+ *
+ * The index holds pointers to the store records: it is built from the store and must be
+ * built again once getEmployeeChangeCount() changes (see nameIndexIsCurrent()). Renames
+ * listed by getEmployeeRename() do not rebuild it: the old tokens of a renamed employee are
+ * skipped and its new name is kept in a short list that every search also reads.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for Employee_t and ManageStatus_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define NAME_FOLDED_LENGTH MAX_NAME_LENGTH  /* Size of a folded name, a name never grows when folded */
+
+/**
+ * @brief Kinds of name search.
+ */
+typedef enum NameMatch {
+    NAME_MATCH_PREFIX = 0,                  /* The full name starts with the query */
+    NAME_MATCH_WORDS                        /* Every word of the query starts a word of the name */
+} NameMatch_t;
+
+/**
+ * @brief One word of an indexed name.
+ */
+typedef struct NameToken {
+    uint64_t key;                           /* First 8 bytes from the word on, first byte most significant */
+    uint32_t employee;                      /* Position of the employee in NameIndex_t.employees */
+    uint32_t start;                         /* Offset of the word in the folded name */
+} NameToken_t;
+
+/**
+ * @brief Search index over the names of the stored employees.
+ */
+typedef struct NameIndex {
+    const Employee_t **employees;           /* Indexed employees, in store order when built */
+    uint64_t *name_offsets;                 /* Offset of the folded name of each employee in text */
+    int8_t *text;                           /* Folded names, each terminated by '\0' */
+    NameToken_t *tokens;                    /* Every word of every name, sorted by the text from the word on */
+    NameToken_t *names;                     /* The first word of every name, sorted by the full name */
+    uint32_t employee_count;                /* Number of indexed employees */
+    uint32_t token_count;                   /* Number of tokens */
+    uint32_t name_count;                    /* Number of names that are not empty once folded */
+    uint64_t text_length;                   /* Number of bytes of text */
+    uint64_t change_count;                  /* getEmployeeChangeCount() when the index was built */
+    uint8_t *renamed;                       /* Flag per indexed employee whose tokens are skipped, NULL before the first rename */
+    uint32_t *renamed_employees;            /* Renamed employees, positions in employees, EMPLOYEE_RENAME_LOG_LENGTH slots */
+    int8_t *renamed_names;                  /* Folded new name of each renamed employee, NAME_FOLDED_LENGTH bytes each */
+    uint32_t renamed_count;                 /* Number of renamed employees */
+    uint32_t rename_count;                  /* getEmployeeRenameCount() when the renames were last read */
+} NameIndex_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Folds a name for comparison: no diacritics, lower case, words separated by one blank.
+ *
+ * Characters other than letters and digits separate words. Characters without a folded form
+ * are kept as they are, bytes that are not valid UTF-8 included.
+ *
+ * @param name The name, terminated by '\0'.
+ * @param folded Receives the folded name, terminated by '\0'; may be name itself.
+ * @param size Size of folded; a longer result is cut at a character boundary.
+ * @return Length of the folded name.
+ */
+uint32_t foldName(const int8_t *name, int8_t *folded, uint32_t size);
+
+/**
+ * @brief Initializes an empty index.
+ */
+void nameIndexInit(NameIndex_t *index);
+
+/**
+ * @brief Frees the memory of an index and leaves it empty.
+ */
+void nameIndexFree(NameIndex_t *index);
+
+/**
+ * @brief Builds the index from the stored employees, replacing its content.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_NO_MEMORY (the index is then empty).
+ */
+ManageStatus_t nameIndexBuild(NameIndex_t *index);
+
+/**
+ * @brief Brings the index up to date with the stored employees.
+ *
+ * The index is built again if employees were added or deleted since it was built; otherwise
+ * only the employees renamed since the last update are changed.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_NO_MEMORY (the index is then empty).
+ */
+ManageStatus_t nameIndexUpdate(NameIndex_t *index);
+
+/**
+ * @brief Returns 1 if no employee was added, deleted or renamed since the index was built or updated, 0 otherwise.
+ */
+uint32_t nameIndexIsCurrent(const NameIndex_t *index);
+
+/**
+ * @brief Finds the employees whose name matches a query.
+ *
+ * The query is folded like the names, so it may be typed with or without accents. An
+ * employee is returned once even if several of its words match.
+ *
+ * @param index The index, which must be current.
+ * @param query The text to look for.
+ * @param match How the query is matched.
+ * @param results Receives the matching employees.
+ * @param max_results Largest number of results; the search stops there.
+ * @return Number of results, 0 if the query is empty once folded.
+ */
+uint32_t nameIndexSearch(const NameIndex_t *index, const int8_t *query, NameMatch_t match,
+                         const Employee_t **results, uint32_t max_results);
+
+/**
+ * @brief Returns the number of bytes allocated by an index.
+ */
+uint64_t nameIndexMemoryUsage(const NameIndex_t *index);
+
+/**
+ * @brief Prompts the user for a name and shows the matching employees.
+ *
+ * The index is built on the first search and again after employees are added or deleted;
+ * renamed employees are updated in place.
+ */
+void searchEmployeesByName();
+
+#endif /* NAME_INDEX_H */
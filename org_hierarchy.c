@@ -0,0 +1,884 @@
+/**
+ * @file org_hierarchy.c
+ * @brief This file contains the implementation of the manager to report hierarchy and its payroll totals.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdio.h>              /* Include standard input and output library for printf, FILE, ... */
+#include <stdlib.h>             /* Include standard library for malloc, realloc, free */
+#include <string.h>             /* Include string manipulation library for strlen, memcpy, memset */
+#include "org_hierarchy.h"      /* Include header file */
+#include "input_handler.h"      /* Include input handler header file for handling user input */
+#include "payroll_stream.h"     /* Include payroll stream header file for reading the payroll in batches */
+#include "perf_stats.h"         /* Include instrumentation header file for measuring hot operations */
+#include "tenant_store.h"       /* Include tenant store header file for the hierarchy of the selected company */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define ORG_MIN_NODES 64u                   /* Initial number of allocated nodes */
+#define ORG_LINE_LENGTH (2 * MAX_ID_LENGTH + 16)   /* Longest line of a links file */
+
+/**
+ * @brief State of orgHierarchySyncStore() while it walks the store.
+ */
+typedef struct OrgSyncContext {
+    OrgHierarchy_t *hierarchy;              /* The hierarchy being updated */
+    uint8_t *seen;                          /* Per node present before the walk, 1 if the employee is stored */
+    uint32_t known;                         /* Number of nodes before the walk */
+    uint32_t added;                         /* Number of employees added */
+    ManageStatus_t status;                  /* First error of the walk */
+} OrgSyncContext_t;
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static const int8_t* nodeKey(uint32_t value, const void *context);
+static uint32_t findNode(const OrgHierarchy_t *hierarchy, const int8_t *employee_id, uint32_t *node);
+static void setNodePayroll(OrgHierarchy_t *hierarchy, uint32_t node, const OrgTotals_t *own);
+static void removeNode(OrgHierarchy_t *hierarchy, uint32_t node);
+static ManageStatus_t layOut(OrgHierarchy_t *hierarchy);
+static void treeAdd(OrgTotals_t *tree, uint32_t size, uint32_t position, const OrgTotals_t *delta);
+static void treePrefix(const OrgTotals_t *tree, uint32_t end, OrgTotals_t *sum);
+static void salaryToTotals(const SalaryBreakdown_t *salary, OrgTotals_t *own);
+static uint32_t syncLines(const PayrollLine_t *lines, uint32_t count, void *context);
+static void addLinkLine(OrgHierarchy_t *hierarchy, int8_t *line, uint64_t line_number, OrgLinkReport_t *report);
+static void rejectLinkLine(OrgLinkReport_t *report, uint64_t line_number);
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Initializes an empty hierarchy.
+ */
+void orgHierarchyInit(OrgHierarchy_t *hierarchy)
+{
+    memset(hierarchy, 0, sizeof(*hierarchy));
+    idIndexInit(&hierarchy->by_id, nodeKey, hierarchy);
+}
+
+
+/**
+ * @brief Frees all memory of a hierarchy and leaves it empty.
+ */
+void orgHierarchyFree(OrgHierarchy_t *hierarchy)
+{
+    uint32_t i = 0;                         /* Index for looping through nodes */
+
+    for (i = 0; i < hierarchy->node_count; i++)
+    {
+        free(hierarchy->nodes[i].id);
+    }
+    free(hierarchy->nodes);
+    free(hierarchy->tree);
+    idIndexFree(&hierarchy->by_id);
+    orgHierarchyInit(hierarchy);
+}
+
+
+/**
+ * @brief Adds an employee.
+ *
+ * The new employee has no place in the layout yet, so the layout is marked as stale.
+ */
+ManageStatus_t orgHierarchyAdd(OrgHierarchy_t *hierarchy, const int8_t *employee_id, const int8_t *manager_id,
+                               const OrgTotals_t *own)
+{
+    OrgNode_t *grown = NULL;                /* Reallocated node array */
+    OrgNode_t *node = NULL;                 /* New node */
+    uint32_t new_capacity = 0;              /* Number of nodes after growing */
+    uint32_t manager = ORG_NO_MANAGER;      /* Node of the manager */
+    uint32_t existing = 0;                  /* Node of an employee with the same ID */
+
+    if (employee_id == NULL || employee_id[0] == '\0' || strlen(employee_id) >= MAX_ID_LENGTH)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    if (findNode(hierarchy, employee_id, &existing) == 1)
+    {
+        return MANAGE_ERR_DUPLICATE_ID;
+    }
+    if (manager_id != NULL && manager_id[0] != '\0' && findNode(hierarchy, manager_id, &manager) == 0)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    if (hierarchy->node_count == hierarchy->node_capacity)
+    {
+        new_capacity = (hierarchy->node_capacity == 0) ? ORG_MIN_NODES : hierarchy->node_capacity * 2;
+        grown = realloc(hierarchy->nodes, (size_t)new_capacity * sizeof(*grown));
+        if (grown == NULL)
+        {
+            return MANAGE_ERR_NO_MEMORY;
+        }
+        hierarchy->nodes = grown;
+        hierarchy->node_capacity = new_capacity;
+    }
+
+    node = &hierarchy->nodes[hierarchy->node_count];
+    memset(node, 0, sizeof(*node));
+    node->id = malloc(strlen(employee_id) + 1);
+    if (node->id == NULL)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    strcpy(node->id, employee_id);
+    if (idIndexInsert(&hierarchy->by_id, node->id, hierarchy->node_count) != MANAGE_OK)
+    {
+        free(node->id);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    node->manager = manager;
+    node->active = 1;
+    node->own = *own;
+    node->own.employees = 1;
+    hierarchy->node_count += 1;
+    hierarchy->layout_stale = 1;
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Removes an employee; the employee's reports then report to the employee's manager.
+ */
+ManageStatus_t orgHierarchyRemove(OrgHierarchy_t *hierarchy, const int8_t *employee_id)
+{
+    uint32_t node = 0;                      /* Node of the employee */
+
+    if (employee_id == NULL || findNode(hierarchy, employee_id, &node) == 0)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    removeNode(hierarchy, node);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Changes the manager of an employee.
+ */
+ManageStatus_t orgHierarchySetManager(OrgHierarchy_t *hierarchy, const int8_t *employee_id, const int8_t *manager_id)
+{
+    uint32_t node = 0;                      /* Node of the employee */
+    uint32_t manager = ORG_NO_MANAGER;      /* Node of the new manager */
+    uint32_t above = 0;                     /* Node walking up from the new manager */
+
+    if (employee_id == NULL || findNode(hierarchy, employee_id, &node) == 0)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    if (manager_id != NULL && manager_id[0] != '\0' && findNode(hierarchy, manager_id, &manager) == 0)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    /* The employee must not be the new manager or above it */
+    for (above = manager; above != ORG_NO_MANAGER; above = hierarchy->nodes[above].manager)
+    {
+        if (above == node)
+        {
+            return MANAGE_ERR_INVALID_ARGUMENT;
+        }
+    }
+    if (hierarchy->nodes[node].manager != manager)
+    {
+        hierarchy->nodes[node].manager = manager;
+        hierarchy->layout_stale = 1;
+    }
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Replaces the payroll of an employee, in O(log n).
+ */
+ManageStatus_t orgHierarchySetPayroll(OrgHierarchy_t *hierarchy, const int8_t *employee_id, const OrgTotals_t *own)
+{
+    uint32_t node = 0;                      /* Node of the employee */
+
+    if (employee_id == NULL || findNode(hierarchy, employee_id, &node) == 0)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    setNodePayroll(hierarchy, node, own);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Sums the headcount and payroll of an employee and of everyone under the employee.
+ */
+ManageStatus_t orgHierarchySubtree(OrgHierarchy_t *hierarchy, const int8_t *employee_id, OrgTotals_t *totals)
+{
+    OrgTotals_t before;                     /* Sums of the positions before the subtree */
+    uint32_t node = 0;                      /* Node of the employee */
+
+    if (hierarchy->layout_stale == 1 && layOut(hierarchy) != MANAGE_OK)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    if (employee_id == NULL || employee_id[0] == '\0')
+    {
+        treePrefix(hierarchy->tree, hierarchy->node_count, totals);
+        return MANAGE_OK;
+    }
+    if (findNode(hierarchy, employee_id, &node) == 0)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    treePrefix(hierarchy->tree, hierarchy->nodes[node].tour_end, totals);
+    treePrefix(hierarchy->tree, hierarchy->nodes[node].tour_start, &before);
+    totals->employees -= before.employees;
+    totals->gross -= before.gross;
+    totals->tax -= before.tax;
+    totals->net -= before.net;
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Brings the hierarchy in line with the store.
+ */
+ManageStatus_t orgHierarchySyncStore(OrgHierarchy_t *hierarchy, uint32_t *added, uint32_t *removed)
+{
+    OrgSyncContext_t context;               /* State of the walk through the store */
+    uint32_t removed_count = 0;             /* Number of removed employees */
+    uint32_t i = 0;                         /* Index for looping through nodes */
+
+    memset(&context, 0, sizeof(context));
+    context.hierarchy = hierarchy;
+    context.known = hierarchy->node_count;
+    context.status = MANAGE_OK;
+    context.seen = calloc((size_t)context.known + 1, sizeof(*context.seen));
+    if (context.seen == NULL)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+
+    forEachPayrollBatch(NULL, 0, PAYROLL_CURSOR_SALARY, syncLines, &context);
+    if (context.status == MANAGE_OK)
+    {
+        for (i = 0; i < context.known; i++)
+        {
+            if (hierarchy->nodes[i].active == 1 && context.seen[i] == 0)
+            {
+                removeNode(hierarchy, i);
+                removed_count += 1;
+            }
+        }
+    }
+    free(context.seen);
+
+    if (added != NULL)
+    {
+        *added = context.added;
+    }
+    if (removed != NULL)
+    {
+        *removed = removed_count;
+    }
+    return context.status;
+}
+
+
+/**
+ * @brief Sets managers from a file of "employee_id,manager_id" lines.
+ */
+ManageStatus_t orgHierarchyLoadLinks(OrgHierarchy_t *hierarchy, const char *path, OrgLinkReport_t *report)
+{
+    OrgLinkReport_t unused_report;          /* Report used when the caller does not want one */
+    int8_t line[ORG_LINE_LENGTH];           /* Line being read */
+    uint32_t length = 0;                    /* Number of characters in line */
+    int32_t character = 0;                  /* Character skipped at the end of a long line */
+    FILE *file = NULL;                      /* The links file */
+
+    if (report == NULL)
+    {
+        report = &unused_report;
+    }
+    memset(report, 0, sizeof(*report));
+    file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return MANAGE_ERR_IO;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        report->lines += 1;
+        length = (uint32_t)strlen(line);
+        if (length == sizeof(line) - 1 && line[length - 1] != '\n' && !feof(file))
+        {
+            /* Too long to hold two IDs: skip the rest of the line */
+            do
+            {
+                character = fgetc(file);
+            } while (character != '\n' && character != EOF);
+            rejectLinkLine(report, report->lines);
+            continue;
+        }
+        line[strcspn(line, "\r\n")] = '\0';
+        addLinkLine(hierarchy, line, report->lines, report);
+    }
+    if (ferror(file))
+    {
+        fclose(file);
+        return MANAGE_ERR_IO;
+    }
+    fclose(file);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Returns the number of bytes allocated by a hierarchy.
+ */
+uint64_t orgHierarchyMemoryUsage(const OrgHierarchy_t *hierarchy)
+{
+    uint64_t total = (uint64_t)hierarchy->node_capacity * sizeof(OrgNode_t) + idIndexMemoryUsage(&hierarchy->by_id);
+    uint32_t i = 0;                         /* Index for looping through nodes */
+
+    if (hierarchy->tree != NULL)
+    {
+        total += ((uint64_t)hierarchy->node_count + 1) * sizeof(OrgTotals_t);
+    }
+    for (i = 0; i < hierarchy->node_count; i++)
+    {
+        total += strlen(hierarchy->nodes[i].id) + 1;
+    }
+    return total;
+}
+
+
+/**
+ * @brief Lets the user load manager links, set a manager and show the totals under an employee.
+ *
+ * Each company has its own hierarchy. It is brought in line with the store first: new
+ * employees are added at the top level, deleted ones are removed and changed payrolls are updated.
+ */
+void manageOrganization()
+{
+    char path[260];                         /* File name entered by the user */
+    int8_t id[MAX_ID_LENGTH];               /* Employee's ID entered by the user */
+    int8_t buffer[MAX_ID_LENGTH + 2];       /* Optional ID entered by the user */
+    OrgLinkReport_t report;                 /* Result of loading links */
+    OrgTotals_t totals;                     /* Totals under the employee */
+    Tenant_t *tenant = getSelectedTenant(); /* Company the menu works on */
+    OrgHierarchy_t *organization = NULL;    /* Hierarchy of the company */
+    int8_t choice = 0;                      /* Action chosen by the user */
+    uint32_t start = 0;                     /* Offset of the optional ID in buffer */
+    uint32_t id_length = 0;                 /* Length of the optional ID */
+    uint32_t added = 0;                     /* Employees added by the sync */
+    uint32_t removed = 0;                   /* Employees removed by the sync */
+    ParseStatus_t parsed = PARSE_EMPTY;     /* Result of validating the optional ID */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the action */
+
+    if (tenant->organization == NULL)
+    {
+        tenant->organization = malloc(sizeof(*tenant->organization));
+        if (tenant->organization == NULL)
+        {
+            printf("Not enough memory to build the organization!!!\n");
+            return;
+        }
+        orgHierarchyInit(tenant->organization);
+    }
+    organization = tenant->organization;
+    if (orgHierarchySyncStore(organization, &added, &removed) != MANAGE_OK)
+    {
+        printf("Not enough memory to build the organization!!!\n");
+        return;
+    }
+    if (added > 0 || removed > 0)
+    {
+        printf("Organization updated: %u employees added at the top level, %u removed.\n", added, removed);
+    }
+
+    printf("Enter 'l' to load manager links, 'm' to set a manager or 's' to show totals: ");
+    choice = getSingleCharInput();
+    if (choice == 'l')
+    {
+        do
+        {
+            printf("Enter links file name (employee_id,manager_id per line): ");
+            fflush(stdin);
+            if (fgets(path, sizeof(path), stdin) == NULL)
+            {
+                return;
+            }
+            /* Remove newline character, spaces are allowed in file names */
+            path[strcspn(path, "\r\n")] = '\0';
+        } while (path[0] == '\0');
+
+        if (orgHierarchyLoadLinks(organization, path, &report) != MANAGE_OK)
+        {
+            printf("Cannot read file %s\n", path);
+            return;
+        }
+        printf("Set the manager of %u employees.\n", report.linked);
+        if (report.rejected > 0)
+        {
+            printf("Rejected %s lines, the first one is line %llu: unknown ID, invalid line or cycle.\n",
+                   formatNumberWithCommas(report.rejected), (unsigned long long)report.first_rejected_line);
+        }
+        return;
+    }
+    if (choice != 'm' && choice != 's')
+    {
+        printf("Input is not valid!!!\n");
+        return;
+    }
+
+    if (choice == 'm')
+    {
+        promptIdInput("Enter employee's ID: ", id, sizeof(id));
+    }
+    do
+    {
+        printf("%s", (choice == 'm') ? "Enter manager's ID (leave blank for top level): "
+                                     : "Enter employee's ID (leave blank for the whole organization): ");
+        fflush(stdin);
+        if (fgets(buffer, sizeof(buffer), stdin) == NULL)
+        {
+            buffer[0] = '\0';
+        }
+        parsed = parseIdField(buffer, (uint32_t)strlen(buffer), MAX_ID_LENGTH - 1, &start, &id_length);
+        if (parsed == PARSE_INVALID || parsed == PARSE_OUT_OF_RANGE)
+        {
+            printf("\nID must not contain spaces or be longer than %u characters !!!\n", MAX_ID_LENGTH - 1);
+        }
+    } while (parsed == PARSE_INVALID || parsed == PARSE_OUT_OF_RANGE);
+    memmove(buffer, buffer + start, id_length);
+    buffer[id_length] = '\0';
+
+    if (choice == 'm')
+    {
+        status = orgHierarchySetManager(organization, id, buffer);
+        if (status == MANAGE_OK)
+        {
+            printf("Manager of %s is now %s\n", id, (buffer[0] != '\0') ? (char *)buffer : "nobody (top level)");
+        }
+        else if (status == MANAGE_ERR_NOT_FOUND)
+        {
+            printf("Employee ID not found!!!\n");
+        }
+        else
+        {
+            printf("%s cannot report to %s: it would make a cycle!!!\n", id, buffer);
+        }
+        return;
+    }
+
+    status = orgHierarchySubtree(organization, buffer, &totals);
+    if (status == MANAGE_ERR_NOT_FOUND)
+    {
+        printf("Employee ID not found!!!\n");
+        return;
+    }
+    if (status != MANAGE_OK)
+    {
+        printf("Not enough memory to lay out the organization!!!\n");
+        return;
+    }
+    printf("Under %s: %llu employees\n", (buffer[0] != '\0') ? (char *)buffer : "the whole organization",
+           (unsigned long long)totals.employees);
+    printf("  Gross income: %s\n", formatNumberWithCommas(totals.gross));
+    printf("  Tax         : %s\n", formatNumberWithCommas(totals.tax));
+    printf("  Net salary  : %s\n", formatNumberWithCommas(totals.net));
+}
+
+
+/**
+ * @brief Returns the key of a node for the ID index.
+ */
+static const int8_t* nodeKey(uint32_t value, const void *context)
+{
+    return ((const OrgHierarchy_t *)context)->nodes[value].id;
+}
+
+
+/**
+ * @brief Looks up the node of an employee that is not removed.
+ *
+ * @return 1 if the employee is found, 0 otherwise.
+ */
+static uint32_t findNode(const OrgHierarchy_t *hierarchy, const int8_t *employee_id, uint32_t *node)
+{
+    return idIndexFind(&hierarchy->by_id, employee_id, node);
+}
+
+
+/**
+ * @brief Replaces the payroll of a node and, if the layout is current, updates the tree.
+ */
+static void setNodePayroll(OrgHierarchy_t *hierarchy, uint32_t node, const OrgTotals_t *own)
+{
+    OrgNode_t *entry = &hierarchy->nodes[node];    /* The node */
+    OrgTotals_t delta;                      /* Change of the payroll, modulo 2^64 */
+
+    delta.employees = 0;
+    delta.gross = own->gross - entry->own.gross;
+    delta.tax = own->tax - entry->own.tax;
+    delta.net = own->net - entry->own.net;
+    entry->own.gross = own->gross;
+    entry->own.tax = own->tax;
+    entry->own.net = own->net;
+    if (hierarchy->layout_stale == 0)
+    {
+        treeAdd(hierarchy->tree, hierarchy->node_count, entry->tour_start, &delta);
+    }
+}
+
+
+/**
+ * @brief Removes a node from the ID index and its payroll from the tree.
+ *
+ * The node keeps its place in the layout with nothing in it, so the ranges of its managers
+ * and of its reports stay valid until the next layout drops it.
+ */
+static void removeNode(OrgHierarchy_t *hierarchy, uint32_t node)
+{
+    OrgNode_t *entry = &hierarchy->nodes[node];    /* The node */
+    OrgTotals_t delta;                      /* Change of the totals, modulo 2^64 */
+
+    idIndexRemove(&hierarchy->by_id, entry->id);
+    entry->active = 0;
+    if (hierarchy->layout_stale == 0)
+    {
+        delta.employees = 0 - entry->own.employees;
+        delta.gross = 0 - entry->own.gross;
+        delta.tax = 0 - entry->own.tax;
+        delta.net = 0 - entry->own.net;
+        treeAdd(hierarchy->tree, hierarchy->node_count, entry->tour_start, &delta);
+    }
+}
+
+
+/**
+ * @brief Lays the hierarchy out again and rebuilds the tree, in O(n).
+ *
+ * Removed nodes are dropped and their reports attached to the nearest manager still present,
+ * then the nodes are numbered depth first, children in the order they were added, and the
+ * tree is built from the payroll of every position.
+ */
+static ManageStatus_t layOut(OrgHierarchy_t *hierarchy)
+{
+    OrgNode_t *nodes = hierarchy->nodes;    /* Nodes of the hierarchy */
+    OrgTotals_t *tree = NULL;               /* New Fenwick tree */
+    uint32_t *scratch = NULL;               /* Memory of the five arrays below */
+    uint32_t *remap = NULL;                 /* New index of every old node, then subtree sizes */
+    uint32_t *first = NULL;                 /* Start of the reports of every node in children */
+    uint32_t *fill = NULL;                  /* Next free place for a report of every node */
+    uint32_t *children = NULL;              /* Reports of every node, grouped by manager */
+    uint32_t *stack = NULL;                 /* Nodes waiting to be numbered */
+    uint32_t count = 0;                     /* Number of nodes still present */
+    uint32_t depth = 0;                     /* Number of nodes on the stack */
+    uint32_t position = 0;                  /* Next position of the layout */
+    uint32_t manager = 0;                   /* Manager of the current node */
+    uint32_t node = 0;                      /* Node being numbered */
+    uint32_t parent = 0;                    /* Tree entry covering the current one */
+    uint32_t i = 0;                         /* Index for looping through nodes */
+    uint32_t j = 0;                         /* Index for looping through reports */
+    PERF_START(perf_start);                 /* Start time of the layout */
+
+    scratch = malloc(((size_t)hierarchy->node_count * 5 + 1) * sizeof(*scratch));
+    tree = realloc(hierarchy->tree, ((size_t)hierarchy->node_count + 1) * sizeof(*tree));
+    if (scratch == NULL || tree == NULL)
+    {
+        free(scratch);
+        if (tree != NULL)
+        {
+            hierarchy->tree = tree;
+        }
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    hierarchy->tree = tree;
+    remap = scratch;
+    first = remap + hierarchy->node_count;
+    fill = first + hierarchy->node_count + 1;
+    children = fill + hierarchy->node_count;
+    stack = children + hierarchy->node_count;
+
+    /* Skip removed managers, then drop the removed nodes */
+    for (i = 0; i < hierarchy->node_count; i++)
+    {
+        manager = nodes[i].manager;
+        while (manager != ORG_NO_MANAGER && nodes[manager].active == 0)
+        {
+            manager = nodes[manager].manager;
+        }
+        nodes[i].manager = manager;
+    }
+    for (i = 0; i < hierarchy->node_count; i++)
+    {
+        if (nodes[i].active == 1)
+        {
+            remap[i] = count;
+            nodes[count] = nodes[i];
+            count += 1;
+        }
+        else
+        {
+            free(nodes[i].id);
+        }
+    }
+    if (count < hierarchy->node_count)
+    {
+        hierarchy->node_count = count;
+        idIndexClear(&hierarchy->by_id);
+        for (i = 0; i < count; i++)
+        {
+            /* Cannot fail: the index already held more IDs */
+            idIndexInsert(&hierarchy->by_id, nodes[i].id, i);
+        }
+    }
+
+    /* Group the reports by manager */
+    memset(first, 0, ((size_t)count + 1) * sizeof(*first));
+    for (i = 0; i < count; i++)
+    {
+        if (nodes[i].manager != ORG_NO_MANAGER)
+        {
+            nodes[i].manager = remap[nodes[i].manager];
+            first[nodes[i].manager + 1] += 1;
+        }
+    }
+    for (i = 0; i < count; i++)
+    {
+        first[i + 1] += first[i];
+        fill[i] = first[i];
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (nodes[i].manager != ORG_NO_MANAGER)
+        {
+            children[fill[nodes[i].manager]] = i;
+            fill[nodes[i].manager] += 1;
+        }
+    }
+
+    /* Number the nodes depth first, top-level employees in the order they were added */
+    for (i = count; i > 0; i--)
+    {
+        if (nodes[i - 1].manager == ORG_NO_MANAGER)
+        {
+            stack[depth] = i - 1;
+            depth += 1;
+        }
+    }
+    while (depth > 0)
+    {
+        depth -= 1;
+        node = stack[depth];
+        nodes[node].tour_start = position;
+        fill[position] = node;
+        position += 1;
+        for (j = first[node + 1]; j > first[node]; j--)
+        {
+            stack[depth] = children[j - 1];
+            depth += 1;
+        }
+    }
+
+    /* Subtree sizes, from the last position back */
+    for (i = 0; i < count; i++)
+    {
+        remap[i] = 1;
+    }
+    for (i = count; i > 0; i--)
+    {
+        node = fill[i - 1];
+        nodes[node].tour_end = nodes[node].tour_start + remap[node];
+        if (nodes[node].manager != ORG_NO_MANAGER)
+        {
+            remap[nodes[node].manager] += remap[node];
+        }
+    }
+
+    /* Fenwick tree built in place: every entry adds itself to the one covering it */
+    memset(&tree[0], 0, sizeof(tree[0]));
+    for (i = 0; i < count; i++)
+    {
+        tree[nodes[i].tour_start + 1] = nodes[i].own;
+    }
+    for (i = 1; i <= count; i++)
+    {
+        parent = i + (i & (0u - i));
+        if (parent <= count)
+        {
+            tree[parent].employees += tree[i].employees;
+            tree[parent].gross += tree[i].gross;
+            tree[parent].tax += tree[i].tax;
+            tree[parent].net += tree[i].net;
+        }
+    }
+
+    free(scratch);
+    hierarchy->layout_stale = 0;
+    PERF_STOP(PERF_OP_ORG_LAYOUT, perf_start);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Adds a change to one position of a Fenwick tree.
+ *
+ * @param tree The tree, 1-based.
+ * @param size Number of positions.
+ * @param position Position to change, 0-based.
+ * @param delta Change to add, modulo 2^64.
+ */
+static void treeAdd(OrgTotals_t *tree, uint32_t size, uint32_t position, const OrgTotals_t *delta)
+{
+    uint32_t i = 0;                         /* Tree entry covering the position */
+
+    for (i = position + 1; i <= size; i += i & (0u - i))
+    {
+        tree[i].employees += delta->employees;
+        tree[i].gross += delta->gross;
+        tree[i].tax += delta->tax;
+        tree[i].net += delta->net;
+    }
+}
+
+
+/**
+ * @brief Sums the positions before end of a Fenwick tree.
+ */
+static void treePrefix(const OrgTotals_t *tree, uint32_t end, OrgTotals_t *sum)
+{
+    uint32_t i = 0;                         /* Tree entry of the prefix */
+
+    memset(sum, 0, sizeof(*sum));
+    for (i = end; i > 0; i -= i & (0u - i))
+    {
+        sum->employees += tree[i].employees;
+        sum->gross += tree[i].gross;
+        sum->tax += tree[i].tax;
+        sum->net += tree[i].net;
+    }
+}
+
+
+/**
+ * @brief Copies the amounts of a salary calculation into a payroll of one employee.
+ */
+static void salaryToTotals(const SalaryBreakdown_t *salary, OrgTotals_t *own)
+{
+    own->employees = 1;
+    own->gross = salary->total_income;
+    own->tax = salary->tax;
+    own->net = salary->actual_salary;
+}
+
+
+/**
+ * @brief Adds or updates the employees of one batch of the store, for orgHierarchySyncStore().
+ */
+static uint32_t syncLines(const PayrollLine_t *lines, uint32_t count, void *context)
+{
+    OrgSyncContext_t *sync = context;       /* State of the walk */
+    OrgHierarchy_t *hierarchy = sync->hierarchy;   /* The hierarchy being updated */
+    OrgTotals_t own;                        /* Payroll of the current employee */
+    OrgNode_t *entry = NULL;                /* Node of the current employee */
+    uint32_t node = 0;                      /* Index of the node */
+    uint32_t i = 0;                         /* Index for looping through lines */
+
+    for (i = 0; i < count; i++)
+    {
+        salaryToTotals(&lines[i].salary, &own);
+        if (findNode(hierarchy, lines[i].employee->id, &node) == 0)
+        {
+            sync->status = orgHierarchyAdd(hierarchy, lines[i].employee->id, NULL, &own);
+            if (sync->status != MANAGE_OK)
+            {
+                return 0;
+            }
+            sync->added += 1;
+            continue;
+        }
+        if (node < sync->known)
+        {
+            sync->seen[node] = 1;
+        }
+        entry = &hierarchy->nodes[node];
+        if (entry->own.gross != own.gross || entry->own.tax != own.tax || entry->own.net != own.net)
+        {
+            setNodePayroll(hierarchy, node, &own);
+        }
+    }
+    return 1;
+}
+
+
+/**
+ * @brief Sets the manager of the employee of one line of a links file.
+ *
+ * @param hierarchy The hierarchy to update.
+ * @param line The line, without its newline; it is cut into its two IDs.
+ * @param line_number Number of the line, starting at 1.
+ * @param report Report being filled.
+ */
+static void addLinkLine(OrgHierarchy_t *hierarchy, int8_t *line, uint64_t line_number, OrgLinkReport_t *report)
+{
+    int8_t *employee_id = NULL;             /* ID of the employee */
+    int8_t *manager_id = NULL;              /* ID of the manager, empty for a top-level employee */
+    int8_t *comma = NULL;                   /* Separator between the two IDs */
+    uint32_t start = 0;                     /* Offset of an ID in its field */
+    uint32_t length = 0;                    /* Length of an ID */
+    ParseStatus_t parsed = PARSE_EMPTY;     /* Result of validating the manager's ID */
+
+    start = (uint32_t)strspn(line, " \t");
+    if (line[start] == '\0' || line[start] == '#')
+    {
+        return;
+    }
+    comma = strchr(line, ',');
+    if (comma == NULL
+        || parseIdField(line, (uint32_t)(comma - line), MAX_ID_LENGTH - 1, &start, &length) != PARSE_OK)
+    {
+        rejectLinkLine(report, line_number);
+        return;
+    }
+    employee_id = line + start;
+    employee_id[length] = '\0';
+    if (line_number == 1 && strcmp(employee_id, "employee_id") == 0)
+    {
+        /* Header line */
+        return;
+    }
+
+    manager_id = comma + 1;
+    parsed = parseIdField(manager_id, (uint32_t)strlen(manager_id), MAX_ID_LENGTH - 1, &start, &length);
+    if (parsed != PARSE_OK && parsed != PARSE_EMPTY)
+    {
+        rejectLinkLine(report, line_number);
+        return;
+    }
+    manager_id += start;
+    manager_id[(parsed == PARSE_OK) ? length : 0] = '\0';
+
+    if (orgHierarchySetManager(hierarchy, employee_id, manager_id) == MANAGE_OK)
+    {
+        report->linked += 1;
+    }
+    else
+    {
+        rejectLinkLine(report, line_number);
+    }
+}
+
+
+/**
+ * @brief Counts a line of a links file that cannot be used.
+ */
+static void rejectLinkLine(OrgLinkReport_t *report, uint64_t line_number)
+{
+    if (report->first_rejected_line == 0)
+    {
+        report->first_rejected_line = line_number;
+    }
+    report->rejected += 1;
+} /* EOF */
@@ -0,0 +1,179 @@
+/**
+ * @file org_hierarchy.h
+ * @brief This file contains the function prototypes for the manager to report hierarchy and its payroll totals.
+ *
+ * Every employee of the hierarchy has at most one manager, and the totals of an employee are
+ * the sums over the employee and everyone who reports to the employee, directly or not.
+ *
+ * The employees are laid out in depth-first (Euler tour) order, so the employees under any
+ * manager occupy one contiguous range of positions. A Fenwick tree over that order holds the
+ * headcount, gross, tax and net of every position: the totals of a subtree are two prefix sums,
+ * and a changed salary is one point update, both O(log n) whatever the size of the subtree.
+ *
+ * Removing an employee keeps an empty place in the order, so it is O(log n) as well: the
+ * employee's reports stay in the range of the employee's manager. Adding an employee or
+ * changing a manager moves employees in the order, so it only marks the layout as stale, and
+ * the next query lays the hierarchy out again in O(n).
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef ORG_HIERARCHY_H
+#define ORG_HIERARCHY_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for ManageStatus_t */
+#include "id_index.h"           /* Include ID index header file for the lookup by employee ID */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define ORG_NO_MANAGER 0xFFFFFFFFu          /* Manager of a top-level employee */
+
+/**
+ * @brief Headcount and payroll of one employee or of a subtree.
+ */
+typedef struct OrgTotals {
+    uint64_t employees;                     /* Number of employees */
+    uint64_t gross;                         /* Gross income, see SalaryBreakdown_t.total_income */
+    uint64_t tax;                           /* Personal income tax */
+    uint64_t net;                           /* Net salary, see SalaryBreakdown_t.actual_salary */
+} OrgTotals_t;
+
+/**
+ * @brief One employee of the hierarchy.
+ */
+typedef struct OrgNode {
+    int8_t *id;                             /* Employee's ID (owned copy) */
+    uint32_t manager;                       /* Node of the manager, ORG_NO_MANAGER for a top-level employee */
+    uint32_t active;                        /* 0 once the employee is removed, until the next layout */
+    uint32_t tour_start;                    /* Position of the employee in the layout */
+    uint32_t tour_end;                      /* Position after the last employee under this one */
+    OrgTotals_t own;                        /* Headcount (1) and payroll of the employee alone */
+} OrgNode_t;
+
+/**
+ * @brief Hierarchy of the employees.
+ */
+typedef struct OrgHierarchy {
+    OrgNode_t *nodes;                       /* Employees, removed ones included until the next layout */
+    uint32_t node_count;                    /* Number of nodes */
+    uint32_t node_capacity;                 /* Number of allocated nodes */
+    IdIndex_t by_id;                        /* Employee ID -> node, removed employees excluded */
+    OrgTotals_t *tree;                      /* Fenwick tree over the layout, 1-based, node_count + 1 entries */
+    uint32_t layout_stale;                  /* Flag set when tree and the tour positions must be rebuilt */
+} OrgHierarchy_t;
+
+/**
+ * @brief Result of orgHierarchyLoadLinks().
+ */
+typedef struct OrgLinkReport {
+    uint64_t lines;                         /* Number of lines in the file */
+    uint32_t linked;                        /* Employees whose manager was set */
+    uint64_t rejected;                      /* Malformed lines, unknown IDs and links that would make a cycle */
+    uint64_t first_rejected_line;           /* Line number of the first rejected line, 0 if none */
+} OrgLinkReport_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Initializes an empty hierarchy.
+ */
+void orgHierarchyInit(OrgHierarchy_t *hierarchy);
+
+/**
+ * @brief Frees all memory of a hierarchy and leaves it empty.
+ */
+void orgHierarchyFree(OrgHierarchy_t *hierarchy);
+
+/**
+ * @brief Adds an employee.
+ *
+ * @param hierarchy The hierarchy to update.
+ * @param employee_id The employee's ID.
+ * @param manager_id The manager's ID, NULL or empty for a top-level employee.
+ * @param own Payroll of the employee; its employees field is ignored.
+ * @return MANAGE_OK, MANAGE_ERR_DUPLICATE_ID, MANAGE_ERR_NOT_FOUND if the manager is not in
+ *         the hierarchy, MANAGE_ERR_INVALID_ARGUMENT or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t orgHierarchyAdd(OrgHierarchy_t *hierarchy, const int8_t *employee_id, const int8_t *manager_id,
+                               const OrgTotals_t *own);
+
+/**
+ * @brief Removes an employee; the employee's reports then report to the employee's manager.
+ *
+ * @return MANAGE_OK or MANAGE_ERR_NOT_FOUND.
+ */
+ManageStatus_t orgHierarchyRemove(OrgHierarchy_t *hierarchy, const int8_t *employee_id);
+
+/**
+ * @brief Changes the manager of an employee.
+ *
+ * @param hierarchy The hierarchy to update.
+ * @param employee_id The employee's ID.
+ * @param manager_id The new manager's ID, NULL or empty to make the employee top-level.
+ * @return MANAGE_OK, MANAGE_ERR_NOT_FOUND if either ID is not in the hierarchy, or
+ *         MANAGE_ERR_INVALID_ARGUMENT if the manager is the employee or reports to the employee.
+ */
+ManageStatus_t orgHierarchySetManager(OrgHierarchy_t *hierarchy, const int8_t *employee_id, const int8_t *manager_id);
+
+/**
+ * @brief Replaces the payroll of an employee, in O(log n).
+ *
+ * @return MANAGE_OK or MANAGE_ERR_NOT_FOUND.
+ */
+ManageStatus_t orgHierarchySetPayroll(OrgHierarchy_t *hierarchy, const int8_t *employee_id, const OrgTotals_t *own);
+
+/**
+ * @brief Sums the headcount and payroll of an employee and of everyone under the employee.
+ *
+ * @param hierarchy The hierarchy, laid out again first if it is stale.
+ * @param employee_id The employee's ID, NULL or empty for the whole hierarchy.
+ * @param totals Receives the sums.
+ * @return MANAGE_OK, MANAGE_ERR_NOT_FOUND or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t orgHierarchySubtree(OrgHierarchy_t *hierarchy, const int8_t *employee_id, OrgTotals_t *totals);
+
+/**
+ * @brief Brings the hierarchy in line with the store.
+ *
+ * Stored employees that are not in the hierarchy are added as top-level employees, employees
+ * that are no longer stored are removed, and every payroll is recalculated with
+ * calculateSalaryForDepartment(); only the payrolls that changed update the tree.
+ *
+ * @param hierarchy The hierarchy to update.
+ * @param added Receives the number of added employees (may be NULL).
+ * @param removed Receives the number of removed employees (may be NULL).
+ * @return MANAGE_OK or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t orgHierarchySyncStore(OrgHierarchy_t *hierarchy, uint32_t *added, uint32_t *removed);
+
+/**
+ * @brief Sets managers from a file of "employee_id,manager_id" lines.
+ *
+ * An empty manager_id makes the employee top-level. Blank lines and lines starting with '#'
+ * are ignored, and the first line is skipped if its first field is "employee_id".
+ *
+ * @param hierarchy The hierarchy to update; both IDs of a line must already be in it.
+ * @param path The file to read.
+ * @param report Receives the counts of the load (may be NULL).
+ * @return MANAGE_OK or MANAGE_ERR_IO if the file cannot be read.
+ */
+ManageStatus_t orgHierarchyLoadLinks(OrgHierarchy_t *hierarchy, const char *path, OrgLinkReport_t *report);
+
+/**
+ * @brief Returns the number of bytes allocated by a hierarchy.
+ */
+uint64_t orgHierarchyMemoryUsage(const OrgHierarchy_t *hierarchy);
+
+/**
+ * @brief Lets the user load manager links, set a manager and show the totals under an employee.
+ */
+void manageOrganization();
+
+#endif /* ORG_HIERARCHY_H */
@@ -0,0 +1,445 @@
+/**
+ * @file payroll_diff.c
+ * @brief This file contains the implementation of the comparison of two payroll runs.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdio.h>              /* Include standard input and output library for printf, FILE, ... */
+#include <stdlib.h>             /* Include standard library for malloc, calloc, free */
+#include <string.h>             /* Include string manipulation library for strcmp, memset */
+#include "payroll_diff.h"       /* Include header file */
+#include "payroll_export.h"     /* Include payroll export header file for reading the columnar files */
+#include "id_index.h"           /* Include ID index header file for looking the old rows up by ID */
+#include "input_handler.h"      /* Include input handler header file for handling user input */
+#include "perf_stats.h"         /* Include instrumentation header file for measuring hot operations */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/**
+ * @brief Compared columns of one payroll run.
+ */
+typedef struct PayrollRun {
+    uint64_t rows;                          /* Number of employees */
+    PayrollStringColumn_t ids;              /* Employee IDs */
+    PayrollStringColumn_t departments;      /* Department IDs */
+    uint64_t *values[PAYROLL_DIFF_FIELD_COUNT];    /* Numeric columns, NULL for the department and the tax bracket */
+} PayrollRun_t;
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static ManageStatus_t loadRun(const char *path, PayrollRun_t *run);
+static void freeRun(PayrollRun_t *run);
+static void fillValues(const PayrollRun_t *run, uint64_t row, uint64_t *values);
+static const int8_t* runKey(uint32_t value, const void *context);
+static int32_t writeDiffRow(const PayrollDiffRow_t *row, void *context);
+static void promptFileName(const char *prompt, char *path, uint32_t size, uint32_t optional);
+
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static const char *const diff_field_names[PAYROLL_DIFF_FIELD_COUNT] = {
+    "department_id",
+    "salary_base",
+    "working_days",
+    "bonus",
+    "late_coming_days",
+    "department_bonus",
+    "gross",
+    "insurance",
+    "tax",
+    "tax_bracket",
+    "net"
+};
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Compares two payroll runs by employee ID.
+ */
+ManageStatus_t diffPayrollExports(const char *old_path, const char *new_path, PayrollDiffFn_t visit,
+                                  void *context, PayrollDiffSummary_t *summary)
+{
+    PayrollRun_t old_run;                   /* Columns of the previous run */
+    PayrollRun_t new_run;                   /* Columns of the current run */
+    PayrollDiffRow_t row;                   /* Employee given to visit */
+    IdIndex_t old_ids;                      /* Old employee IDs -> old rows */
+    uint8_t *matched = NULL;                /* Per old row, 1 once a new row has the same ID */
+    uint32_t old_row = 0;                   /* Old row of the current employee */
+    uint32_t stopped = 0;                   /* Flag set when visit asks to stop */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the comparison */
+    uint32_t field = 0;                     /* Index for looping through fields */
+    uint64_t i = 0;                         /* Index for looping through rows */
+    PERF_START(perf_start);                 /* Start time of the comparison */
+
+    memset(summary, 0, sizeof(*summary));
+    memset(&old_run, 0, sizeof(old_run));
+    memset(&new_run, 0, sizeof(new_run));
+    idIndexInit(&old_ids, runKey, &old_run);
+    status = loadRun(old_path, &old_run);
+    if (status == MANAGE_OK)
+    {
+        status = loadRun(new_path, &new_run);
+    }
+    if (status == MANAGE_OK)
+    {
+        matched = calloc((size_t)old_run.rows + 1, sizeof(*matched));
+        if (matched == NULL || idIndexReserve(&old_ids, (uint32_t)old_run.rows) != MANAGE_OK)
+        {
+            status = MANAGE_ERR_NO_MEMORY;
+        }
+    }
+    for (i = 0; i < old_run.rows && status == MANAGE_OK; i++)
+    {
+        status = idIndexInsert(&old_ids, old_run.ids.bytes + old_run.ids.offsets[i], (uint32_t)i);
+        summary->old_net_total += old_run.values[DIFF_FIELD_NET][i];
+    }
+    summary->old_rows = old_run.rows;
+    summary->new_rows = new_run.rows;
+
+    /* Changed and added employees, in the order of the new run */
+    for (i = 0; i < new_run.rows && status == MANAGE_OK; i++)
+    {
+        memset(&row, 0, sizeof(row));
+        row.employee_id = new_run.ids.bytes + new_run.ids.offsets[i];
+        row.new_department_id = new_run.departments.bytes + new_run.departments.offsets[i];
+        fillValues(&new_run, i, row.new_values);
+        summary->new_net_total += row.new_values[DIFF_FIELD_NET];
+
+        if (idIndexFind(&old_ids, row.employee_id, &old_row) == 0)
+        {
+            row.kind = PAYROLL_DIFF_ADDED;
+            summary->added += 1;
+        }
+        else
+        {
+            if (matched[old_row] == 1)
+            {
+                status = MANAGE_ERR_DUPLICATE_ID;
+                break;
+            }
+            matched[old_row] = 1;
+            row.kind = PAYROLL_DIFF_CHANGED;
+            row.old_department_id = old_run.departments.bytes + old_run.departments.offsets[old_row];
+            fillValues(&old_run, old_row, row.old_values);
+            if (strcmp(row.old_department_id, row.new_department_id) != 0)
+            {
+                row.changed_fields |= 1u << DIFF_FIELD_DEPARTMENT_ID;
+            }
+            for (field = DIFF_FIELD_DEPARTMENT_ID + 1; field < PAYROLL_DIFF_FIELD_COUNT; field++)
+            {
+                if (row.old_values[field] != row.new_values[field])
+                {
+                    row.changed_fields |= 1u << field;
+                }
+            }
+            if (row.changed_fields == 0)
+            {
+                summary->unchanged += 1;
+                continue;
+            }
+            summary->changed += 1;
+            for (field = 0; field < PAYROLL_DIFF_FIELD_COUNT; field++)
+            {
+                summary->field_changes[field] += (row.changed_fields >> field) & 1u;
+            }
+        }
+        if (stopped == 0 && visit != NULL && visit(&row, context) != 0)
+        {
+            stopped = 1;
+        }
+    }
+
+    /* Removed employees, in the order of the old run */
+    for (i = 0; i < old_run.rows && status == MANAGE_OK; i++)
+    {
+        if (matched[i] == 1)
+        {
+            continue;
+        }
+        memset(&row, 0, sizeof(row));
+        row.kind = PAYROLL_DIFF_REMOVED;
+        row.employee_id = old_run.ids.bytes + old_run.ids.offsets[i];
+        row.old_department_id = old_run.departments.bytes + old_run.departments.offsets[i];
+        fillValues(&old_run, i, row.old_values);
+        summary->removed += 1;
+        if (stopped == 0 && visit != NULL && visit(&row, context) != 0)
+        {
+            stopped = 1;
+        }
+    }
+
+    free(matched);
+    idIndexFree(&old_ids);
+    freeRun(&old_run);
+    freeRun(&new_run);
+    PERF_STOP(PERF_OP_DIFF_PAYROLL, perf_start);
+    return status;
+}
+
+
+/**
+ * @brief Compares two payroll runs and writes the differences to a CSV file.
+ */
+ManageStatus_t writePayrollDiffCsv(const char *old_path, const char *new_path, const char *report_path,
+                                   PayrollDiffSummary_t *summary)
+{
+    PayrollDiffSummary_t unused_summary;    /* Summary used when the caller does not want one */
+    FILE *report = NULL;                    /* The CSV report */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the comparison */
+
+    if (summary == NULL)
+    {
+        summary = &unused_summary;
+    }
+    report = fopen(report_path, "w");
+    if (report == NULL)
+    {
+        memset(summary, 0, sizeof(*summary));
+        return MANAGE_ERR_IO;
+    }
+    fprintf(report, "change,employee_id,field,old,new,delta\n");
+    status = diffPayrollExports(old_path, new_path, writeDiffRow, report, summary);
+    if ((ferror(report) || fclose(report) != 0) && status == MANAGE_OK)
+    {
+        status = MANAGE_ERR_IO;
+    }
+    return status;
+}
+
+
+/**
+ * @brief Returns the name of a compared field, as used in the export and the report.
+ */
+const char* payrollDiffFieldName(PayrollDiffField_t field)
+{
+    return ((uint32_t)field < PAYROLL_DIFF_FIELD_COUNT) ? diff_field_names[field] : "";
+}
+
+
+/**
+ * @brief Prompts the user for two payroll exports and an optional report file, and compares them.
+ *
+ * The summary is printed on the screen; the differences themselves go to the report, which
+ * can hold millions of lines.
+ */
+void comparePayrolls()
+{
+    char old_path[260];                     /* Export of the previous run */
+    char new_path[260];                     /* Export of the current run */
+    char report_path[260];                  /* CSV report, empty for the summary only */
+    PayrollDiffSummary_t summary;           /* Counts of the comparison */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the comparison */
+    uint32_t field = 0;                     /* Index for looping through fields */
+
+    promptFileName("Enter payroll export of the previous run: ", old_path, sizeof(old_path), 0);
+    promptFileName("Enter payroll export of the current run: ", new_path, sizeof(new_path), 0);
+    promptFileName("Enter CSV report file name (leave blank for the summary only): ", report_path,
+                   sizeof(report_path), 1);
+
+    if (report_path[0] != '\0')
+    {
+        status = writePayrollDiffCsv(old_path, new_path, report_path, &summary);
+    }
+    else
+    {
+        status = diffPayrollExports(old_path, new_path, NULL, NULL, &summary);
+    }
+    if (status == MANAGE_ERR_IO)
+    {
+        printf("Cannot read the payroll exports or write the report!!!\n");
+        return;
+    }
+    if (status == MANAGE_ERR_DUPLICATE_ID)
+    {
+        printf("A payroll export has the same employee ID twice!!!\n");
+        return;
+    }
+    if (status != MANAGE_OK)
+    {
+        printf("Not enough memory to compare the payrolls!!!\n");
+        return;
+    }
+
+    printf("Previous run: %s employees, ", formatNumberWithCommas(summary.old_rows));
+    printf("current run: %s employees\n", formatNumberWithCommas(summary.new_rows));
+    printf("  Added    : %s\n", formatNumberWithCommas(summary.added));
+    printf("  Removed  : %s\n", formatNumberWithCommas(summary.removed));
+    printf("  Changed  : %s\n", formatNumberWithCommas(summary.changed));
+    printf("  Unchanged: %s\n", formatNumberWithCommas(summary.unchanged));
+    for (field = 0; field < PAYROLL_DIFF_FIELD_COUNT; field++)
+    {
+        if (summary.field_changes[field] > 0)
+        {
+            printf("    %-18s %s\n", diff_field_names[field], formatNumberWithCommas(summary.field_changes[field]));
+        }
+    }
+    printf("  Total net salary: %s -> ", formatNumberWithCommas(summary.old_net_total));
+    printf("%s\n", formatNumberWithCommas(summary.new_net_total));
+    if (report_path[0] != '\0')
+    {
+        printf("Differences written to %s\n", report_path);
+    }
+}
+
+
+/**
+ * @brief Loads the compared columns of a payroll run.
+ *
+ * @return MANAGE_OK, MANAGE_ERR_IO if the file cannot be read, lacks a column or has columns
+ *         of different lengths, or MANAGE_ERR_NO_MEMORY.
+ */
+static ManageStatus_t loadRun(const char *path, PayrollRun_t *run)
+{
+    uint64_t rows = 0;                      /* Number of values of a numeric column */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the load */
+    uint32_t field = 0;                     /* Index for looping through fields */
+
+    status = readPayrollColumnStrings(path, "id", &run->ids);
+    if (status == MANAGE_OK)
+    {
+        status = readPayrollColumnStrings(path, "department_id", &run->departments);
+    }
+    for (field = DIFF_FIELD_DEPARTMENT_ID + 1; field < PAYROLL_DIFF_FIELD_COUNT && status == MANAGE_OK; field++)
+    {
+        if (field == DIFF_FIELD_TAX_BRACKET)
+        {
+            continue;
+        }
+        status = readPayrollColumnU64(path, diff_field_names[field], &run->values[field], &rows);
+        if (status == MANAGE_OK && rows != run->ids.rows)
+        {
+            status = MANAGE_ERR_IO;
+        }
+    }
+    if (status == MANAGE_OK && (run->departments.rows != run->ids.rows || run->ids.rows > UINT32_MAX))
+    {
+        status = MANAGE_ERR_IO;
+    }
+    if (status == MANAGE_ERR_NOT_FOUND)
+    {
+        /* Not a payroll export */
+        status = MANAGE_ERR_IO;
+    }
+    run->rows = (status == MANAGE_OK) ? run->ids.rows : 0;
+    return status;
+}
+
+
+/**
+ * @brief Frees the columns of a payroll run.
+ */
+static void freeRun(PayrollRun_t *run)
+{
+    uint32_t field = 0;                     /* Index for looping through fields */
+
+    freePayrollColumnStrings(&run->ids);
+    freePayrollColumnStrings(&run->departments);
+    for (field = 0; field < PAYROLL_DIFF_FIELD_COUNT; field++)
+    {
+        free(run->values[field]);
+    }
+    memset(run, 0, sizeof(*run));
+}
+
+
+/**
+ * @brief Copies the numeric fields of one row and derives its tax bracket.
+ */
+static void fillValues(const PayrollRun_t *run, uint64_t row, uint64_t *values)
+{
+    uint32_t field = 0;                     /* Index for looping through fields */
+
+    for (field = 0; field < PAYROLL_DIFF_FIELD_COUNT; field++)
+    {
+        values[field] = (run->values[field] != NULL) ? run->values[field][row] : 0;
+    }
+    values[DIFF_FIELD_TAX_BRACKET] = taxBracket(values[DIFF_FIELD_GROSS] - values[DIFF_FIELD_INSURANCE]);
+}
+
+
+/**
+ * @brief Returns the key of an old row for the ID index.
+ */
+static const int8_t* runKey(uint32_t value, const void *context)
+{
+    const PayrollRun_t *run = context;      /* The old run */
+
+    return run->ids.bytes + run->ids.offsets[value];
+}
+
+
+/**
+ * @brief Writes the lines of one employee to the CSV report, for writePayrollDiffCsv().
+ */
+static int32_t writeDiffRow(const PayrollDiffRow_t *row, void *context)
+{
+    FILE *report = context;                 /* The CSV report */
+    uint32_t field = 0;                     /* Index for looping through fields */
+
+    if (row->kind == PAYROLL_DIFF_ADDED)
+    {
+        fprintf(report, "added,%s,net,,%llu,%lld\n", row->employee_id,
+                (unsigned long long)row->new_values[DIFF_FIELD_NET], (long long)row->new_values[DIFF_FIELD_NET]);
+        return 0;
+    }
+    if (row->kind == PAYROLL_DIFF_REMOVED)
+    {
+        fprintf(report, "removed,%s,net,%llu,,%lld\n", row->employee_id,
+                (unsigned long long)row->old_values[DIFF_FIELD_NET], -(long long)row->old_values[DIFF_FIELD_NET]);
+        return 0;
+    }
+
+    if ((row->changed_fields & (1u << DIFF_FIELD_DEPARTMENT_ID)) != 0)
+    {
+        fprintf(report, "changed,%s,department_id,%s,%s,\n", row->employee_id, row->old_department_id,
+                row->new_department_id);
+    }
+    for (field = DIFF_FIELD_DEPARTMENT_ID + 1; field < PAYROLL_DIFF_FIELD_COUNT; field++)
+    {
+        if ((row->changed_fields & (1u << field)) != 0)
+        {
+            fprintf(report, "changed,%s,%s,%llu,%llu,%lld\n", row->employee_id, diff_field_names[field],
+                    (unsigned long long)row->old_values[field], (unsigned long long)row->new_values[field],
+                    (long long)(row->new_values[field] - row->old_values[field]));
+        }
+    }
+    return ferror(report) ? 1 : 0;
+}
+
+
+/**
+ * @brief Prompts for a file name; spaces are allowed.
+ *
+ * @param prompt The message printed before each attempt.
+ * @param path Receives the file name.
+ * @param size Size of path.
+ * @param optional 1 if an empty name is accepted.
+ */
+static void promptFileName(const char *prompt, char *path, uint32_t size, uint32_t optional)
+{
+    do
+    {
+        printf("%s", prompt);
+        fflush(stdin);
+        if (fgets(path, (int)size, stdin) == NULL)
+        {
+            path[0] = '\0';
+            return;
+        }
+        /* Remove newline character, spaces are allowed in file names */
+        path[strcspn(path, "\r\n")] = '\0';
+        if (path[0] == '\0' && optional == 0)
+        {
+            printf("\nYou must not leave blank this information ...\n");
+            printf("\nPlease enter again ...\n");
+        }
+    } while (path[0] == '\0' && optional == 0);
+} /* EOF */
@@ -0,0 +1,141 @@
+/**
+ * @file payroll_diff.h
+ * @brief This file contains the function prototypes for comparing two payroll runs.
+ *
+ * A payroll run is a columnar file written by exportPayrollColumnar(). Two runs are compared
+ * by employee ID: the IDs of the old run are put in a hash index, the new run is read once in
+ * its own order and every row is looked up, then the old rows that were never matched are the
+ * removed employees. The comparison is linear in the number of rows and only the compared
+ * columns of the two files are loaded.
+ *
+ * For every employee present in both runs, the department, the payroll inputs and outputs and
+ * the tax bracket (see taxBracket(), from gross minus insurance) are compared field by field.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef PAYROLL_DIFF_H
+#define PAYROLL_DIFF_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for ManageStatus_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/**
+ * @brief Compared fields of a payroll row.
+ */
+typedef enum PayrollDiffField {
+    DIFF_FIELD_DEPARTMENT_ID = 0,           /* Department of the employee, compared as a string */
+    DIFF_FIELD_SALARY_BASE,
+    DIFF_FIELD_WORKING_DAYS,
+    DIFF_FIELD_BONUS,
+    DIFF_FIELD_LATE_COMING_DAYS,
+    DIFF_FIELD_DEPARTMENT_BONUS,
+    DIFF_FIELD_GROSS,
+    DIFF_FIELD_INSURANCE,
+    DIFF_FIELD_TAX,
+    DIFF_FIELD_TAX_BRACKET,                 /* Derived from gross minus insurance */
+    DIFF_FIELD_NET,
+    PAYROLL_DIFF_FIELD_COUNT                /* Number of compared fields, must stay last */
+} PayrollDiffField_t;
+
+/**
+ * @brief How an employee differs between the two runs.
+ */
+typedef enum PayrollDiffKind {
+    PAYROLL_DIFF_ADDED = 0,                 /* Only in the new run */
+    PAYROLL_DIFF_REMOVED,                   /* Only in the old run */
+    PAYROLL_DIFF_CHANGED                    /* In both runs, with at least one different field */
+} PayrollDiffKind_t;
+
+/**
+ * @brief One employee that differs between the two runs.
+ */
+typedef struct PayrollDiffRow {
+    PayrollDiffKind_t kind;                 /* Added, removed or changed */
+    const int8_t *employee_id;              /* The employee's ID */
+    uint32_t changed_fields;                /* Bit (1 << field) of every different field, 0 if added or removed */
+    const int8_t *old_department_id;        /* Department in the old run, NULL if added */
+    const int8_t *new_department_id;        /* Department in the new run, NULL if removed */
+    uint64_t old_values[PAYROLL_DIFF_FIELD_COUNT];  /* Numeric fields in the old run, 0 if added */
+    uint64_t new_values[PAYROLL_DIFF_FIELD_COUNT];  /* Numeric fields in the new run, 0 if removed */
+} PayrollDiffRow_t;
+
+/**
+ * @brief Called for every employee that differs by diffPayrollExports().
+ *
+ * The strings of the row are only valid during the call.
+ *
+ * @return 0 to continue, any other value to stop.
+ */
+typedef int32_t (*PayrollDiffFn_t)(const PayrollDiffRow_t *row, void *context);
+
+/**
+ * @brief Counts of a comparison.
+ */
+typedef struct PayrollDiffSummary {
+    uint64_t old_rows;                      /* Employees in the old run */
+    uint64_t new_rows;                      /* Employees in the new run */
+    uint64_t added;                         /* Employees only in the new run */
+    uint64_t removed;                       /* Employees only in the old run */
+    uint64_t changed;                       /* Employees with at least one different field */
+    uint64_t unchanged;                     /* Employees identical in both runs */
+    uint64_t field_changes[PAYROLL_DIFF_FIELD_COUNT];  /* Changed employees per field */
+    uint64_t old_net_total;                 /* Sum of the net salaries of the old run */
+    uint64_t new_net_total;                 /* Sum of the net salaries of the new run */
+} PayrollDiffSummary_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Compares two payroll runs by employee ID.
+ *
+ * visit receives the changed and added employees in the order of the new run, then the
+ * removed employees in the order of the old run.
+ *
+ * @param old_path Columnar file of the previous run.
+ * @param new_path Columnar file of the current run.
+ * @param visit Function called on every employee that differs (may be NULL).
+ * @param context Passed to visit.
+ * @param summary Receives the counts; they are complete only if visit never stops.
+ * @return MANAGE_OK, MANAGE_ERR_IO if a file cannot be read or is not a payroll export,
+ *         MANAGE_ERR_DUPLICATE_ID if a run has the same ID twice, or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t diffPayrollExports(const char *old_path, const char *new_path, PayrollDiffFn_t visit,
+                                  void *context, PayrollDiffSummary_t *summary);
+
+/**
+ * @brief Compares two payroll runs and writes the differences to a CSV file.
+ *
+ * The report has one line per changed field of a changed employee and one line with the net
+ * salary per added or removed employee:
+ *     change,employee_id,field,old,new,delta
+ * delta is new - old and is empty for the department.
+ *
+ * @param old_path Columnar file of the previous run.
+ * @param new_path Columnar file of the current run.
+ * @param report_path The CSV file to write.
+ * @param summary Receives the counts (may be NULL).
+ * @return The result of diffPayrollExports(), or MANAGE_ERR_IO if the report cannot be written.
+ */
+ManageStatus_t writePayrollDiffCsv(const char *old_path, const char *new_path, const char *report_path,
+                                   PayrollDiffSummary_t *summary);
+
+/**
+ * @brief Returns the name of a compared field, as used in the export and the report.
+ */
+const char* payrollDiffFieldName(PayrollDiffField_t field);
+
+/**
+ * @brief Prompts the user for two payroll exports and an optional report file, and compares them.
+ */
+void comparePayrolls();
+
+#endif /* PAYROLL_DIFF_H */
@@ -0,0 +1,952 @@
+/**
+ * @file payroll_export.c
+ * @brief This file contains the implementation of the columnar payroll export.
+ *
+ * The payroll of every employee is calculated once, then each column is encoded into a memory
+ * buffer and written to the file in large sequential chunks before the next column is built, so
+ * only one encoded column is held in memory at a time. The file layout is described in
+ * payroll_export.h.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdio.h>              /* Include standard input and output library for FILE, fopen, fwrite, ... */
+#include <stdlib.h>             /* Include standard library for malloc, realloc, qsort, bsearch */
+#include <string.h>             /* Include string manipulation library for strlen, strcmp, memcpy */
+#include "payroll_export.h"     /* Include header file */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define EXPORT_MAGIC "MEPCOL01"             /* Magic bytes at the start and at the end of the file */
+#define EXPORT_MAGIC_LENGTH 8               /* Length of the magic bytes */
+#define EXPORT_VERSION 1u                   /* Version of the file layout */
+#define EXPORT_CHUNK_SIZE (1u << 20)        /* Size of the chunks written to the file */
+#define EXPORT_NAME_LENGTH 24               /* Size of the column name in a directory entry */
+#define EXPORT_DIRECTORY_ENTRY_SIZE 48      /* Size of one directory entry */
+#define EXPORT_TRAILER_SIZE 32              /* Size of the trailer */
+
+#ifdef _WIN32
+#define EXPORT_FSEEK _fseeki64              /* 64-bit seek, files can be larger than 2 GB */
+#else
+#define EXPORT_FSEEK fseeko
+#endif
+
+/**
+ * @brief Fields that can be exported.
+ */
+typedef enum ExportField {
+    FIELD_ID,
+    FIELD_DEPARTMENT_ID,
+    FIELD_NAME,
+    FIELD_SALARY_BASE,
+    FIELD_WORKING_DAYS,
+    FIELD_WORKING_PERFORMANCE,
+    FIELD_BONUS,
+    FIELD_LATE_COMING_DAYS,
+    FIELD_DEPARTMENT_BONUS,
+    FIELD_GROSS,
+    FIELD_INSURANCE,
+    FIELD_TAX,
+    FIELD_NET
+} ExportField_t;
+
+/**
+ * @brief Description of one exported column.
+ */
+typedef struct ColumnSpec {
+    const char *name;                       /* Column name in the directory */
+    ExportField_t field;                    /* Field stored in the column */
+    ColumnType_t type;                      /* Value type of the column */
+} ColumnSpec_t;
+
+/**
+ * @brief Growable byte buffer used to encode one column.
+ */
+typedef struct ColumnBuffer {
+    uint8_t *data;                          /* Encoded bytes */
+    size_t length;                          /* Number of bytes used */
+    size_t capacity;                        /* Number of bytes allocated */
+    uint32_t failed;                        /* Set to 1 when an allocation failed */
+} ColumnBuffer_t;
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static ManageStatus_t readColumnBlock(const char *path, const char *column, uint8_t *type, uint8_t *encoding,
+                                      uint8_t **block, uint64_t *block_length, uint64_t *row_count);
+static uint8_t* bufferReserve(ColumnBuffer_t *buffer, size_t extra);
+static void bufferPutU16(ColumnBuffer_t *buffer, uint16_t value);
+static void bufferPutU32(ColumnBuffer_t *buffer, uint32_t value);
+static void bufferPutU64(ColumnBuffer_t *buffer, uint64_t value);
+static void bufferPutVarint(ColumnBuffer_t *buffer, uint64_t value);
+static void bufferPutBytes(ColumnBuffer_t *buffer, const void *bytes, size_t length);
+static uint64_t readU64(const uint8_t *bytes);
+static uint32_t readU32(const uint8_t *bytes);
+static const int8_t* stringField(const Employee_t *employee, ExportField_t field);
+static uint64_t numberField(const Employee_t *employee, const SalaryBreakdown_t *breakdown, ExportField_t field);
+static void encodePlainStrings(ColumnBuffer_t *buffer, ExportField_t field, uint32_t rows);
+static void encodeDictionaryStrings(ColumnBuffer_t *buffer, ExportField_t field, uint32_t rows);
+static int compareStringPointers(const void *first, const void *second);
+static uint32_t writeChunks(FILE *file, const uint8_t *data, size_t length);
+
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static const ColumnSpec_t export_columns[] = {
+    {"id",                  FIELD_ID,                   COLUMN_TYPE_STRING},
+    {"department_id",       FIELD_DEPARTMENT_ID,        COLUMN_TYPE_STRING},
+    {"name",                FIELD_NAME,                 COLUMN_TYPE_STRING},
+    {"salary_base",         FIELD_SALARY_BASE,          COLUMN_TYPE_U64},
+    {"working_days",        FIELD_WORKING_DAYS,         COLUMN_TYPE_U16},
+    {"working_performance", FIELD_WORKING_PERFORMANCE,  COLUMN_TYPE_F32},
+    {"bonus",               FIELD_BONUS,                COLUMN_TYPE_U64},
+    {"late_coming_days",    FIELD_LATE_COMING_DAYS,     COLUMN_TYPE_U16},
+    {"department_bonus",    FIELD_DEPARTMENT_BONUS,     COLUMN_TYPE_U64},
+    {"gross",               FIELD_GROSS,                COLUMN_TYPE_U64},
+    {"insurance",           FIELD_INSURANCE,            COLUMN_TYPE_U64},
+    {"tax",                 FIELD_TAX,                  COLUMN_TYPE_U64},
+    {"net",                 FIELD_NET,                  COLUMN_TYPE_U64}
+};
+#define EXPORT_COLUMN_COUNT ((uint32_t)(sizeof(export_columns) / sizeof(export_columns[0])))
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Prompts the user for a file name and exports the payroll into it.
+ */
+void exportPayroll()
+{
+    char path[260];                         /* File name entered by the user */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the export */
+
+    if (getTotalEmployees() == 0)
+    {
+        printf("No employee to export payroll!!!\n");
+        return;
+    }
+    do
+    {
+        printf("Enter file name to export payroll: ");
+        fflush(stdin);
+        if (fgets(path, sizeof(path), stdin) == NULL)
+        {
+            return;
+        }
+        /* Remove newline character, spaces are allowed in file names */
+        path[strcspn(path, "\r\n")] = '\0';
+        if (path[0] == '\0')
+        {
+            printf("\nYou must not leave blank this information ...\n");
+            printf("\nPlease enter again ...\n");
+        }
+    } while (path[0] == '\0');
+
+    status = exportPayrollColumnar(path, EXPORT_DICTIONARY_STRINGS | EXPORT_DELTA_NUMBERS);
+    if (status == MANAGE_OK)
+    {
+        printf("Exported payroll of %u employees to %s\n", getTotalEmployees(), path);
+    }
+    else if (status == MANAGE_ERR_NO_MEMORY)
+    {
+        printf("Not enough memory to export payroll!!!\n");
+    }
+    else
+    {
+        printf("Cannot write file %s\n", path);
+    }
+}
+
+
+/**
+ * @brief Exports the stored employees and their payroll to a columnar file.
+ *
+ * @param path The file to write.
+ * @param flags Combination of EXPORT_DICTIONARY_STRINGS and EXPORT_DELTA_NUMBERS.
+ * @return MANAGE_OK on success, MANAGE_ERR_IO or MANAGE_ERR_NO_MEMORY otherwise.
+ */
+ManageStatus_t exportPayrollColumnar(const char *path, uint32_t flags)
+{
+    uint32_t rows = getTotalEmployees();    /* Number of exported employees */
+    SalaryBreakdown_t *breakdowns = NULL;   /* Payroll of every employee, calculated once */
+    ColumnBuffer_t buffer = {NULL, 0, 0, 0};       /* Encoded column */
+    ColumnBuffer_t directory = {NULL, 0, 0, 0};    /* Encoded directory */
+    uint8_t name[EXPORT_NAME_LENGTH];       /* Column name padded with NUL */
+    uint8_t encoding = COLUMN_ENCODING_PLAIN;       /* Encoding of the current column */
+    uint64_t file_offset = 0;               /* Number of bytes written so far */
+    uint64_t previous = 0;                  /* Previous value of a delta-encoded column */
+    uint64_t value = 0;                     /* Value of the current row */
+    uint64_t delta = 0;                     /* Difference with the previous row */
+    uint64_t directory_offset = 0;          /* Offset of the directory */
+    uint8_t type = 0;                       /* Type of the current column */
+    float performance = 0;                  /* Working performance of the current row */
+    FILE *file = NULL;                      /* The exported file */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the export */
+    uint32_t column = 0;                    /* Index for looping through columns */
+    uint32_t i = 0;                         /* Index for looping through rows */
+
+    if (rows > 0)
+    {
+        breakdowns = malloc((size_t)rows * sizeof(*breakdowns));
+        if (breakdowns == NULL)
+        {
+            return MANAGE_ERR_NO_MEMORY;
+        }
+        for (i = 0; i < rows; i++)
+        {
+            calculateSalaryBreakdown(getEmployeeAt(i), &breakdowns[i]);
+        }
+    }
+
+    file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        free(breakdowns);
+        return MANAGE_ERR_IO;
+    }
+    setvbuf(file, NULL, _IOFBF, EXPORT_CHUNK_SIZE);
+
+    /* Header */
+    bufferPutBytes(&buffer, EXPORT_MAGIC, EXPORT_MAGIC_LENGTH);
+    bufferPutU32(&buffer, EXPORT_VERSION);
+    bufferPutU32(&buffer, 0);
+
+    for (column = 0; column < EXPORT_COLUMN_COUNT && status == MANAGE_OK; column++)
+    {
+        /* Flush the previous block (or the header) in large chunks */
+        if (buffer.failed == 1)
+        {
+            status = MANAGE_ERR_NO_MEMORY;
+        }
+        else if (writeChunks(file, buffer.data, buffer.length) == 0)
+        {
+            status = MANAGE_ERR_IO;
+        }
+        file_offset += buffer.length;
+        buffer.length = 0;
+
+        encoding = COLUMN_ENCODING_PLAIN;
+        switch (export_columns[column].type)
+        {
+            case COLUMN_TYPE_STRING:
+                if ((flags & EXPORT_DICTIONARY_STRINGS) != 0 && export_columns[column].field == FIELD_DEPARTMENT_ID)
+                {
+                    encoding = COLUMN_ENCODING_DICTIONARY;
+                    encodeDictionaryStrings(&buffer, export_columns[column].field, rows);
+                }
+                else
+                {
+                    encodePlainStrings(&buffer, export_columns[column].field, rows);
+                }
+                break;
+            case COLUMN_TYPE_F32:
+                for (i = 0; i < rows; i++)
+                {
+                    performance = getEmployeeAt(i)->working_performance;
+                    memcpy(&value, &performance, sizeof(performance));
+                    bufferPutU32(&buffer, (uint32_t)value);
+                }
+                break;
+            case COLUMN_TYPE_U16:
+                for (i = 0; i < rows; i++)
+                {
+                    bufferPutU16(&buffer, (uint16_t)numberField(getEmployeeAt(i), &breakdowns[i],
+                                                                export_columns[column].field));
+                }
+                break;
+            default:
+                if ((flags & EXPORT_DELTA_NUMBERS) != 0)
+                {
+                    encoding = COLUMN_ENCODING_DELTA;
+                    previous = 0;
+                    for (i = 0; i < rows; i++)
+                    {
+                        value = numberField(getEmployeeAt(i), &breakdowns[i], export_columns[column].field);
+                        delta = value - previous;
+                        /* Zigzag: small negative and positive deltas both become small varints */
+                        bufferPutVarint(&buffer, (delta << 1) ^ (uint64_t)(-(int64_t)(delta >> 63)));
+                        previous = value;
+                    }
+                }
+                else
+                {
+                    for (i = 0; i < rows; i++)
+                    {
+                        bufferPutU64(&buffer, numberField(getEmployeeAt(i), &breakdowns[i], export_columns[column].field));
+                    }
+                }
+                break;
+        }
+
+        /* Directory entry of this column */
+        memset(name, 0, sizeof(name));
+        memcpy(name, export_columns[column].name, strlen(export_columns[column].name));
+        bufferPutBytes(&directory, name, sizeof(name));
+        type = (uint8_t)export_columns[column].type;
+        bufferPutBytes(&directory, &type, 1);
+        bufferPutBytes(&directory, &encoding, 1);
+        bufferPutBytes(&directory, "\0\0\0\0\0\0", 6);
+        bufferPutU64(&directory, file_offset);
+        bufferPutU64(&directory, buffer.length);
+    }
+
+    /* Last column, directory and trailer */
+    if (status == MANAGE_OK)
+    {
+        directory_offset = file_offset + buffer.length;
+        bufferPutBytes(&buffer, directory.data, directory.length);
+        bufferPutU32(&buffer, EXPORT_COLUMN_COUNT);
+        bufferPutU32(&buffer, 0);
+        bufferPutU64(&buffer, rows);
+        bufferPutU64(&buffer, directory_offset);
+        bufferPutBytes(&buffer, EXPORT_MAGIC, EXPORT_MAGIC_LENGTH);
+        if (buffer.failed == 1 || directory.failed == 1)
+        {
+            status = MANAGE_ERR_NO_MEMORY;
+        }
+        else if (writeChunks(file, buffer.data, buffer.length) == 0)
+        {
+            status = MANAGE_ERR_IO;
+        }
+    }
+    if (fclose(file) != 0 && status == MANAGE_OK)
+    {
+        status = MANAGE_ERR_IO;
+    }
+
+    free(buffer.data);
+    free(directory.data);
+    free(breakdowns);
+    return status;
+}
+
+
+/**
+ * @brief Loads one numeric column of a columnar file.
+ *
+ * @param path The file to read.
+ * @param column The name of the column, for example "net".
+ * @param values Receives an array allocated with malloc() that the caller must free.
+ * @param rows Receives the number of values.
+ * @return MANAGE_OK on success, MANAGE_ERR_NOT_FOUND if the column does not exist or is not
+ *         numeric, MANAGE_ERR_IO or MANAGE_ERR_NO_MEMORY otherwise.
+ */
+ManageStatus_t readPayrollColumnU64(const char *path, const char *column, uint64_t **values, uint64_t *rows)
+{
+    uint8_t *block = NULL;                  /* Bytes of the wanted column */
+    uint64_t *decoded = NULL;               /* Decoded values */
+    uint64_t row_count = 0;                 /* Number of rows in the file */
+    uint64_t block_length = 0;              /* Length of the wanted column */
+    uint64_t position = 0;                  /* Read position inside the block */
+    uint64_t previous = 0;                  /* Previous value of a delta-encoded column */
+    uint64_t zigzag = 0;                    /* Decoded varint */
+    uint32_t shift = 0;                     /* Bit position inside a varint */
+    uint8_t type = 0;                       /* Type of the wanted column */
+    uint8_t encoding = 0;                   /* Encoding of the wanted column */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the read */
+    uint64_t i = 0;                         /* Index for looping */
+
+    *values = NULL;
+    *rows = 0;
+    status = readColumnBlock(path, column, &type, &encoding, &block, &block_length, &row_count);
+    if (status == MANAGE_OK && type != COLUMN_TYPE_U64 && type != COLUMN_TYPE_U16)
+    {
+        status = MANAGE_ERR_NOT_FOUND;
+    }
+    if (status == MANAGE_OK)
+    {
+        decoded = malloc((size_t)row_count * sizeof(*decoded) + 1);
+        if (decoded == NULL)
+        {
+            status = MANAGE_ERR_NO_MEMORY;
+        }
+    }
+
+    if (status == MANAGE_OK)
+    {
+        for (i = 0; i < row_count && status == MANAGE_OK; i++)
+        {
+            if (type == COLUMN_TYPE_U16)
+            {
+                if (position + 2 > block_length)
+                {
+                    status = MANAGE_ERR_IO;
+                }
+                else
+                {
+                    decoded[i] = (uint64_t)block[position] | ((uint64_t)block[position + 1] << 8);
+                    position += 2;
+                }
+            }
+            else if (encoding == COLUMN_ENCODING_DELTA)
+            {
+                zigzag = 0;
+                shift = 0;
+                do
+                {
+                    if (position >= block_length || shift > 63)
+                    {
+                        status = MANAGE_ERR_IO;
+                        break;
+                    }
+                    zigzag |= (uint64_t)(block[position] & 0x7f) << shift;
+                    shift += 7;
+                    position++;
+                } while ((block[position - 1] & 0x80) != 0);
+                previous += (zigzag >> 1) ^ (uint64_t)(-(int64_t)(zigzag & 1));
+                decoded[i] = previous;
+            }
+            else
+            {
+                if (position + 8 > block_length)
+                {
+                    status = MANAGE_ERR_IO;
+                }
+                else
+                {
+                    decoded[i] = readU64(&block[position]);
+                    position += 8;
+                }
+            }
+        }
+    }
+
+    free(block);
+    if (status == MANAGE_OK)
+    {
+        *values = decoded;
+        *rows = row_count;
+    }
+    else
+    {
+        free(decoded);
+    }
+    return status;
+}
+
+
+/**
+ * @brief Loads one string column of a columnar file.
+ *
+ * Plain and dictionary-encoded columns give the same result: one NUL-terminated copy of the
+ * string of every row.
+ */
+ManageStatus_t readPayrollColumnStrings(const char *path, const char *column, PayrollStringColumn_t *strings)
+{
+    uint8_t *block = NULL;                  /* Bytes of the wanted column */
+    const uint8_t *offsets = NULL;          /* u32 offsets of the plain strings or of the dictionary */
+    const uint8_t *text = NULL;             /* String bytes of the block */
+    const uint8_t *codes = NULL;            /* u32 dictionary code of every row */
+    uint64_t row_count = 0;                 /* Number of rows in the file */
+    uint64_t block_length = 0;              /* Length of the wanted column */
+    uint64_t string_count = 0;              /* Number of strings in the block: rows or dictionary size */
+    uint64_t text_length = 0;               /* Number of string bytes in the block */
+    uint64_t header_length = 0;             /* Bytes before the string bytes */
+    uint64_t total = 0;                     /* Bytes of the decoded strings, terminators included */
+    uint64_t string = 0;                    /* String of the current row */
+    uint64_t start = 0;                     /* Offset of the current string in text */
+    uint64_t length = 0;                    /* Length of the current string */
+    uint8_t type = 0;                       /* Type of the wanted column */
+    uint8_t encoding = 0;                   /* Encoding of the wanted column */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the read */
+    uint64_t i = 0;                         /* Index for looping through rows and strings */
+
+    memset(strings, 0, sizeof(*strings));
+    status = readColumnBlock(path, column, &type, &encoding, &block, &block_length, &row_count);
+    if (status == MANAGE_OK && type != COLUMN_TYPE_STRING)
+    {
+        status = MANAGE_ERR_NOT_FOUND;
+    }
+
+    /* Locate and check the parts of the block */
+    if (status == MANAGE_OK)
+    {
+        if (encoding == COLUMN_ENCODING_DICTIONARY)
+        {
+            string_count = (block_length >= 4) ? readU32(block) : 0;
+            offsets = block + 4;
+            header_length = 4 + (string_count + 1) * 4;
+        }
+        else
+        {
+            string_count = row_count;
+            offsets = block;
+            header_length = (string_count + 1) * 4;
+        }
+        if (header_length > block_length)
+        {
+            status = MANAGE_ERR_IO;
+        }
+    }
+    if (status == MANAGE_OK)
+    {
+        text = block + header_length;
+        text_length = readU32(offsets + string_count * 4);
+        codes = text + text_length;
+        if (header_length + text_length
+            + ((encoding == COLUMN_ENCODING_DICTIONARY) ? row_count * 4 : 0) > block_length)
+        {
+            status = MANAGE_ERR_IO;
+        }
+        for (i = 0; i < string_count && status == MANAGE_OK; i++)
+        {
+            if (readU32(offsets + i * 4) > readU32(offsets + (i + 1) * 4))
+            {
+                status = MANAGE_ERR_IO;
+            }
+        }
+    }
+
+    /* Size of the decoded strings */
+    for (i = 0; i < row_count && status == MANAGE_OK; i++)
+    {
+        string = (encoding == COLUMN_ENCODING_DICTIONARY) ? readU32(codes + i * 4) : i;
+        if (string >= string_count)
+        {
+            status = MANAGE_ERR_IO;
+            break;
+        }
+        total += readU32(offsets + (string + 1) * 4) - readU32(offsets + string * 4) + 1;
+    }
+    if (status == MANAGE_OK)
+    {
+        strings->offsets = malloc((size_t)row_count * sizeof(*strings->offsets) + 1);
+        strings->bytes = malloc((size_t)total + 1);
+        if (strings->offsets == NULL || strings->bytes == NULL)
+        {
+            status = MANAGE_ERR_NO_MEMORY;
+        }
+    }
+
+    if (status == MANAGE_OK)
+    {
+        total = 0;
+        for (i = 0; i < row_count; i++)
+        {
+            string = (encoding == COLUMN_ENCODING_DICTIONARY) ? readU32(codes + i * 4) : i;
+            start = readU32(offsets + string * 4);
+            length = readU32(offsets + (string + 1) * 4) - start;
+            strings->offsets[i] = total;
+            memcpy(strings->bytes + total, text + start, (size_t)length);
+            strings->bytes[total + length] = '\0';
+            total += length + 1;
+        }
+        strings->rows = row_count;
+    }
+    else
+    {
+        freePayrollColumnStrings(strings);
+    }
+    free(block);
+    return status;
+}
+
+
+/**
+ * @brief Frees a string column loaded by readPayrollColumnStrings() and leaves it empty.
+ */
+void freePayrollColumnStrings(PayrollStringColumn_t *strings)
+{
+    free(strings->offsets);
+    free(strings->bytes);
+    memset(strings, 0, sizeof(*strings));
+}
+
+
+/**
+ * @brief Reads the block of one column of a columnar file.
+ *
+ * Only the trailer, the directory and the wanted block are read.
+ *
+ * @param path The file to read.
+ * @param column The name of the column.
+ * @param type Receives the type of the column.
+ * @param encoding Receives the encoding of the column.
+ * @param block Receives the bytes of the column, allocated with malloc(), that the caller must free.
+ * @param block_length Receives the number of bytes of the column.
+ * @param row_count Receives the number of rows of the file.
+ * @return MANAGE_OK, MANAGE_ERR_NOT_FOUND if the column does not exist, MANAGE_ERR_IO or
+ *         MANAGE_ERR_NO_MEMORY.
+ */
+static ManageStatus_t readColumnBlock(const char *path, const char *column, uint8_t *type, uint8_t *encoding,
+                                      uint8_t **block, uint64_t *block_length, uint64_t *row_count)
+{
+    uint8_t trailer[EXPORT_TRAILER_SIZE];   /* Trailer of the file */
+    uint8_t entry[EXPORT_DIRECTORY_ENTRY_SIZE];    /* Current directory entry */
+    uint64_t block_offset = 0;              /* Offset of the wanted column */
+    uint32_t column_count = 0;              /* Number of columns in the file */
+    uint32_t found = 0;                     /* Flag to check if the column is found */
+    FILE *file = NULL;                      /* The file being read */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the read */
+    uint32_t i = 0;                         /* Index for looping through the directory */
+
+    *block = NULL;
+    *block_length = 0;
+    file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return MANAGE_ERR_IO;
+    }
+    if (EXPORT_FSEEK(file, -EXPORT_TRAILER_SIZE, SEEK_END) != 0
+        || fread(trailer, 1, sizeof(trailer), file) != sizeof(trailer)
+        || memcmp(&trailer[24], EXPORT_MAGIC, EXPORT_MAGIC_LENGTH) != 0)
+    {
+        fclose(file);
+        return MANAGE_ERR_IO;
+    }
+    column_count = readU32(&trailer[0]);
+    *row_count = readU64(&trailer[8]);
+
+    /* Find the column in the directory */
+    if (EXPORT_FSEEK(file, (int64_t)readU64(&trailer[16]), SEEK_SET) != 0)
+    {
+        status = MANAGE_ERR_IO;
+    }
+    for (i = 0; i < column_count && status == MANAGE_OK && found == 0; i++)
+    {
+        if (fread(entry, 1, sizeof(entry), file) != sizeof(entry))
+        {
+            status = MANAGE_ERR_IO;
+        }
+        else if (strncmp((const char *)entry, column, EXPORT_NAME_LENGTH) == 0)
+        {
+            found = 1;
+            *type = entry[EXPORT_NAME_LENGTH];
+            *encoding = entry[EXPORT_NAME_LENGTH + 1];
+            block_offset = readU64(&entry[32]);
+            *block_length = readU64(&entry[40]);
+        }
+    }
+    if (status == MANAGE_OK && found == 0)
+    {
+        status = MANAGE_ERR_NOT_FOUND;
+    }
+
+    /* Read only the wanted column */
+    if (status == MANAGE_OK)
+    {
+        *block = malloc((size_t)*block_length + 1);
+        if (*block == NULL)
+        {
+            status = MANAGE_ERR_NO_MEMORY;
+        }
+        else if (EXPORT_FSEEK(file, (int64_t)block_offset, SEEK_SET) != 0
+                 || fread(*block, 1, (size_t)*block_length, file) != *block_length)
+        {
+            status = MANAGE_ERR_IO;
+        }
+    }
+    fclose(file);
+    if (status != MANAGE_OK)
+    {
+        free(*block);
+        *block = NULL;
+    }
+    return status;
+}
+
+
+/**
+ * @brief Makes room for extra bytes at the end of a buffer.
+ *
+ * @return Pointer to the first free byte, or NULL if memory could not be allocated
+ *         (the buffer is then marked as failed).
+ */
+static uint8_t* bufferReserve(ColumnBuffer_t *buffer, size_t extra)
+{
+    size_t new_capacity = 0;                /* Grown capacity */
+    uint8_t *grown = NULL;                  /* Reallocated data */
+
+    if (buffer->failed == 1)
+    {
+        return NULL;
+    }
+    if (buffer->length + extra > buffer->capacity)
+    {
+        new_capacity = (buffer->capacity == 0) ? EXPORT_CHUNK_SIZE : buffer->capacity;
+        while (new_capacity < buffer->length + extra)
+        {
+            new_capacity *= 2;
+        }
+        grown = realloc(buffer->data, new_capacity);
+        if (grown == NULL)
+        {
+            buffer->failed = 1;
+            return NULL;
+        }
+        buffer->data = grown;
+        buffer->capacity = new_capacity;
+    }
+    return &buffer->data[buffer->length];
+}
+
+
+/**
+ * @brief Appends a little-endian 16-bit value to a buffer.
+ */
+static void bufferPutU16(ColumnBuffer_t *buffer, uint16_t value)
+{
+    uint8_t *out = bufferReserve(buffer, 2);       /* Destination */
+
+    if (out != NULL)
+    {
+        out[0] = (uint8_t)value;
+        out[1] = (uint8_t)(value >> 8);
+        buffer->length += 2;
+    }
+}
+
+
+/**
+ * @brief Appends a little-endian 32-bit value to a buffer.
+ */
+static void bufferPutU32(ColumnBuffer_t *buffer, uint32_t value)
+{
+    uint8_t *out = bufferReserve(buffer, 4);       /* Destination */
+    uint32_t i = 0;                         /* Index for looping through bytes */
+
+    if (out != NULL)
+    {
+        for (i = 0; i < 4; i++)
+        {
+            out[i] = (uint8_t)(value >> (8 * i));
+        }
+        buffer->length += 4;
+    }
+}
+
+
+/**
+ * @brief Appends a little-endian 64-bit value to a buffer.
+ */
+static void bufferPutU64(ColumnBuffer_t *buffer, uint64_t value)
+{
+    uint8_t *out = bufferReserve(buffer, 8);       /* Destination */
+    uint32_t i = 0;                         /* Index for looping through bytes */
+
+    if (out != NULL)
+    {
+        for (i = 0; i < 8; i++)
+        {
+            out[i] = (uint8_t)(value >> (8 * i));
+        }
+        buffer->length += 8;
+    }
+}
+
+
+/**
+ * @brief Appends an unsigned LEB128 varint (7 bits per byte, high bit set on all but the last byte).
+ */
+static void bufferPutVarint(ColumnBuffer_t *buffer, uint64_t value)
+{
+    uint8_t *out = bufferReserve(buffer, 10);      /* Destination, a varint has at most 10 bytes */
+    size_t length = 0;                      /* Number of bytes written */
+
+    if (out != NULL)
+    {
+        while (value >= 0x80)
+        {
+            out[length++] = (uint8_t)(value | 0x80);
+            value >>= 7;
+        }
+        out[length++] = (uint8_t)value;
+        buffer->length += length;
+    }
+}
+
+
+/**
+ * @brief Appends raw bytes to a buffer.
+ */
+static void bufferPutBytes(ColumnBuffer_t *buffer, const void *bytes, size_t length)
+{
+    uint8_t *out = bufferReserve(buffer, length);  /* Destination */
+
+    if (out != NULL && length > 0)
+    {
+        memcpy(out, bytes, length);
+        buffer->length += length;
+    }
+}
+
+
+/**
+ * @brief Reads a little-endian 64-bit value.
+ */
+static uint64_t readU64(const uint8_t *bytes)
+{
+    return (uint64_t)readU32(bytes) | ((uint64_t)readU32(bytes + 4) << 32);
+}
+
+
+/**
+ * @brief Reads a little-endian 32-bit value.
+ */
+static uint32_t readU32(const uint8_t *bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+
+/**
+ * @brief Returns the string field of an employee.
+ */
+static const int8_t* stringField(const Employee_t *employee, ExportField_t field)
+{
+    if (field == FIELD_DEPARTMENT_ID)
+    {
+        return employee->department_id;
+    }
+    else if (field == FIELD_NAME)
+    {
+        return employee->name;
+    }
+    return employee->id;
+}
+
+
+/**
+ * @brief Returns the numeric field of an employee or of their payroll.
+ */
+static uint64_t numberField(const Employee_t *employee, const SalaryBreakdown_t *breakdown, ExportField_t field)
+{
+    switch (field)
+    {
+        case FIELD_SALARY_BASE:
+            return employee->salary_base;
+        case FIELD_WORKING_DAYS:
+            return employee->working_days;
+        case FIELD_BONUS:
+            return employee->bonus;
+        case FIELD_LATE_COMING_DAYS:
+            return employee->late_coming_days;
+        case FIELD_DEPARTMENT_BONUS:
+            return breakdown->department_bonus;
+        case FIELD_GROSS:
+            return breakdown->total_income;
+        case FIELD_INSURANCE:
+            return breakdown->insurance;
+        case FIELD_TAX:
+            return breakdown->tax;
+        case FIELD_NET:
+            return breakdown->actual_salary;
+        default:
+            return 0;
+    }
+}
+
+
+/**
+ * @brief Encodes a string column as offsets followed by the string bytes.
+ */
+static void encodePlainStrings(ColumnBuffer_t *buffer, ExportField_t field, uint32_t rows)
+{
+    uint32_t offset = 0;                    /* Offset of the current string */
+    uint32_t i = 0;                         /* Index for looping through rows */
+
+    for (i = 0; i < rows; i++)
+    {
+        bufferPutU32(buffer, offset);
+        offset += (uint32_t)strlen(stringField(getEmployeeAt(i), field));
+    }
+    bufferPutU32(buffer, offset);
+    for (i = 0; i < rows; i++)
+    {
+        const int8_t *text = stringField(getEmployeeAt(i), field);     /* String of the row */
+
+        bufferPutBytes(buffer, text, strlen(text));
+    }
+}
+
+
+/**
+ * @brief Encodes a string column as a sorted dictionary of distinct values and one code per row.
+ */
+static void encodeDictionaryStrings(ColumnBuffer_t *buffer, ExportField_t field, uint32_t rows)
+{
+    const int8_t **dictionary = NULL;       /* Distinct values, sorted */
+    const int8_t **found = NULL;            /* Dictionary entry of a row */
+    uint32_t distinct = 0;                  /* Number of distinct values */
+    uint32_t offset = 0;                    /* Offset of the current string */
+    uint32_t i = 0;                         /* Index for looping */
+
+    if (rows > 0)
+    {
+        dictionary = malloc((size_t)rows * sizeof(*dictionary));
+        if (dictionary == NULL)
+        {
+            buffer->failed = 1;
+            return;
+        }
+        for (i = 0; i < rows; i++)
+        {
+            dictionary[i] = stringField(getEmployeeAt(i), field);
+        }
+        qsort(dictionary, rows, sizeof(*dictionary), compareStringPointers);
+        for (i = 0; i < rows; i++)
+        {
+            if (distinct == 0 || strcmp(dictionary[distinct - 1], dictionary[i]) != 0)
+            {
+                dictionary[distinct++] = dictionary[i];
+            }
+        }
+    }
+
+    bufferPutU32(buffer, distinct);
+    for (i = 0; i < distinct; i++)
+    {
+        bufferPutU32(buffer, offset);
+        offset += (uint32_t)strlen(dictionary[i]);
+    }
+    bufferPutU32(buffer, offset);
+    for (i = 0; i < distinct; i++)
+    {
+        bufferPutBytes(buffer, dictionary[i], strlen(dictionary[i]));
+    }
+    for (i = 0; i < rows; i++)
+    {
+        const int8_t *key = stringField(getEmployeeAt(i), field);      /* String of the row */
+
+        found = bsearch(&key, dictionary, distinct, sizeof(*dictionary), compareStringPointers);
+        bufferPutU32(buffer, (uint32_t)(found - dictionary));
+    }
+    free(dictionary);
+}
+
+
+/**
+ * @brief qsort()/bsearch() comparator for an array of string pointers.
+ */
+static int compareStringPointers(const void *first, const void *second)
+{
+    return strcmp(*(const int8_t *const *)first, *(const int8_t *const *)second);
+}
+
+
+/**
+ * @brief Writes bytes to a file in chunks of EXPORT_CHUNK_SIZE.
+ *
+ * @return 1 if everything was written, 0 otherwise.
+ */
+static uint32_t writeChunks(FILE *file, const uint8_t *data, size_t length)
+{
+    size_t chunk = 0;                       /* Size of the current chunk */
+
+    while (length > 0)
+    {
+        chunk = (length < EXPORT_CHUNK_SIZE) ? length : EXPORT_CHUNK_SIZE;
+        if (fwrite(data, 1, chunk, file) != chunk)
+        {
+            return 0;
+        }
+        data += chunk;
+        length -= chunk;
+    }
+    return 1;
+} /* EOF */
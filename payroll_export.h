@@ -0,0 +1,125 @@
+/**
+ * @file payroll_export.h
+ * @brief This file contains the function prototypes for exporting the payroll to a columnar file.
+ *
+ * The columnar file stores every employee field plus the computed gross income, insurance, tax
+ * and net salary. Each column is one contiguous block, so a reader can load only the columns it
+ * needs without parsing text. All integers are little-endian.
+ *
+ *     header    : "MEPCOL01" (8 bytes), version u32, reserved u32
+ *     columns   : one block per column, in directory order
+ *     directory : one 48-byte entry per column:
+ *                 name (24 bytes, NUL padded), type u8, encoding u8, reserved (6 bytes),
+ *                 offset u64 (from start of file), length u64 (bytes)
+ *     trailer   : column count u32, reserved u32, row count u64, directory offset u64,
+ *                 "MEPCOL01" (8 bytes)
+ *
+ * Column blocks by type and encoding:
+ *     U16/F32/U64 + PLAIN  : row count values of 2, 4 or 8 bytes (F32 is IEEE 754 bits)
+ *     U64 + DELTA          : per row, zigzag LEB128 varint of (value - previous value), previous starts at 0
+ *     STRING + PLAIN       : u32 offsets[rows + 1] into the bytes that follow (strings are not NUL terminated)
+ *     STRING + DICTIONARY  : u32 dictionary size n, u32 offsets[n + 1], string bytes, u32 codes[rows]
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef PAYROLL_EXPORT_H
+#define PAYROLL_EXPORT_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for ManageStatus_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define EXPORT_DICTIONARY_STRINGS 0x01u     /* Dictionary-encode the department ID column */
+#define EXPORT_DELTA_NUMBERS 0x02u          /* Delta-encode the 64-bit amount columns */
+
+/**
+ * @brief Value types of the columns.
+ */
+typedef enum ColumnType {
+    COLUMN_TYPE_U16 = 1,
+    COLUMN_TYPE_F32 = 2,
+    COLUMN_TYPE_U64 = 3,
+    COLUMN_TYPE_STRING = 4
+} ColumnType_t;
+
+/**
+ * @brief Encodings of the column blocks.
+ */
+typedef enum ColumnEncoding {
+    COLUMN_ENCODING_PLAIN = 0,
+    COLUMN_ENCODING_DELTA = 1,
+    COLUMN_ENCODING_DICTIONARY = 2
+} ColumnEncoding_t;
+
+/**
+ * @brief One string column of a columnar file, decoded.
+ */
+typedef struct PayrollStringColumn {
+    uint64_t rows;                          /* Number of rows */
+    uint64_t *offsets;                      /* Offset of the string of every row in bytes */
+    int8_t *bytes;                          /* Strings of all rows, each NUL terminated */
+} PayrollStringColumn_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Prompts the user for a file name and exports the payroll into it.
+ *
+ * Strings are dictionary-encoded and amounts delta-encoded.
+ */
+void exportPayroll();
+
+/**
+ * @brief Exports the stored employees and their payroll to a columnar file.
+ *
+ * The columns are: id, department_id, name, salary_base, working_days, working_performance,
+ * bonus, late_coming_days, department_bonus, gross, insurance, tax and net.
+ *
+ * @param path The file to write.
+ * @param flags Combination of EXPORT_DICTIONARY_STRINGS and EXPORT_DELTA_NUMBERS.
+ * @return MANAGE_OK on success, MANAGE_ERR_IO or MANAGE_ERR_NO_MEMORY otherwise.
+ */
+ManageStatus_t exportPayrollColumnar(const char *path, uint32_t flags);
+
+/**
+ * @brief Loads one numeric column of a columnar file.
+ *
+ * Only the directory and the wanted column are read. U16 columns are widened to 64 bits.
+ *
+ * @param path The file to read.
+ * @param column The name of the column, for example "net".
+ * @param values Receives an array allocated with malloc() that the caller must free.
+ * @param rows Receives the number of values.
+ * @return MANAGE_OK on success, MANAGE_ERR_NOT_FOUND if the column does not exist or is not
+ *         numeric, MANAGE_ERR_IO or MANAGE_ERR_NO_MEMORY otherwise.
+ */
+ManageStatus_t readPayrollColumnU64(const char *path, const char *column, uint64_t **values, uint64_t *rows);
+
+/**
+ * @brief Loads one string column of a columnar file.
+ *
+ * Only the directory and the wanted column are read. The string of row i is
+ * strings->bytes + strings->offsets[i].
+ *
+ * @param path The file to read.
+ * @param column The name of the column, for example "id".
+ * @param strings Receives the strings; free them with freePayrollColumnStrings().
+ * @return MANAGE_OK on success, MANAGE_ERR_NOT_FOUND if the column does not exist or does not
+ *         hold strings, MANAGE_ERR_IO or MANAGE_ERR_NO_MEMORY otherwise.
+ */
+ManageStatus_t readPayrollColumnStrings(const char *path, const char *column, PayrollStringColumn_t *strings);
+
+/**
+ * @brief Frees a string column loaded by readPayrollColumnStrings() and leaves it empty.
+ */
+void freePayrollColumnStrings(PayrollStringColumn_t *strings);
+
+#endif /* PAYROLL_EXPORT_H */
@@ -0,0 +1,903 @@
+/**
+ * @file payroll_golden.c
+ * @brief This file contains the implementation of the payroll golden-file check.
+ *
+ * Every record of the dataset is derived from the seed and its own position only, so a block
+ * of records can be generated without generating the records before it. The fingerprint of
+ * an employee is 32 bits of a 64-bit hash of all fields of its salary breakdown, and the
+ * digest chains the 64-bit hashes in employee order, so a change that slips through a
+ * fingerprint still changes the digest.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdio.h>              /* Include standard input and output library for printf, FILE, ... */
+#include <stdlib.h>             /* Include standard library for malloc, free */
+#include <string.h>             /* Include string manipulation library for strcmp, strlen, memcmp */
+#include <time.h>               /* Include time library for clock() */
+#include "payroll_golden.h"     /* Include header file */
+#include "input_handler.h"      /* Include input handler header file for parseUnsignedField() */
+#include "payroll_simulation.h" /* Include payroll simulation header file for calculateSalaryWithRules() */
+#include "shared_table.h"       /* Include shared table header file for sharedTablePayroll() */
+#include "mutation_queue.h"     /* Include mutation queue header file for the queue path */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define GOLDEN_MAGIC "MEPGLD01"             /* Magic bytes at the start of a golden file */
+#define GOLDEN_MAGIC_LENGTH 8               /* Length of the magic bytes */
+#define GOLDEN_BLOCK_EMPLOYEES 65536u       /* Number of employees generated and checked at once */
+#define GOLDEN_EMPLOYEES_PER_DEPARTMENT 64u /* Average size of a generated department */
+#define GOLDEN_DEFAULT_SEED 20240330u       /* Seed used when none is given on the command line */
+#define GOLDEN_QUEUE_PRODUCERS 4u           /* Threads submitting the block to the queue path */
+#define GOLDEN_QUEUE_REPEAT 16u             /* One employee in so many is submitted twice by the queue path */
+
+/**
+ * @brief A registered payroll path.
+ */
+typedef struct PayrollPath {
+    const char *name;                       /* Name used on the command line */
+    PayrollPathFn_t calculate;              /* Calculates the payroll of a block */
+} PayrollPath_t;
+
+/**
+ * @brief Generated dataset and the buffers of one block.
+ */
+typedef struct GoldenDataset {
+    uint64_t seed;                          /* Seed of the dataset */
+    uint32_t employee_count;                /* Number of employees */
+    Department_t *departments;              /* Every department */
+    uint32_t department_count;              /* Number of departments */
+    Employee_t *employees;                  /* Employees of the current block */
+    const Department_t **employee_departments;  /* Department of each employee of the block */
+    SalaryBreakdown_t *breakdowns;          /* Breakdowns calculated for the block */
+} GoldenDataset_t;
+
+/**
+ * @brief Additions of a block submitted by the queue path.
+ */
+typedef struct GoldenQueue {
+    MutationQueue_t queue;                  /* Queue the producers submit to */
+    const PayrollBlock_t *block;            /* The block */
+    SalaryBreakdown_t *breakdowns;          /* Receives the breakdowns, on the writer thread */
+    Mutation_t *additions;                  /* Addition of each employee of the block */
+    Mutation_t *repeats;                    /* Second addition of every GOLDEN_QUEUE_REPEAT-th employee */
+} GoldenQueue_t;
+
+/**
+ * @brief One producer of the queue path.
+ */
+typedef struct GoldenProducer {
+    GoldenQueue_t *state;                   /* The additions */
+    uint32_t index;                         /* Index of the producer */
+} GoldenProducer_t;
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static ManageStatus_t scalarPath(const PayrollBlock_t *block, SalaryBreakdown_t *breakdowns);
+static ManageStatus_t storePath(const PayrollBlock_t *block, SalaryBreakdown_t *breakdowns);
+static ManageStatus_t rulesPath(const PayrollBlock_t *block, SalaryBreakdown_t *breakdowns);
+static ManageStatus_t sharedPath(const PayrollBlock_t *block, SalaryBreakdown_t *breakdowns);
+static ManageStatus_t queuePath(const PayrollBlock_t *block, SalaryBreakdown_t *breakdowns);
+static void* queueProducerThread(void *argument);
+static ManageStatus_t calculateQueuedBlock(void *context);
+static ManageStatus_t openDataset(GoldenDataset_t *dataset, uint64_t seed, uint32_t employee_count);
+static void closeDataset(GoldenDataset_t *dataset);
+static void generateBlock(GoldenDataset_t *dataset, uint32_t first, uint32_t count, PayrollBlock_t *block);
+static void generateEmployee(const GoldenDataset_t *dataset, uint32_t index, Employee_t *employee, uint32_t *department);
+static uint64_t mixBits(uint64_t value);
+static uint64_t nextRandom(uint64_t *state);
+static uint64_t hashBreakdown(const SalaryBreakdown_t *breakdown);
+static uint32_t writeU32(FILE *file, uint32_t value);
+static uint32_t writeU64(FILE *file, uint64_t value);
+static uint32_t readU32(FILE *file, uint32_t *value);
+static uint32_t readU64(FILE *file, uint64_t *value);
+static uint32_t parseArgument(const char *text, uint64_t max_value, uint64_t *value);
+
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+/* Payroll paths checked by payrollGoldenVerify(); register every new fast path here */
+static const PayrollPath_t payroll_paths[] = {
+    {"scalar", scalarPath},                 /* Reference: calculateSalaryForDepartment() per employee */
+    {"store", storePath},                   /* Records added to the store, calculateSalaryBreakdown() */
+    {"rules", rulesPath},                   /* calculateSalaryWithRules() with the current rules */
+    {"shared", sharedPath},                 /* Records published to shared memory, sharedTablePayroll() */
+    {"queue", queuePath}                    /* Records added through a mutation queue by several threads */
+};
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Generates a dataset and writes the golden digests of its reference payroll.
+ *
+ * @return MANAGE_OK, MANAGE_ERR_INVALID_ARGUMENT, MANAGE_ERR_IO or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t payrollGoldenGenerate(const char *path, uint64_t seed, uint32_t employee_count)
+{
+    GoldenDataset_t dataset;                /* Generated records */
+    PayrollBlock_t block;                   /* Current block */
+    FILE *file = NULL;                      /* The golden file */
+    uint64_t digest = 0;                    /* Digest of all breakdowns */
+    uint64_t hash = 0;                      /* Hash of one breakdown */
+    uint32_t ok = 1;                        /* Flag to check if every write succeeded */
+    uint32_t first = 0;                     /* Position of the first employee of the block */
+    uint32_t i = 0;                         /* Index for looping through a block */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the generation */
+
+    if (employee_count == 0)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    status = openDataset(&dataset, seed, employee_count);
+    if (status != MANAGE_OK)
+    {
+        return status;
+    }
+    file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        closeDataset(&dataset);
+        return MANAGE_ERR_IO;
+    }
+    setvbuf(file, NULL, _IOFBF, 1u << 20);
+    ok &= (fwrite(GOLDEN_MAGIC, 1, GOLDEN_MAGIC_LENGTH, file) == GOLDEN_MAGIC_LENGTH) ? 1u : 0u;
+    ok &= writeU64(file, seed);
+    ok &= writeU32(file, employee_count);
+    ok &= writeU32(file, dataset.department_count);
+    /* The digest is only known at the end, its place is rewritten then */
+    ok &= writeU64(file, 0);
+
+    for (first = 0; first < employee_count && ok == 1; first += block.count)
+    {
+        generateBlock(&dataset, first, employee_count - first, &block);
+        scalarPath(&block, dataset.breakdowns);
+        for (i = 0; i < block.count; i++)
+        {
+            hash = hashBreakdown(&dataset.breakdowns[i]);
+            digest = mixBits(digest + hash);
+            ok &= writeU32(file, (uint32_t)(hash ^ (hash >> 32)));
+        }
+    }
+    if (ok == 1 && fseek(file, GOLDEN_MAGIC_LENGTH + 16, SEEK_SET) == 0)
+    {
+        ok &= writeU64(file, digest);
+    }
+    else
+    {
+        ok = 0;
+    }
+    if (fclose(file) != 0)
+    {
+        ok = 0;
+    }
+    closeDataset(&dataset);
+    return (ok == 1) ? MANAGE_OK : MANAGE_ERR_IO;
+}
+
+
+/**
+ * @brief Checks payroll paths against a golden file.
+ *
+ * @return MANAGE_OK if the file was read, MANAGE_ERR_IO, MANAGE_ERR_NOT_FOUND or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t payrollGoldenVerify(const char *path, const char *path_name, PayrollGoldenReport_t *report)
+{
+    GoldenDataset_t dataset;                /* Regenerated records */
+    PayrollBlock_t block;                   /* Current block */
+    PayrollPathResult_t *result = NULL;     /* Result of the path being checked */
+    const PayrollPath_t *checked[PAYROLL_GOLDEN_MAX_PATHS];   /* Paths to check */
+    uint32_t *fingerprints = NULL;          /* Golden fingerprints of the block */
+    int8_t magic[GOLDEN_MAGIC_LENGTH];      /* Magic bytes of the file */
+    uint32_t department_count = 0;          /* Number of departments stored in the file */
+    uint64_t hash = 0;                      /* Hash of one breakdown */
+    uint32_t first = 0;                     /* Position of the first employee of the block */
+    uint32_t i = 0;                         /* Index for looping through a block */
+    uint32_t p = 0;                         /* Index for looping through paths */
+    clock_t started = 0;                    /* Processor time when the path started */
+    FILE *file = NULL;                      /* The golden file */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the verification */
+
+    memset(report, 0, sizeof(*report));
+    for (p = 0; p < sizeof(payroll_paths) / sizeof(payroll_paths[0]); p++)
+    {
+        if (path_name == NULL || strcmp(path_name, payroll_paths[p].name) == 0)
+        {
+            checked[report->path_count] = &payroll_paths[p];
+            report->paths[report->path_count].name = payroll_paths[p].name;
+            report->path_count += 1;
+        }
+    }
+    if (report->path_count == 0)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+
+    file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return MANAGE_ERR_IO;
+    }
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, GOLDEN_MAGIC, sizeof(magic)) != 0
+        || readU64(file, &report->seed) == 0 || readU32(file, &report->employee_count) == 0
+        || readU32(file, &department_count) == 0 || readU64(file, &report->digest) == 0
+        || report->employee_count == 0)
+    {
+        fclose(file);
+        return MANAGE_ERR_IO;
+    }
+    status = openDataset(&dataset, report->seed, report->employee_count);
+    fingerprints = malloc(GOLDEN_BLOCK_EMPLOYEES * sizeof(*fingerprints));
+    if (status == MANAGE_OK && fingerprints == NULL)
+    {
+        status = MANAGE_ERR_NO_MEMORY;
+    }
+    /* A file written by another version of the generator cannot be checked */
+    if (status == MANAGE_OK && department_count != dataset.department_count)
+    {
+        status = MANAGE_ERR_IO;
+    }
+    report->department_count = department_count;
+
+    for (first = 0; first < report->employee_count && status == MANAGE_OK; first += block.count)
+    {
+        generateBlock(&dataset, first, report->employee_count - first, &block);
+        for (i = 0; i < block.count && status == MANAGE_OK; i++)
+        {
+            if (readU32(file, &fingerprints[i]) == 0)
+            {
+                status = MANAGE_ERR_IO;
+            }
+        }
+
+        for (p = 0; p < report->path_count && status == MANAGE_OK; p++)
+        {
+            result = &report->paths[p];
+            if (result->status != MANAGE_OK)
+            {
+                continue;
+            }
+            started = clock();
+            result->status = checked[p]->calculate(&block, dataset.breakdowns);
+            result->seconds += (double)(clock() - started) / CLOCKS_PER_SEC;
+
+            for (i = 0; i < block.count && result->status == MANAGE_OK; i++)
+            {
+                hash = hashBreakdown(&dataset.breakdowns[i]);
+                result->digest = mixBits(result->digest + hash);
+                if ((uint32_t)(hash ^ (hash >> 32)) != fingerprints[i])
+                {
+                    if (result->listed < PAYROLL_GOLDEN_MAX_MISMATCHES)
+                    {
+                        strcpy(result->mismatch_ids[result->listed], block.employees[i].id);
+                        result->mismatch_salaries[result->listed] = dataset.breakdowns[i].actual_salary;
+                        result->listed += 1;
+                    }
+                    result->mismatches += 1;
+                }
+            }
+        }
+    }
+
+    free(fingerprints);
+    closeDataset(&dataset);
+    fclose(file);
+    return status;
+}
+
+
+/**
+ * @brief Runs the golden-file check from the command line.
+ *
+ * @return 0 on success, 1 if a path does not match the golden file, 2 on error.
+ */
+int32_t payrollGoldenCommand(int argc, char *argv[])
+{
+    PayrollGoldenReport_t report;           /* Result of a verification */
+    PayrollPathResult_t *result = NULL;     /* Result of one path */
+    uint64_t employee_count = 0;            /* Number of employees to generate */
+    uint64_t seed = GOLDEN_DEFAULT_SEED;    /* Seed of the dataset */
+    int32_t exit_code = 0;                  /* Exit code of the program */
+    uint32_t p = 0;                         /* Index for looping through paths */
+    uint32_t i = 0;                         /* Index for looping through mismatches */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the command */
+
+    if (argc >= 4 && argc <= 5 && strcmp(argv[1], "--golden-generate") == 0
+        && parseArgument(argv[3], UINT32_MAX, &employee_count) == 1 && employee_count > 0
+        && (argc == 4 || parseArgument(argv[4], UINT64_MAX, &seed) == 1))
+    {
+        status = payrollGoldenGenerate(argv[2], seed, (uint32_t)employee_count);
+        if (status != MANAGE_OK)
+        {
+            printf("Cannot write golden file %s\n", argv[2]);
+            return 2;
+        }
+        printf("Wrote golden payroll of %s employees (seed %llu) to %s\n",
+               formatNumberWithCommas(employee_count), (unsigned long long)seed, argv[2]);
+        return 0;
+    }
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "--golden-verify") == 0)
+    {
+        status = payrollGoldenVerify(argv[2], (argc == 4) ? argv[3] : NULL, &report);
+        if (status == MANAGE_ERR_NOT_FOUND)
+        {
+            printf("No payroll path is named %s\n", argv[3]);
+            return 2;
+        }
+        if (status != MANAGE_OK)
+        {
+            printf("Cannot check golden file %s\n", argv[2]);
+            return 2;
+        }
+        printf("Golden file %s: %s employees, %u departments, seed %llu\n", argv[2],
+               formatNumberWithCommas(report.employee_count), report.department_count,
+               (unsigned long long)report.seed);
+        for (p = 0; p < report.path_count; p++)
+        {
+            result = &report.paths[p];
+            if (result->status != MANAGE_OK)
+            {
+                printf("  %-8s ERROR: the path could not run (status %d)\n", result->name, (int)result->status);
+                exit_code = 2;
+            }
+            else if (result->mismatches == 0 && result->digest == report.digest)
+            {
+                printf("  %-8s OK (%.3f s)\n", result->name, result->seconds);
+            }
+            else
+            {
+                printf("  %-8s MISMATCH: %s employees differ", result->name, formatNumberWithCommas(result->mismatches));
+                printf("%s\n", (result->digest != report.digest) ? ", digest differs" : "");
+                for (i = 0; i < result->listed; i++)
+                {
+                    printf("    %s: actual salary %s (VND)\n", result->mismatch_ids[i],
+                           formatNumberWithCommas(result->mismatch_salaries[i]));
+                }
+                exit_code = (exit_code == 0) ? 1 : exit_code;
+            }
+        }
+        return exit_code;
+    }
+
+    printf("Usage: %s --golden-generate <file> <employees> [seed]\n", argv[0]);
+    printf("       %s --golden-verify <file> [path]\n", argv[0]);
+    printf("Payroll paths:");
+    for (p = 0; p < sizeof(payroll_paths) / sizeof(payroll_paths[0]); p++)
+    {
+        printf(" %s", payroll_paths[p].name);
+    }
+    printf("\n");
+    return 2;
+}
+
+
+/**
+ * @brief Reference path: calculateSalaryForDepartment() on each employee.
+ */
+static ManageStatus_t scalarPath(const PayrollBlock_t *block, SalaryBreakdown_t *breakdowns)
+{
+    uint32_t i = 0;                         /* Index for looping through the block */
+
+    for (i = 0; i < block->count; i++)
+    {
+        calculateSalaryForDepartment(&block->employees[i], block->employee_departments[i], &breakdowns[i]);
+    }
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Store path: the block is added to the store, calculated with calculateSalaryBreakdown()
+ *        (which looks the departments up in the store) and deleted again.
+ *
+ * The departments are added with the first block and deleted after the last one. The store
+ * must not hold any of the dataset's IDs.
+ */
+static ManageStatus_t storePath(const PayrollBlock_t *block, SalaryBreakdown_t *breakdowns)
+{
+    const int8_t **ids = malloc(((size_t)block->count + block->department_count) * sizeof(*ids));  /* IDs to delete */
+    uint32_t created = 0;                   /* Number of departments created */
+    uint32_t first = getTotalEmployees();   /* Position of the block in the store */
+    uint32_t i = 0;                         /* Index for looping through the block */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the path */
+
+    if (ids == NULL)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    if (block->first == 0)
+    {
+        status = ensureDepartments(block->departments, block->department_count, &created);
+        if (status == MANAGE_OK && created != block->department_count)
+        {
+            /* A stored department would be used instead of the dataset's one */
+            status = MANAGE_ERR_DUPLICATE_ID;
+        }
+    }
+    if (status == MANAGE_OK)
+    {
+        status = addEmployeesBatch(block->employees, block->count, NULL, 0);
+    }
+    if (status == MANAGE_OK)
+    {
+        for (i = 0; i < block->count; i++)
+        {
+            calculateSalaryBreakdown(getEmployeeAt(first + i), &breakdowns[i]);
+            ids[i] = block->employees[i].id;
+        }
+        deleteEmployeesBatch(ids, block->count);
+    }
+    /* The departments are the last ones of the store; a failed path is not called again */
+    if (status != MANAGE_OK || block->first + block->count == block->total)
+    {
+        created = (block->first == 0) ? created : block->department_count;
+        for (i = 0; i < created; i++)
+        {
+            ids[i] = getDepartmentAt(getTotalDepartments() - created + i)->id;
+        }
+        deleteDepartmentsBatch(ids, created);
+    }
+    free(ids);
+    return status;
+}
+
+
+/**
+ * @brief Rules path: calculateSalaryWithRules() with payrollRulesDefault(), as used by the
+ *        payroll simulation.
+ */
+static ManageStatus_t rulesPath(const PayrollBlock_t *block, SalaryBreakdown_t *breakdowns)
+{
+    PayrollRules_t rules;                   /* Current rules */
+    uint32_t i = 0;                         /* Index for looping through the block */
+
+    payrollRulesDefault(&rules);
+    for (i = 0; i < block->count; i++)
+    {
+        calculateSalaryWithRules(&block->employees[i], block->employee_departments[i], &rules, &breakdowns[i]);
+    }
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Shared path: the block and every department are published to a segment private to
+ *        this process, and a reader computes the payroll on its mapping.
+ */
+static ManageStatus_t sharedPath(const PayrollBlock_t *block, SalaryBreakdown_t *breakdowns)
+{
+    SharedTableWriter_t writer;             /* Segment the block is published to */
+    SharedTableReader_t reader;             /* Mapping of the same segment */
+    SharedPayrollTotals_t totals;           /* Totals computed by the reader */
+    Employee_t *employees = NULL;           /* Employee table of the segment */
+    Department_t *departments = NULL;       /* Department table of the segment */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the path */
+
+    sharedTableWriterInit(&writer, NULL);
+    status = sharedTableBegin(&writer, block->count, block->department_count, &employees, &departments);
+    if (status != MANAGE_OK)
+    {
+        return status;
+    }
+    memcpy(employees, block->employees, (size_t)block->count * sizeof(Employee_t));
+    memcpy(departments, block->departments, (size_t)block->department_count * sizeof(Department_t));
+    sharedTableCommit(&writer);
+
+    status = sharedTableOpen(&reader, writer.name);
+    if (status == MANAGE_OK)
+    {
+        status = sharedTablePayroll(&reader, breakdowns, block->count, &totals);
+        sharedTableClose(&reader);
+    }
+    sharedTableWriterClose(&writer);
+    return status;
+}
+
+
+/**
+ * @brief Queue path: the departments and the block are added to a store of their own through a
+ *        mutation queue by GOLDEN_QUEUE_PRODUCERS threads at once, and calculated with
+ *        calculateSalaryBreakdown() on the writer thread.
+ *
+ * Producer p submits the employees at positions p, p + GOLDEN_QUEUE_PRODUCERS, ..., and every
+ * GOLDEN_QUEUE_REPEAT-th employee is submitted a second time by another producer, so the writer
+ * gets interleaved runs with duplicate IDs. Of the two additions of an employee exactly one
+ * must succeed, whichever comes first.
+ */
+static ManageStatus_t queuePath(const PayrollBlock_t *block, SalaryBreakdown_t *breakdowns)
+{
+    GoldenQueue_t state;                    /* Additions of the block */
+    GoldenProducer_t producer[GOLDEN_QUEUE_PRODUCERS];     /* Arguments of the producers */
+    pthread_t threads[GOLDEN_QUEUE_PRODUCERS];             /* Producer threads */
+    uint32_t started[GOLDEN_QUEUE_PRODUCERS];              /* Set for producers that run on a thread */
+    Mutation_t *departments = malloc(((size_t)block->department_count + 1) * sizeof(*departments));  /* Department creations */
+    Mutation_t calculate;                   /* Calculates the block once everything is added */
+    EmployeeStore_t *store = createEmployeeStore();        /* Store of the path */
+    EmployeeStore_t *previous = NULL;       /* Store selected by the caller */
+    ManageStatus_t first_status = MANAGE_OK;    /* Result of the first addition of a repeated employee */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the path */
+    uint32_t p = 0;                         /* Index for looping through producers */
+    uint32_t i = 0;                         /* Index for looping through the block */
+
+    state.block = block;
+    state.breakdowns = breakdowns;
+    state.additions = malloc((size_t)block->count * sizeof(*state.additions));
+    state.repeats = malloc(((size_t)block->count / GOLDEN_QUEUE_REPEAT + 1) * sizeof(*state.repeats));
+    if (departments == NULL || store == NULL || state.additions == NULL || state.repeats == NULL)
+    {
+        free(departments);
+        free(state.additions);
+        free(state.repeats);
+        destroyEmployeeStore(store);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    previous = selectEmployeeStore(store);
+    status = mutationQueueStart(&state.queue);
+    selectEmployeeStore(previous);
+
+    if (status == MANAGE_OK)
+    {
+        /* Submitted before any producer starts, so created before any addition is applied */
+        for (i = 0; i < block->department_count; i++)
+        {
+            mutationEnsureDepartment(&departments[i], &block->departments[i]);
+            mutationQueueSubmit(&state.queue, &departments[i], NULL, NULL);
+        }
+        for (p = 0; p < GOLDEN_QUEUE_PRODUCERS; p++)
+        {
+            producer[p].state = &state;
+            producer[p].index = p;
+            started[p] = (pthread_create(&threads[p], NULL, queueProducerThread, &producer[p]) == 0);
+            if (started[p] == 0)
+            {
+                queueProducerThread(&producer[p]);
+            }
+        }
+        for (p = 0; p < GOLDEN_QUEUE_PRODUCERS; p++)
+        {
+            if (started[p] != 0)
+            {
+                pthread_join(threads[p], NULL);
+            }
+        }
+        /* Applied after every submission above, as the producers have finished */
+        mutationCall(&calculate, calculateQueuedBlock, &state);
+        status = mutationQueueApply(&state.queue, &calculate);
+        mutationQueueStop(&state.queue);
+    }
+
+    for (i = 0; i < block->department_count && status == MANAGE_OK; i++)
+    {
+        status = departments[i].status;
+    }
+    /* The last employee of the block is never repeated */
+    for (i = 0; i + 1 < block->count && status == MANAGE_OK; i += GOLDEN_QUEUE_REPEAT)
+    {
+        first_status = state.additions[i].status;
+        if ((first_status == MANAGE_OK) == (state.repeats[i / GOLDEN_QUEUE_REPEAT].status == MANAGE_OK))
+        {
+            status = (first_status == MANAGE_OK) ? MANAGE_ERR_DUPLICATE_ID : first_status;
+        }
+    }
+    free(departments);
+    free(state.additions);
+    free(state.repeats);
+    destroyEmployeeStore(store);
+    return status;
+}
+
+
+/**
+ * @brief Producer of the queue path: submits its share of the block without waiting.
+ */
+static void* queueProducerThread(void *argument)
+{
+    GoldenProducer_t *producer = argument;  /* The producer */
+    GoldenQueue_t *state = producer->state; /* Additions of the block */
+    uint32_t i = 0;                         /* Index for looping through the block */
+
+    for (i = producer->index; i < state->block->count; i += GOLDEN_QUEUE_PRODUCERS)
+    {
+        mutationAddEmployee(&state->additions[i], &state->block->employees[i]);
+        mutationQueueSubmit(&state->queue, &state->additions[i], NULL, NULL);
+        /* The repeat of employee i - 1 comes from the producer after the one that submitted it */
+        if (i > 0 && (i - 1) % GOLDEN_QUEUE_REPEAT == 0)
+        {
+            mutationAddEmployee(&state->repeats[(i - 1) / GOLDEN_QUEUE_REPEAT], &state->block->employees[i - 1]);
+            mutationQueueSubmit(&state->queue, &state->repeats[(i - 1) / GOLDEN_QUEUE_REPEAT], NULL, NULL);
+        }
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Calculates the queue path's block from its store, on the writer thread.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_NOT_FOUND if an employee of the block was not added.
+ */
+static ManageStatus_t calculateQueuedBlock(void *context)
+{
+    GoldenQueue_t *state = context;         /* Additions of the block */
+    const Employee_t *employee = NULL;      /* Stored employee */
+    uint32_t i = 0;                         /* Index for looping through the block */
+
+    for (i = 0; i < state->block->count; i++)
+    {
+        employee = findEmployee(state->block->employees[i].id);
+        if (employee == NULL)
+        {
+            return MANAGE_ERR_NOT_FOUND;
+        }
+        calculateSalaryBreakdown(employee, &state->breakdowns[i]);
+    }
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Generates the departments of a dataset and allocates the block buffers.
+ *
+ * @return MANAGE_OK or MANAGE_ERR_NO_MEMORY.
+ */
+static ManageStatus_t openDataset(GoldenDataset_t *dataset, uint64_t seed, uint32_t employee_count)
+{
+    Department_t *department = NULL;        /* Department being generated */
+    uint64_t state = 0;                     /* Random state of the department */
+    uint32_t i = 0;                         /* Index for looping through departments */
+
+    memset(dataset, 0, sizeof(*dataset));
+    dataset->seed = seed;
+    dataset->employee_count = employee_count;
+    dataset->department_count = employee_count / GOLDEN_EMPLOYEES_PER_DEPARTMENT + 1;
+    dataset->departments = calloc(dataset->department_count, sizeof(*dataset->departments));
+    dataset->employees = malloc(GOLDEN_BLOCK_EMPLOYEES * sizeof(*dataset->employees));
+    dataset->employee_departments = malloc(GOLDEN_BLOCK_EMPLOYEES * sizeof(*dataset->employee_departments));
+    dataset->breakdowns = malloc(GOLDEN_BLOCK_EMPLOYEES * sizeof(*dataset->breakdowns));
+    if (dataset->departments == NULL || dataset->employees == NULL
+        || dataset->employee_departments == NULL || dataset->breakdowns == NULL)
+    {
+        closeDataset(dataset);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+
+    for (i = 0; i < dataset->department_count; i++)
+    {
+        department = &dataset->departments[i];
+        /* Departments use the upper half of the random streams, employees the lower half */
+        state = mixBits(seed ^ mixBits(((uint64_t)1 << 63) | i));
+        sprintf(department->id, "D%06u", i);
+        department->bonus_salary = (nextRandom(&state) % 4 == 0) ? 0 : (nextRandom(&state) % 2001) * 1000;
+        switch (nextRandom(&state) % 8)
+        {
+            case 0:
+                /* Older records store 0 for "no raise" */
+                department->raise_factor = 0;
+                break;
+            case 1:
+            case 2:
+                department->raise_factor = DEPARTMENT_NO_RAISE + 1 + (uint32_t)(nextRandom(&state) % 5000);
+                break;
+            default:
+                department->raise_factor = DEPARTMENT_NO_RAISE;
+        }
+    }
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Frees the memory of a dataset.
+ */
+static void closeDataset(GoldenDataset_t *dataset)
+{
+    free(dataset->departments);
+    free(dataset->employees);
+    free(dataset->employee_departments);
+    free(dataset->breakdowns);
+    memset(dataset, 0, sizeof(*dataset));
+}
+
+
+/**
+ * @brief Generates the employees of the block starting at the given position.
+ *
+ * @param remaining Number of employees from first to the end of the dataset.
+ */
+static void generateBlock(GoldenDataset_t *dataset, uint32_t first, uint32_t remaining, PayrollBlock_t *block)
+{
+    uint32_t department = 0;                /* Position of an employee's department */
+    uint32_t i = 0;                         /* Index for looping through the block */
+
+    block->count = (remaining < GOLDEN_BLOCK_EMPLOYEES) ? remaining : GOLDEN_BLOCK_EMPLOYEES;
+    for (i = 0; i < block->count; i++)
+    {
+        generateEmployee(dataset, first + i, &dataset->employees[i], &department);
+        dataset->employee_departments[i] = &dataset->departments[department];
+    }
+    block->first = first;
+    block->total = dataset->employee_count;
+    block->employees = dataset->employees;
+    block->employee_departments = dataset->employee_departments;
+    block->departments = dataset->departments;
+    block->department_count = dataset->department_count;
+}
+
+
+/**
+ * @brief Generates one employee from the seed and its position.
+ *
+ * Besides typical records, the dataset holds records whose net income is close to the tax
+ * thresholds, records with no income and records with large incomes. The bonus is never
+ * less than the late coming penalty, so the gross income cannot wrap around.
+ */
+static void generateEmployee(const GoldenDataset_t *dataset, uint32_t index, Employee_t *employee, uint32_t *department)
+{
+    uint64_t state = mixBits(dataset->seed ^ mixBits(index));    /* Random state of the employee */
+    uint64_t penalty = 0;                   /* Late coming penalty */
+    uint64_t target = 0;                    /* Gross income aimed at near a tax threshold */
+    const Department_t *chosen = NULL;      /* The employee's department */
+
+    memset(employee, 0, sizeof(*employee));
+    *department = (uint32_t)(nextRandom(&state) % dataset->department_count);
+    chosen = &dataset->departments[*department];
+    sprintf(employee->id, "E%09u", index);
+    sprintf(employee->name, "Employee %u", index);
+    strcpy(employee->department_id, chosen->id);
+    employee->late_coming_days = (EmployeeDays_t)(nextRandom(&state) % 9);
+    employee->bonus = (nextRandom(&state) % 3 == 0) ? 0 : (nextRandom(&state) % 2000001);
+
+    switch (nextRandom(&state) % 8)
+    {
+        case 0:
+            /* Net income within 1,000 VND of the 11,000,000 or 16,000,000 tax threshold */
+            target = (nextRandom(&state) % 2 == 0) ? 11000000 : 16000000;
+            target = (uint64_t)(target / 0.895) + nextRandom(&state) % 2001 - 1000;
+            employee->working_days = 1;
+            employee->working_performance = 1.0f;
+            employee->bonus = 0;
+            employee->late_coming_days = 0;
+            employee->salary_base = (target > chosen->bonus_salary) ? target - chosen->bonus_salary : target;
+            break;
+        case 1:
+            /* No income from work */
+            employee->salary_base = (nextRandom(&state) % 2 == 0) ? 0 : (nextRandom(&state) % 1000) * 1000;
+            employee->working_days = (employee->salary_base == 0) ? (EmployeeDays_t)(nextRandom(&state) % 32) : 0;
+            employee->working_performance = (float)(nextRandom(&state) % 300 + 1) / 100.0f;
+            break;
+        case 2:
+            /* Large income */
+            employee->salary_base = nextRandom(&state) % 50000001;
+            employee->working_days = (EmployeeDays_t)(nextRandom(&state) % 32);
+            employee->working_performance = (float)(nextRandom(&state) % 500 + 1) / 100.0f;
+            break;
+        default:
+            /* Typical record */
+            employee->salary_base = (nextRandom(&state) % 901 + 100) * 1000;
+            employee->working_days = (EmployeeDays_t)(15 + nextRandom(&state) % 17);
+            employee->working_performance = (float)(nextRandom(&state) % 30 + 1) / 10.0f;
+    }
+
+    penalty = (uint64_t)employee->late_coming_days * ((employee->late_coming_days <= 3) ? 10000 : 20000);
+    if (employee->bonus < penalty)
+    {
+        employee->bonus = penalty;
+    }
+}
+
+
+/**
+ * @brief Scrambles the bits of a 64-bit value (SplitMix64 finalizer).
+ */
+static uint64_t mixBits(uint64_t value)
+{
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ull;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBull;
+    value ^= value >> 31;
+    return value;
+}
+
+
+/**
+ * @brief Returns the next value of a SplitMix64 random sequence.
+ */
+static uint64_t nextRandom(uint64_t *state)
+{
+    *state += 0x9E3779B97F4A7C15ull;
+    return mixBits(*state);
+}
+
+
+/**
+ * @brief Returns a 64-bit hash of every field of a salary breakdown.
+ */
+static uint64_t hashBreakdown(const SalaryBreakdown_t *breakdown)
+{
+    uint64_t hash = 0x243F6A8885A308D3ull; /* Running hash */
+
+    hash = mixBits(hash ^ breakdown->department_bonus);
+    hash = mixBits(hash ^ breakdown->late_coming_penalty);
+    hash = mixBits(hash ^ breakdown->income_without_bonus);
+    hash = mixBits(hash ^ breakdown->total_income);
+    hash = mixBits(hash ^ breakdown->insurance);
+    hash = mixBits(hash ^ breakdown->totalIncome_without_tax);
+    hash = mixBits(hash ^ breakdown->tax);
+    hash = mixBits(hash ^ breakdown->department_raise);
+    hash = mixBits(hash ^ breakdown->actual_salary);
+    return hash;
+}
+
+
+/**
+ * @brief Writes a little-endian 32-bit value. Returns 1 on success, 0 otherwise.
+ */
+static uint32_t writeU32(FILE *file, uint32_t value)
+{
+    uint8_t bytes[4];                       /* Encoded value */
+    uint32_t i = 0;                         /* Index for looping through bytes */
+
+    for (i = 0; i < 4; i++)
+    {
+        bytes[i] = (uint8_t)(value >> (8 * i));
+    }
+    return (fwrite(bytes, 1, 4, file) == 4) ? 1u : 0u;
+}
+
+
+/**
+ * @brief Writes a little-endian 64-bit value. Returns 1 on success, 0 otherwise.
+ */
+static uint32_t writeU64(FILE *file, uint64_t value)
+{
+    return writeU32(file, (uint32_t)value) & writeU32(file, (uint32_t)(value >> 32));
+}
+
+
+/**
+ * @brief Reads a little-endian 32-bit value. Returns 1 on success, 0 otherwise.
+ */
+static uint32_t readU32(FILE *file, uint32_t *value)
+{
+    uint8_t bytes[4];                       /* Encoded value */
+
+    if (fread(bytes, 1, 4, file) != 4)
+    {
+        return 0;
+    }
+    *value = (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    return 1;
+}
+
+
+/**
+ * @brief Reads a little-endian 64-bit value. Returns 1 on success, 0 otherwise.
+ */
+static uint32_t readU64(FILE *file, uint64_t *value)
+{
+    uint32_t low = 0;                       /* Lower half */
+    uint32_t high = 0;                      /* Upper half */
+
+    if (readU32(file, &low) == 0 || readU32(file, &high) == 0)
+    {
+        return 0;
+    }
+    *value = (uint64_t)low | ((uint64_t)high << 32);
+    return 1;
+}
+
+
+/**
+ * @brief Parses a whole number given on the command line. Returns 1 on success, 0 otherwise.
+ */
+static uint32_t parseArgument(const char *text, uint64_t max_value, uint64_t *value)
+{
+    return (parseUnsignedField(text, (uint32_t)strlen(text), max_value, value) == PARSE_OK) ? 1u : 0u;
+} /* EOF */
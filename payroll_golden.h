@@ -0,0 +1,129 @@
+/**
+ * @file payroll_golden.h
+ * @brief This file contains the function prototypes of the payroll golden-file check.
+ *
+ * The check protects the salary calculation against silent changes. A dataset of employees
+ * and departments is generated from a seed (the same seed always gives the same records, on
+ * every machine), its payroll is calculated with the reference calculateSalaryForDepartment()
+ * and a compact digest of every salary breakdown is written to a golden file:
+ *
+ *     8 bytes  "MEPGLD01"
+ *     u64      seed
+ *     u32      number of employees
+ *     u32      number of departments
+ *     u64      digest of all breakdowns, in employee order
+ *     u32      fingerprint of the breakdown of each employee, in employee order
+ *
+ * All numbers are little-endian. Verifying regenerates the dataset from the seed, runs every
+ * registered payroll path on it (see payroll_paths in payroll_golden.c) and compares the
+ * results with the file, so a faster path (fixed point, SIMD, threads, ...) is checked by
+ * registering it there. Records are generated and checked in blocks, so datasets of millions
+ * of employees only need memory for one block.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef PAYROLL_GOLDEN_H
+#define PAYROLL_GOLDEN_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for Employee_t and SalaryBreakdown_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define PAYROLL_GOLDEN_MAX_PATHS 8          /* Largest number of registered payroll paths */
+#define PAYROLL_GOLDEN_MAX_MISMATCHES 10    /* Number of mismatching employees listed per path */
+
+/**
+ * @brief Records given to a payroll path.
+ */
+typedef struct PayrollBlock {
+    const Employee_t *employees;            /* Employees of the block */
+    const Department_t *const *employee_departments;   /* Department of each employee */
+    uint32_t count;                         /* Number of employees in the block */
+    uint32_t first;                         /* Position of the block's first employee in the dataset */
+    uint32_t total;                         /* Number of employees in the dataset */
+    const Department_t *departments;        /* Every department of the dataset */
+    uint32_t department_count;              /* Number of departments */
+} PayrollBlock_t;
+
+/**
+ * @brief Calculates the payroll of a block of employees.
+ *
+ * @param block The employees and their departments.
+ * @param breakdowns Receives the salary breakdown of each employee, in block order.
+ * @return MANAGE_OK, or the reason the path could not run.
+ */
+typedef ManageStatus_t (*PayrollPathFn_t)(const PayrollBlock_t *block, SalaryBreakdown_t *breakdowns);
+
+/**
+ * @brief Result of one payroll path.
+ */
+typedef struct PayrollPathResult {
+    const char *name;                       /* Name of the path */
+    ManageStatus_t status;                  /* MANAGE_OK if the path ran on every employee */
+    uint64_t mismatches;                    /* Number of employees whose breakdown differs */
+    uint64_t digest;                        /* Digest of the path's breakdowns */
+    double seconds;                         /* Processor time spent in the path */
+    uint32_t listed;                        /* Number of entries in the mismatch lists */
+    int8_t mismatch_ids[PAYROLL_GOLDEN_MAX_MISMATCHES][MAX_ID_LENGTH]; /* First mismatching employees */
+    uint64_t mismatch_salaries[PAYROLL_GOLDEN_MAX_MISMATCHES];     /* Their actual salary from the path */
+} PayrollPathResult_t;
+
+/**
+ * @brief Result of a verification.
+ */
+typedef struct PayrollGoldenReport {
+    uint64_t seed;                          /* Seed of the dataset */
+    uint32_t employee_count;                /* Number of employees in the dataset */
+    uint32_t department_count;              /* Number of departments in the dataset */
+    uint64_t digest;                        /* Digest stored in the golden file */
+    uint32_t path_count;                    /* Number of entries in paths */
+    PayrollPathResult_t paths[PAYROLL_GOLDEN_MAX_PATHS];   /* Result of each checked path */
+} PayrollGoldenReport_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Generates a dataset and writes the golden digests of its reference payroll.
+ *
+ * @param path Path of the golden file.
+ * @param seed Seed of the dataset.
+ * @param employee_count Number of employees, more than 0.
+ * @return MANAGE_OK, MANAGE_ERR_INVALID_ARGUMENT, MANAGE_ERR_IO or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t payrollGoldenGenerate(const char *path, uint64_t seed, uint32_t employee_count);
+
+/**
+ * @brief Checks payroll paths against a golden file.
+ *
+ * A path that fails to run is reported with its status; the other paths are still checked.
+ *
+ * @param path Path of the golden file.
+ * @param path_name Name of the path to check, or NULL to check every registered path.
+ * @param report Receives the result of each path.
+ * @return MANAGE_OK if the file was read (some paths may have mismatches), MANAGE_ERR_IO if it
+ *         cannot be read or is not a golden file, MANAGE_ERR_NOT_FOUND if no path has the
+ *         given name, or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t payrollGoldenVerify(const char *path, const char *path_name, PayrollGoldenReport_t *report);
+
+/**
+ * @brief Runs the golden-file check from the command line.
+ *
+ *     --golden-generate <file> <employees> [seed]
+ *     --golden-verify <file> [path]
+ *
+ * @param argc Number of arguments, as given to main().
+ * @param argv Arguments, as given to main().
+ * @return Exit code: 0 on success, 1 if a path does not match the golden file, 2 on error.
+ */
+int32_t payrollGoldenCommand(int argc, char *argv[]);
+
+#endif /* PAYROLL_GOLDEN_H */
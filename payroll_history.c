@@ -0,0 +1,914 @@
+/**
+ * @file payroll_history.c
+ * @brief This file contains the implementation of the multi-month payroll history.
+ *
+ * A month is encoded as:
+ *     varint  month number - previous month number (previous is 0 for a keyframe)
+ *     varint  bit mask of the fields that differ from the previous month
+ *     varint  zigzag(field - previous field) for every bit set in the mask, lowest bit first
+ * The encoding is described in payroll_history.h.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdio.h>              /* Include standard input and output library for printf, FILE, ... */
+#include <stdlib.h>             /* Include standard library for malloc, realloc, free */
+#include <string.h>             /* Include string manipulation library for strlen, memcpy, memset */
+#include "payroll_history.h"    /* Include header file */
+#include "input_handler.h"      /* Include input handler header file for handling user input */
+#include "payroll_stream.h"     /* Include payroll stream header file for reading the payroll in batches */
+#include "tenant_store.h"       /* Include tenant store header file for the history of the selected company */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define HISTORY_MAGIC "MEPHIS01"            /* Magic bytes at the start of a history file */
+#define HISTORY_MAGIC_LENGTH 8              /* Length of the magic bytes */
+#define HISTORY_MIN_BYTES 64u               /* Initial size of an employee's byte stream */
+
+/**
+ * @brief Position of each field in the encoded field vector.
+ */
+typedef enum HistoryField {
+    HISTORY_SALARY_BASE = 0,
+    HISTORY_WORKING_DAYS,
+    HISTORY_WORKING_PERFORMANCE,
+    HISTORY_BONUS,
+    HISTORY_LATE_COMING_DAYS,
+    HISTORY_DEPARTMENT_BONUS,
+    HISTORY_RAISE_FACTOR,
+    HISTORY_GROSS,
+    HISTORY_INSURANCE,
+    HISTORY_TAX,
+    HISTORY_NET
+} HistoryField_t;
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static const int8_t* entryKey(uint32_t value, const void *context);
+static void recordToFields(const PayrollMonthRecord_t *record, uint64_t *fields);
+static void fieldsToRecord(const uint64_t *fields, uint32_t period, PayrollMonthRecord_t *record);
+static uint32_t putVarint(HistoryEntry_t *entry, uint64_t value);
+static uint32_t getVarint(const uint8_t *bytes, uint32_t length, uint32_t *position, uint64_t *value);
+static int32_t findOrAddEntry(PayrollHistory_t *history, const int8_t *employee_id);
+static uint32_t writeU32(FILE *file, uint32_t value);
+static uint32_t writeU64(FILE *file, uint64_t value);
+static uint32_t readU32(FILE *file, uint32_t *value);
+static uint32_t readU64(FILE *file, uint64_t *value);
+static int32_t printHistoryRecord(const int8_t *employee_id, const PayrollMonthRecord_t *record, void *context);
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Initializes an empty history.
+ *
+ * The history must not be moved in memory afterwards, because its ID index refers to it.
+ */
+void payrollHistoryInit(PayrollHistory_t *history)
+{
+    history->entries = NULL;
+    history->entry_count = 0;
+    history->entry_capacity = 0;
+    idIndexInit(&history->by_id, entryKey, history);
+}
+
+
+/**
+ * @brief Frees all memory of a history and leaves it empty.
+ */
+void payrollHistoryFree(PayrollHistory_t *history)
+{
+    uint32_t i = 0;                         /* Index for looping through entries */
+
+    for (i = 0; i < history->entry_count; i++)
+    {
+        free(history->entries[i].id);
+        free(history->entries[i].bytes);
+        free(history->entries[i].keyframe_offsets);
+        free(history->entries[i].keyframe_periods);
+    }
+    free(history->entries);
+    idIndexFree(&history->by_id);
+    history->entries = NULL;
+    history->entry_count = 0;
+    history->entry_capacity = 0;
+}
+
+
+/**
+ * @brief Appends one month to an employee's history.
+ *
+ * @return MANAGE_OK, MANAGE_ERR_DUPLICATE_ID if the month is already recorded,
+ *         MANAGE_ERR_INVALID_ARGUMENT if the month is invalid or older than the last one,
+ *         or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t payrollHistoryAppend(PayrollHistory_t *history, const int8_t *employee_id,
+                                    const PayrollMonthRecord_t *record)
+{
+    HistoryEntry_t *entry = NULL;           /* History of the employee */
+    uint64_t fields[HISTORY_FIELD_COUNT];   /* Fields of the new month */
+    uint64_t zero[HISTORY_FIELD_COUNT];     /* Base of a keyframe */
+    const uint64_t *base = NULL;            /* Fields the new month is encoded against */
+    uint32_t period = 0;                    /* Month number of the new month */
+    uint32_t base_period = 0;               /* Month number the new month is encoded against */
+    uint32_t is_keyframe = 0;               /* Flag to check if the new month is a keyframe */
+    uint32_t old_length = 0;                /* Length of the stream before encoding, to undo on failure */
+    uint32_t *grown = NULL;                 /* Reallocated keyframe array */
+    uint64_t mask = 0;                      /* Fields that changed */
+    uint64_t delta = 0;                     /* Difference of one field */
+    uint32_t ok = 1;                        /* Flag to check if every byte was written */
+    int32_t position = 0;                   /* Position of the entry */
+    uint32_t i = 0;                         /* Index for looping through fields */
+
+    if (employee_id == NULL || employee_id[0] == '\0' || record->month < 1 || record->month > 12)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    period = (uint32_t)record->year * 12u + record->month - 1u;
+
+    position = findOrAddEntry(history, employee_id);
+    if (position < 0)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    entry = &history->entries[position];
+    if (entry->record_count > 0 && period == entry->last_period)
+    {
+        return MANAGE_ERR_DUPLICATE_ID;
+    }
+    if (entry->record_count > 0 && period < entry->last_period)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+
+    recordToFields(record, fields);
+    memset(zero, 0, sizeof(zero));
+    is_keyframe = (entry->record_count % HISTORY_KEYFRAME_INTERVAL == 0) ? 1 : 0;
+    base = (is_keyframe == 1) ? zero : entry->last;
+    base_period = (is_keyframe == 1) ? 0 : entry->last_period;
+
+    if (is_keyframe == 1)
+    {
+        grown = realloc(entry->keyframe_offsets, (entry->keyframe_count + 1) * sizeof(*grown));
+        if (grown == NULL)
+        {
+            return MANAGE_ERR_NO_MEMORY;
+        }
+        entry->keyframe_offsets = grown;
+        grown = realloc(entry->keyframe_periods, (entry->keyframe_count + 1) * sizeof(*grown));
+        if (grown == NULL)
+        {
+            return MANAGE_ERR_NO_MEMORY;
+        }
+        entry->keyframe_periods = grown;
+    }
+
+    for (i = 0; i < HISTORY_FIELD_COUNT; i++)
+    {
+        if (fields[i] != base[i])
+        {
+            mask |= (uint64_t)1 << i;
+        }
+    }
+
+    old_length = entry->length;
+    ok &= putVarint(entry, period - base_period);
+    ok &= putVarint(entry, mask);
+    for (i = 0; i < HISTORY_FIELD_COUNT; i++)
+    {
+        if ((mask & ((uint64_t)1 << i)) != 0)
+        {
+            delta = fields[i] - base[i];
+            /* Zigzag: small negative and positive differences both become small varints */
+            ok &= putVarint(entry, (delta << 1) ^ (uint64_t)(-(int64_t)(delta >> 63)));
+        }
+    }
+    if (ok == 0)
+    {
+        entry->length = old_length;
+        return MANAGE_ERR_NO_MEMORY;
+    }
+
+    if (is_keyframe == 1)
+    {
+        entry->keyframe_offsets[entry->keyframe_count] = old_length;
+        entry->keyframe_periods[entry->keyframe_count] = period;
+        entry->keyframe_count += 1;
+    }
+    memcpy(entry->last, fields, sizeof(fields));
+    entry->last_period = period;
+    entry->record_count += 1;
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Records the current payroll of every stored employee for one month.
+ *
+ * @return MANAGE_OK, MANAGE_ERR_INVALID_ARGUMENT or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t payrollHistoryRecordMonth(PayrollHistory_t *history, uint16_t year, uint8_t month,
+                                         uint32_t *recorded)
+{
+    PayrollMonthRecord_t record;            /* Month of the current employee */
+    PayrollLine_t lines[PAYROLL_STREAM_BATCH];     /* Current batch of employees and their payroll */
+    const PayrollLine_t *line = NULL;       /* Current employee */
+    PayrollCursor_t cursor;                 /* Walk through the store */
+    ManageStatus_t status = MANAGE_OK;      /* Result of appending one month */
+    uint32_t filled = 0;                    /* Number of lines in the batch */
+    uint32_t count = 0;                     /* Number of recorded employees */
+    uint32_t i = 0;                         /* Index for looping through the batch */
+
+    if (month < 1 || month > 12)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    if (idIndexReserve(&history->by_id, getTotalEmployees()) != MANAGE_OK)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    payrollCursorOpen(&cursor, NULL, 0, PAYROLL_CURSOR_SALARY);
+    while (status != MANAGE_ERR_NO_MEMORY && (filled = payrollCursorNext(&cursor, lines, PAYROLL_STREAM_BATCH)) > 0)
+    {
+        for (i = 0; i < filled; i++)
+        {
+            line = &lines[i];
+            record.year = year;
+            record.month = month;
+            record.salary_base = line->employee->salary_base;
+            record.working_days = line->employee->working_days;
+            record.working_performance = line->employee->working_performance;
+            record.bonus = line->employee->bonus;
+            record.late_coming_days = line->employee->late_coming_days;
+            record.department_bonus = line->salary.department_bonus;
+            record.raise_factor = (line->department != NULL) ? line->department->raise_factor : 0;
+            record.gross = line->salary.total_income;
+            record.insurance = line->salary.insurance;
+            record.tax = line->salary.tax;
+            record.net = line->salary.actual_salary;
+
+            status = payrollHistoryAppend(history, line->employee->id, &record);
+            if (status == MANAGE_OK)
+            {
+                count += 1;
+            }
+            else if (status == MANAGE_ERR_NO_MEMORY)
+            {
+                break;
+            }
+        }
+    }
+    if (recorded != NULL)
+    {
+        *recorded = count;
+    }
+    return (status == MANAGE_ERR_NO_MEMORY) ? status : MANAGE_OK;
+}
+
+
+/**
+ * @brief Reads one month of one employee.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_NOT_FOUND if the employee or the month is not recorded.
+ */
+ManageStatus_t payrollHistoryGet(const PayrollHistory_t *history, const int8_t *employee_id,
+                                 uint16_t year, uint8_t month, PayrollMonthRecord_t *record)
+{
+    const HistoryEntry_t *entry = NULL;     /* History of the employee */
+    uint64_t fields[HISTORY_FIELD_COUNT];   /* Fields of the decoded month */
+    uint64_t value = 0;                     /* Decoded varint */
+    uint64_t mask = 0;                      /* Fields that changed */
+    uint32_t wanted = 0;                    /* Month number of the wanted month */
+    uint32_t period = 0;                    /* Month number of the decoded month */
+    uint32_t position = 0;                  /* Read position in the stream */
+    uint32_t end = 0;                       /* End of the keyframe's group of months */
+    uint32_t low = 0;                       /* Binary search bounds */
+    uint32_t high = 0;
+    uint32_t middle = 0;
+    uint32_t value_index = 0;               /* Position of the entry */
+    uint32_t i = 0;                         /* Index for looping through fields */
+
+    if (month < 1 || month > 12 || idIndexFind(&history->by_id, employee_id, &value_index) == 0)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    entry = &history->entries[value_index];
+    wanted = (uint32_t)year * 12u + month - 1u;
+    if (entry->keyframe_count == 0 || wanted < entry->keyframe_periods[0] || wanted > entry->last_period)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+
+    /* Last keyframe that is not later than the wanted month */
+    low = 0;
+    high = entry->keyframe_count;
+    while (high - low > 1)
+    {
+        middle = (low + high) / 2;
+        if (entry->keyframe_periods[middle] <= wanted)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    position = entry->keyframe_offsets[low];
+    end = (low + 1 < entry->keyframe_count) ? entry->keyframe_offsets[low + 1] : entry->length;
+
+    /* Decode forward from the keyframe until the wanted month */
+    memset(fields, 0, sizeof(fields));
+    period = 0;
+    while (position < end)
+    {
+        if (getVarint(entry->bytes, end, &position, &value) == 0)
+        {
+            return MANAGE_ERR_NOT_FOUND;
+        }
+        period += (uint32_t)value;
+        if (getVarint(entry->bytes, end, &position, &mask) == 0)
+        {
+            return MANAGE_ERR_NOT_FOUND;
+        }
+        for (i = 0; i < HISTORY_FIELD_COUNT; i++)
+        {
+            if ((mask & ((uint64_t)1 << i)) != 0)
+            {
+                if (getVarint(entry->bytes, end, &position, &value) == 0)
+                {
+                    return MANAGE_ERR_NOT_FOUND;
+                }
+                fields[i] += (value >> 1) ^ (uint64_t)(-(int64_t)(value & 1));
+            }
+        }
+        if (period == wanted)
+        {
+            fieldsToRecord(fields, period, record);
+            return MANAGE_OK;
+        }
+        if (period > wanted)
+        {
+            break;
+        }
+    }
+    return MANAGE_ERR_NOT_FOUND;
+}
+
+
+/**
+ * @brief Calls a function for every employee that has a record for the given month.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_INVALID_ARGUMENT if the month is invalid.
+ */
+ManageStatus_t payrollHistoryForEachInMonth(const PayrollHistory_t *history, uint16_t year, uint8_t month,
+                                            HistoryMonthFn_t callback, void *context)
+{
+    PayrollMonthRecord_t record;            /* Month of the current employee */
+    uint32_t i = 0;                         /* Index for looping through entries */
+
+    if (month < 1 || month > 12)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    for (i = 0; i < history->entry_count; i++)
+    {
+        if (payrollHistoryGet(history, history->entries[i].id, year, month, &record) == MANAGE_OK
+            && callback(history->entries[i].id, &record, context) != 0)
+        {
+            break;
+        }
+    }
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Writes a history to a file in its encoded form.
+ *
+ * Layout (little-endian): "MEPHIS01", entry count u32, then per entry: ID length u32, ID bytes,
+ * record count u32, stream length u32, stream bytes, keyframe count u32, keyframe offsets and
+ * months (u32 each), last month u32 and the HISTORY_FIELD_COUNT fields of the last month (u64 each).
+ *
+ * @return MANAGE_OK or MANAGE_ERR_IO.
+ */
+ManageStatus_t payrollHistorySave(const PayrollHistory_t *history, const char *path)
+{
+    const HistoryEntry_t *entry = NULL;     /* Entry being written */
+    FILE *file = fopen(path, "wb");         /* The history file */
+    uint32_t ok = 1;                        /* Flag to check if every write succeeded */
+    uint32_t i = 0;                         /* Index for looping through entries */
+    uint32_t j = 0;                         /* Index for looping inside an entry */
+
+    if (file == NULL)
+    {
+        return MANAGE_ERR_IO;
+    }
+    setvbuf(file, NULL, _IOFBF, 1u << 20);
+    ok &= (fwrite(HISTORY_MAGIC, 1, HISTORY_MAGIC_LENGTH, file) == HISTORY_MAGIC_LENGTH) ? 1u : 0u;
+    ok &= writeU32(file, history->entry_count);
+    for (i = 0; i < history->entry_count && ok == 1; i++)
+    {
+        entry = &history->entries[i];
+        ok &= writeU32(file, (uint32_t)strlen(entry->id));
+        ok &= (fwrite(entry->id, 1, strlen(entry->id), file) == strlen(entry->id)) ? 1u : 0u;
+        ok &= writeU32(file, entry->record_count);
+        ok &= writeU32(file, entry->length);
+        ok &= (fwrite(entry->bytes, 1, entry->length, file) == entry->length) ? 1u : 0u;
+        ok &= writeU32(file, entry->keyframe_count);
+        for (j = 0; j < entry->keyframe_count; j++)
+        {
+            ok &= writeU32(file, entry->keyframe_offsets[j]);
+            ok &= writeU32(file, entry->keyframe_periods[j]);
+        }
+        ok &= writeU32(file, entry->last_period);
+        for (j = 0; j < HISTORY_FIELD_COUNT; j++)
+        {
+            ok &= writeU64(file, entry->last[j]);
+        }
+    }
+    if (fclose(file) != 0)
+    {
+        ok = 0;
+    }
+    return (ok == 1) ? MANAGE_OK : MANAGE_ERR_IO;
+}
+
+
+/**
+ * @brief Replaces a history with the content of a file written by payrollHistorySave().
+ *
+ * @return MANAGE_OK, MANAGE_ERR_IO or MANAGE_ERR_NO_MEMORY. On failure the history is empty.
+ */
+ManageStatus_t payrollHistoryLoad(PayrollHistory_t *history, const char *path)
+{
+    HistoryEntry_t *entry = NULL;           /* Entry being read */
+    int8_t magic[HISTORY_MAGIC_LENGTH];     /* Magic bytes of the file */
+    int8_t *id = NULL;                      /* ID of the entry being read */
+    uint32_t entry_count = 0;               /* Number of entries in the file */
+    uint32_t id_length = 0;                 /* Length of the ID being read */
+    int32_t position = 0;                   /* Position of the entry being read */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the load */
+    FILE *file = fopen(path, "rb");         /* The history file */
+    uint32_t i = 0;                         /* Index for looping through entries */
+    uint32_t j = 0;                         /* Index for looping inside an entry */
+
+    payrollHistoryFree(history);
+    if (file == NULL)
+    {
+        return MANAGE_ERR_IO;
+    }
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, HISTORY_MAGIC, sizeof(magic)) != 0
+        || readU32(file, &entry_count) == 0)
+    {
+        status = MANAGE_ERR_IO;
+    }
+    for (i = 0; i < entry_count && status == MANAGE_OK; i++)
+    {
+        if (readU32(file, &id_length) == 0 || id_length == 0 || id_length >= MAX_ID_LENGTH)
+        {
+            status = MANAGE_ERR_IO;
+            break;
+        }
+        id = calloc(id_length + 1, 1);
+        if (id == NULL)
+        {
+            status = MANAGE_ERR_NO_MEMORY;
+            break;
+        }
+        if (fread(id, 1, id_length, file) != id_length)
+        {
+            status = MANAGE_ERR_IO;
+        }
+        else
+        {
+            position = findOrAddEntry(history, id);
+            if (position < 0)
+            {
+                status = MANAGE_ERR_NO_MEMORY;
+            }
+        }
+        free(id);
+        if (status != MANAGE_OK)
+        {
+            break;
+        }
+
+        entry = &history->entries[position];
+        if (readU32(file, &entry->record_count) == 0 || readU32(file, &entry->length) == 0)
+        {
+            status = MANAGE_ERR_IO;
+            break;
+        }
+        entry->capacity = entry->length;
+        entry->bytes = malloc(entry->length + 1);
+        if (entry->bytes == NULL)
+        {
+            status = MANAGE_ERR_NO_MEMORY;
+            break;
+        }
+        if (fread(entry->bytes, 1, entry->length, file) != entry->length
+            || readU32(file, &entry->keyframe_count) == 0
+            || entry->keyframe_count != (entry->record_count + HISTORY_KEYFRAME_INTERVAL - 1) / HISTORY_KEYFRAME_INTERVAL)
+        {
+            entry->keyframe_count = 0;
+            status = MANAGE_ERR_IO;
+            break;
+        }
+        entry->keyframe_offsets = malloc((entry->keyframe_count + 1) * sizeof(uint32_t));
+        entry->keyframe_periods = malloc((entry->keyframe_count + 1) * sizeof(uint32_t));
+        if (entry->keyframe_offsets == NULL || entry->keyframe_periods == NULL)
+        {
+            entry->keyframe_count = 0;
+            status = MANAGE_ERR_NO_MEMORY;
+            break;
+        }
+        for (j = 0; j < entry->keyframe_count && status == MANAGE_OK; j++)
+        {
+            if (readU32(file, &entry->keyframe_offsets[j]) == 0 || readU32(file, &entry->keyframe_periods[j]) == 0
+                || entry->keyframe_offsets[j] >= entry->length)
+            {
+                status = MANAGE_ERR_IO;
+            }
+        }
+        if (status == MANAGE_OK && readU32(file, &entry->last_period) == 0)
+        {
+            status = MANAGE_ERR_IO;
+        }
+        for (j = 0; j < HISTORY_FIELD_COUNT && status == MANAGE_OK; j++)
+        {
+            if (readU64(file, &entry->last[j]) == 0)
+            {
+                status = MANAGE_ERR_IO;
+            }
+        }
+        if (status != MANAGE_OK)
+        {
+            entry->keyframe_count = 0;
+        }
+    }
+
+    fclose(file);
+    if (status != MANAGE_OK)
+    {
+        payrollHistoryFree(history);
+    }
+    return status;
+}
+
+
+/**
+ * @brief Returns the number of bytes allocated by a history.
+ */
+uint64_t payrollHistoryMemoryUsage(const PayrollHistory_t *history)
+{
+    uint64_t total = (uint64_t)history->entry_capacity * sizeof(HistoryEntry_t) + idIndexMemoryUsage(&history->by_id);
+    uint32_t i = 0;                         /* Index for looping through entries */
+
+    for (i = 0; i < history->entry_count; i++)
+    {
+        total += strlen(history->entries[i].id) + 1;
+        total += history->entries[i].capacity;
+        total += (uint64_t)history->entries[i].keyframe_count * 2 * sizeof(uint32_t);
+    }
+    return total;
+}
+
+
+/**
+ * @brief Prompts the user to record, show, save or load the payroll history.
+ *
+ * This function asks for one of four actions: record the current payroll as a month of the
+ * history, show the payroll of one employee or of all employees for a month, save the
+ * history to a file or load it from a file. Each company has its own history.
+ */
+void managePayrollHistory()
+{
+    PayrollMonthRecord_t record;            /* Month shown to the user */
+    int8_t buffer[MAX_ID_LENGTH];          /* Buffer to store input temporarily */
+    int8_t choice = 0;                      /* Action chosen by the user */
+    uint16_t year = 0;                      /* Year entered by the user */
+    uint8_t month = 0;                      /* Month entered by the user */
+    uint32_t recorded = 0;                  /* Number of recorded employees */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the action */
+    Tenant_t *tenant = getSelectedTenant(); /* Company the menu works on */
+    PayrollHistory_t *payroll_history = NULL;   /* History of the company */
+
+    if (tenant->history == NULL)
+    {
+        tenant->history = malloc(sizeof(*tenant->history));
+        if (tenant->history == NULL)
+        {
+            printf("Not enough memory to keep the payroll history!!!\n");
+            return;
+        }
+        payrollHistoryInit(tenant->history);
+    }
+    payroll_history = tenant->history;
+
+    printf("Enter 'r' to record this month, 's' to show history, 'w' to save or 'l' to load: ");
+    choice = getSingleCharInput();
+    if (choice == 'w' || choice == 'l')
+    {
+        do
+        {
+            printf("Enter file name: ");
+            fflush(stdin);
+            fgets(buffer, sizeof(buffer), stdin);
+        } while (isStringEmpty(buffer) == 1);   /* Repeat if input is empty */
+
+        status = (choice == 'w') ? payrollHistorySave(payroll_history, buffer)
+                                 : payrollHistoryLoad(payroll_history, buffer);
+        if (status == MANAGE_OK)
+        {
+            printf("Done: %u employees in history.\n", payroll_history->entry_count);
+        }
+        else
+        {
+            printf("Cannot %s file %s\n", (choice == 'w') ? "write" : "read", buffer);
+        }
+        return;
+    }
+    if (choice != 'r' && choice != 's')
+    {
+        printf("Input is not valid!!!\n");
+        return;
+    }
+
+    year = (uint16_t)promptUnsignedInput("Enter year: ", UINT16_MAX);
+    do
+    {
+        month = (uint8_t)promptUnsignedInput("Enter month (1-12): ", 12);
+    } while (month < 1);
+
+    if (choice == 'r')
+    {
+        status = payrollHistoryRecordMonth(payroll_history, year, month, &recorded);
+        if (status == MANAGE_OK)
+        {
+            printf("Recorded payroll of %u employees for %02u/%u\n", recorded, month, year);
+        }
+        else
+        {
+            printf("Not enough memory to record payroll!!!\n");
+        }
+        return;
+    }
+
+    printf("Enter employee's ID (leave blank for all employees): ");
+    fflush(stdin);
+    fgets(buffer, sizeof(buffer), stdin);
+    if (isStringEmpty(buffer) == 1)
+    {
+        payrollHistoryForEachInMonth(payroll_history, year, month, printHistoryRecord, NULL);
+    }
+    else if (payrollHistoryGet(payroll_history, buffer, year, month, &record) == MANAGE_OK)
+    {
+        printHistoryRecord(buffer, &record, NULL);
+    }
+    else
+    {
+        printf("No payroll of %s for %02u/%u\n", buffer, month, year);
+    }
+}
+
+
+/**
+ * @brief Returns the key of an entry for the ID index.
+ */
+static const int8_t* entryKey(uint32_t value, const void *context)
+{
+    return ((const PayrollHistory_t *)context)->entries[value].id;
+}
+
+
+/**
+ * @brief Copies the fields of a record into the encoded field vector.
+ */
+static void recordToFields(const PayrollMonthRecord_t *record, uint64_t *fields)
+{
+    uint32_t performance_bits = 0;          /* Bits of the float performance */
+
+    memcpy(&performance_bits, &record->working_performance, sizeof(performance_bits));
+    fields[HISTORY_SALARY_BASE] = record->salary_base;
+    fields[HISTORY_WORKING_DAYS] = record->working_days;
+    fields[HISTORY_WORKING_PERFORMANCE] = performance_bits;
+    fields[HISTORY_BONUS] = record->bonus;
+    fields[HISTORY_LATE_COMING_DAYS] = record->late_coming_days;
+    fields[HISTORY_DEPARTMENT_BONUS] = record->department_bonus;
+    fields[HISTORY_RAISE_FACTOR] = record->raise_factor;
+    fields[HISTORY_GROSS] = record->gross;
+    fields[HISTORY_INSURANCE] = record->insurance;
+    fields[HISTORY_TAX] = record->tax;
+    fields[HISTORY_NET] = record->net;
+}
+
+
+/**
+ * @brief Copies the encoded field vector back into a record.
+ */
+static void fieldsToRecord(const uint64_t *fields, uint32_t period, PayrollMonthRecord_t *record)
+{
+    uint32_t performance_bits = (uint32_t)fields[HISTORY_WORKING_PERFORMANCE];  /* Bits of the float performance */
+
+    record->year = (uint16_t)(period / 12u);
+    record->month = (uint8_t)(period % 12u + 1u);
+    record->salary_base = fields[HISTORY_SALARY_BASE];
+    record->working_days = (uint16_t)fields[HISTORY_WORKING_DAYS];
+    memcpy(&record->working_performance, &performance_bits, sizeof(performance_bits));
+    record->bonus = fields[HISTORY_BONUS];
+    record->late_coming_days = (uint16_t)fields[HISTORY_LATE_COMING_DAYS];
+    record->department_bonus = fields[HISTORY_DEPARTMENT_BONUS];
+    record->raise_factor = (uint32_t)fields[HISTORY_RAISE_FACTOR];
+    record->gross = fields[HISTORY_GROSS];
+    record->insurance = fields[HISTORY_INSURANCE];
+    record->tax = fields[HISTORY_TAX];
+    record->net = fields[HISTORY_NET];
+}
+
+
+/**
+ * @brief Appends a LEB128 varint to an employee's stream.
+ *
+ * @return 1 on success, 0 if memory could not be allocated.
+ */
+static uint32_t putVarint(HistoryEntry_t *entry, uint64_t value)
+{
+    uint32_t new_capacity = 0;              /* Grown capacity */
+    uint8_t *grown = NULL;                  /* Reallocated stream */
+
+    if (entry->length + 10 > entry->capacity)
+    {
+        new_capacity = (entry->capacity == 0) ? HISTORY_MIN_BYTES : entry->capacity * 2;
+        grown = realloc(entry->bytes, new_capacity);
+        if (grown == NULL)
+        {
+            return 0;
+        }
+        entry->bytes = grown;
+        entry->capacity = new_capacity;
+    }
+    while (value >= 0x80)
+    {
+        entry->bytes[entry->length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    entry->bytes[entry->length++] = (uint8_t)value;
+    return 1;
+}
+
+
+/**
+ * @brief Reads a LEB128 varint.
+ *
+ * @return 1 on success, 0 if the stream ends inside the varint or the varint is too long.
+ */
+static uint32_t getVarint(const uint8_t *bytes, uint32_t length, uint32_t *position, uint64_t *value)
+{
+    uint32_t shift = 0;                     /* Bit position of the next 7 bits */
+
+    *value = 0;
+    while (*position < length && shift < 64)
+    {
+        *value |= (uint64_t)(bytes[*position] & 0x7f) << shift;
+        shift += 7;
+        *position += 1;
+        if ((bytes[*position - 1] & 0x80) == 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Returns the position of an employee's entry, creating an empty entry if needed.
+ *
+ * @return The position, or -1 if memory could not be allocated.
+ */
+static int32_t findOrAddEntry(PayrollHistory_t *history, const int8_t *employee_id)
+{
+    HistoryEntry_t *grown = NULL;           /* Reallocated entries */
+    HistoryEntry_t *entry = NULL;           /* New entry */
+    uint32_t position = 0;                  /* Position of the entry */
+    uint32_t new_capacity = 0;              /* Grown capacity */
+
+    if (idIndexFind(&history->by_id, employee_id, &position) == 1)
+    {
+        return (int32_t)position;
+    }
+    if (history->entry_count == history->entry_capacity)
+    {
+        new_capacity = (history->entry_capacity == 0) ? 64 : history->entry_capacity * 2;
+        grown = realloc(history->entries, (size_t)new_capacity * sizeof(*grown));
+        if (grown == NULL)
+        {
+            return -1;
+        }
+        history->entries = grown;
+        history->entry_capacity = new_capacity;
+    }
+
+    entry = &history->entries[history->entry_count];
+    memset(entry, 0, sizeof(*entry));
+    entry->id = malloc(strlen(employee_id) + 1);
+    if (entry->id == NULL)
+    {
+        return -1;
+    }
+    strcpy(entry->id, employee_id);
+    if (idIndexInsert(&history->by_id, entry->id, history->entry_count) != MANAGE_OK)
+    {
+        free(entry->id);
+        return -1;
+    }
+    history->entry_count += 1;
+    return (int32_t)(history->entry_count - 1);
+}
+
+
+/**
+ * @brief Writes a little-endian 32-bit value. Returns 1 on success, 0 otherwise.
+ */
+static uint32_t writeU32(FILE *file, uint32_t value)
+{
+    uint8_t bytes[4];                       /* Encoded value */
+    uint32_t i = 0;                         /* Index for looping through bytes */
+
+    for (i = 0; i < 4; i++)
+    {
+        bytes[i] = (uint8_t)(value >> (8 * i));
+    }
+    return (fwrite(bytes, 1, 4, file) == 4) ? 1u : 0u;
+}
+
+
+/**
+ * @brief Writes a little-endian 64-bit value. Returns 1 on success, 0 otherwise.
+ */
+static uint32_t writeU64(FILE *file, uint64_t value)
+{
+    return writeU32(file, (uint32_t)value) & writeU32(file, (uint32_t)(value >> 32));
+}
+
+
+/**
+ * @brief Reads a little-endian 32-bit value. Returns 1 on success, 0 otherwise.
+ */
+static uint32_t readU32(FILE *file, uint32_t *value)
+{
+    uint8_t bytes[4];                       /* Encoded value */
+
+    if (fread(bytes, 1, 4, file) != 4)
+    {
+        return 0;
+    }
+    *value = (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    return 1;
+}
+
+
+/**
+ * @brief Reads a little-endian 64-bit value. Returns 1 on success, 0 otherwise.
+ */
+static uint32_t readU64(FILE *file, uint64_t *value)
+{
+    uint32_t low = 0;                       /* Lower half */
+    uint32_t high = 0;                      /* Upper half */
+
+    if (readU32(file, &low) == 0 || readU32(file, &high) == 0)
+    {
+        return 0;
+    }
+    *value = (uint64_t)low | ((uint64_t)high << 32);
+    return 1;
+}
+
+
+/**
+ * @brief Prints one month of one employee.
+ */
+static int32_t printHistoryRecord(const int8_t *employee_id, const PayrollMonthRecord_t *record, void *context)
+{
+    (void)context;
+    printf("----\n");
+    printf("ID: %s (%02u/%u)\n", employee_id, record->month, record->year);
+    printf("Salary base: %s (VND)\n", formatNumberWithCommas(record->salary_base));
+    printf("Number of working days: %hu (days)\n", record->working_days);
+    printf("Working performance: %.1f\n", record->working_performance);
+    printf("Bonus: %s (VND)\n", formatNumberWithCommas(record->bonus));
+    printf("Number of late working days: %hu (days)\n", record->late_coming_days);
+    printf("Department's bonus: %s (VND)\n", formatNumberWithCommas(record->department_bonus));
+    printf("Gross income: %s (VND)\n", formatNumberWithCommas(record->gross));
+    printf("Insurance: %s (VND)\n", formatNumberWithCommas(record->insurance));
+    printf("Tax: %s (VND)\n", formatNumberWithCommas(record->tax));
+    printf("Actual salary received: %s (VND)\n", formatNumberWithCommas(record->net));
+    printf("----\n");
+    return 0;
+} /* EOF */
@@ -0,0 +1,170 @@
+/**
+ * @file payroll_history.h
+ * @brief This file contains the function prototypes for the multi-month payroll history.
+ *
+ * The history keeps, for every employee and every recorded month, the payroll inputs
+ * (salary base, working days, performance, bonus, late days, department bonus and raise)
+ * and outputs (gross, insurance, tax, net).
+ *
+ * Each employee's months are stored as one compact byte stream. A month is encoded against the
+ * previous month of the same employee: a bit mask of the fields that changed, then the zigzag
+ * varint difference of each changed field, so unchanged fields cost nothing. Every
+ * HISTORY_KEYFRAME_INTERVAL months a record is encoded against an all-zero record (a keyframe)
+ * and its offset is kept, so reading one month decodes at most HISTORY_KEYFRAME_INTERVAL
+ * records of one employee.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef PAYROLL_HISTORY_H
+#define PAYROLL_HISTORY_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for Employee_t and ManageStatus_t */
+#include "id_index.h"           /* Include ID index header file for the lookup by employee ID */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define HISTORY_KEYFRAME_INTERVAL 12        /* Number of months between two keyframes */
+#define HISTORY_FIELD_COUNT 11              /* Number of encoded fields per month, besides the month itself */
+
+/**
+ * @brief Payroll inputs and outputs of one employee for one month.
+ */
+typedef struct PayrollMonthRecord {
+    uint16_t year;                          /* Year of the payroll, e.g. 2024. */
+    uint8_t month;                          /* Month of the payroll, 1 to 12. */
+    uint64_t salary_base;                   /* Employee's base salary. */
+    uint16_t working_days;                  /* Number of days the employee worked. */
+    float working_performance;              /* Employee's working performance. */
+    uint64_t bonus;                         /* Bonus received by the employee. */
+    uint16_t late_coming_days;              /* Number of days the employee came late to work. */
+    uint64_t department_bonus;              /* Bonus of the employee's department. */
+    uint32_t raise_factor;                  /* Department raise in basis points. */
+    uint64_t gross;                         /* Gross income. */
+    uint64_t insurance;                     /* Insurance deducted. */
+    uint64_t tax;                           /* Personal income tax. */
+    uint64_t net;                           /* Net salary received. */
+} PayrollMonthRecord_t;
+
+/**
+ * @brief History of one employee.
+ */
+typedef struct HistoryEntry {
+    int8_t *id;                             /* Employee's ID (owned copy) */
+    uint8_t *bytes;                         /* Encoded months, oldest first */
+    uint32_t length;                        /* Number of encoded bytes */
+    uint32_t capacity;                      /* Number of allocated bytes */
+    uint32_t *keyframe_offsets;             /* Byte offset of every keyframe */
+    uint32_t *keyframe_periods;             /* Month number (year * 12 + month - 1) of every keyframe */
+    uint32_t keyframe_count;                /* Number of keyframes */
+    uint32_t record_count;                  /* Number of encoded months */
+    uint32_t last_period;                   /* Month number of the last month */
+    uint64_t last[HISTORY_FIELD_COUNT];     /* Fields of the last month, used to encode the next one */
+} HistoryEntry_t;
+
+/**
+ * @brief Payroll history of all employees.
+ */
+typedef struct PayrollHistory {
+    HistoryEntry_t *entries;                /* One entry per employee that has history */
+    uint32_t entry_count;                   /* Number of entries */
+    uint32_t entry_capacity;                /* Number of allocated entries */
+    IdIndex_t by_id;                        /* Employee ID -> position in entries */
+} PayrollHistory_t;
+
+/**
+ * @brief Called for every record of a month by payrollHistoryForEachInMonth().
+ *
+ * @return 0 to continue, any other value to stop.
+ */
+typedef int32_t (*HistoryMonthFn_t)(const int8_t *employee_id, const PayrollMonthRecord_t *record, void *context);
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Initializes an empty history.
+ */
+void payrollHistoryInit(PayrollHistory_t *history);
+
+/**
+ * @brief Frees all memory of a history and leaves it empty.
+ */
+void payrollHistoryFree(PayrollHistory_t *history);
+
+/**
+ * @brief Appends one month to an employee's history.
+ *
+ * @param history The history to update.
+ * @param employee_id The employee's ID.
+ * @param record The month to append; it must be later than the employee's last recorded month.
+ * @return MANAGE_OK, MANAGE_ERR_DUPLICATE_ID if the month is already recorded,
+ *         MANAGE_ERR_INVALID_ARGUMENT if the month is invalid or older than the last one,
+ *         or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t payrollHistoryAppend(PayrollHistory_t *history, const int8_t *employee_id,
+                                    const PayrollMonthRecord_t *record);
+
+/**
+ * @brief Records the current payroll of every stored employee for one month.
+ *
+ * Employees whose month is already recorded are left unchanged.
+ *
+ * @param history The history to update.
+ * @param year Year of the payroll.
+ * @param month Month of the payroll, 1 to 12.
+ * @param recorded Receives the number of employees recorded (may be NULL).
+ * @return MANAGE_OK, MANAGE_ERR_INVALID_ARGUMENT or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t payrollHistoryRecordMonth(PayrollHistory_t *history, uint16_t year, uint8_t month,
+                                         uint32_t *recorded);
+
+/**
+ * @brief Reads one month of one employee.
+ *
+ * Only the records between the closest keyframe and the wanted month are decoded.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_NOT_FOUND if the employee or the month is not recorded.
+ */
+ManageStatus_t payrollHistoryGet(const PayrollHistory_t *history, const int8_t *employee_id,
+                                 uint16_t year, uint8_t month, PayrollMonthRecord_t *record);
+
+/**
+ * @brief Calls a function for every employee that has a record for the given month.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_INVALID_ARGUMENT if the month is invalid.
+ */
+ManageStatus_t payrollHistoryForEachInMonth(const PayrollHistory_t *history, uint16_t year, uint8_t month,
+                                            HistoryMonthFn_t callback, void *context);
+
+/**
+ * @brief Writes a history to a file in its encoded form.
+ *
+ * @return MANAGE_OK or MANAGE_ERR_IO.
+ */
+ManageStatus_t payrollHistorySave(const PayrollHistory_t *history, const char *path);
+
+/**
+ * @brief Replaces a history with the content of a file written by payrollHistorySave().
+ *
+ * @return MANAGE_OK, MANAGE_ERR_IO or MANAGE_ERR_NO_MEMORY. On failure the history is empty.
+ */
+ManageStatus_t payrollHistoryLoad(PayrollHistory_t *history, const char *path);
+
+/**
+ * @brief Returns the number of bytes allocated by a history.
+ */
+uint64_t payrollHistoryMemoryUsage(const PayrollHistory_t *history);
+
+/**
+ * @brief Prompts the user to record, show, save or load the payroll history.
+ */
+void managePayrollHistory();
+
+#endif /* PAYROLL_HISTORY_H */
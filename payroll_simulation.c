@@ -0,0 +1,789 @@
+/**
+ * @file payroll_simulation.c
+ * @brief This file contains the implementation of the payroll what-if simulation.
+ *
+ * The part of a salary that does not depend on the rules (income from the base salary,
+ * bonuses, the department's raise) is calculated once per employee, then the current rules
+ * and every scenario are applied to it while the record is still in the cache. The store is
+ * handled in ranges by the worker pool; each thread keeps its own results, which are added
+ * together when all threads are done, so the threads never write to shared memory.
+ *
+ * Rates are kept in basis points and turned into doubles once per rule set; 8950 / 10000.0
+ * is the same double as 0.895, so the current rules give exactly the same salaries as
+ * calculateSalaryForDepartment() (checked by the "rules" path of the golden-file check).
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdio.h>              /* Include standard input and output library for printf, FILE, ... */
+#include <stdlib.h>             /* Include standard library for calloc, free */
+#include <string.h>             /* Include string manipulation library for memset, strcspn, strchr */
+#include "payroll_simulation.h" /* Include header file */
+#include "input_handler.h"      /* Include input handler header file for the field parsers */
+#include "perf_stats.h"         /* Include instrumentation header file for measuring hot operations */
+#include "worker_pool.h"        /* Include worker pool header file for the simulation threads */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define SIMULATION_CHUNK 1024u              /* Largest range of employees simulated without splitting it */
+#define SIMULATION_MAX_FIELDS (5 + PAYROLL_MAX_BRACKETS)   /* Fields of a scenario line */
+#define SIMULATION_LINE_LENGTH 512          /* Longest line of a scenario file */
+#define BASIS_POINTS 10000u                 /* Basis points in 100% */
+
+/**
+ * @brief Rule set ready to be applied: rates are converted to multipliers.
+ */
+typedef struct PreparedRules {
+    uint16_t late_threshold_days;           /* Late days up to this number use late_penalty_low */
+    uint64_t late_penalty_low;              /* Penalty per late day, up to the threshold */
+    uint64_t late_penalty_high;             /* Penalty per late day, above the threshold */
+    double keep_after_insurance;            /* Part of the gross income left after insurance */
+    uint32_t bracket_count;                 /* Number of tax brackets */
+    uint64_t bracket_limits[PAYROLL_MAX_BRACKETS];     /* Largest income of each bracket */
+    uint32_t bracket_basis_points[PAYROLL_MAX_BRACKETS];   /* Tax rate of each bracket, 0 if none */
+    double bracket_rates[PAYROLL_MAX_BRACKETS];        /* Tax rate of each bracket as a multiplier */
+} PreparedRules_t;
+
+/**
+ * @brief Work shared by the simulation threads.
+ */
+typedef struct SimulationJob {
+    const PreparedRules_t *current;         /* Current rules */
+    const PreparedRules_t *scenarios;       /* Rules of each scenario */
+    uint32_t scenario_count;                /* Number of scenarios */
+    PayrollScenarioResult_t *results;       /* Results of each thread: current rules, then each scenario */
+} SimulationJob_t;
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static void prepareRules(const PayrollRules_t *rules, PreparedRules_t *prepared);
+static uint32_t applyRules(const PreparedRules_t *rules, uint16_t late_coming_days, uint64_t income_without_bonus,
+                           uint64_t bonuses, const Department_t *department, SalaryBreakdown_t *breakdown);
+static void simulateRange(void *context, uint32_t worker, const WorkerRange_t *range);
+static void addSalary(PayrollScenarioResult_t *result, const SalaryBreakdown_t *breakdown, uint32_t bracket,
+                      uint64_t current_salary);
+static void mergeResult(PayrollScenarioResult_t *total, const PayrollScenarioResult_t *part);
+static uint32_t parseScenario(const int8_t *line, PayrollRules_t *rules);
+static uint32_t parsePercent(const int8_t *text, uint32_t length, uint32_t *basis_points);
+static uint32_t isNoLimit(const int8_t *text, uint32_t length);
+static void printRuleTotals(const int8_t *name, const PayrollScenarioResult_t *result);
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Fills a rule set with the rules used by calculateSalaryBreakdown().
+ */
+void payrollRulesDefault(PayrollRules_t *rules)
+{
+    memset(rules, 0, sizeof(*rules));
+    strcpy((char*)rules->name, "current");
+    rules->late_threshold_days = 3;
+    rules->late_penalty_low = 10000;
+    rules->late_penalty_high = 20000;
+    rules->insurance_basis_points = 1050;
+    rules->bracket_count = 3;
+    rules->bracket_limits[0] = 11000000;
+    rules->bracket_basis_points[0] = 0;
+    rules->bracket_limits[1] = 16000000;
+    rules->bracket_basis_points[1] = 500;
+    rules->bracket_limits[2] = PAYROLL_NO_LIMIT;
+    rules->bracket_basis_points[2] = 1000;
+}
+
+
+/**
+ * @brief Checks that a rule set can be simulated.
+ */
+ManageStatus_t payrollRulesCheck(const PayrollRules_t *rules)
+{
+    uint32_t i = 0;                         /* Index for looping through brackets */
+
+    if (rules->insurance_basis_points > BASIS_POINTS
+        || rules->bracket_count == 0 || rules->bracket_count > PAYROLL_MAX_BRACKETS
+        || rules->bracket_limits[rules->bracket_count - 1] != PAYROLL_NO_LIMIT)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    for (i = 0; i < rules->bracket_count; i++)
+    {
+        if (rules->bracket_basis_points[i] > BASIS_POINTS
+            || (i > 0 && rules->bracket_limits[i] <= rules->bracket_limits[i - 1]))
+        {
+            return MANAGE_ERR_INVALID_ARGUMENT;
+        }
+    }
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Calculates the salary of an employee with the given rules.
+ */
+void calculateSalaryWithRules(const Employee_t *employee, const Department_t *department,
+                              const PayrollRules_t *rules, SalaryBreakdown_t *breakdown)
+{
+    PreparedRules_t prepared;               /* Rules converted to multipliers */
+    uint64_t income_without_bonus = 0;      /* Income without bonus */
+    uint64_t bonus_department = 0;          /* Bonus allocated to the department */
+
+    prepareRules(rules, &prepared);
+    if (department != NULL)
+    {
+        bonus_department = department->bonus_salary;
+    }
+    income_without_bonus = ((uint64_t)employee->salary_base * employee->working_days) * employee->working_performance;
+    applyRules(&prepared, employee->late_coming_days, income_without_bonus, employee->bonus + bonus_department,
+               department, breakdown);
+    breakdown->department_bonus = bonus_department;
+}
+
+
+/**
+ * @brief Simulates the payroll of every stored employee under many scenarios in one pass.
+ *
+ * The store is one range of the worker pool, split into ranges of at most SIMULATION_CHUNK
+ * employees while the threads work.
+ */
+ManageStatus_t simulatePayroll(const PayrollRules_t *scenarios, uint32_t scenario_count, uint32_t thread_count,
+                               PayrollScenarioResult_t *results, PayrollScenarioResult_t *current)
+{
+    PayrollRules_t default_rules;           /* Current rules */
+    PreparedRules_t current_rules;          /* Current rules converted to multipliers */
+    PreparedRules_t *prepared = NULL;       /* Scenarios converted to multipliers */
+    SimulationJob_t job;                    /* Work shared by the threads */
+    WorkerRange_t range;                    /* Every stored employee */
+    PayrollScenarioResult_t *partial = NULL;           /* Results of each thread */
+    uint32_t employee_count = getTotalEmployees();     /* Number of employees to simulate */
+    uint32_t per_thread = scenario_count + 1;          /* Results per thread */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the pool */
+    uint32_t t = 0;                         /* Index for looping through threads */
+    uint32_t s = 0;                         /* Index for looping through scenarios */
+    PERF_START(perf_start);                 /* Start time of the simulation */
+
+    if (scenario_count == 0 || scenario_count > PAYROLL_MAX_SCENARIOS || scenarios == NULL || results == NULL)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    for (s = 0; s < scenario_count; s++)
+    {
+        if (payrollRulesCheck(&scenarios[s]) != MANAGE_OK)
+        {
+            return MANAGE_ERR_INVALID_ARGUMENT;
+        }
+    }
+    thread_count = workerPoolThreadCount(employee_count, SIMULATION_CHUNK, thread_count);
+
+    prepared = malloc(scenario_count * sizeof(*prepared));
+    partial = calloc((size_t)thread_count * per_thread, sizeof(*partial));
+    if (prepared == NULL || partial == NULL)
+    {
+        free(prepared);
+        free(partial);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    payrollRulesDefault(&default_rules);
+    prepareRules(&default_rules, &current_rules);
+    for (s = 0; s < scenario_count; s++)
+    {
+        prepareRules(&scenarios[s], &prepared[s]);
+    }
+
+    job.current = &current_rules;
+    job.scenarios = prepared;
+    job.scenario_count = scenario_count;
+    job.results = partial;
+    range.group = 0;
+    range.first = 0;
+    range.end = employee_count;
+    status = runWorkerPool(&range, 1, SIMULATION_CHUNK, thread_count, simulateRange, &job);
+    if (status != MANAGE_OK)
+    {
+        free(prepared);
+        free(partial);
+        return status;
+    }
+
+    /* Results are sums, counts and maximums, so they do not depend on which thread had which range */
+    memset(results, 0, scenario_count * sizeof(*results));
+    if (current != NULL)
+    {
+        memset(current, 0, sizeof(*current));
+    }
+    for (t = 0; t < thread_count; t++)
+    {
+        if (current != NULL)
+        {
+            mergeResult(current, &partial[(size_t)t * per_thread]);
+        }
+        for (s = 0; s < scenario_count; s++)
+        {
+            mergeResult(&results[s], &partial[(size_t)t * per_thread + 1 + s]);
+        }
+    }
+
+    free(prepared);
+    free(partial);
+    PERF_STOP(PERF_OP_SIMULATE_PAYROLL, perf_start);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Reads scenarios from a file.
+ */
+ManageStatus_t loadPayrollScenarios(const char *path, PayrollRules_t *scenarios, uint32_t max_scenarios,
+                                    uint32_t *count, uint64_t *error_line)
+{
+    FILE *file = fopen(path, "r");          /* Scenario file */
+    int8_t line[SIMULATION_LINE_LENGTH];    /* Line being read */
+    uint64_t line_number = 0;               /* Number of the line being read */
+    uint32_t start = 0;                     /* Position of the first non-blank character */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the load */
+
+    *count = 0;
+    *error_line = 0;
+    if (file == NULL)
+    {
+        return MANAGE_ERR_IO;
+    }
+    while (status == MANAGE_OK && fgets((char*)line, sizeof(line), file) != NULL)
+    {
+        line_number += 1;
+        if (strchr((char*)line, '\n') == NULL && feof(file) == 0)
+        {
+            /* Line too long for any valid scenario */
+            status = MANAGE_ERR_INVALID_ARGUMENT;
+            break;
+        }
+        line[strcspn((char*)line, "\r\n")] = '\0';
+        start = (uint32_t)strspn((char*)line, " \t");
+        if (line[start] == '\0' || line[start] == '#')
+        {
+            continue;
+        }
+        if (*count == max_scenarios || parseScenario(&line[start], &scenarios[*count]) == 0)
+        {
+            status = MANAGE_ERR_INVALID_ARGUMENT;
+            break;
+        }
+        *count += 1;
+    }
+    if (status != MANAGE_OK)
+    {
+        *error_line = line_number;
+    }
+    else if (ferror(file) != 0)
+    {
+        status = MANAGE_ERR_IO;
+    }
+    fclose(file);
+    return status;
+}
+
+
+/**
+ * @brief Prompts the user for a scenario file, simulates it and prints the comparison.
+ *
+ * For each scenario this function prints its totals, how many employees gain or lose and
+ * by how much, and how the changes are spread.
+ */
+void simulatePayrollScenarios()
+{
+    static const char *const bucket_names[PAYROLL_DELTA_BUCKETS] = {
+        "<= -1,000,000", "-999,999 .. -100,000", "-99,999 .. -10,000", "-9,999 .. -1", "0",
+        "1 .. 9,999", "10,000 .. 99,999", "100,000 .. 999,999", ">= 1,000,000"
+    };                                      /* Label of each histogram bucket */
+    char path[260];                         /* File name entered by the user */
+    PayrollRules_t *scenarios = NULL;       /* Scenarios read from the file */
+    PayrollScenarioResult_t *results = NULL;   /* Result of each scenario */
+    PayrollScenarioResult_t current;        /* Result of the current rules */
+    uint32_t count = 0;                     /* Number of scenarios */
+    uint64_t error_line = 0;                /* Line of the first invalid scenario */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the load and the simulation */
+    uint32_t s = 0;                         /* Index for looping through scenarios */
+    uint32_t b = 0;                         /* Index for looping through brackets and buckets */
+
+    /* Check if there are any employees */
+    if (getTotalEmployees() == 0)
+    {
+        printf("No employee to simulate payroll!!!\n");
+        return;
+    }
+
+    do
+    {
+        printf("Enter scenario file name: ");
+        fflush(stdin);
+        if (fgets(path, sizeof(path), stdin) == NULL)
+        {
+            return;
+        }
+        /* Remove newline character, spaces are allowed in file names */
+        path[strcspn(path, "\r\n")] = '\0';
+        if (path[0] == '\0')
+        {
+            printf("\nYou must not leave blank this information ...\n");
+            printf("\nPlease enter again ...\n");
+        }
+    } while (path[0] == '\0');
+
+    scenarios = malloc(PAYROLL_MAX_SCENARIOS * sizeof(*scenarios));
+    results = malloc(PAYROLL_MAX_SCENARIOS * sizeof(*results));
+    if (scenarios == NULL || results == NULL)
+    {
+        printf("Not enough memory to simulate payroll!!!\n");
+        free(scenarios);
+        free(results);
+        return;
+    }
+
+    status = loadPayrollScenarios(path, scenarios, PAYROLL_MAX_SCENARIOS, &count, &error_line);
+    if (status == MANAGE_ERR_IO)
+    {
+        printf("Cannot read file %s\n", path);
+    }
+    else if (status != MANAGE_OK)
+    {
+        printf("Invalid scenario on line %llu (at most %u scenarios are allowed)\n",
+               (unsigned long long)error_line, PAYROLL_MAX_SCENARIOS);
+    }
+    else if (count == 0)
+    {
+        printf("No scenario in file %s\n", path);
+    }
+    else if (simulatePayroll(scenarios, count, 0, results, &current) != MANAGE_OK)
+    {
+        printf("Not enough memory to simulate payroll!!!\n");
+    }
+    else
+    {
+        printf("\nPayroll of %s employees\n", formatNumberWithCommas(current.employees));
+        printRuleTotals((const int8_t*)"current rules", &current);
+        for (s = 0; s < count; s++)
+        {
+            printRuleTotals(scenarios[s].name, &results[s]);
+            printf("Employees paid more: %s", formatNumberWithCommas(results[s].raised));
+            printf(", total %s (VND)", formatNumberWithCommas(results[s].total_increase));
+            printf(", largest %s (VND)\n", formatNumberWithCommas(results[s].max_increase));
+            printf("Employees paid less: %s", formatNumberWithCommas(results[s].lowered));
+            printf(", total %s (VND)", formatNumberWithCommas(results[s].total_decrease));
+            printf(", largest %s (VND)\n", formatNumberWithCommas(results[s].max_decrease));
+            printf("Employees per tax bracket:");
+            for (b = 0; b < scenarios[s].bracket_count; b++)
+            {
+                printf(" %s", formatNumberWithCommas(results[s].bracket_employees[b]));
+            }
+            printf("\nChange of net salary (VND):\n");
+            for (b = 0; b < PAYROLL_DELTA_BUCKETS; b++)
+            {
+                if (results[s].delta_histogram[b] > 0)
+                {
+                    printf("  %-22s %s\n", bucket_names[b], formatNumberWithCommas(results[s].delta_histogram[b]));
+                }
+            }
+        }
+    }
+    free(scenarios);
+    free(results);
+}
+
+
+/**
+ * @brief Converts the rates of a rule set to multipliers.
+ */
+static void prepareRules(const PayrollRules_t *rules, PreparedRules_t *prepared)
+{
+    uint32_t i = 0;                         /* Index for looping through brackets */
+
+    memset(prepared, 0, sizeof(*prepared));
+    prepared->late_threshold_days = rules->late_threshold_days;
+    prepared->late_penalty_low = rules->late_penalty_low;
+    prepared->late_penalty_high = rules->late_penalty_high;
+    prepared->keep_after_insurance = (BASIS_POINTS - rules->insurance_basis_points) / (double)BASIS_POINTS;
+    prepared->bracket_count = rules->bracket_count;
+    for (i = 0; i < rules->bracket_count; i++)
+    {
+        prepared->bracket_limits[i] = rules->bracket_limits[i];
+        prepared->bracket_basis_points[i] = rules->bracket_basis_points[i];
+        prepared->bracket_rates[i] = rules->bracket_basis_points[i] / (double)BASIS_POINTS;
+    }
+}
+
+
+/**
+ * @brief Applies a rule set to the rule-independent part of a salary.
+ *
+ * The steps and their rounding are the same as in calculateSalaryForDepartment().
+ * breakdown->department_bonus is not set.
+ *
+ * @return The tax bracket of the employee.
+ */
+static uint32_t applyRules(const PreparedRules_t *rules, uint16_t late_coming_days, uint64_t income_without_bonus,
+                           uint64_t bonuses, const Department_t *department, SalaryBreakdown_t *breakdown)
+{
+    uint64_t late_coming_penalty = 0;       /* Penalty for late coming */
+    uint64_t total_income = 0;              /* Total income */
+    uint64_t totalIncome_without_tax = 0;   /* Total income without tax */
+    uint64_t tax = 0;                       /* Tax */
+    uint64_t department_raise = 0;          /* Amount added by the department's raise */
+    uint64_t actual_salary = 0;             /* Actual salary */
+    uint32_t bracket = 0;                   /* Tax bracket of the income */
+
+    if (late_coming_days <= rules->late_threshold_days)
+    {
+        late_coming_penalty = late_coming_days * rules->late_penalty_low;
+    }
+    else
+    {
+        late_coming_penalty = late_coming_days * rules->late_penalty_high;
+    }
+    total_income = income_without_bonus + bonuses - late_coming_penalty;
+    totalIncome_without_tax = total_income * rules->keep_after_insurance;
+
+    /* The last limit is PAYROLL_NO_LIMIT, so a bracket is always found */
+    while (totalIncome_without_tax > rules->bracket_limits[bracket])
+    {
+        bracket++;
+    }
+    if (rules->bracket_basis_points[bracket] != 0)
+    {
+        tax = totalIncome_without_tax * rules->bracket_rates[bracket];
+    }
+    actual_salary = totalIncome_without_tax - tax;
+
+    if (department != NULL && department->raise_factor != 0 && department->raise_factor != DEPARTMENT_NO_RAISE)
+    {
+        department_raise = (actual_salary * department->raise_factor) / DEPARTMENT_NO_RAISE - actual_salary;
+        actual_salary += department_raise;
+    }
+
+    breakdown->late_coming_penalty = late_coming_penalty;
+    breakdown->income_without_bonus = income_without_bonus;
+    breakdown->total_income = total_income;
+    breakdown->insurance = total_income - totalIncome_without_tax;
+    breakdown->totalIncome_without_tax = totalIncome_without_tax;
+    breakdown->tax = tax;
+    breakdown->department_raise = department_raise;
+    breakdown->actual_salary = actual_salary;
+    return bracket;
+}
+
+
+/**
+ * @brief Simulates the current rules and every scenario on a range of the store, adding the
+ *        results to those of the thread.
+ */
+static void simulateRange(void *context, uint32_t worker, const WorkerRange_t *range)
+{
+    const SimulationJob_t *job = context;   /* The shared work */
+    PayrollScenarioResult_t *results = &job->results[(size_t)worker * (job->scenario_count + 1)];  /* Results of the thread */
+    const Employee_t *employee = NULL;      /* Employee being simulated */
+    const Department_t *department = NULL;  /* Department of the employee */
+    SalaryBreakdown_t breakdown;            /* Salary under the rules being applied */
+    uint64_t income_without_bonus = 0;      /* Income without bonus, the same for every rule set */
+    uint64_t bonuses = 0;                   /* Employee's and department's bonus */
+    uint64_t current_salary = 0;            /* Net salary under the current rules */
+    uint32_t bracket = 0;                   /* Tax bracket of the employee */
+    uint32_t i = 0;                         /* Index for looping through employees */
+    uint32_t s = 0;                         /* Index for looping through scenarios */
+
+    for (i = range->first; i < range->end; i++)
+    {
+        employee = getEmployeeAt(i);
+        department = findDepartment(employee->department_id);
+        income_without_bonus = ((uint64_t)employee->salary_base * employee->working_days) * employee->working_performance;
+        bonuses = employee->bonus + ((department != NULL) ? department->bonus_salary : 0);
+
+        bracket = applyRules(job->current, employee->late_coming_days, income_without_bonus, bonuses,
+                             department, &breakdown);
+        current_salary = breakdown.actual_salary;
+        addSalary(&results[0], &breakdown, bracket, current_salary);
+
+        for (s = 0; s < job->scenario_count; s++)
+        {
+            bracket = applyRules(&job->scenarios[s], employee->late_coming_days, income_without_bonus, bonuses,
+                                 department, &breakdown);
+            addSalary(&results[1 + s], &breakdown, bracket, current_salary);
+        }
+    }
+}
+
+
+/**
+ * @brief Adds the salary of one employee to the result of a rule set.
+ */
+static void addSalary(PayrollScenarioResult_t *result, const SalaryBreakdown_t *breakdown, uint32_t bracket,
+                      uint64_t current_salary)
+{
+    uint64_t change = 0;                    /* Size of the change of net salary */
+    uint32_t bucket = 4;                    /* Histogram bucket of the change */
+
+    result->employees += 1;
+    result->total_gross += breakdown->total_income;
+    result->total_insurance += breakdown->insurance;
+    result->total_tax += breakdown->tax;
+    result->total_net += breakdown->actual_salary;
+    result->bracket_employees[bracket] += 1;
+
+    if (breakdown->actual_salary > current_salary)
+    {
+        change = breakdown->actual_salary - current_salary;
+        result->raised += 1;
+        result->total_increase += change;
+        if (change > result->max_increase)
+        {
+            result->max_increase = change;
+        }
+        bucket = (change < 10000) ? 5 : (change < 100000) ? 6 : (change < 1000000) ? 7 : 8;
+    }
+    else if (breakdown->actual_salary < current_salary)
+    {
+        change = current_salary - breakdown->actual_salary;
+        result->lowered += 1;
+        result->total_decrease += change;
+        if (change > result->max_decrease)
+        {
+            result->max_decrease = change;
+        }
+        bucket = (change < 10000) ? 3 : (change < 100000) ? 2 : (change < 1000000) ? 1 : 0;
+    }
+    result->delta_histogram[bucket] += 1;
+}
+
+
+/**
+ * @brief Adds the result of a range to the total result.
+ */
+static void mergeResult(PayrollScenarioResult_t *total, const PayrollScenarioResult_t *part)
+{
+    uint32_t i = 0;                         /* Index for looping through brackets and buckets */
+
+    total->employees += part->employees;
+    total->total_gross += part->total_gross;
+    total->total_insurance += part->total_insurance;
+    total->total_tax += part->total_tax;
+    total->total_net += part->total_net;
+    total->raised += part->raised;
+    total->lowered += part->lowered;
+    total->total_increase += part->total_increase;
+    total->total_decrease += part->total_decrease;
+    if (part->max_increase > total->max_increase)
+    {
+        total->max_increase = part->max_increase;
+    }
+    if (part->max_decrease > total->max_decrease)
+    {
+        total->max_decrease = part->max_decrease;
+    }
+    for (i = 0; i < PAYROLL_MAX_BRACKETS; i++)
+    {
+        total->bracket_employees[i] += part->bracket_employees[i];
+    }
+    for (i = 0; i < PAYROLL_DELTA_BUCKETS; i++)
+    {
+        total->delta_histogram[i] += part->delta_histogram[i];
+    }
+}
+
+
+/**
+ * @brief Parses one scenario line (see payroll_simulation.h).
+ *
+ * @return 1 if the line is a valid scenario, 0 otherwise.
+ */
+static uint32_t parseScenario(const int8_t *line, PayrollRules_t *rules)
+{
+    const int8_t *fields[SIMULATION_MAX_FIELDS];   /* Start of each field */
+    uint32_t lengths[SIMULATION_MAX_FIELDS];       /* Length of each field */
+    uint32_t field_count = 0;               /* Number of fields */
+    const int8_t *colon = NULL;             /* Separator of a bracket's limit and rate */
+    uint64_t value = 0;                     /* Parsed number */
+    uint32_t length = 0;                    /* Length of the current field */
+    uint32_t start = 0;                     /* Position of the first non-blank character of the name */
+    uint32_t i = 0;                         /* Index for looping through fields */
+
+    /* Split the line at commas */
+    for (;;)
+    {
+        length = (uint32_t)strcspn((const char*)line, ",");
+        if (field_count == SIMULATION_MAX_FIELDS)
+        {
+            return 0;
+        }
+        fields[field_count] = line;
+        lengths[field_count] = length;
+        field_count++;
+        if (line[length] == '\0')
+        {
+            break;
+        }
+        line += length + 1;
+    }
+    if (field_count < 6)
+    {
+        return 0;
+    }
+
+    memset(rules, 0, sizeof(*rules));
+    /* Name, without surrounding blanks */
+    while (start < lengths[0] && (fields[0][start] == ' ' || fields[0][start] == '\t'))
+    {
+        start++;
+    }
+    while (lengths[0] > start && (fields[0][lengths[0] - 1] == ' ' || fields[0][lengths[0] - 1] == '\t'))
+    {
+        lengths[0]--;
+    }
+    if (lengths[0] == start || lengths[0] - start >= PAYROLL_SCENARIO_NAME_LENGTH)
+    {
+        return 0;
+    }
+    memcpy(rules->name, fields[0] + start, lengths[0] - start);
+
+    if (parseUnsignedField(fields[1], lengths[1], UINT16_MAX, &value) != PARSE_OK)
+    {
+        return 0;
+    }
+    rules->late_threshold_days = (uint16_t)value;
+    if (parseUnsignedField(fields[2], lengths[2], UINT32_MAX, &rules->late_penalty_low) != PARSE_OK
+        || parseUnsignedField(fields[3], lengths[3], UINT32_MAX, &rules->late_penalty_high) != PARSE_OK
+        || parsePercent(fields[4], lengths[4], &rules->insurance_basis_points) == 0)
+    {
+        return 0;
+    }
+
+    /* Brackets: limit:rate, the last limit is '*' */
+    rules->bracket_count = field_count - 5;
+    for (i = 0; i < rules->bracket_count; i++)
+    {
+        colon = memchr(fields[5 + i], ':', lengths[5 + i]);
+        if (colon == NULL
+            || parsePercent(colon + 1, lengths[5 + i] - (uint32_t)(colon - fields[5 + i]) - 1,
+                            &rules->bracket_basis_points[i]) == 0)
+        {
+            return 0;
+        }
+        length = (uint32_t)(colon - fields[5 + i]);
+        if (i == rules->bracket_count - 1)
+        {
+            if (isNoLimit(fields[5 + i], length) == 0)
+            {
+                return 0;
+            }
+            rules->bracket_limits[i] = PAYROLL_NO_LIMIT;
+        }
+        else if (parseUnsignedField(fields[5 + i], length, PAYROLL_NO_LIMIT - 1, &rules->bracket_limits[i]) != PARSE_OK)
+        {
+            return 0;
+        }
+    }
+    return (payrollRulesCheck(rules) == MANAGE_OK) ? 1 : 0;
+}
+
+
+/**
+ * @brief Parses a percentage with at most 2 decimals, such as 10, 10.5 or 0.25.
+ *
+ * @return 1 and the value in basis points, or 0 if the text is not such a percentage.
+ */
+static uint32_t parsePercent(const int8_t *text, uint32_t length, uint32_t *basis_points)
+{
+    const int8_t *dot = memchr(text, '.', length);     /* Decimal point */
+    uint32_t whole_length = length;         /* Length of the part before the decimal point */
+    uint64_t whole = 0;                     /* Whole percents */
+    uint32_t fraction = 0;                  /* Hundredths of a percent */
+    uint32_t digits = 0;                    /* Number of decimals read */
+    uint32_t i = 0;                         /* Position in the decimals */
+
+    if (dot != NULL)
+    {
+        whole_length = (uint32_t)(dot - text);
+        for (i = whole_length + 1; i < length && text[i] >= '0' && text[i] <= '9'; i++)
+        {
+            if (digits == 2)
+            {
+                return 0;
+            }
+            fraction = fraction * 10 + (uint32_t)(text[i] - '0');
+            digits++;
+        }
+        /* Only blanks may follow the decimals */
+        for (; i < length; i++)
+        {
+            if (text[i] != ' ' && text[i] != '\t')
+            {
+                return 0;
+            }
+        }
+        if (digits == 0)
+        {
+            return 0;
+        }
+        fraction *= (digits == 1) ? 10 : 1;
+    }
+    switch (parseUnsignedField(text, whole_length, BASIS_POINTS / 100, &whole))
+    {
+        case PARSE_OK:
+            break;
+        case PARSE_EMPTY:
+            /* ".5" has no whole percents */
+            if (dot == NULL)
+            {
+                return 0;
+            }
+            whole = 0;
+            break;
+        default:
+            return 0;
+    }
+    if (whole * 100 + fraction > BASIS_POINTS)
+    {
+        return 0;
+    }
+    *basis_points = (uint32_t)whole * 100 + fraction;
+    return 1;
+}
+
+
+/**
+ * @brief Checks if a bracket limit is '*', with optional blanks around it.
+ *
+ * @return 1 if it is, 0 otherwise.
+ */
+static uint32_t isNoLimit(const int8_t *text, uint32_t length)
+{
+    uint32_t stars = 0;                     /* Number of '*' characters */
+    uint32_t i = 0;                         /* Position in the text */
+
+    for (i = 0; i < length; i++)
+    {
+        if (text[i] == '*')
+        {
+            stars++;
+        }
+        else if (text[i] != ' ' && text[i] != '\t')
+        {
+            return 0;
+        }
+    }
+    return (stars == 1) ? 1 : 0;
+}
+
+
+/**
+ * @brief Prints the totals of one rule set.
+ */
+static void printRuleTotals(const int8_t *name, const PayrollScenarioResult_t *result)
+{
+    printf("\n---- %s ----\n", name);
+    printf("Gross income: %s (VND)\n", formatNumberWithCommas(result->total_gross));
+    printf("Insurance: %s (VND)\n", formatNumberWithCommas(result->total_insurance));
+    printf("Tax: %s (VND)\n", formatNumberWithCommas(result->total_tax));
+    printf("Net salary: %s (VND)\n", formatNumberWithCommas(result->total_net));
+} /* EOF */
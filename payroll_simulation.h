@@ -0,0 +1,149 @@
+/**
+ * @file payroll_simulation.h
+ * @brief This file contains the function prototypes of the payroll what-if simulation.
+ *
+ * A simulation evaluates many sets of payroll rules (late penalties, insurance rate and tax
+ * brackets) against every stored employee without changing the stored data or the rules used
+ * by the rest of the program. The employees are read in a single pass: each record is loaded
+ * once and every scenario is calculated on it before moving on, and the pass is split across
+ * threads. Each scenario is compared employee by employee with the current rules
+ * (payrollRulesDefault()).
+ *
+ * Scenario file format (one scenario per line, fields separated by commas):
+ *     name,late_threshold_days,late_penalty_low,late_penalty_high,insurance_%,limit:rate_%,...
+ * for example the current rules are
+ *     current,3,10000,20000,10.5,11000000:0,16000000:5,*:10
+ * A tax bracket is written as the largest income after insurance it applies to and its rate;
+ * the last bracket has no limit and is written '*'. Percentages have at most 2 decimals.
+ * Blank lines and lines starting with '#' are ignored.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef PAYROLL_SIMULATION_H
+#define PAYROLL_SIMULATION_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for Employee_t and SalaryBreakdown_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define PAYROLL_MAX_BRACKETS 8              /* Largest number of tax brackets in a rule set */
+#define PAYROLL_MAX_SCENARIOS 64            /* Largest number of scenarios simulated at once */
+#define PAYROLL_SCENARIO_NAME_LENGTH 32     /* Size of a scenario name, including the terminator */
+#define PAYROLL_NO_LIMIT UINT64_MAX         /* Limit of the last tax bracket */
+#define PAYROLL_DELTA_BUCKETS 9             /* Number of buckets of the net salary change histogram */
+
+/**
+ * @brief Rules used to calculate a salary.
+ *
+ * Rates are in basis points (1% = 100). The tax of an employee is the rate of the first bracket
+ * whose limit is not below the income after insurance, applied to the whole income after
+ * insurance. Department bonuses and raises are not part of the rules.
+ */
+typedef struct PayrollRules {
+    int8_t name[PAYROLL_SCENARIO_NAME_LENGTH];      /* Name of the scenario */
+    uint16_t late_threshold_days;                   /* Late days up to this number use late_penalty_low */
+    uint64_t late_penalty_low;                      /* Penalty per late day, up to the threshold */
+    uint64_t late_penalty_high;                     /* Penalty per late day, above the threshold */
+    uint32_t insurance_basis_points;                /* Part of the gross income deducted for insurance */
+    uint32_t bracket_count;                         /* Number of tax brackets */
+    uint64_t bracket_limits[PAYROLL_MAX_BRACKETS];  /* Largest income of each bracket, increasing,
+                                                       the last one is PAYROLL_NO_LIMIT */
+    uint32_t bracket_basis_points[PAYROLL_MAX_BRACKETS];   /* Tax rate of each bracket */
+} PayrollRules_t;
+
+/**
+ * @brief Totals of one scenario and how it changes net salaries compared with the current rules.
+ *
+ * Histogram buckets of the change of an employee's net salary (VND):
+ *     0: <= -1,000,000   1: -999,999..-100,000   2: -99,999..-10,000   3: -9,999..-1
+ *     4: 0               5: 1..9,999             6: 10,000..99,999     7: 100,000..999,999
+ *     8: >= 1,000,000
+ */
+typedef struct PayrollScenarioResult {
+    uint64_t employees;                     /* Number of employees calculated */
+    uint64_t total_gross;                   /* Sum of the gross incomes */
+    uint64_t total_insurance;               /* Sum of the insurance deductions */
+    uint64_t total_tax;                     /* Sum of the taxes */
+    uint64_t total_net;                     /* Sum of the net salaries */
+    uint64_t raised;                        /* Employees who receive more than with the current rules */
+    uint64_t lowered;                       /* Employees who receive less than with the current rules */
+    uint64_t total_increase;                /* Sum of the increases of the raised employees */
+    uint64_t total_decrease;                /* Sum of the decreases of the lowered employees */
+    uint64_t max_increase;                  /* Largest increase of one employee */
+    uint64_t max_decrease;                  /* Largest decrease of one employee */
+    uint64_t bracket_employees[PAYROLL_MAX_BRACKETS];  /* Employees taxed in each bracket */
+    uint64_t delta_histogram[PAYROLL_DELTA_BUCKETS];   /* Employees per change of net salary */
+} PayrollScenarioResult_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Fills a rule set with the rules used by calculateSalaryBreakdown().
+ */
+void payrollRulesDefault(PayrollRules_t *rules);
+
+/**
+ * @brief Checks that a rule set can be simulated.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_INVALID_ARGUMENT if a rate is above 100%, there is no
+ *         bracket, the limits do not increase or the last limit is not PAYROLL_NO_LIMIT.
+ */
+ManageStatus_t payrollRulesCheck(const PayrollRules_t *rules);
+
+/**
+ * @brief Calculates the salary of an employee with the given rules.
+ *
+ * With payrollRulesDefault() the result is the same as calculateSalaryForDepartment().
+ *
+ * @param employee The employee for whom the salary is to be calculated.
+ * @param department The employee's department, or NULL if it has none.
+ * @param rules Rules to use; they must pass payrollRulesCheck().
+ * @param breakdown Receives the intermediate values and the actual salary.
+ */
+void calculateSalaryWithRules(const Employee_t *employee, const Department_t *department,
+                              const PayrollRules_t *rules, SalaryBreakdown_t *breakdown);
+
+/**
+ * @brief Simulates the payroll of every stored employee under many scenarios in one pass.
+ *
+ * The store must not change while the simulation runs.
+ *
+ * @param scenarios Rule sets to evaluate.
+ * @param scenario_count Number of rule sets, at most PAYROLL_MAX_SCENARIOS.
+ * @param thread_count Number of threads, 0 to use one per processor.
+ * @param results Receives the result of each scenario, in scenario order.
+ * @param current Receives the result of the current rules (may be NULL).
+ * @return MANAGE_OK, MANAGE_ERR_INVALID_ARGUMENT if a rule set fails payrollRulesCheck()
+ *         or there are too many, or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t simulatePayroll(const PayrollRules_t *scenarios, uint32_t scenario_count, uint32_t thread_count,
+                               PayrollScenarioResult_t *results, PayrollScenarioResult_t *current);
+
+/**
+ * @brief Reads scenarios from a file.
+ *
+ * @param path Path of the file.
+ * @param scenarios Receives the rule sets.
+ * @param max_scenarios Number of entries in scenarios.
+ * @param count Receives the number of rule sets read.
+ * @param error_line Receives the line of the first invalid scenario, 0 if there is none.
+ * @return MANAGE_OK, MANAGE_ERR_IO if the file cannot be read,
+ *         or MANAGE_ERR_INVALID_ARGUMENT if a line is invalid or there are too many scenarios.
+ */
+ManageStatus_t loadPayrollScenarios(const char *path, PayrollRules_t *scenarios, uint32_t max_scenarios,
+                                    uint32_t *count, uint64_t *error_line);
+
+/**
+ * @brief Prompts the user for a scenario file, simulates it and prints the comparison.
+ */
+void simulatePayrollScenarios();
+
+#endif /* PAYROLL_SIMULATION_H */
@@ -0,0 +1,89 @@
+/**
+ * @file payroll_stream.c
+ * @brief This file contains the implementation of the batched employee and payroll cursor.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <string.h>             /* Include string manipulation library for memset */
+#include "payroll_stream.h"     /* Include header file */
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Opens a cursor on the stored employees.
+ */
+void payrollCursorOpen(PayrollCursor_t *cursor, const uint32_t *order, uint32_t count, uint32_t flags)
+{
+    cursor->order = order;
+    cursor->next = 0;
+    cursor->end = (order != NULL) ? count : getTotalEmployees();
+    cursor->flags = flags;
+}
+
+
+/**
+ * @brief Fills the next batch of lines.
+ */
+uint32_t payrollCursorNext(PayrollCursor_t *cursor, PayrollLine_t *lines, uint32_t max_lines)
+{
+    PayrollLine_t *line = NULL;             /* Line being filled */
+    uint32_t position = 0;                  /* Store position of the next employee */
+    uint32_t filled = 0;                    /* Number of lines filled */
+
+    while (filled < max_lines && cursor->next < cursor->end)
+    {
+        position = (cursor->order != NULL) ? cursor->order[cursor->next] : cursor->next;
+        cursor->next += 1;
+
+        line = &lines[filled];
+        line->employee = getEmployeeAt(position);
+        if (line->employee == NULL)
+        {
+            continue;
+        }
+        line->position = position;
+        line->department = findDepartment(line->employee->department_id);
+        if ((cursor->flags & PAYROLL_CURSOR_SALARY) != 0)
+        {
+            calculateSalaryForDepartment(line->employee, line->department, &line->salary);
+        }
+        else
+        {
+            memset(&line->salary, 0, sizeof(line->salary));
+        }
+        filled += 1;
+    }
+    return filled;
+}
+
+
+/**
+ * @brief Calls a function on the stored employees, PAYROLL_STREAM_BATCH lines at a time.
+ */
+uint64_t forEachPayrollBatch(const uint32_t *order, uint32_t count, uint32_t flags,
+                             PayrollBatchFn_t visit, void *context)
+{
+    PayrollLine_t lines[PAYROLL_STREAM_BATCH];     /* Current batch */
+    PayrollCursor_t cursor;                 /* Walk through the store */
+    uint64_t visited = 0;                   /* Number of lines given to visit */
+    uint32_t filled = 0;                    /* Number of lines in the current batch */
+
+    payrollCursorOpen(&cursor, order, count, flags);
+    for (;;)
+    {
+        filled = payrollCursorNext(&cursor, lines, PAYROLL_STREAM_BATCH);
+        if (filled == 0)
+        {
+            break;
+        }
+        visited += filled;
+        if (visit(lines, filled, context) == 0)
+        {
+            break;
+        }
+    }
+    return visited;
+} /* EOF */
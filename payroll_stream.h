@@ -0,0 +1,100 @@
+/**
+ * @file payroll_stream.h
+ * @brief This file contains the function prototypes for reading employees and payroll lines in batches.
+ *
+ * A cursor walks the stored employees (in store order or in an order from sortEmployeeOrder())
+ * and fills a caller-provided batch of lines at a time, calculating the salaries of that
+ * batch only. Consumers (printing, export, aggregation, serving) therefore use memory for one
+ * batch whatever the number of employees, and can stop at any point.
+ *
+ * The lines point into the store: they stay valid until an employee or a department is
+ * deleted. The store must not change while a cursor is open.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef PAYROLL_STREAM_H
+#define PAYROLL_STREAM_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for Employee_t and SalaryBreakdown_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define PAYROLL_STREAM_BATCH 256            /* Lines per batch of forEachPayrollBatch() */
+#define PAYROLL_CURSOR_SALARY 0x01u         /* Calculate the salary of each line */
+
+/**
+ * @brief One employee and, if requested, its payroll.
+ */
+typedef struct PayrollLine {
+    uint32_t position;                      /* Store position of the employee */
+    const Employee_t *employee;             /* The employee */
+    const Department_t *department;         /* The employee's department, NULL if it has none */
+    SalaryBreakdown_t salary;               /* Payroll of the employee, zero without PAYROLL_CURSOR_SALARY */
+} PayrollLine_t;
+
+/**
+ * @brief Position of a walk through the stored employees.
+ */
+typedef struct PayrollCursor {
+    const uint32_t *order;                  /* Store positions to visit, NULL for store order */
+    uint32_t next;                          /* Index of the next employee to visit */
+    uint32_t end;                           /* Index after the last employee to visit */
+    uint32_t flags;                         /* PAYROLL_CURSOR_* flags */
+} PayrollCursor_t;
+
+/**
+ * @brief Receives one batch of lines.
+ *
+ * @param lines Lines of the batch, valid during the call only.
+ * @param count Number of lines, more than 0.
+ * @param context The context given to forEachPayrollBatch().
+ * @return 1 to receive the next batch, 0 to stop.
+ */
+typedef uint32_t (*PayrollBatchFn_t)(const PayrollLine_t *lines, uint32_t count, void *context);
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Opens a cursor on the stored employees.
+ *
+ * @param cursor The cursor to open.
+ * @param order Store positions to visit, or NULL to visit every employee in store order.
+ * @param count Number of entries in order; ignored when order is NULL.
+ * @param flags PAYROLL_CURSOR_SALARY to calculate salaries, 0 for the employees only.
+ */
+void payrollCursorOpen(PayrollCursor_t *cursor, const uint32_t *order, uint32_t count, uint32_t flags);
+
+/**
+ * @brief Fills the next batch of lines.
+ *
+ * Positions that are no longer in the store are skipped.
+ *
+ * @param cursor An open cursor.
+ * @param lines Receives the lines.
+ * @param max_lines Number of entries in lines.
+ * @return Number of lines filled, 0 when every employee has been visited.
+ */
+uint32_t payrollCursorNext(PayrollCursor_t *cursor, PayrollLine_t *lines, uint32_t max_lines);
+
+/**
+ * @brief Calls a function on the stored employees, PAYROLL_STREAM_BATCH lines at a time.
+ *
+ * @param order Store positions to visit, or NULL to visit every employee in store order.
+ * @param count Number of entries in order; ignored when order is NULL.
+ * @param flags PAYROLL_CURSOR_SALARY to calculate salaries, 0 for the employees only.
+ * @param visit Function called on each batch.
+ * @param context Passed to visit.
+ * @return Number of lines given to visit.
+ */
+uint64_t forEachPayrollBatch(const uint32_t *order, uint32_t count, uint32_t flags,
+                             PayrollBatchFn_t visit, void *context);
+
+#endif /* PAYROLL_STREAM_H */
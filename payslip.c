@@ -0,0 +1,641 @@
+/**
+ * @file payslip.c
+ * @brief This file contains the implementation of the payslip generator.
+ *
+ * The store is one range of the worker pool, whose threads steal ranges from each other, so a
+ * thread that is slowed down by the file system does not hold the others back. Each thread
+ * keeps its own buffers and counts, added together when all threads are done.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdio.h>              /* Include standard input and output library for printf, FILE, snprintf */
+#include <stdlib.h>             /* Include standard library for malloc, free */
+#include <string.h>             /* Include string manipulation library for memcpy, strlen, strchr */
+#include <errno.h>              /* Include error number library for EEXIST */
+#include <time.h>               /* Include time library for clock_gettime, time */
+#ifdef _WIN32
+#include <direct.h>             /* Include directory header file for _mkdir */
+#else
+#include <sys/stat.h>           /* Include POSIX header file for mkdir */
+#endif
+#include "payslip.h"            /* Include header file */
+#include "input_handler.h"      /* Include input handler header file for formatNumberWithCommas */
+#include "worker_pool.h"        /* Include worker pool header file for the payslip threads */
+#include "perf_stats.h"         /* Include instrumentation header file for measuring hot operations */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define PAYSLIP_FILE_SUFFIX ".txt"          /* Extension of a payslip file */
+#define PAYSLIP_MAX_PATH 260                /* Size of a directory name entered by the user */
+
+/**
+ * @brief One payslip thread: its buffers and counts.
+ */
+typedef struct PayslipWorker {
+    int8_t *buffer;                         /* Rendered payslip, allocated with the first range */
+    char *path;                             /* File of the current payslip, allocated with the first range */
+    uint32_t written;                       /* Number of payslips written by this thread */
+    uint32_t failed;                        /* Number of payslips this thread could not write */
+    uint64_t bytes;                         /* Number of bytes written by this thread */
+    uint32_t out_of_memory;                 /* Flag set if the thread had no buffer */
+} PayslipWorker_t;
+
+/**
+ * @brief Work shared by the payslip threads.
+ */
+typedef struct PayslipJob {
+    const PayslipTemplate_t *compiled;      /* The template */
+    const char *directory;                  /* Directory of the payslips */
+    PayslipWorker_t *workers;               /* Buffers and counts of each thread */
+} PayslipJob_t;
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static void writeRange(void *context, uint32_t worker, const WorkerRange_t *range);
+static uint32_t payslipFileName(const char *directory, const Employee_t *employee, uint32_t position, char *path);
+static ManageStatus_t makeDirectory(const char *directory);
+static uint32_t formatText(const int8_t *text, uint32_t max_length, int8_t *out);
+static uint32_t formatAmount(uint64_t value, int8_t *out);
+static void addPiece(PayslipTemplate_t *compiled, PayslipField_t field, uint32_t offset, uint32_t length);
+
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+/* Name of each field in a template, in the order of PayslipField_t */
+static const char *const payslip_field_names[PAYSLIP_FIELD_COUNT] = {
+    "employee_id",
+    "name",
+    "department_id",
+    "salary_base",
+    "working_days",
+    "working_performance",
+    "income_without_bonus",
+    "bonus",
+    "department_bonus",
+    "late_coming_days",
+    "late_coming_penalty",
+    "gross",
+    "insurance",
+    "income_after_insurance",
+    "tax_bracket",
+    "tax_rate",
+    "tax",
+    "department_raise",
+    "net"
+};
+
+/* Rate of each tax bracket, as returned by taxBracket() */
+static const char *const tax_rates[3] = {"0%", "5%", "10%"};
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Compiles a template.
+ */
+ManageStatus_t compilePayslipTemplate(const char *text, PayslipTemplate_t *compiled, uint32_t *error_offset)
+{
+    const char *close = NULL;               /* Closing brace of a field */
+    size_t length = strlen(text);           /* Length of the template */
+    uint32_t braces = 0;                    /* Number of '{' in the template */
+    uint32_t text_length = 0;               /* Length of the text copied so far */
+    uint32_t piece_start = 0;               /* Start of the current text piece */
+    uint32_t field_length = 0;              /* Length of a field name */
+    uint32_t field = 0;                     /* Index for looping through field names */
+    size_t i = 0;                           /* Position in the template */
+
+    memset(compiled, 0, sizeof(*compiled));
+    if (length > PAYSLIP_MAX_TEMPLATE)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    for (i = 0; i < length; i++)
+    {
+        braces += (text[i] == '{') ? 1u : 0u;
+    }
+    /* Each field adds at most itself and the text before it */
+    compiled->text = malloc(length + 1);
+    compiled->pieces = malloc((2 * (size_t)braces + 1) * sizeof(*compiled->pieces));
+    if (compiled->text == NULL || compiled->pieces == NULL)
+    {
+        freePayslipTemplate(compiled);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+
+    i = 0;
+    while (i < length)
+    {
+        if (text[i] != '{')
+        {
+            compiled->text[text_length++] = text[i++];
+            continue;
+        }
+        if (text[i + 1] == '{')
+        {
+            compiled->text[text_length++] = '{';
+            i += 2;
+            continue;
+        }
+
+        close = strchr(text + i + 1, '}');
+        field_length = (close != NULL) ? (uint32_t)(close - (text + i + 1)) : 0;
+        for (field = 0; close != NULL && field < PAYSLIP_FIELD_COUNT; field++)
+        {
+            if (strlen(payslip_field_names[field]) == field_length
+                && memcmp(payslip_field_names[field], text + i + 1, field_length) == 0)
+            {
+                break;
+            }
+        }
+        if (close == NULL || field == PAYSLIP_FIELD_COUNT)
+        {
+            if (error_offset != NULL)
+            {
+                *error_offset = (uint32_t)i;
+            }
+            freePayslipTemplate(compiled);
+            return MANAGE_ERR_INVALID_ARGUMENT;
+        }
+
+        addPiece(compiled, PAYSLIP_TEXT, piece_start, text_length - piece_start);
+        addPiece(compiled, (PayslipField_t)field, 0, 0);
+        piece_start = text_length;
+        i = (size_t)(close - text) + 1;
+    }
+    addPiece(compiled, PAYSLIP_TEXT, piece_start, text_length - piece_start);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Reads a template file and compiles it.
+ */
+ManageStatus_t loadPayslipTemplate(const char *path, PayslipTemplate_t *compiled, uint32_t *error_offset)
+{
+    FILE *file = fopen(path, "rb");         /* The template file */
+    char *text = NULL;                      /* Content of the file */
+    size_t length = 0;                      /* Number of bytes read */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the compilation */
+
+    memset(compiled, 0, sizeof(*compiled));
+    if (file == NULL)
+    {
+        return MANAGE_ERR_IO;
+    }
+    text = malloc(PAYSLIP_MAX_TEMPLATE + 2);
+    if (text == NULL)
+    {
+        fclose(file);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    length = fread(text, 1, PAYSLIP_MAX_TEMPLATE + 1, file);
+    if (ferror(file) != 0 || length > PAYSLIP_MAX_TEMPLATE)
+    {
+        status = MANAGE_ERR_IO;
+    }
+    else
+    {
+        text[length] = '\0';
+        status = compilePayslipTemplate(text, compiled, error_offset);
+    }
+    fclose(file);
+    free(text);
+    return status;
+}
+
+
+/**
+ * @brief Frees a compiled template.
+ */
+void freePayslipTemplate(PayslipTemplate_t *compiled)
+{
+    free(compiled->text);
+    free(compiled->pieces);
+    memset(compiled, 0, sizeof(*compiled));
+}
+
+
+/**
+ * @brief Renders the payslip of one employee.
+ */
+uint32_t renderPayslip(const PayslipTemplate_t *compiled, const Employee_t *employee,
+                       const SalaryBreakdown_t *salary, int8_t *out)
+{
+    const PayslipPiece_t *piece = NULL;     /* Current piece */
+    uint32_t bracket = taxBracket(salary->totalIncome_without_tax);    /* Tax bracket, 0 to 2 */
+    uint32_t length = 0;                    /* Number of bytes written */
+    int written = 0;                        /* Result of snprintf */
+    uint32_t p = 0;                         /* Index for looping through pieces */
+
+    for (p = 0; p < compiled->piece_count; p++)
+    {
+        piece = &compiled->pieces[p];
+        switch (piece->field)
+        {
+            case PAYSLIP_TEXT:
+                memcpy(out + length, compiled->text + piece->offset, piece->length);
+                length += piece->length;
+                break;
+            case PAYSLIP_FIELD_EMPLOYEE_ID:
+                length += formatText(employee->id, MAX_ID_LENGTH, out + length);
+                break;
+            case PAYSLIP_FIELD_NAME:
+                length += formatText(employee->name, MAX_NAME_LENGTH, out + length);
+                break;
+            case PAYSLIP_FIELD_DEPARTMENT_ID:
+                length += formatText(employee->department_id, MAX_ID_LENGTH, out + length);
+                break;
+            case PAYSLIP_FIELD_SALARY_BASE:
+                length += formatAmount(employee->salary_base, out + length);
+                break;
+            case PAYSLIP_FIELD_WORKING_DAYS:
+                length += formatAmount(employee->working_days, out + length);
+                break;
+            case PAYSLIP_FIELD_WORKING_PERFORMANCE:
+                written = snprintf((char *)out + length, PAYSLIP_FIELD_LENGTH, "%.2f", employee->working_performance);
+                length += (written < 0) ? 0u : (written >= PAYSLIP_FIELD_LENGTH) ? PAYSLIP_FIELD_LENGTH - 1u
+                                                                                   : (uint32_t)written;
+                break;
+            case PAYSLIP_FIELD_INCOME_WITHOUT_BONUS:
+                length += formatAmount(salary->income_without_bonus, out + length);
+                break;
+            case PAYSLIP_FIELD_BONUS:
+                length += formatAmount(employee->bonus, out + length);
+                break;
+            case PAYSLIP_FIELD_DEPARTMENT_BONUS:
+                length += formatAmount(salary->department_bonus, out + length);
+                break;
+            case PAYSLIP_FIELD_LATE_COMING_DAYS:
+                length += formatAmount(employee->late_coming_days, out + length);
+                break;
+            case PAYSLIP_FIELD_LATE_COMING_PENALTY:
+                length += formatAmount(salary->late_coming_penalty, out + length);
+                break;
+            case PAYSLIP_FIELD_GROSS:
+                length += formatAmount(salary->total_income, out + length);
+                break;
+            case PAYSLIP_FIELD_INSURANCE:
+                length += formatAmount(salary->insurance, out + length);
+                break;
+            case PAYSLIP_FIELD_INCOME_AFTER_INSURANCE:
+                length += formatAmount(salary->totalIncome_without_tax, out + length);
+                break;
+            case PAYSLIP_FIELD_TAX_BRACKET:
+                length += formatAmount(bracket + 1, out + length);
+                break;
+            case PAYSLIP_FIELD_TAX_RATE:
+                length += formatText((const int8_t *)tax_rates[bracket], PAYSLIP_FIELD_LENGTH, out + length);
+                break;
+            case PAYSLIP_FIELD_TAX:
+                length += formatAmount(salary->tax, out + length);
+                break;
+            case PAYSLIP_FIELD_DEPARTMENT_RAISE:
+                length += formatAmount(salary->department_raise, out + length);
+                break;
+            case PAYSLIP_FIELD_NET:
+                length += formatAmount(salary->actual_salary, out + length);
+                break;
+            default:
+                break;
+        }
+    }
+    return length;
+}
+
+
+/**
+ * @brief Writes the payslip of every stored employee to a directory.
+ *
+ * The store is one range of the worker pool, split into ranges of at most PAYSLIP_CHUNK
+ * employees while the threads work.
+ */
+ManageStatus_t generatePayslips(const PayslipTemplate_t *compiled, const char *directory, uint32_t thread_count,
+                                PayslipReport_t *report)
+{
+    PayslipJob_t job;                       /* The shared work */
+    PayslipWorker_t workers[WORKER_POOL_MAX_THREADS];  /* Buffers and counts of each thread */
+    WorkerRange_t range;                    /* Every stored employee */
+    uint32_t out_of_memory = 0;             /* Flag set if a thread had no buffer */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the generation */
+    uint32_t t = 0;                         /* Index for looping through threads */
+    PERF_START(perf_start);                 /* Start time of the generation */
+
+    memset(report, 0, sizeof(*report));
+    status = makeDirectory(directory);
+    if (status != MANAGE_OK)
+    {
+        return status;
+    }
+
+    job.compiled = compiled;
+    job.directory = directory;
+    job.workers = workers;
+    range.group = 0;
+    range.first = 0;
+    range.end = getTotalEmployees();
+    thread_count = workerPoolThreadCount(range.end, PAYSLIP_CHUNK, thread_count);
+    memset(workers, 0, thread_count * sizeof(workers[0]));
+
+    /* Build the department index before the threads look departments up */
+    findDepartment((const int8_t *)"");
+    status = runWorkerPool(&range, 1, PAYSLIP_CHUNK, thread_count, writeRange, &job);
+    for (t = 0; t < thread_count; t++)
+    {
+        report->written += workers[t].written;
+        report->failed += workers[t].failed;
+        report->bytes += workers[t].bytes;
+        out_of_memory |= workers[t].out_of_memory;
+        free(workers[t].buffer);
+        free(workers[t].path);
+    }
+    report->thread_count = thread_count;
+    PERF_STOP(PERF_OP_GENERATE_PAYSLIPS, perf_start);
+
+    if (status != MANAGE_OK || out_of_memory != 0)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    return (report->failed > 0) ? MANAGE_ERR_IO : MANAGE_OK;
+}
+
+
+/**
+ * @brief Prompts the user for a directory and a template file, and writes every payslip.
+ */
+void generatePayslipFiles()
+{
+    char directory[PAYSLIP_MAX_PATH];       /* Directory entered by the user */
+    char path[PAYSLIP_MAX_PATH];            /* Template file entered by the user */
+    PayslipTemplate_t compiled;             /* The template */
+    PayslipReport_t report;                 /* Counts of the generation */
+    struct timespec start;                  /* Time the generation started */
+    struct timespec end;                    /* Time the generation ended */
+    uint32_t error_offset = 0;              /* Position of an invalid field in the template */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the generation */
+
+    if (getTotalEmployees() == 0)
+    {
+        printf("No employee to generate payslips!!!\n");
+        return;
+    }
+    do
+    {
+        printf("Enter directory for the payslips: ");
+        fflush(stdin);
+        if (fgets(directory, sizeof(directory), stdin) == NULL)
+        {
+            return;
+        }
+        /* Remove newline character, spaces are allowed in file names */
+        directory[strcspn(directory, "\r\n")] = '\0';
+        if (directory[0] == '\0')
+        {
+            printf("\nYou must not leave blank this information ...\n");
+            printf("\nPlease enter again ...\n");
+        }
+    } while (directory[0] == '\0');
+    printf("Enter template file name (or press Enter for the standard payslip): ");
+    fflush(stdin);
+    if (fgets(path, sizeof(path), stdin) == NULL)
+    {
+        return;
+    }
+    path[strcspn(path, "\r\n")] = '\0';
+
+    status = (path[0] == '\0') ? compilePayslipTemplate(PAYSLIP_DEFAULT_TEMPLATE, &compiled, &error_offset)
+                               : loadPayslipTemplate(path, &compiled, &error_offset);
+    if (status == MANAGE_ERR_IO)
+    {
+        printf("Cannot read template file %s (at most %u bytes)\n", path, PAYSLIP_MAX_TEMPLATE);
+        return;
+    }
+    if (status == MANAGE_ERR_INVALID_ARGUMENT)
+    {
+        printf("Unknown or unclosed field at position %u of the template\n", error_offset);
+        return;
+    }
+    if (status != MANAGE_OK)
+    {
+        printf("Not enough memory to generate payslips!!!\n");
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    status = generatePayslips(&compiled, directory, 0, &report);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    freePayslipTemplate(&compiled);
+    if (status == MANAGE_ERR_NO_MEMORY)
+    {
+        printf("Not enough memory to generate payslips!!!\n");
+        return;
+    }
+    if (report.written == 0 && report.failed == 0)
+    {
+        printf("Cannot create directory %s\n", directory);
+        return;
+    }
+    printf("Wrote %s payslips", formatNumberWithCommas(report.written));
+    printf(" (%s bytes) to %s with %u threads in %.2f s\n", formatNumberWithCommas(report.bytes), directory,
+           report.thread_count, (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+    if (report.failed > 0)
+    {
+        printf("%s payslips could not be written!!!\n", formatNumberWithCommas(report.failed));
+    }
+}
+
+
+/**
+ * @brief Writes the payslips of a range of employees with the buffers of a thread.
+ *
+ * A thread that cannot allocate its buffers counts the payslips of its ranges as failed.
+ */
+static void writeRange(void *context, uint32_t worker, const WorkerRange_t *range)
+{
+    PayslipJob_t *job = context;            /* The shared work */
+    PayslipWorker_t *state = &job->workers[worker];    /* Buffers and counts of the thread */
+    const Employee_t *employee = NULL;      /* Current employee */
+    SalaryBreakdown_t salary;               /* Payroll of the current employee */
+    FILE *file = NULL;                      /* The payslip file */
+    uint32_t length = 0;                    /* Length of the rendered payslip */
+    uint32_t i = 0;                         /* Index for looping through the range */
+
+    if (state->buffer == NULL && state->out_of_memory == 0)
+    {
+        state->buffer = malloc(job->compiled->max_length + 1);
+        state->path = malloc(strlen(job->directory) + 2 * MAX_ID_LENGTH + 32);
+        state->out_of_memory = (state->buffer == NULL || state->path == NULL) ? 1 : 0;
+    }
+    if (state->out_of_memory != 0)
+    {
+        state->failed += range->end - range->first;
+        return;
+    }
+
+    for (i = range->first; i < range->end; i++)
+    {
+        employee = getEmployeeAt(i);
+        calculateSalaryForDepartment(employee, findDepartment(employee->department_id), &salary);
+        length = renderPayslip(job->compiled, employee, &salary, state->buffer);
+        payslipFileName(job->directory, employee, i, state->path);
+
+        /* The whole payslip is in the buffer: write it with one call and no stdio copy */
+        file = fopen(state->path, "wb");
+        if (file != NULL)
+        {
+            setvbuf(file, NULL, _IONBF, 0);
+        }
+        if (file != NULL && fwrite(state->buffer, 1, length, file) == length && fclose(file) == 0)
+        {
+            state->written++;
+            state->bytes += length;
+        }
+        else
+        {
+            if (file != NULL)
+            {
+                fclose(file);
+            }
+            state->failed++;
+        }
+    }
+}
+
+
+/**
+ * @brief Builds the file name of a payslip: "<directory>/<id>.txt".
+ *
+ * Upper-case letters are written in lower case and characters other than letters, digits, '-',
+ * '_' and '.' are replaced by '_', and a name that had to be changed ends with the store
+ * position so that it cannot be taken by another ID, even where file names ignore case
+ * ("NV01" and "nv01" would otherwise be the same file).
+ * A leading '.' is replaced too, so no name is hidden or refers to a parent directory.
+ *
+ * @return Length of the path.
+ */
+static uint32_t payslipFileName(const char *directory, const Employee_t *employee, uint32_t position, char *path)
+{
+    uint32_t length = (uint32_t)strlen(directory); /* Length of the path */
+    uint32_t changed = 0;                   /* Flag set if a character of the ID was replaced */
+    int8_t c = 0;                           /* Current character of the ID */
+    uint32_t i = 0;                         /* Position in the ID */
+
+    memcpy(path, directory, length);
+    path[length++] = '/';
+    for (i = 0; i < MAX_ID_LENGTH && employee->id[i] != '\0'; i++)
+    {
+        c = employee->id[i];
+        if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || (c == '.' && i > 0))
+        {
+            path[length++] = (char)c;
+        }
+        else if (c >= 'A' && c <= 'Z')
+        {
+            path[length++] = (char)(c + ('a' - 'A'));
+            changed = 1;
+        }
+        else
+        {
+            path[length++] = '_';
+            changed = 1;
+        }
+    }
+    if (changed == 1)
+    {
+        length += (uint32_t)sprintf(path + length, "~%u", position);
+    }
+    memcpy(path + length, PAYSLIP_FILE_SUFFIX, sizeof(PAYSLIP_FILE_SUFFIX));
+    return length + (uint32_t)sizeof(PAYSLIP_FILE_SUFFIX) - 1;
+}
+
+
+/**
+ * @brief Creates a directory unless it exists.
+ *
+ * @return MANAGE_OK or MANAGE_ERR_IO.
+ */
+static ManageStatus_t makeDirectory(const char *directory)
+{
+#ifdef _WIN32
+    if (_mkdir(directory) == 0 || errno == EEXIST)
+#else
+    if (mkdir(directory, 0755) == 0 || errno == EEXIST)
+#endif
+    {
+        return MANAGE_OK;
+    }
+    return MANAGE_ERR_IO;
+}
+
+
+/**
+ * @brief Copies a string field.
+ *
+ * @return Number of bytes written, at most max_length.
+ */
+static uint32_t formatText(const int8_t *text, uint32_t max_length, int8_t *out)
+{
+    uint32_t length = 0;                    /* Length of the field */
+
+    while (length < max_length && length < PAYSLIP_FIELD_LENGTH && text[length] != '\0')
+    {
+        out[length] = text[length];
+        length++;
+    }
+    return length;
+}
+
+
+/**
+ * @brief Formats an amount with commas, as formatNumberWithCommas() does, into a caller buffer.
+ *
+ * @return Number of bytes written.
+ */
+static uint32_t formatAmount(uint64_t value, int8_t *out)
+{
+    int8_t digits[32];                      /* Digits and commas, from the last one */
+    uint32_t count = 0;                     /* Number of characters in digits */
+    uint32_t group = 0;                     /* Number of digits since the last comma */
+    uint32_t i = 0;                         /* Index for looping through digits */
+
+    do
+    {
+        if (group == 3)
+        {
+            digits[count++] = ',';
+            group = 0;
+        }
+        digits[count++] = (int8_t)('0' + value % 10);
+        value /= 10;
+        group++;
+    } while (value > 0);
+
+    for (i = 0; i < count; i++)
+    {
+        out[i] = digits[count - 1 - i];
+    }
+    return count;
+}
+
+
+/**
+ * @brief Appends a piece to a template being compiled; empty text pieces are left out.
+ */
+static void addPiece(PayslipTemplate_t *compiled, PayslipField_t field, uint32_t offset, uint32_t length)
+{
+    if (field == PAYSLIP_TEXT && length == 0)
+    {
+        return;
+    }
+    compiled->pieces[compiled->piece_count].field = field;
+    compiled->pieces[compiled->piece_count].offset = offset;
+    compiled->pieces[compiled->piece_count].length = length;
+    compiled->piece_count++;
+    compiled->max_length += (field == PAYSLIP_TEXT) ? length : PAYSLIP_FIELD_LENGTH;
+} /* EOF */
@@ -0,0 +1,179 @@
+/**
+ * @file payslip.h
+ * @brief This file contains the function prototypes for generating one payslip file per employee.
+ *
+ * A payslip is rendered from a template: plain text with fields written as {field}, for
+ * example "Net salary: {net}". "{{" stands for a single '{'. The template is compiled once into
+ * a list of text pieces and fields, so rendering a payslip is a copy of each piece and a
+ * format of each field, without parsing. Without a template file, PAYSLIP_DEFAULT_TEMPLATE is
+ * used.
+ *
+ * Fields (amounts are formatted with commas):
+ *     employee_id, name, department_id, salary_base, working_days, working_performance,
+ *     income_without_bonus, bonus, department_bonus, late_coming_days, late_coming_penalty,
+ *     gross, insurance, income_after_insurance, tax_bracket (1 to 3), tax_rate, tax,
+ *     department_raise, net
+ * Their values are the ones calculated by calculateSalaryForDepartment().
+ *
+ * The payslips are generated on the worker pool, in ranges of at most PAYSLIP_CHUNK employees.
+ * Each thread renders a payslip into its own buffer and writes the file with a single write.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef PAYSLIP_H
+#define PAYSLIP_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for Employee_t and SalaryBreakdown_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define PAYSLIP_MAX_TEMPLATE (64u * 1024u)  /* Largest template file */
+#define PAYSLIP_CHUNK 256                   /* Largest range of employees written without splitting it */
+#define PAYSLIP_FIELD_LENGTH 64             /* Most characters written for one field */
+
+/* Template used when no template file is given */
+#define PAYSLIP_DEFAULT_TEMPLATE \
+    "PAYSLIP\n" \
+    "==================================================\n" \
+    "Employee             : {employee_id} - {name}\n" \
+    "Department           : {department_id}\n" \
+    "--------------------------------------------------\n" \
+    "Base salary          : {salary_base} x {working_days} days x {working_performance}\n" \
+    "Income without bonus : {income_without_bonus}\n" \
+    "Bonus                : {bonus}\n" \
+    "Department bonus     : {department_bonus}\n" \
+    "Late penalty         : -{late_coming_penalty} ({late_coming_days} late days)\n" \
+    "Gross income         : {gross}\n" \
+    "Insurance (10.5%)    : -{insurance}\n" \
+    "Income after insur.  : {income_after_insurance}\n" \
+    "Tax                  : -{tax} (bracket {tax_bracket}, {tax_rate})\n" \
+    "Department raise     : {department_raise}\n" \
+    "--------------------------------------------------\n" \
+    "Net salary           : {net} (VND)\n"
+
+/**
+ * @brief Fields of a payslip.
+ */
+typedef enum PayslipField {
+    PAYSLIP_FIELD_EMPLOYEE_ID = 0,
+    PAYSLIP_FIELD_NAME,
+    PAYSLIP_FIELD_DEPARTMENT_ID,
+    PAYSLIP_FIELD_SALARY_BASE,
+    PAYSLIP_FIELD_WORKING_DAYS,
+    PAYSLIP_FIELD_WORKING_PERFORMANCE,
+    PAYSLIP_FIELD_INCOME_WITHOUT_BONUS,
+    PAYSLIP_FIELD_BONUS,
+    PAYSLIP_FIELD_DEPARTMENT_BONUS,
+    PAYSLIP_FIELD_LATE_COMING_DAYS,
+    PAYSLIP_FIELD_LATE_COMING_PENALTY,
+    PAYSLIP_FIELD_GROSS,
+    PAYSLIP_FIELD_INSURANCE,
+    PAYSLIP_FIELD_INCOME_AFTER_INSURANCE,
+    PAYSLIP_FIELD_TAX_BRACKET,
+    PAYSLIP_FIELD_TAX_RATE,
+    PAYSLIP_FIELD_TAX,
+    PAYSLIP_FIELD_DEPARTMENT_RAISE,
+    PAYSLIP_FIELD_NET,
+    PAYSLIP_FIELD_COUNT,                    /* Number of fields */
+    PAYSLIP_TEXT = PAYSLIP_FIELD_COUNT      /* A piece of text of the template, not a field */
+} PayslipField_t;
+
+/**
+ * @brief One piece of a compiled template.
+ */
+typedef struct PayslipPiece {
+    PayslipField_t field;                   /* Field to format, or PAYSLIP_TEXT */
+    uint32_t offset;                        /* Start of the text in PayslipTemplate_t.text */
+    uint32_t length;                        /* Length of the text */
+} PayslipPiece_t;
+
+/**
+ * @brief A compiled template.
+ */
+typedef struct PayslipTemplate {
+    int8_t *text;                           /* Text of the pieces, "{{" already replaced */
+    PayslipPiece_t *pieces;                 /* Pieces in order */
+    uint32_t piece_count;                   /* Number of pieces */
+    uint32_t max_length;                    /* Longest payslip the template can render */
+} PayslipTemplate_t;
+
+/**
+ * @brief Result of generatePayslips().
+ */
+typedef struct PayslipReport {
+    uint32_t written;                       /* Number of payslip files written */
+    uint32_t failed;                        /* Number of payslip files that could not be written */
+    uint64_t bytes;                         /* Number of bytes written */
+    uint32_t thread_count;                  /* Number of threads used */
+} PayslipReport_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Compiles a template.
+ *
+ * @param text The template, terminated by '\0'.
+ * @param compiled Receives the compiled template, to free with freePayslipTemplate().
+ * @param error_offset Receives the position of an unknown or unterminated field (may be NULL).
+ * @return MANAGE_OK, MANAGE_ERR_INVALID_ARGUMENT if a field is unknown or not closed, or
+ *         MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t compilePayslipTemplate(const char *text, PayslipTemplate_t *compiled, uint32_t *error_offset);
+
+/**
+ * @brief Reads a template file and compiles it.
+ *
+ * @return The result of compilePayslipTemplate(), or MANAGE_ERR_IO if the file cannot be read
+ *         or is larger than PAYSLIP_MAX_TEMPLATE.
+ */
+ManageStatus_t loadPayslipTemplate(const char *path, PayslipTemplate_t *compiled, uint32_t *error_offset);
+
+/**
+ * @brief Frees a compiled template.
+ */
+void freePayslipTemplate(PayslipTemplate_t *compiled);
+
+/**
+ * @brief Renders the payslip of one employee.
+ *
+ * @param compiled The template.
+ * @param employee The employee.
+ * @param salary The payroll of the employee, from calculateSalaryForDepartment().
+ * @param out Receives the payslip, at least compiled->max_length bytes; not terminated.
+ * @return Number of bytes written.
+ */
+uint32_t renderPayslip(const PayslipTemplate_t *compiled, const Employee_t *employee,
+                       const SalaryBreakdown_t *salary, int8_t *out);
+
+/**
+ * @brief Writes the payslip of every stored employee to a directory.
+ *
+ * The file of an employee is named after its ID, "<id>.txt"; upper-case letters are written in
+ * lower case and characters that cannot be used in a file name are replaced by '_', and the
+ * store position is then added to keep names unique on file systems that ignore case.
+ * The directory is created if needed. The store must not change meanwhile.
+ *
+ * @param compiled The template.
+ * @param directory The directory to write to.
+ * @param thread_count Number of threads, 0 to use one per processor.
+ * @param report Receives the counts.
+ * @return MANAGE_OK, MANAGE_ERR_IO if the directory cannot be created or a payslip cannot be
+ *         written (the others are still written), or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t generatePayslips(const PayslipTemplate_t *compiled, const char *directory, uint32_t thread_count,
+                                PayslipReport_t *report);
+
+/**
+ * @brief Prompts the user for a directory and a template file, and writes every payslip.
+ */
+void generatePayslipFiles();
+
+#endif /* PAYSLIP_H */
@@ -0,0 +1,509 @@
+/**
+ * @file perf_stats.c
+ * @brief This file contains the implementation of hot-path instrumentation.
+ *
+ * Every thread owns a block of counters that it gets the first time it records something and
+ * that stays linked into a global list. Only the owning thread writes its block, so recording
+ * needs no lock and no atomic read-modify-write; dumping walks the list and merges all blocks.
+ * When a thread exits its block is released with its counts, and the next new thread takes it
+ * over and adds to them, so the list only grows to the largest number of threads recording at
+ * the same time and no count is lost.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdlib.h>             /* Include standard library for calloc, getenv, atexit */
+#include <string.h>             /* Include string manipulation library for memset, strcmp */
+#include <pthread.h>            /* Include POSIX threads library for releasing a block when its thread exits */
+#include "perf_stats.h"         /* Include header file */
+#include "input_handler.h"      /* Include input handler header file for the menu choice */
+
+#ifdef _WIN32
+#include <windows.h>            /* QueryPerformanceCounter() */
+#else
+#include <time.h>               /* clock_gettime() */
+#endif
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define PERF_SUB_BUCKET_BITS 4                                  /* log2 of sub-buckets per power of two */
+#define PERF_SUB_BUCKETS (1u << PERF_SUB_BUCKET_BITS)           /* Sub-buckets per power of two */
+#define PERF_BUCKETS ((64 - PERF_SUB_BUCKET_BITS + 1) * PERF_SUB_BUCKETS)  /* Buckets covering all uint64_t values */
+
+/* Relaxed load and store: readers on other threads see whole values without locking the writer */
+#define PERF_LOAD(field)         __atomic_load_n(&(field), __ATOMIC_RELAXED)
+#define PERF_STORE(field, value) __atomic_store_n(&(field), (value), __ATOMIC_RELAXED)
+
+/**
+ * @brief Counters of one operation.
+ */
+typedef struct PerfCounter {
+    uint64_t calls;                         /* Number of recorded calls */
+    uint64_t total_ns;                      /* Sum of all latencies */
+    uint64_t min_ns;                        /* Smallest latency, valid when calls > 0 */
+    uint64_t max_ns;                        /* Largest latency */
+    uint64_t buckets[PERF_BUCKETS];         /* Latency histogram */
+} PerfCounter_t;
+
+/**
+ * @brief Counters owned by one thread.
+ */
+typedef struct PerfThreadStats {
+    PerfCounter_t counters[PERF_OP_COUNT];  /* One counter per operation */
+    struct PerfThreadStats *next;           /* Next block in the global list */
+    uint32_t in_use;                        /* 1 while a thread records into the block, 0 once it exited */
+} PerfThreadStats_t;
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static uint64_t nowNanoseconds();
+static uint32_t bucketIndex(uint64_t value);
+static uint64_t bucketLowerBound(uint32_t index);
+static PerfThreadStats_t* threadStats();
+static void createThreadKey();
+static void releaseThreadStats(void *block);
+static void dumpAtExit();
+
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t perf_enabled = 0;                       /* Run time switch */
+static PerfThreadStats_t *perf_all_threads = NULL;      /* List of every thread's counters */
+static __thread PerfThreadStats_t *perf_this_thread = NULL;  /* Counters of the calling thread */
+static pthread_key_t perf_thread_key;                   /* Releases the block of a thread when it exits */
+static pthread_once_t perf_thread_key_once = PTHREAD_ONCE_INIT;  /* Creates perf_thread_key once */
+static uint32_t perf_thread_key_ready = 0;              /* Flag set if perf_thread_key was created */
+static const char *const perf_operation_names[PERF_OP_COUNT] = {
+    "calculate_salary",
+    "sort_employees",
+    "format_number",
+    "delete_employee",
+    "delete_department",
+    "add_employees_batch",
+    "delete_employees_batch",
+    "delete_departments_batch",
+    "import_csv",
+    "parse_import_chunk",
+    "ensure_departments",
+    "simulate_payroll",
+    "load_snapshot",
+    "import_attendance",
+    "org_layout",
+    "diff_payroll",
+    "publish_shared",
+    "apply_mutations",
+    "generate_payslips",
+    "build_name_index",
+    "search_names",
+    "update_employees_batch",
+    "change_feed_commit",
+    "tenant_payroll"
+};
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Initializes instrumentation from the environment.
+ *
+ * If the MANAGE_PERF_STATS environment variable is set to a value other than "0",
+ * instrumentation is switched on and the statistics are dumped when the program exits.
+ */
+void perfStatsInit()
+{
+    const char *setting = getenv("MANAGE_PERF_STATS");     /* Value of the environment variable */
+
+    if (setting != NULL && strcmp(setting, "0") != 0 && PERF_STATS_ENABLED)
+    {
+        perfStatsSetEnabled(1);
+        atexit(dumpAtExit);
+    }
+}
+
+
+/**
+ * @brief Switches recording on (1) or off (0) at run time.
+ */
+void perfStatsSetEnabled(uint32_t enabled)
+{
+    PERF_STORE(perf_enabled, (enabled != 0) ? 1u : 0u);
+}
+
+
+/**
+ * @brief Returns 1 if recording is switched on, 0 otherwise.
+ */
+uint32_t perfStatsIsEnabled()
+{
+    return PERF_LOAD(perf_enabled);
+}
+
+
+/**
+ * @brief Returns the start time of a measured operation, or 0 if recording is switched off.
+ */
+uint64_t perfStatsBegin()
+{
+    if (PERF_LOAD(perf_enabled) == 0)
+    {
+        return 0;
+    }
+    return nowNanoseconds();
+}
+
+
+/**
+ * @brief Records one call of an operation into the calling thread's counters.
+ *
+ * @param operation The measured operation.
+ * @param start_ns Value returned by perfStatsBegin(); nothing is recorded if it is 0.
+ */
+void perfStatsEnd(PerfOperation_t operation, uint64_t start_ns)
+{
+    PerfThreadStats_t *stats = NULL;        /* Counters of the calling thread */
+    PerfCounter_t *counter = NULL;          /* Counter of the operation */
+    uint64_t elapsed = 0;                   /* Latency of this call */
+    uint32_t index = 0;                     /* Histogram bucket of the latency */
+
+    if (start_ns == 0 || (uint32_t)operation >= PERF_OP_COUNT)
+    {
+        return;
+    }
+    elapsed = nowNanoseconds() - start_ns;
+    stats = threadStats();
+    if (stats == NULL)
+    {
+        return;
+    }
+
+    counter = &stats->counters[operation];
+    index = bucketIndex(elapsed);
+    if (PERF_LOAD(counter->calls) == 0 || elapsed < PERF_LOAD(counter->min_ns))
+    {
+        PERF_STORE(counter->min_ns, elapsed);
+    }
+    if (elapsed > PERF_LOAD(counter->max_ns))
+    {
+        PERF_STORE(counter->max_ns, elapsed);
+    }
+    PERF_STORE(counter->total_ns, PERF_LOAD(counter->total_ns) + elapsed);
+    PERF_STORE(counter->buckets[index], PERF_LOAD(counter->buckets[index]) + 1);
+    PERF_STORE(counter->calls, PERF_LOAD(counter->calls) + 1);
+}
+
+
+/**
+ * @brief Clears the counters of all threads.
+ *
+ * Calls recorded by other threads while the counters are being cleared may be partly lost.
+ */
+void perfStatsReset()
+{
+    PerfThreadStats_t *stats = NULL;        /* Block being cleared */
+    uint32_t op = 0;                        /* Index for looping through operations */
+    uint32_t i = 0;                         /* Index for looping through buckets */
+
+    for (stats = __atomic_load_n(&perf_all_threads, __ATOMIC_ACQUIRE); stats != NULL; stats = stats->next)
+    {
+        for (op = 0; op < PERF_OP_COUNT; op++)
+        {
+            PERF_STORE(stats->counters[op].calls, 0);
+            PERF_STORE(stats->counters[op].total_ns, 0);
+            PERF_STORE(stats->counters[op].min_ns, 0);
+            PERF_STORE(stats->counters[op].max_ns, 0);
+            for (i = 0; i < PERF_BUCKETS; i++)
+            {
+                PERF_STORE(stats->counters[op].buckets[i], 0);
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Writes the statistics of all threads, merged per operation.
+ *
+ * @param output The stream to write to.
+ */
+void perfStatsDump(FILE *output)
+{
+    static PerfCounter_t merged;            /* Counters of one operation merged over all threads */
+    static const uint32_t percentiles[4] = {500, 900, 990, 999};      /* Percentiles in per mille */
+    static const char *const percentile_names[4] = {"p50_ns", "p90_ns", "p99_ns", "p999_ns"};
+    PerfThreadStats_t *stats = NULL;        /* Block being merged */
+    uint64_t seen = 0;                      /* Calls counted while walking the histogram */
+    uint64_t total_in_histogram = 0;        /* Calls counted in the merged histogram */
+    uint64_t value = 0;                     /* Value read from a block */
+    uint32_t next_percentile = 0;           /* Next percentile to print */
+    uint32_t first_bucket = 1;              /* Flag to print separators in the histogram */
+    uint32_t op = 0;                        /* Index for looping through operations */
+    uint32_t i = 0;                         /* Index for looping through buckets */
+
+    for (op = 0; op < PERF_OP_COUNT; op++)
+    {
+        memset(&merged, 0, sizeof(merged));
+        for (stats = __atomic_load_n(&perf_all_threads, __ATOMIC_ACQUIRE); stats != NULL; stats = stats->next)
+        {
+            value = PERF_LOAD(stats->counters[op].calls);
+            if (value > 0)
+            {
+                if (merged.calls == 0 || PERF_LOAD(stats->counters[op].min_ns) < merged.min_ns)
+                {
+                    merged.min_ns = PERF_LOAD(stats->counters[op].min_ns);
+                }
+                if (PERF_LOAD(stats->counters[op].max_ns) > merged.max_ns)
+                {
+                    merged.max_ns = PERF_LOAD(stats->counters[op].max_ns);
+                }
+                merged.calls += value;
+                merged.total_ns += PERF_LOAD(stats->counters[op].total_ns);
+                for (i = 0; i < PERF_BUCKETS; i++)
+                {
+                    merged.buckets[i] += PERF_LOAD(stats->counters[op].buckets[i]);
+                }
+            }
+        }
+        if (merged.calls == 0)
+        {
+            continue;
+        }
+
+        /* The histogram may hold a few more or fewer calls than 'calls' if other threads are recording */
+        for (seen = 0, i = 0; i < PERF_BUCKETS; i++)
+        {
+            seen += merged.buckets[i];
+        }
+        fprintf(output, "perf op=%s calls=%llu total_ns=%llu mean_ns=%llu min_ns=%llu",
+                perf_operation_names[op], (unsigned long long)merged.calls,
+                (unsigned long long)merged.total_ns, (unsigned long long)(merged.total_ns / merged.calls),
+                (unsigned long long)merged.min_ns);
+
+        /* Walk the histogram once and print each percentile when its rank is reached */
+        total_in_histogram = seen;
+        next_percentile = 0;
+        for (seen = 0, i = 0; i < PERF_BUCKETS && next_percentile < 4; i++)
+        {
+            seen += merged.buckets[i];
+            while (next_percentile < 4
+                   && seen >= (total_in_histogram * percentiles[next_percentile] + 999) / 1000)
+            {
+                fprintf(output, " %s=%llu", percentile_names[next_percentile],
+                        (unsigned long long)bucketLowerBound(i));
+                next_percentile++;
+            }
+        }
+        fprintf(output, " max_ns=%llu hist=", (unsigned long long)merged.max_ns);
+
+        first_bucket = 1;
+        for (i = 0; i < PERF_BUCKETS; i++)
+        {
+            if (merged.buckets[i] > 0)
+            {
+                fprintf(output, "%s%llu:%llu", (first_bucket == 1) ? "" : ",",
+                        (unsigned long long)bucketLowerBound(i), (unsigned long long)merged.buckets[i]);
+                first_bucket = 0;
+            }
+        }
+        fprintf(output, "\n");
+    }
+    fflush(output);
+}
+
+
+/**
+ * @brief Returns a monotonic time stamp in nanoseconds (never 0).
+ */
+static uint64_t nowNanoseconds()
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;         /* Ticks per second of the performance counter */
+    LARGE_INTEGER ticks;                    /* Current tick count */
+
+    if (frequency.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&ticks);
+    return (uint64_t)((double)ticks.QuadPart * 1e9 / (double)frequency.QuadPart) | 1u;
+#else
+    struct timespec now;                    /* Current time */
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec) | 1u;
+#endif
+}
+
+
+/**
+ * @brief Returns the histogram bucket of a value.
+ *
+ * Values below 16 have a bucket each. Above that, every power of two is split
+ * into 16 equal sub-buckets.
+ */
+static uint32_t bucketIndex(uint64_t value)
+{
+    uint32_t magnitude = 0;                 /* Position of the highest set bit */
+
+    if (value < PERF_SUB_BUCKETS)
+    {
+        return (uint32_t)value;
+    }
+    magnitude = 63u - (uint32_t)__builtin_clzll(value);
+    return (magnitude - PERF_SUB_BUCKET_BITS + 1) * PERF_SUB_BUCKETS
+           + (uint32_t)((value >> (magnitude - PERF_SUB_BUCKET_BITS)) & (PERF_SUB_BUCKETS - 1));
+}
+
+
+/**
+ * @brief Returns the smallest value that falls into a histogram bucket.
+ */
+static uint64_t bucketLowerBound(uint32_t index)
+{
+    uint32_t magnitude = 0;                 /* Position of the highest set bit of the bucket's values */
+
+    if (index < PERF_SUB_BUCKETS)
+    {
+        return index;
+    }
+    magnitude = index / PERF_SUB_BUCKETS + PERF_SUB_BUCKET_BITS - 1;
+    return (uint64_t)(PERF_SUB_BUCKETS + index % PERF_SUB_BUCKETS) << (magnitude - PERF_SUB_BUCKET_BITS);
+}
+
+
+/**
+ * @brief Returns the counters of the calling thread, taking a released block or allocating one on first use.
+ *
+ * @return The thread's counters, or NULL if memory could not be allocated.
+ */
+static PerfThreadStats_t* threadStats()
+{
+    PerfThreadStats_t *stats = perf_this_thread;    /* Counters of the calling thread */
+    uint32_t expected = 0;                  /* in_use of a block that can be taken */
+
+    if (stats != NULL)
+    {
+        return stats;
+    }
+    pthread_once(&perf_thread_key_once, createThreadKey);
+
+    /* Take over the block of a thread that exited, its counts stay in the merged statistics */
+    for (stats = __atomic_load_n(&perf_all_threads, __ATOMIC_ACQUIRE); stats != NULL; stats = stats->next)
+    {
+        expected = 0;
+        if (__atomic_compare_exchange_n(&stats->in_use, &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            break;
+        }
+    }
+    if (stats == NULL)
+    {
+        stats = calloc(1, sizeof(*stats));
+        if (stats == NULL)
+        {
+            return NULL;
+        }
+        stats->in_use = 1;
+        /* Lock-free push onto the global list; blocks are never freed, only released */
+        stats->next = __atomic_load_n(&perf_all_threads, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&perf_all_threads, &stats->next, stats, 1,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+            /* stats->next was refreshed by the failed exchange, try again */
+        }
+    }
+    if (perf_thread_key_ready != 0)
+    {
+        pthread_setspecific(perf_thread_key, stats);
+    }
+    perf_this_thread = stats;
+    return stats;
+}
+
+
+/**
+ * @brief Creates the key whose destructor releases the block of an exiting thread.
+ *
+ * If it cannot be created, blocks are kept by their threads as if they never exited.
+ */
+static void createThreadKey()
+{
+    perf_thread_key_ready = (pthread_key_create(&perf_thread_key, releaseThreadStats) == 0) ? 1u : 0u;
+}
+
+
+/**
+ * @brief Releases the block of an exiting thread so that another thread can take it over.
+ */
+static void releaseThreadStats(void *block)
+{
+    __atomic_store_n(&((PerfThreadStats_t *)block)->in_use, 0, __ATOMIC_RELEASE);
+}
+
+
+/**
+ * @brief Shows whether recording is on and lets the user show, clear or switch the statistics.
+ */
+void managePerfStats()
+{
+    int8_t choice = 0;                      /* Action chosen by the user */
+
+    if (!PERF_STATS_ENABLED)
+    {
+        printf("Instrumentation is compiled out (PERF_STATS_ENABLED is 0).\n");
+        return;
+    }
+    printf("Recording is %s.\n", (perfStatsIsEnabled() == 1) ? "on" : "off");
+    printf("Enter 's' to show the statistics, 'r' to clear them, 't' to switch recording %s,\n"
+           "or any other key to go back: ",
+           (perfStatsIsEnabled() == 1) ? "off" : "on");
+    choice = getSingleCharInput();
+    if (choice == 's')
+    {
+        printf("\n");
+        perfStatsDump(stdout);
+    }
+    else if (choice == 'r')
+    {
+        perfStatsReset();
+        printf("Cleared the statistics of all threads.\n");
+    }
+    else if (choice == 't')
+    {
+        perfStatsSetEnabled(perfStatsIsEnabled() == 0);
+        printf("Recording is %s.\n", (perfStatsIsEnabled() == 1) ? "on" : "off");
+    }
+    else
+    {
+        /* Do nothing */
+    }
+}
+
+
+/**
+ * @brief Writes the statistics when the program exits.
+ */
+static void dumpAtExit()
+{
+    const char *path = getenv("MANAGE_PERF_STATS_FILE");   /* File to write, stderr if not set */
+    FILE *output = NULL;                    /* Stream to write to */
+
+    if (path != NULL && path[0] != '\0')
+    {
+        output = fopen(path, "w");
+    }
+    if (output != NULL)
+    {
+        perfStatsDump(output);
+        fclose(output);
+    }
+    else
+    {
+        perfStatsDump(stderr);
+    }
+} /* EOF */
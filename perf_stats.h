@@ -0,0 +1,139 @@
+/**
+ * @file perf_stats.h
+ * @brief This file contains the function prototypes and macros for hot-path instrumentation.
+ *
+ * This file contains the function prototypes and macros to count calls and measure the
+ * latency of the hot operations of the program (salary calculation, sorting, number
+ * formatting, deletions, ...). Every thread records into its own counters so recording never
+ * takes a lock. Latencies are kept in log-linear (HDR-style) histograms with 16 sub-buckets
+ * per power of two, which keeps the relative error of percentiles below 6.25%.
+ *
+ * Instrumentation can be removed at compile time by defining PERF_STATS_ENABLED to 0, and is
+ * switched on at run time with perfStatsSetEnabled(), from the menu (see managePerfStats())
+ * or with the MANAGE_PERF_STATS environment variable (see perfStatsInit()). When it is compiled in but switched off, each measured
+ * operation costs one branch on a global flag.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdio.h>           /* Include standard input and output library for FILE */
+#include <stdint.h>          /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#ifndef PERF_STATS_ENABLED
+#define PERF_STATS_ENABLED 1            /* Set to 0 to compile all instrumentation out */
+#endif
+
+/**
+ * @brief Operations that are measured.
+ */
+typedef enum PerfOperation {
+    PERF_OP_CALCULATE_SALARY = 0,       /* calculateSalary() */
+    PERF_OP_SORT_EMPLOYEES,             /* Sorting in showEmployees() */
+    PERF_OP_FORMAT_NUMBER,              /* formatNumberWithCommas() */
+    PERF_OP_DELETE_EMPLOYEE,            /* Search and shift in deleteEmployee() */
+    PERF_OP_DELETE_DEPARTMENT,          /* Search and shift in deleteDepartment() */
+    PERF_OP_ADD_EMPLOYEES_BATCH,        /* addEmployeesBatch() */
+    PERF_OP_DELETE_EMPLOYEES_BATCH,     /* deleteEmployeesBatch() */
+    PERF_OP_DELETE_DEPARTMENTS_BATCH,   /* deleteDepartmentsBatch() */
+    PERF_OP_IMPORT_CSV,                 /* importEmployeesCsv() */
+    PERF_OP_PARSE_IMPORT_CHUNK,         /* Parsing one chunk of a CSV import */
+    PERF_OP_ENSURE_DEPARTMENTS,         /* ensureDepartments() */
+    PERF_OP_SIMULATE_PAYROLL,           /* simulatePayroll() */
+    PERF_OP_LOAD_SNAPSHOT,              /* loadStoreSnapshot() */
+    PERF_OP_IMPORT_ATTENDANCE,          /* importAttendanceLog() */
+    PERF_OP_ORG_LAYOUT,                 /* Laying out the organization hierarchy again */
+    PERF_OP_DIFF_PAYROLL,               /* diffPayrollExports() */
+    PERF_OP_PUBLISH_SHARED,             /* sharedTablePublishStore() */
+    PERF_OP_APPLY_MUTATIONS,            /* A batch of the mutation queue */
+    PERF_OP_GENERATE_PAYSLIPS,          /* generatePayslips() */
+    PERF_OP_BUILD_NAME_INDEX,           /* nameIndexBuild() */
+    PERF_OP_SEARCH_NAMES,               /* nameIndexSearch() */
+    PERF_OP_UPDATE_EMPLOYEES_BATCH,     /* updateEmployeesBatch() */
+    PERF_OP_CHANGE_FEED_COMMIT,         /* changeFeedCommit() */
+    PERF_OP_TENANT_PAYROLL,             /* runTenantPayrolls() */
+    PERF_OP_COUNT                       /* Number of operations, must stay last */
+} PerfOperation_t;
+
+#if PERF_STATS_ENABLED
+/* Declares a variable holding the start time of a measured operation */
+#define PERF_START(start_var)           uint64_t start_var = perfStatsBegin()
+/* Records the time elapsed since PERF_START() for the given operation */
+#define PERF_STOP(operation, start_var) perfStatsEnd((operation), (start_var))
+#else
+#define PERF_START(start_var)
+#define PERF_STOP(operation, start_var) ((void)0)
+#endif
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Initializes instrumentation from the environment.
+ *
+ * If the MANAGE_PERF_STATS environment variable is set to a value other than "0",
+ * instrumentation is switched on and the statistics are dumped when the program exits:
+ * to the file named by MANAGE_PERF_STATS_FILE if it is set, otherwise to stderr.
+ */
+void perfStatsInit();
+
+/**
+ * @brief Switches recording on (1) or off (0) at run time.
+ */
+void perfStatsSetEnabled(uint32_t enabled);
+
+/**
+ * @brief Returns 1 if recording is switched on, 0 otherwise.
+ */
+uint32_t perfStatsIsEnabled();
+
+/**
+ * @brief Returns the start time of a measured operation.
+ *
+ * @return Current monotonic time in nanoseconds, or 0 if recording is switched off.
+ */
+uint64_t perfStatsBegin();
+
+/**
+ * @brief Records one call of an operation into the calling thread's counters.
+ *
+ * @param operation The measured operation.
+ * @param start_ns Value returned by perfStatsBegin(); nothing is recorded if it is 0.
+ */
+void perfStatsEnd(PerfOperation_t operation, uint64_t start_ns);
+
+/**
+ * @brief Clears the counters of all threads.
+ */
+void perfStatsReset();
+
+/**
+ * @brief Writes the statistics of all threads, merged per operation.
+ *
+ * One line is written per operation that was called at least once, as space separated
+ * key=value pairs:
+ *
+ *     perf op=<name> calls=<n> total_ns=<n> mean_ns=<n> min_ns=<n> p50_ns=<n> p90_ns=<n>
+ *          p99_ns=<n> p999_ns=<n> max_ns=<n> hist=<bucket_low_ns>:<count>,...
+ *
+ * Percentiles are the lower bound of the histogram bucket that holds them.
+ *
+ * @param output The stream to write to.
+ */
+void perfStatsDump(FILE *output);
+
+/**
+ * @brief Shows whether recording is on and lets the user show, clear or switch the statistics.
+ */
+void managePerfStats();
+
+#endif /* PERF_STATS_H */
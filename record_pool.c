@@ -0,0 +1,309 @@
+/**
+ * @file record_pool.c
+ * @brief This file contains the implementation of the pool allocator for fixed-size records.
+ *
+ * The free list is stored inside the released records: the first 4 bytes of a released
+ * record hold the handle of the next released record.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdlib.h>             /* Include standard library for malloc, calloc, realloc, free */
+#include <string.h>             /* Include string manipulation library for memcpy, memset */
+#include "record_pool.h"        /* Include header file */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define RECORD_POOL_SLAB_MASK (RECORD_POOL_SLAB_RECORDS - 1u)      /* Position of a record in its slab */
+#define RECORD_POOL_LIVE_WORDS (RECORD_POOL_SLAB_RECORDS / 64u)     /* Words of the live bitmap per slab */
+#define RECORD_POOL_MAX_SLABS (RECORD_POOL_INVALID_HANDLE >> RECORD_POOL_SLAB_SHIFT)   /* Keeps handles below the invalid one */
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static uint32_t addSlab(RecordPool_t *pool);
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Initializes an empty pool.
+ */
+void recordPoolInit(RecordPool_t *pool, uint32_t record_size)
+{
+    memset(pool, 0, sizeof(*pool));
+    pool->record_size = (record_size < sizeof(uint32_t)) ? (uint32_t)sizeof(uint32_t) : record_size;
+    pool->free_head = RECORD_POOL_INVALID_HANDLE;
+}
+
+
+/**
+ * @brief Frees every slab of a pool. All handles become invalid.
+ */
+void recordPoolFree(RecordPool_t *pool)
+{
+    uint32_t i = 0;                         /* Index for looping through slabs */
+
+    for (i = pool->external_slabs; i < pool->slab_count; i++)
+    {
+        free(pool->slabs[i]);
+    }
+    free(pool->slabs);
+    free(pool->live);
+    recordPoolInit(pool, pool->record_size);
+}
+
+
+/**
+ * @brief Makes an empty pool use records that are already in memory, without copying them.
+ *
+ * @return 1 on success, 0 if the pool is not empty or memory could not be allocated.
+ */
+uint32_t recordPoolAdopt(RecordPool_t *pool, uint8_t *records, uint32_t record_count)
+{
+    uint32_t slab_count = (record_count + RECORD_POOL_SLAB_MASK) >> RECORD_POOL_SLAB_SHIFT;    /* Slabs covering the records */
+    uint32_t i = 0;                         /* Index for looping through slabs and bitmap words */
+
+    if (pool->slab_count != 0 || pool->next_unused != 0)
+    {
+        return 0;
+    }
+    if (slab_count == 0)
+    {
+        return 1;
+    }
+    pool->slabs = malloc((size_t)slab_count * sizeof(*pool->slabs));
+    pool->live = calloc((size_t)slab_count * RECORD_POOL_LIVE_WORDS, sizeof(*pool->live));
+    if (pool->slabs == NULL || pool->live == NULL)
+    {
+        free(pool->slabs);
+        free(pool->live);
+        pool->slabs = NULL;
+        pool->live = NULL;
+        return 0;
+    }
+    for (i = 0; i < slab_count; i++)
+    {
+        pool->slabs[i] = records + (size_t)i * RECORD_POOL_SLAB_RECORDS * pool->record_size;
+    }
+    /* Whole bitmap words first, then the bits of the last partial word */
+    for (i = 0; i < record_count / 64; i++)
+    {
+        pool->live[i] = ~(uint64_t)0;
+    }
+    if (record_count % 64 != 0)
+    {
+        pool->live[i] = ((uint64_t)1 << (record_count % 64)) - 1;
+    }
+    pool->slab_count = slab_count;
+    pool->slab_capacity = slab_count;
+    pool->external_slabs = slab_count;
+    pool->next_unused = record_count;
+    pool->live_count = record_count;
+    return 1;
+}
+
+
+/**
+ * @brief Copies the slabs given to recordPoolAdopt() into memory owned by the pool.
+ *
+ * Every copy is allocated before any slab pointer changes, so a failure leaves the pool as it was.
+ *
+ * @return 1 on success, 0 if memory could not be allocated (the pool is unchanged).
+ */
+uint32_t recordPoolDetach(RecordPool_t *pool)
+{
+    uint8_t **copies = NULL;                /* Owned copies of the adopted slabs */
+    size_t slab_bytes = (size_t)RECORD_POOL_SLAB_RECORDS * pool->record_size;    /* Size of one slab */
+    uint32_t i = 0;                         /* Index for looping through slabs */
+
+    if (pool->external_slabs == 0)
+    {
+        return 1;
+    }
+    copies = calloc(pool->external_slabs, sizeof(*copies));
+    if (copies == NULL)
+    {
+        return 0;
+    }
+    for (i = 0; i < pool->external_slabs; i++)
+    {
+        copies[i] = malloc(slab_bytes);
+        if (copies[i] == NULL)
+        {
+            while (i > 0)
+            {
+                i -= 1;
+                free(copies[i]);
+            }
+            free(copies);
+            return 0;
+        }
+    }
+    for (i = 0; i < pool->external_slabs; i++)
+    {
+        memcpy(copies[i], pool->slabs[i], slab_bytes);
+        pool->slabs[i] = copies[i];
+    }
+    free(copies);
+    pool->external_slabs = 0;
+    return 1;
+}
+
+
+/**
+ * @brief Makes sure the given number of records can be allocated without failing.
+ *
+ * @return 1 on success, 0 if memory could not be allocated.
+ */
+uint32_t recordPoolReserve(RecordPool_t *pool, uint32_t count)
+{
+    uint64_t available = 0;                 /* Records that can be allocated without a new slab */
+
+    for (;;)
+    {
+        available = (uint64_t)pool->free_count
+                    + (uint64_t)pool->slab_count * RECORD_POOL_SLAB_RECORDS - pool->next_unused;
+        if (available >= count)
+        {
+            return 1;
+        }
+        if (addSlab(pool) == 0)
+        {
+            return 0;
+        }
+    }
+}
+
+
+/**
+ * @brief Allocates a record. Its content is not initialized.
+ *
+ * @return The handle of the record, or RECORD_POOL_INVALID_HANDLE if memory could not be allocated.
+ */
+RecordHandle_t recordPoolAlloc(RecordPool_t *pool)
+{
+    RecordHandle_t handle = RECORD_POOL_INVALID_HANDLE;    /* Allocated record */
+
+    if (pool->free_head != RECORD_POOL_INVALID_HANDLE)
+    {
+        /* Reuse the last released record */
+        handle = pool->free_head;
+        memcpy(&pool->free_head, pool->slabs[handle >> RECORD_POOL_SLAB_SHIFT]
+               + (size_t)(handle & RECORD_POOL_SLAB_MASK) * pool->record_size, sizeof(pool->free_head));
+        pool->free_count -= 1;
+    }
+    else
+    {
+        if (pool->next_unused == pool->slab_count * RECORD_POOL_SLAB_RECORDS && addSlab(pool) == 0)
+        {
+            return RECORD_POOL_INVALID_HANDLE;
+        }
+        handle = pool->next_unused;
+        pool->next_unused += 1;
+    }
+    pool->live[handle / 64] |= (uint64_t)1 << (handle % 64);
+    pool->live_count += 1;
+    return handle;
+}
+
+
+/**
+ * @brief Releases a record. Releasing an invalid or already released handle does nothing.
+ */
+void recordPoolRelease(RecordPool_t *pool, RecordHandle_t handle)
+{
+    uint8_t *record = recordPoolGet(pool, handle);     /* Record to release */
+
+    if (record == NULL)
+    {
+        return;
+    }
+    pool->live[handle / 64] &= ~((uint64_t)1 << (handle % 64));
+    memcpy(record, &pool->free_head, sizeof(pool->free_head));
+    pool->free_head = handle;
+    pool->free_count += 1;
+    pool->live_count -= 1;
+}
+
+
+/**
+ * @brief Returns the record named by a handle.
+ *
+ * @return Pointer to the record, or NULL if the handle does not name an allocated record.
+ */
+void* recordPoolGet(const RecordPool_t *pool, RecordHandle_t handle)
+{
+    if (handle >= pool->next_unused || (pool->live[handle / 64] & ((uint64_t)1 << (handle % 64))) == 0)
+    {
+        return NULL;
+    }
+    return pool->slabs[handle >> RECORD_POOL_SLAB_SHIFT] + (size_t)(handle & RECORD_POOL_SLAB_MASK) * pool->record_size;
+}
+
+
+/**
+ * @brief Reports the memory used by a pool.
+ */
+void recordPoolUsage(const RecordPool_t *pool, RecordPoolUsage_t *usage)
+{
+    usage->live_records = pool->live_count;
+    usage->free_records = pool->free_count;
+    usage->unused_records = pool->slab_count * RECORD_POOL_SLAB_RECORDS - pool->next_unused;
+    usage->slab_count = pool->slab_count;
+    usage->live_bytes = (uint64_t)pool->live_count * pool->record_size;
+    usage->reserved_bytes = (uint64_t)pool->slab_count * RECORD_POOL_SLAB_RECORDS * pool->record_size
+                            + (uint64_t)pool->slab_capacity * (sizeof(*pool->slabs) + RECORD_POOL_LIVE_WORDS * sizeof(*pool->live));
+    usage->adopted_bytes = (uint64_t)pool->external_slabs * RECORD_POOL_SLAB_RECORDS * pool->record_size;
+}
+
+
+/**
+ * @brief Adds one slab to a pool.
+ *
+ * @return 1 on success, 0 if memory could not be allocated or the pool is full.
+ */
+static uint32_t addSlab(RecordPool_t *pool)
+{
+    uint8_t **slabs = NULL;                 /* Reallocated slab table */
+    uint64_t *live = NULL;                  /* Reallocated live bitmap */
+    uint32_t new_capacity = 0;              /* Grown size of the slab table */
+
+    if (pool->slab_count >= RECORD_POOL_MAX_SLABS)
+    {
+        return 0;
+    }
+    if (pool->slab_count == pool->slab_capacity)
+    {
+        new_capacity = (pool->slab_capacity == 0) ? 4 : pool->slab_capacity * 2;
+        if (new_capacity > RECORD_POOL_MAX_SLABS)
+        {
+            new_capacity = RECORD_POOL_MAX_SLABS;
+        }
+        slabs = realloc(pool->slabs, (size_t)new_capacity * sizeof(*slabs));
+        if (slabs == NULL)
+        {
+            return 0;
+        }
+        pool->slabs = slabs;
+        live = realloc(pool->live, (size_t)new_capacity * RECORD_POOL_LIVE_WORDS * sizeof(*live));
+        if (live == NULL)
+        {
+            return 0;
+        }
+        pool->live = live;
+        pool->slab_capacity = new_capacity;
+    }
+    pool->slabs[pool->slab_count] = malloc((size_t)RECORD_POOL_SLAB_RECORDS * pool->record_size);
+    if (pool->slabs[pool->slab_count] == NULL)
+    {
+        return 0;
+    }
+    memset(&pool->live[(size_t)pool->slab_count * RECORD_POOL_LIVE_WORDS], 0, RECORD_POOL_LIVE_WORDS * sizeof(*pool->live));
+    pool->slab_count += 1;
+    return 1;
+} /* EOF */
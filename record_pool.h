@@ -0,0 +1,139 @@
+/**
+ * @file record_pool.h
+ * @brief This file contains the function prototypes of a pool allocator for fixed-size records.
+ *
+ * Records are carved out of slabs of RECORD_POOL_SLAB_RECORDS records each, so records are
+ * contiguous in memory and adding or deleting records never fragments the heap. A record is
+ * named by a 32-bit handle that stays valid (and keeps pointing at the same memory) until the
+ * record is released. Released records are kept in a free list and reused first, so
+ * allocation and release take constant time. Slabs are never returned to the system before
+ * recordPoolFree().
+ *
+ * A pool can also start from records that are already in memory, e.g. a mapped snapshot file
+ * (see recordPoolAdopt()); those slabs stay owned by the caller until recordPoolDetach().
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef RECORD_POOL_H
+#define RECORD_POOL_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define RECORD_POOL_SLAB_SHIFT 10                           /* log2 of the number of records per slab */
+#define RECORD_POOL_SLAB_RECORDS (1u << RECORD_POOL_SLAB_SHIFT) /* Number of records per slab */
+#define RECORD_POOL_INVALID_HANDLE 0xFFFFFFFFu              /* Handle that never names a record */
+
+/**
+ * @brief Handle of a record: slab number in the high bits, position in the slab in the low bits.
+ */
+typedef uint32_t RecordHandle_t;
+
+/**
+ * @brief Pool of records of one size.
+ */
+typedef struct RecordPool {
+    uint8_t **slabs;                        /* Slabs of RECORD_POOL_SLAB_RECORDS records */
+    uint64_t *live;                         /* One bit per record, set while the record is allocated */
+    uint32_t slab_count;                    /* Number of slabs */
+    uint32_t slab_capacity;                 /* Number of entries allocated in slabs */
+    uint32_t record_size;                   /* Size of one record in bytes, at least 4 */
+    uint32_t free_head;                     /* First released record, RECORD_POOL_INVALID_HANDLE if none */
+    uint32_t free_count;                    /* Number of released records */
+    uint32_t next_unused;                   /* First record that was never allocated */
+    uint32_t live_count;                    /* Number of allocated records */
+    uint32_t external_slabs;                /* Number of first slabs owned by the caller, see recordPoolAdopt() */
+} RecordPool_t;
+
+/**
+ * @brief Memory used by a pool.
+ */
+typedef struct RecordPoolUsage {
+    uint32_t live_records;                  /* Records currently allocated */
+    uint32_t free_records;                  /* Released records waiting for reuse */
+    uint32_t unused_records;                /* Records of the last slabs never allocated */
+    uint32_t slab_count;                    /* Number of slabs */
+    uint64_t live_bytes;                    /* Bytes of the allocated records */
+    uint64_t reserved_bytes;                /* Bytes of all slabs and bookkeeping */
+    uint64_t adopted_bytes;                 /* Bytes of the slabs given to recordPoolAdopt(), part of reserved_bytes */
+} RecordPoolUsage_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Initializes an empty pool.
+ *
+ * @param pool The pool to initialize.
+ * @param record_size Size of one record in bytes; sizes below 4 are rounded up to 4.
+ */
+void recordPoolInit(RecordPool_t *pool, uint32_t record_size);
+
+/**
+ * @brief Frees every slab of a pool. All handles become invalid.
+ */
+void recordPoolFree(RecordPool_t *pool);
+
+/**
+ * @brief Makes an empty pool use records that are already in memory, without copying them.
+ *
+ * The records become allocated with handles 0 to record_count - 1. The memory must hold whole
+ * slabs (record_count rounded up to RECORD_POOL_SLAB_RECORDS records), be writable, and stay
+ * valid until recordPoolFree() or recordPoolDetach(); the pool never frees it.
+ *
+ * @param pool An initialized pool without slabs.
+ * @param records The records, aligned for the record type.
+ * @param record_count Number of allocated records.
+ * @return 1 on success, 0 if the pool is not empty or memory could not be allocated.
+ */
+uint32_t recordPoolAdopt(RecordPool_t *pool, uint8_t *records, uint32_t record_count);
+
+/**
+ * @brief Copies the slabs given to recordPoolAdopt() into memory owned by the pool.
+ *
+ * Handles and record contents do not change, but pointers to records do. Afterwards the
+ * adopted memory is no longer used.
+ *
+ * @return 1 on success, 0 if memory could not be allocated (the pool is unchanged).
+ */
+uint32_t recordPoolDetach(RecordPool_t *pool);
+
+/**
+ * @brief Makes sure the given number of records can be allocated without failing.
+ *
+ * @return 1 on success, 0 if memory could not be allocated.
+ */
+uint32_t recordPoolReserve(RecordPool_t *pool, uint32_t count);
+
+/**
+ * @brief Allocates a record. Its content is not initialized.
+ *
+ * @return The handle of the record, or RECORD_POOL_INVALID_HANDLE if memory could not be allocated.
+ */
+RecordHandle_t recordPoolAlloc(RecordPool_t *pool);
+
+/**
+ * @brief Releases a record. Releasing an invalid or already released handle does nothing.
+ */
+void recordPoolRelease(RecordPool_t *pool, RecordHandle_t handle);
+
+/**
+ * @brief Returns the record named by a handle.
+ *
+ * @return Pointer to the record, or NULL if the handle does not name an allocated record.
+ */
+void* recordPoolGet(const RecordPool_t *pool, RecordHandle_t handle);
+
+/**
+ * @brief Reports the memory used by a pool.
+ */
+void recordPoolUsage(const RecordPool_t *pool, RecordPoolUsage_t *usage);
+
+#endif /* RECORD_POOL_H */
@@ -0,0 +1,796 @@
+/**
+ * @file shared_table.c
+ * @brief This file contains the implementation of the employee and department tables shared between processes.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdio.h>              /* Include standard input and output library for printf, snprintf */
+#include <stdlib.h>             /* Include standard library for malloc, free */
+#include <string.h>             /* Include string manipulation library for memcpy, memcmp, memset */
+#ifdef _WIN32
+#include <windows.h>            /* Include Windows header file for CreateFileMapping, MapViewOfFile */
+#else
+#include <fcntl.h>              /* Include POSIX header file for the O_* flags */
+#include <time.h>               /* Include time library for nanosleep */
+#include <unistd.h>             /* Include POSIX header file for close, ftruncate, getpid */
+#include <sys/mman.h>           /* Include POSIX header file for shm_open, mmap, munmap */
+#include <sys/stat.h>           /* Include POSIX header file for fstat */
+#endif
+#include "shared_table.h"       /* Include header file */
+#include "id_index.h"           /* Include ID index header file for looking the departments up by ID */
+#include "input_handler.h"      /* Include input handler header file for formatNumberWithCommas */
+#include "perf_stats.h"         /* Include instrumentation header file for measuring hot operations */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define SHARED_TABLE_MAGIC "MESHM001"       /* Magic bytes at the start of a published segment */
+#define SHARED_TABLE_MAGIC_LENGTH 8         /* Length of the magic bytes */
+#define SHARED_TABLE_BYTE_ORDER 0x01020304u /* Written in native order, read back to detect another byte order */
+#define SHARED_TABLE_HEADER_SIZE 4096u      /* Bytes before the employee table */
+#define SHARED_TABLE_GUARD_SIZE 4096u       /* Bytes at the end of a segment that stay 0, so every string ends */
+#define SHARED_TABLE_MIN_SIZE (1u << 20)    /* Smallest segment */
+#define SHARED_TABLE_ROUNDING (1u << 16)    /* Segment sizes are multiples of this */
+
+/**
+ * @brief Header at the start of a segment.
+ *
+ * sequence, generation and the counts are only accessed with atomic operations, as the
+ * writer changes them while readers look at them.
+ */
+typedef struct SharedTableHeader {
+    uint8_t magic[SHARED_TABLE_MAGIC_LENGTH];   /* SHARED_TABLE_MAGIC once the segment is ready */
+    uint32_t byte_order;                    /* SHARED_TABLE_BYTE_ORDER in the writer's order */
+    uint32_t employee_size;                 /* sizeof(Employee_t) of the writer */
+    uint32_t department_size;               /* sizeof(Department_t) of the writer */
+    uint32_t employee_count;                /* Number of published employees */
+    uint32_t department_count;              /* Number of published departments */
+    uint32_t reserved;                      /* Always 0 */
+    uint64_t department_offset;             /* Offset of the department table */
+    uint64_t sequence;                      /* Seqlock: odd while the writer changes the tables */
+    uint64_t generation;                    /* Number of completed publications */
+} SharedTableHeader_t;
+
+/**
+ * @brief State of sharedTablePayroll() while it reads the tables.
+ */
+typedef struct SharedPayrollContext {
+    SalaryBreakdown_t *breakdowns;          /* Salary of each employee, may be NULL */
+    uint32_t max_breakdowns;                /* Number of entries of breakdowns */
+    SharedPayrollTotals_t *totals;          /* Totals being computed */
+    IdIndex_t department_ids;               /* Department ID -> position in the shared table */
+    const Department_t *departments;        /* Shared department table of the current read */
+    ManageStatus_t status;                  /* Result of the last read */
+} SharedPayrollContext_t;
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static ManageStatus_t checkName(const char *name, char *copy);
+static void segmentPath(const char *name, char *path, uint32_t size);
+static uint64_t segmentSize(uint64_t required);
+static ManageStatus_t createSegment(SharedTableWriter_t *writer, uint64_t required);
+static ManageStatus_t growSegment(SharedTableWriter_t *writer, uint64_t required);
+static ManageStatus_t remapReader(SharedTableReader_t *reader);
+static void pauseReader();
+static void addPayroll(const SharedTableView_t *view, void *context);
+static const int8_t* sharedDepartmentKey(uint32_t value, const void *context);
+
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static SharedTableWriter_t menu_writer;         /* Writer used by the menu */
+static uint32_t menu_writer_ready = 0;          /* Flag to check if menu_writer is initialized */
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Prepares a writer; the segment is created by the first sharedTableBegin().
+ *
+ * A NULL name gives a name unique to this process.
+ */
+ManageStatus_t sharedTableWriterInit(SharedTableWriter_t *writer, const char *name)
+{
+    char unique[SHARED_TABLE_MAX_NAME + 1]; /* Name unique to this process */
+
+    memset(writer, 0, sizeof(*writer));
+    writer->handle = -1;
+    if (name == NULL)
+    {
+#ifdef _WIN32
+        snprintf(unique, sizeof(unique), "manage_employee_%lu", (unsigned long)GetCurrentProcessId());
+#else
+        snprintf(unique, sizeof(unique), "manage_employee_%lu", (unsigned long)getpid());
+#endif
+        name = unique;
+    }
+    return checkName(name, writer->name);
+}
+
+
+/**
+ * @brief Starts a publication and returns where the records go.
+ */
+ManageStatus_t sharedTableBegin(SharedTableWriter_t *writer, uint32_t employee_count, uint32_t department_count,
+                                Employee_t **employees, Department_t **departments)
+{
+    SharedTableHeader_t *header = NULL;     /* Header of the segment */
+    uint64_t department_offset = 0;         /* Offset of the department table */
+    uint64_t required = 0;                  /* Bytes needed by the tables */
+    uint64_t sequence = 0;                  /* Sequence number before the publication */
+    ManageStatus_t status = MANAGE_OK;      /* Result of creating or growing the segment */
+
+    department_offset = SHARED_TABLE_HEADER_SIZE
+                        + (((uint64_t)employee_count * sizeof(Employee_t) + 63u) & ~(uint64_t)63u);
+    required = department_offset + (uint64_t)department_count * sizeof(Department_t) + SHARED_TABLE_GUARD_SIZE;
+    if (writer->base == NULL)
+    {
+        status = createSegment(writer, required);
+    }
+    else if (required > writer->size)
+    {
+        status = growSegment(writer, required);
+    }
+    if (status != MANAGE_OK)
+    {
+        return status;
+    }
+
+    /* Odd sequence first: no store of the tables may become visible before it */
+    header = (SharedTableHeader_t *)writer->base;
+    sequence = __atomic_load_n(&header->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&header->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    __atomic_store_n(&header->employee_count, employee_count, __ATOMIC_RELAXED);
+    __atomic_store_n(&header->department_count, department_count, __ATOMIC_RELAXED);
+    __atomic_store_n(&header->department_offset, department_offset, __ATOMIC_RELAXED);
+    *employees = (Employee_t *)(writer->base + SHARED_TABLE_HEADER_SIZE);
+    *departments = (Department_t *)(writer->base + department_offset);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Ends a publication: the readers see the new tables from now on.
+ */
+uint64_t sharedTableCommit(SharedTableWriter_t *writer)
+{
+    SharedTableHeader_t *header = (SharedTableHeader_t *)writer->base;     /* Header of the segment */
+    uint64_t generation = __atomic_load_n(&header->generation, __ATOMIC_RELAXED) + 1;  /* New generation */
+
+    __atomic_store_n(&header->generation, generation, __ATOMIC_RELAXED);
+    /* Even sequence last: every store of the tables is visible before it */
+    __atomic_store_n(&header->sequence, __atomic_load_n(&header->sequence, __ATOMIC_RELAXED) + 1, __ATOMIC_RELEASE);
+    return generation;
+}
+
+
+/**
+ * @brief Publishes the stored employees and departments.
+ */
+ManageStatus_t sharedTablePublishStore(SharedTableWriter_t *writer, uint64_t *generation)
+{
+    Employee_t *employees = NULL;           /* Employee table of the segment */
+    Department_t *departments = NULL;       /* Department table of the segment */
+    uint32_t employee_count = getTotalEmployees();     /* Number of stored employees */
+    uint32_t department_count = getTotalDepartments(); /* Number of stored departments */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the publication */
+    uint32_t i = 0;                         /* Index for looping through records */
+    PERF_START(perf_start);                 /* Start time of the publication */
+
+    status = sharedTableBegin(writer, employee_count, department_count, &employees, &departments);
+    if (status != MANAGE_OK)
+    {
+        PERF_STOP(PERF_OP_PUBLISH_SHARED, perf_start);
+        return status;
+    }
+    for (i = 0; i < employee_count; i++)
+    {
+        memcpy(&employees[i], getEmployeeAt(i), sizeof(Employee_t));
+    }
+    for (i = 0; i < department_count; i++)
+    {
+        memcpy(&departments[i], getDepartmentAt(i), sizeof(Department_t));
+    }
+    if (generation != NULL)
+    {
+        *generation = sharedTableCommit(writer);
+    }
+    else
+    {
+        sharedTableCommit(writer);
+    }
+    PERF_STOP(PERF_OP_PUBLISH_SHARED, perf_start);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Unmaps and removes the segment; readers that have it mapped keep their mapping.
+ */
+void sharedTableWriterClose(SharedTableWriter_t *writer)
+{
+    char path[SHARED_TABLE_MAX_NAME + 8];   /* System name of the segment */
+
+    if (writer->base == NULL)
+    {
+        return;
+    }
+#ifdef _WIN32
+    (void)path;
+    UnmapViewOfFile(writer->base);
+    CloseHandle((HANDLE)writer->handle);
+#else
+    munmap(writer->base, (size_t)writer->size);
+    close((int)writer->handle);
+    segmentPath(writer->name, path, sizeof(path));
+    shm_unlink(path);
+#endif
+    writer->base = NULL;
+    writer->size = 0;
+    writer->handle = -1;
+}
+
+
+/**
+ * @brief Maps a published segment read-only.
+ */
+ManageStatus_t sharedTableOpen(SharedTableReader_t *reader, const char *name)
+{
+    char path[SHARED_TABLE_MAX_NAME + 8];   /* System name of the segment */
+    const SharedTableHeader_t *header = NULL;      /* Header of the segment */
+    uint32_t byte_order = SHARED_TABLE_BYTE_ORDER; /* Marker in this program's order */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the checks */
+#ifdef _WIN32
+    HANDLE mapping = NULL;                  /* The named mapping */
+    MEMORY_BASIC_INFORMATION info;          /* Size of the view */
+#else
+    struct stat info;                       /* Size of the segment */
+    void *mapped = MAP_FAILED;              /* The mapped segment */
+    int file = -1;                          /* The segment */
+#endif
+
+    memset(reader, 0, sizeof(*reader));
+    reader->handle = -1;
+    if (checkName(name, reader->name) != MANAGE_OK)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    segmentPath(reader->name, path, sizeof(path));
+
+#ifdef _WIN32
+    mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, path);
+    if (mapping == NULL)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    reader->base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (reader->base == NULL || VirtualQuery(reader->base, &info, sizeof(info)) == 0)
+    {
+        if (reader->base != NULL)
+        {
+            UnmapViewOfFile((void *)reader->base);
+        }
+        CloseHandle(mapping);
+        reader->base = NULL;
+        return MANAGE_ERR_IO;
+    }
+    reader->handle = (intptr_t)mapping;
+    reader->size = info.RegionSize;
+#else
+    file = shm_open(path, O_RDONLY, 0);
+    if (file < 0)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    if (fstat(file, &info) != 0 || info.st_size < (off_t)SHARED_TABLE_HEADER_SIZE)
+    {
+        close(file);
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, file, 0);
+    if (mapped == MAP_FAILED)
+    {
+        close(file);
+        return MANAGE_ERR_IO;
+    }
+    reader->handle = file;
+    reader->base = mapped;
+    reader->size = (uint64_t)info.st_size;
+#endif
+
+    header = (const SharedTableHeader_t *)reader->base;
+    if (memcmp(header->magic, SHARED_TABLE_MAGIC, SHARED_TABLE_MAGIC_LENGTH) != 0)
+    {
+        status = MANAGE_ERR_NOT_FOUND;
+    }
+    else if (memcmp(&header->byte_order, &byte_order, sizeof(byte_order)) != 0
+             || header->employee_size != sizeof(Employee_t) || header->department_size != sizeof(Department_t))
+    {
+        status = MANAGE_ERR_IO;
+    }
+    if (status != MANAGE_OK)
+    {
+        sharedTableClose(reader);
+    }
+    return status;
+}
+
+
+/**
+ * @brief Calls a function on a consistent view of the tables.
+ *
+ * The view is checked against the mapped size before the function sees it, so counts read
+ * while the writer changes them can never make the function read outside the segment.
+ */
+ManageStatus_t sharedTableRead(SharedTableReader_t *reader, SharedTableFn_t visit, void *context)
+{
+    const SharedTableHeader_t *header = (const SharedTableHeader_t *)reader->base;     /* Header of the segment */
+    SharedTableView_t view;                 /* Tables of the current attempt */
+    uint64_t department_offset = 0;         /* Offset of the department table */
+    uint64_t sequence = 0;                  /* Sequence number when the attempt started */
+    uint32_t attempt = 0;                   /* Index for looping through attempts */
+
+    for (attempt = 0; attempt < SHARED_TABLE_MAX_ATTEMPTS; attempt++)
+    {
+        if (attempt > 0)
+        {
+            pauseReader();
+        }
+        sequence = __atomic_load_n(&header->sequence, __ATOMIC_ACQUIRE);
+        if ((sequence & 1) != 0)
+        {
+            /* The writer is publishing */
+            continue;
+        }
+        view.employee_count = __atomic_load_n(&header->employee_count, __ATOMIC_RELAXED);
+        view.department_count = __atomic_load_n(&header->department_count, __ATOMIC_RELAXED);
+        view.generation = __atomic_load_n(&header->generation, __ATOMIC_RELAXED);
+        department_offset = __atomic_load_n(&header->department_offset, __ATOMIC_RELAXED);
+        if (SHARED_TABLE_HEADER_SIZE + (uint64_t)view.employee_count * sizeof(Employee_t) > department_offset
+            || department_offset + (uint64_t)view.department_count * sizeof(Department_t) + 1 > reader->size)
+        {
+            /* Counts being changed, or tables grown beyond the mapping */
+            if (remapReader(reader) != MANAGE_OK)
+            {
+                return MANAGE_ERR_IO;
+            }
+            header = (const SharedTableHeader_t *)reader->base;
+            continue;
+        }
+        view.employees = (const Employee_t *)(reader->base + SHARED_TABLE_HEADER_SIZE);
+        view.departments = (const Department_t *)(reader->base + department_offset);
+        visit(&view, context);
+
+        /* The work is valid only if no publication started meanwhile */
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&header->sequence, __ATOMIC_RELAXED) == sequence)
+        {
+            reader->generation = view.generation;
+            return MANAGE_OK;
+        }
+    }
+    return MANAGE_ERR_IO;
+}
+
+
+/**
+ * @brief Computes the payroll of the shared tables.
+ */
+ManageStatus_t sharedTablePayroll(SharedTableReader_t *reader, SalaryBreakdown_t *breakdowns, uint32_t max_breakdowns,
+                                  SharedPayrollTotals_t *totals)
+{
+    SharedPayrollContext_t context;         /* State of the reads */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the read */
+
+    memset(&context, 0, sizeof(context));
+    context.breakdowns = breakdowns;
+    context.max_breakdowns = (breakdowns != NULL) ? max_breakdowns : 0;
+    context.totals = totals;
+    idIndexInit(&context.department_ids, sharedDepartmentKey, &context);
+    status = sharedTableRead(reader, addPayroll, &context);
+    if (status == MANAGE_OK)
+    {
+        status = context.status;
+    }
+    idIndexFree(&context.department_ids);
+    return status;
+}
+
+
+/**
+ * @brief Unmaps a segment mapped by sharedTableOpen().
+ */
+void sharedTableClose(SharedTableReader_t *reader)
+{
+    if (reader->base == NULL)
+    {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile((void *)reader->base);
+    CloseHandle((HANDLE)reader->handle);
+#else
+    munmap((void *)reader->base, (size_t)reader->size);
+    close((int)reader->handle);
+#endif
+    reader->base = NULL;
+    reader->size = 0;
+    reader->handle = -1;
+}
+
+
+/**
+ * @brief Publishes the store to SHARED_TABLE_DEFAULT_NAME from the menu.
+ *
+ * Every call publishes a new generation; reader processes see it on their next read.
+ */
+void publishSharedTables()
+{
+    uint64_t generation = 0;                /* Generation of the published tables */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the publication */
+
+    if (menu_writer_ready == 0)
+    {
+        sharedTableWriterInit(&menu_writer, SHARED_TABLE_DEFAULT_NAME);
+        menu_writer_ready = 1;
+    }
+    status = sharedTablePublishStore(&menu_writer, &generation);
+    if (status == MANAGE_ERR_NO_MEMORY)
+    {
+        printf("The shared memory segment is too small for %u employees, restart the program to publish them!!!\n",
+               getTotalEmployees());
+        return;
+    }
+    if (status != MANAGE_OK)
+    {
+        printf("Cannot create shared memory segment %s\n", menu_writer.name);
+        return;
+    }
+    printf("Published %u employees and %u departments to shared memory segment %s (generation %llu).\n",
+           getTotalEmployees(), getTotalDepartments(), menu_writer.name, (unsigned long long)generation);
+    printf("Reader processes can run this program with --shared-report while it stays open.\n");
+}
+
+
+/**
+ * @brief Removes the segment published from the menu, if any. Called when the program exits.
+ */
+void stopSharedTables()
+{
+    if (menu_writer_ready == 1)
+    {
+        sharedTableWriterClose(&menu_writer);
+    }
+}
+
+
+/**
+ * @brief Runs a reader from the command line and prints the payroll totals of the shared tables.
+ */
+int32_t sharedTableCommand(int argc, char *argv[])
+{
+    SharedTableReader_t reader;             /* The mapped segment */
+    SharedPayrollTotals_t totals;           /* Payroll of the shared tables */
+    const char *name = (argc >= 3) ? argv[2] : SHARED_TABLE_DEFAULT_NAME;  /* Segment to read */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the read */
+
+    if (argc > 3)
+    {
+        printf("Usage: %s --shared-report [name]\n", argv[0]);
+        return 2;
+    }
+    status = sharedTableOpen(&reader, name);
+    if (status == MANAGE_ERR_NOT_FOUND)
+    {
+        printf("Nothing is published to shared memory segment %s\n", name);
+        return 2;
+    }
+    if (status == MANAGE_ERR_INVALID_ARGUMENT)
+    {
+        printf("Segment name %s is not valid\n", name);
+        return 2;
+    }
+    if (status != MANAGE_OK)
+    {
+        printf("Cannot map shared memory segment %s, or it was published by another build\n", name);
+        return 2;
+    }
+    status = sharedTablePayroll(&reader, NULL, 0, &totals);
+    sharedTableClose(&reader);
+    if (status != MANAGE_OK)
+    {
+        printf("Cannot read shared memory segment %s\n", name);
+        return 2;
+    }
+
+    printf("Shared tables %s, generation %llu: %u employees, %u departments\n", name,
+           (unsigned long long)totals.generation, totals.employee_count, totals.department_count);
+    printf("  Gross income: %s\n", formatNumberWithCommas(totals.gross));
+    printf("  Tax         : %s\n", formatNumberWithCommas(totals.tax));
+    printf("  Net salary  : %s\n", formatNumberWithCommas(totals.net));
+    return 0;
+}
+
+
+/**
+ * @brief Checks a segment name and copies it.
+ *
+ * @return MANAGE_OK or MANAGE_ERR_INVALID_ARGUMENT.
+ */
+static ManageStatus_t checkName(const char *name, char *copy)
+{
+    size_t length = (name != NULL) ? strlen(name) : 0;     /* Length of the name */
+
+    if (length == 0 || length > SHARED_TABLE_MAX_NAME || strpbrk(name, "/\\") != NULL)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    memcpy(copy, name, length + 1);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Returns the system name of a segment: "/name" for POSIX, "Local\name" for Windows.
+ */
+static void segmentPath(const char *name, char *path, uint32_t size)
+{
+#ifdef _WIN32
+    snprintf(path, size, "Local\\%s", name);
+#else
+    snprintf(path, size, "/%s", name);
+#endif
+}
+
+
+/**
+ * @brief Returns the size of a segment for the required bytes, with room to grow.
+ */
+static uint64_t segmentSize(uint64_t required)
+{
+    uint64_t size = required + required / 2;       /* Required bytes and half as much to grow */
+
+    if (size < SHARED_TABLE_MIN_SIZE)
+    {
+        size = SHARED_TABLE_MIN_SIZE;
+    }
+    return (size + SHARED_TABLE_ROUNDING - 1) & ~(uint64_t)(SHARED_TABLE_ROUNDING - 1);
+}
+
+
+/**
+ * @brief Creates, or opens again after a crash, the segment of a writer and writes its header.
+ */
+static ManageStatus_t createSegment(SharedTableWriter_t *writer, uint64_t required)
+{
+    char path[SHARED_TABLE_MAX_NAME + 8];   /* System name of the segment */
+    SharedTableHeader_t *header = NULL;     /* Header of the segment */
+    uint64_t size = segmentSize(required);  /* Size of the segment */
+    uint64_t sequence = 0;                  /* Sequence number left by a previous writer */
+#ifdef _WIN32
+    HANDLE mapping = NULL;                  /* The named mapping */
+    MEMORY_BASIC_INFORMATION info;          /* Size of an existing segment */
+    uint32_t existed = 0;                   /* Flag set if the segment already existed */
+#else
+    struct stat info;                       /* Size of an existing segment */
+    void *mapped = MAP_FAILED;              /* The mapped segment */
+    int file = -1;                          /* The segment */
+#endif
+
+    segmentPath(writer->name, path, sizeof(path));
+#ifdef _WIN32
+    mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, path);
+    if (mapping == NULL)
+    {
+        return MANAGE_ERR_IO;
+    }
+    existed = (GetLastError() == ERROR_ALREADY_EXISTS) ? 1u : 0u;
+    writer->base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (writer->base == NULL || VirtualQuery(writer->base, &info, sizeof(info)) == 0)
+    {
+        if (writer->base != NULL)
+        {
+            UnmapViewOfFile(writer->base);
+        }
+        CloseHandle(mapping);
+        writer->base = NULL;
+        return MANAGE_ERR_IO;
+    }
+    writer->handle = (intptr_t)mapping;
+    writer->size = (existed == 1) ? info.RegionSize : size;
+    if (writer->size < required)
+    {
+        sharedTableWriterClose(writer);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+#else
+    file = shm_open(path, O_CREAT | O_RDWR, 0600);
+    if (file < 0)
+    {
+        return MANAGE_ERR_IO;
+    }
+    /* A segment left by a writer that crashed is reused, never shrunk */
+    if (fstat(file, &info) == 0 && (uint64_t)info.st_size > size)
+    {
+        size = (uint64_t)info.st_size;
+    }
+    if (ftruncate(file, (off_t)size) != 0)
+    {
+        close(file);
+        return MANAGE_ERR_IO;
+    }
+    mapped = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (mapped == MAP_FAILED)
+    {
+        close(file);
+        return MANAGE_ERR_IO;
+    }
+    writer->handle = file;
+    writer->base = mapped;
+    writer->size = size;
+#endif
+
+    header = (SharedTableHeader_t *)writer->base;
+    if (memcmp(header->magic, SHARED_TABLE_MAGIC, SHARED_TABLE_MAGIC_LENGTH) == 0)
+    {
+        /* Keep counting from the previous writer, readers may still have it mapped */
+        sequence = __atomic_load_n(&header->sequence, __ATOMIC_RELAXED);
+        __atomic_store_n(&header->sequence, sequence + (sequence & 1), __ATOMIC_RELEASE);
+    }
+    header->byte_order = SHARED_TABLE_BYTE_ORDER;
+    header->employee_size = sizeof(Employee_t);
+    header->department_size = sizeof(Department_t);
+    header->reserved = 0;
+    __atomic_store_n(&header->department_offset, (uint64_t)SHARED_TABLE_HEADER_SIZE, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(header->magic, SHARED_TABLE_MAGIC, SHARED_TABLE_MAGIC_LENGTH);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Grows the segment of a writer. Readers remap it when they see larger tables.
+ *
+ * @return MANAGE_OK, MANAGE_ERR_IO, or MANAGE_ERR_NO_MEMORY on Windows, where a named mapping
+ *         keeps the size it was created with.
+ */
+static ManageStatus_t growSegment(SharedTableWriter_t *writer, uint64_t required)
+{
+#ifdef _WIN32
+    (void)writer;
+    (void)required;
+    return MANAGE_ERR_NO_MEMORY;
+#else
+    uint64_t size = segmentSize(required);  /* New size of the segment */
+    void *mapped = MAP_FAILED;              /* The segment mapped again */
+
+    if (ftruncate((int)writer->handle, (off_t)size) != 0)
+    {
+        return MANAGE_ERR_IO;
+    }
+    mapped = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, (int)writer->handle, 0);
+    if (mapped == MAP_FAILED)
+    {
+        return MANAGE_ERR_IO;
+    }
+    munmap(writer->base, (size_t)writer->size);
+    writer->base = mapped;
+    writer->size = size;
+    return MANAGE_OK;
+#endif
+}
+
+
+/**
+ * @brief Maps the segment of a reader again if the writer has grown it.
+ */
+static ManageStatus_t remapReader(SharedTableReader_t *reader)
+{
+#ifdef _WIN32
+    (void)reader;
+    return MANAGE_OK;
+#else
+    struct stat info;                       /* Current size of the segment */
+    void *mapped = MAP_FAILED;              /* The segment mapped again */
+
+    if (fstat((int)reader->handle, &info) != 0)
+    {
+        return MANAGE_ERR_IO;
+    }
+    if ((uint64_t)info.st_size <= reader->size)
+    {
+        return MANAGE_OK;
+    }
+    mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, (int)reader->handle, 0);
+    if (mapped == MAP_FAILED)
+    {
+        return MANAGE_ERR_IO;
+    }
+    munmap((void *)reader->base, (size_t)reader->size);
+    reader->base = mapped;
+    reader->size = (uint64_t)info.st_size;
+    return MANAGE_OK;
+#endif
+}
+
+
+/**
+ * @brief Waits a millisecond before a reader tries again.
+ */
+static void pauseReader()
+{
+#ifdef _WIN32
+    Sleep(1);
+#else
+    struct timespec delay = {0, 1000000};   /* One millisecond */
+
+    nanosleep(&delay, NULL);
+#endif
+}
+
+
+/**
+ * @brief Computes the payroll of one view of the tables, for sharedTablePayroll().
+ */
+static void addPayroll(const SharedTableView_t *view, void *context)
+{
+    SharedPayrollContext_t *payroll = context;     /* State of the reads */
+    SharedPayrollTotals_t *totals = payroll->totals;   /* Totals being computed */
+    SalaryBreakdown_t breakdown;            /* Salary of the current employee */
+    const Department_t *department = NULL;  /* Department of the current employee */
+    uint32_t position = 0;                  /* Position of the department in the shared table */
+    uint32_t i = 0;                         /* Index for looping through records */
+
+    /* Start from scratch: a previous call may have seen half-written tables */
+    memset(totals, 0, sizeof(*totals));
+    totals->generation = view->generation;
+    totals->employee_count = view->employee_count;
+    totals->department_count = view->department_count;
+    payroll->departments = view->departments;
+    payroll->status = MANAGE_OK;
+    idIndexClear(&payroll->department_ids);
+    if (idIndexReserve(&payroll->department_ids, view->department_count) != MANAGE_OK)
+    {
+        payroll->status = MANAGE_ERR_NO_MEMORY;
+        return;
+    }
+    for (i = 0; i < view->department_count; i++)
+    {
+        /* A duplicate can only come from half-written tables, which are read again */
+        idIndexInsert(&payroll->department_ids, view->departments[i].id, i);
+    }
+
+    for (i = 0; i < view->employee_count; i++)
+    {
+        department = NULL;
+        if (idIndexFind(&payroll->department_ids, view->employees[i].department_id, &position) == 1)
+        {
+            department = &view->departments[position];
+        }
+        calculateSalaryForDepartment(&view->employees[i], department, &breakdown);
+        totals->gross += breakdown.total_income;
+        totals->tax += breakdown.tax;
+        totals->net += breakdown.actual_salary;
+        if (i < payroll->max_breakdowns)
+        {
+            payroll->breakdowns[i] = breakdown;
+        }
+    }
+}
+
+
+/**
+ * @brief Returns the key of a shared department for the ID index.
+ */
+static const int8_t* sharedDepartmentKey(uint32_t value, const void *context)
+{
+    return ((const SharedPayrollContext_t *)context)->departments[value].id;
+} /* EOF */
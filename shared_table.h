@@ -0,0 +1,197 @@
+/**
+ * @file shared_table.h
+ * @brief This file contains the function prototypes for sharing the employee and department tables between processes.
+ *
+ * One writer process publishes the tables into a named shared-memory segment (POSIX shm_open(),
+ * or a named file mapping on Windows): a header, then every employee record and every
+ * department record, each table contiguous and in store order. Any number of reader processes
+ * map the segment read-only and work on the records where they are, without copying them.
+ *
+ * The header holds a sequence number used as a seqlock. The writer makes it odd before it
+ * changes the tables and even again when they are complete, and never waits for the readers.
+ * A reader notes the sequence number, works on the tables, then checks that the number is
+ * still the same and even; if it is not, the tables changed meanwhile and the work is done
+ * again. The generation counts the publications, so a reader can tell that nothing changed
+ * since its last read.
+ *
+ * The records are shared in the layout and byte order of the program that publishes them; a
+ * reader built with another record layout (see MANAGE_COMPACT_MODE) is refused.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef SHARED_TABLE_H
+#define SHARED_TABLE_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for Employee_t, Department_t and ManageStatus_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define SHARED_TABLE_DEFAULT_NAME "manage_employee_tables"  /* Segment published from the menu */
+#define SHARED_TABLE_MAX_NAME 64            /* Longest segment name, without the terminator */
+#define SHARED_TABLE_MAX_ATTEMPTS 5000      /* Reads tried before giving up on a writer that keeps publishing */
+
+/**
+ * @brief Writer side of a segment.
+ */
+typedef struct SharedTableWriter {
+    char name[SHARED_TABLE_MAX_NAME + 2];   /* Name of the segment */
+    intptr_t handle;                        /* File descriptor or mapping handle, -1 before the first publication */
+    uint8_t *base;                          /* Mapped segment, NULL before the first publication */
+    uint64_t size;                          /* Number of mapped bytes */
+} SharedTableWriter_t;
+
+/**
+ * @brief Reader side of a segment.
+ */
+typedef struct SharedTableReader {
+    char name[SHARED_TABLE_MAX_NAME + 2];   /* Name of the segment */
+    intptr_t handle;                        /* File descriptor or mapping handle */
+    const uint8_t *base;                    /* Mapped segment, read-only */
+    uint64_t size;                          /* Number of mapped bytes */
+    uint64_t generation;                    /* Generation of the last consistent read */
+} SharedTableReader_t;
+
+/**
+ * @brief The tables as seen by one read, pointing into the segment.
+ */
+typedef struct SharedTableView {
+    const Employee_t *employees;            /* Employee records, in store order */
+    uint32_t employee_count;                /* Number of employees */
+    const Department_t *departments;        /* Department records, in store order */
+    uint32_t department_count;              /* Number of departments */
+    uint64_t generation;                    /* Number of publications so far */
+} SharedTableView_t;
+
+/**
+ * @brief Called by sharedTableRead() on the tables.
+ *
+ * The function may be called again if the writer published meanwhile; only the last call saw
+ * consistent tables, so it must start its work from scratch on every call. The records of a
+ * call that is repeated may be half-written: strings may not be terminated inside their field,
+ * but they always are inside the segment.
+ */
+typedef void (*SharedTableFn_t)(const SharedTableView_t *view, void *context);
+
+/**
+ * @brief Payroll totals computed by a reader.
+ */
+typedef struct SharedPayrollTotals {
+    uint64_t generation;                    /* Generation the totals were computed on */
+    uint32_t employee_count;                /* Number of employees */
+    uint32_t department_count;              /* Number of departments */
+    uint64_t gross;                         /* Sum of the gross incomes */
+    uint64_t tax;                           /* Sum of the taxes */
+    uint64_t net;                           /* Sum of the net salaries */
+} SharedPayrollTotals_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Prepares a writer; the segment is created by the first sharedTableBegin().
+ *
+ * @return MANAGE_OK or MANAGE_ERR_INVALID_ARGUMENT if the name is empty, too long or has a '/' or '\\'.
+ */
+ManageStatus_t sharedTableWriterInit(SharedTableWriter_t *writer, const char *name);
+
+/**
+ * @brief Starts a publication and returns where the records go.
+ *
+ * The segment is created or grown as needed, the sequence number is made odd and the counts
+ * are set. The caller fills the two tables and calls sharedTableCommit().
+ *
+ * @param writer The writer.
+ * @param employee_count Number of employees to publish.
+ * @param department_count Number of departments to publish.
+ * @param employees Receives the employee table of the segment.
+ * @param departments Receives the department table of the segment.
+ * @return MANAGE_OK, MANAGE_ERR_IO if the segment cannot be created or mapped, or
+ *         MANAGE_ERR_NO_MEMORY if it cannot grow (on Windows a segment keeps its first size).
+ */
+ManageStatus_t sharedTableBegin(SharedTableWriter_t *writer, uint32_t employee_count, uint32_t department_count,
+                                Employee_t **employees, Department_t **departments);
+
+/**
+ * @brief Ends a publication: the readers see the new tables from now on.
+ *
+ * @return The generation of the new tables.
+ */
+uint64_t sharedTableCommit(SharedTableWriter_t *writer);
+
+/**
+ * @brief Publishes the stored employees and departments.
+ *
+ * @param writer The writer.
+ * @param generation Receives the generation of the published tables (may be NULL).
+ * @return The result of sharedTableBegin().
+ */
+ManageStatus_t sharedTablePublishStore(SharedTableWriter_t *writer, uint64_t *generation);
+
+/**
+ * @brief Unmaps and removes the segment; readers that have it mapped keep their mapping.
+ */
+void sharedTableWriterClose(SharedTableWriter_t *writer);
+
+/**
+ * @brief Maps a published segment read-only.
+ *
+ * @return MANAGE_OK, MANAGE_ERR_NOT_FOUND if no segment has this name or nothing was published
+ *         yet, MANAGE_ERR_IO if it cannot be mapped or was published with another record layout,
+ *         or MANAGE_ERR_INVALID_ARGUMENT if the name is not valid.
+ */
+ManageStatus_t sharedTableOpen(SharedTableReader_t *reader, const char *name);
+
+/**
+ * @brief Calls a function on a consistent view of the tables.
+ *
+ * @return MANAGE_OK, or MANAGE_ERR_IO if the segment cannot be remapped or the writer kept
+ *         publishing during SHARED_TABLE_MAX_ATTEMPTS reads.
+ */
+ManageStatus_t sharedTableRead(SharedTableReader_t *reader, SharedTableFn_t visit, void *context);
+
+/**
+ * @brief Computes the payroll of the shared tables.
+ *
+ * @param reader The reader.
+ * @param breakdowns Receives the salary of each employee in store order (may be NULL).
+ * @param max_breakdowns Number of entries of breakdowns; later employees are only added to the totals.
+ * @param totals Receives the totals.
+ * @return The result of sharedTableRead(), or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t sharedTablePayroll(SharedTableReader_t *reader, SalaryBreakdown_t *breakdowns, uint32_t max_breakdowns,
+                                  SharedPayrollTotals_t *totals);
+
+/**
+ * @brief Unmaps a segment mapped by sharedTableOpen().
+ */
+void sharedTableClose(SharedTableReader_t *reader);
+
+/**
+ * @brief Publishes the store to SHARED_TABLE_DEFAULT_NAME from the menu.
+ */
+void publishSharedTables();
+
+/**
+ * @brief Removes the segment published from the menu, if any. Called when the program exits.
+ */
+void stopSharedTables();
+
+/**
+ * @brief Runs a reader from the command line and prints the payroll totals of the shared tables.
+ *
+ *     --shared-report [name]
+ *
+ * @param argc Number of arguments, as given to main().
+ * @param argv Arguments, as given to main().
+ * @return Exit code: 0 on success, 2 on error.
+ */
+int32_t sharedTableCommand(int argc, char *argv[]);
+
+#endif /* SHARED_TABLE_H */
@@ -0,0 +1,888 @@
+/**
+ * @file store_snapshot.c
+ * @brief This file contains the implementation of the store snapshot.
+ *
+ * A save writes "<path>.tmp" and renames it over the old snapshot once it is complete and
+ * closed, so a save that stops half-way leaves the old snapshot as it was. The header is
+ * written last, after every chunk checksum is known, so an unfinished temporary file has a
+ * zero header that loading rejects.
+ *
+ * Loading only checks the header and the chunk table before the store adopts the records; the
+ * chunk checksums are checked by a background thread on a second, read-only view of the file,
+ * so changes made to the records meanwhile are not taken for damage.
+ *
+ * Header (72 bytes, little-endian except the byte order marker):
+ *     0  magic "MESNAP01"             8  version u32              12 byte order marker u32 (native)
+ *     16 employee record size u32     20 department record size u32
+ *     24 employee count u32           28 department count u32
+ *     32 chunk size u32               36 chunk count u32
+ *     40 data offset u64              48 data size u64
+ *     56 checksum of the chunk table u64                          64 checksum of bytes 0 to 63 u64
+ * followed by the chunk table (one u64 per chunk).
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdio.h>              /* Include standard input and output library for printf, FILE, ... */
+#include <stdlib.h>             /* Include standard library for malloc, calloc, free */
+#include <string.h>             /* Include string manipulation library for memcpy, memcmp, memset */
+#include <pthread.h>            /* Include POSIX threads library for the background check */
+#ifdef _WIN32
+#include <windows.h>            /* Include Windows header file for CreateFileMapping, MapViewOfFile */
+#else
+#include <fcntl.h>              /* Include POSIX header file for open */
+#include <unistd.h>             /* Include POSIX header file for close, fsync */
+#include <sys/mman.h>           /* Include POSIX header file for mmap, munmap */
+#include <sys/stat.h>           /* Include POSIX header file for fstat */
+#endif
+#include "store_snapshot.h"     /* Include header file */
+#include "record_pool.h"        /* Include pool allocator header file for the slab size */
+#include "worker_pool.h"        /* Include worker pool header file for the verification threads */
+#include "perf_stats.h"         /* Include instrumentation header file for measuring hot operations */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define SNAPSHOT_MAGIC "MESNAP01"           /* Magic bytes at the start of a snapshot */
+#define SNAPSHOT_MAGIC_LENGTH 8             /* Length of the magic bytes */
+#define SNAPSHOT_VERSION 1u                 /* Version of the file layout */
+#define SNAPSHOT_BYTE_ORDER 0x01020304u     /* Written in native byte order to detect another byte order */
+#define SNAPSHOT_HEADER_SIZE 72u            /* Size of the header before the chunk table */
+#define SNAPSHOT_CHECKED_HEADER_SIZE 64u    /* Header bytes covered by the header checksum */
+#define SNAPSHOT_DATA_ALIGNMENT 4096u       /* Records start on a page boundary */
+#define SNAPSHOT_VERIFY_CHUNKS 4u           /* Largest range of chunks checked without splitting it */
+#define SNAPSHOT_PRIME_1 0x9E3779B185EBCA87ull  /* Multipliers of the checksum */
+#define SNAPSHOT_PRIME_2 0xC2B2AE3D27D4EB4Full
+#define SNAPSHOT_TEMP_SUFFIX ".tmp"         /* Added to the path of the file being written */
+
+/**
+ * @brief Where the records are in a snapshot with given counts.
+ */
+typedef struct SnapshotLayout {
+    uint32_t employee_count;                /* Number of employees */
+    uint32_t department_count;              /* Number of departments */
+    uint32_t chunk_count;                   /* Number of checksummed chunks */
+    uint64_t data_offset;                   /* Offset of the first department slab */
+    uint64_t department_bytes;              /* Size of the department slabs */
+    uint64_t data_size;                     /* Size of the department and employee slabs */
+} SnapshotLayout_t;
+
+/**
+ * @brief Writes the data of a snapshot one chunk at a time.
+ */
+typedef struct SnapshotWriter {
+    FILE *file;                             /* The snapshot file */
+    uint8_t *buffer;                        /* Chunk being filled */
+    uint32_t fill;                          /* Bytes in buffer */
+    uint32_t chunk;                         /* Index of the chunk being filled */
+    uint64_t *checksums;                    /* Checksum of every written chunk */
+} SnapshotWriter_t;
+
+/**
+ * @brief Chunks checked by the verification threads.
+ */
+typedef struct VerifyJob {
+    const uint8_t *data;                    /* First byte of the data */
+    const uint8_t *table;                   /* Chunk table of the file */
+    uint64_t data_size;                     /* Size of the data */
+    uint32_t damaged;                       /* First damaged chunk found so far, SNAPSHOT_NO_CHUNK if none */
+} VerifyJob_t;
+
+/**
+ * @brief Background check of the chunks of the loaded snapshot.
+ */
+typedef struct SnapshotCheckJob {
+    uint8_t *bytes;                         /* Read-only view of the file, NULL once unmapped */
+    uint64_t size;                          /* Size of the view */
+    SnapshotLayout_t layout;                /* Where the records are */
+    uint32_t thread_count;                  /* Threads asked for, then threads that checked the chunks */
+    uint32_t damaged;                       /* First damaged chunk, SNAPSHOT_NO_CHUNK if none */
+    uint32_t done;                          /* Flag set by the thread once damaged is known */
+    uint32_t reported;                      /* Flag set once the user was told the result */
+    EmployeeStore_t *store;                 /* Store that adopted the records */
+    SnapshotCheck_t state;                  /* State once the thread was joined */
+} SnapshotCheckJob_t;
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static void planLayout(uint32_t employee_count, uint32_t department_count, SnapshotLayout_t *layout);
+static uint32_t checkHeader(const uint8_t *bytes, uint64_t size, SnapshotLayout_t *layout);
+static uint32_t verifyChunks(const uint8_t *bytes, const SnapshotLayout_t *layout, uint32_t thread_count,
+                             uint32_t *used_threads);
+static void verifyRange(void *context, uint32_t worker, const WorkerRange_t *range);
+static void* checkSnapshotThread(void *argument);
+static void finishSnapshotCheck();
+static uint64_t checksumBytes(const uint8_t *bytes, uint64_t length);
+static uint32_t appendBytes(SnapshotWriter_t *writer, const void *data, uint64_t length);
+static uint32_t flushChunk(SnapshotWriter_t *writer);
+static ManageStatus_t mapSnapshot(const char *path, uint8_t **bytes, uint8_t **check_bytes, uint64_t *size);
+static uint32_t replaceFile(const char *from, const char *to);
+static void unmapSnapshot(uint8_t *bytes, uint64_t size);
+static void putU32(uint8_t *bytes, uint32_t value);
+static void putU64(uint8_t *bytes, uint64_t value);
+static uint32_t getU32(const uint8_t *bytes);
+static uint64_t getU64(const uint8_t *bytes);
+
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint8_t *snapshot_bytes = NULL;      /* Mapped snapshot whose records the store uses, NULL if none */
+static uint64_t snapshot_size = 0;          /* Size of the mapped snapshot */
+static EmployeeStore_t *snapshot_store = NULL;  /* Store that uses the records of the mapped snapshot */
+static SnapshotCheckJob_t check_job = { .state = SNAPSHOT_CHECK_NONE };    /* Check of the last loaded snapshot */
+static pthread_t check_thread;              /* Thread running check_job */
+static uint32_t check_started = 0;          /* Flag set while check_thread has to be joined */
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Writes every stored employee and department to a snapshot file.
+ *
+ * Records are copied in store order, so the loaded store has the same order and handles
+ * 0, 1, 2, ...; the unused records of the last slab of each pool are written as zeros.
+ * The records of a snapshot whose check found a damaged chunk are not saved again, as the
+ * new checksums would hide the damage.
+ */
+ManageStatus_t saveStoreSnapshot(const char *path)
+{
+    SnapshotLayout_t layout;                /* Where the records go */
+    SnapshotWriter_t writer;                /* Writes the data and checksums it */
+    uint8_t *prefix = NULL;                 /* Header, chunk table and padding before the data */
+    char *temp_path = NULL;                 /* File written before it replaces path */
+    uint32_t byte_order = SNAPSHOT_BYTE_ORDER;  /* Byte order marker, in native byte order */
+    uint32_t ok = 1;                        /* Flag to check if every write succeeded */
+    EmployeeStore_t *previous = NULL;       /* Store selected by the calling thread */
+    ManageStatus_t status = MANAGE_OK;      /* Result of copying the mapped records */
+    uint32_t i = 0;                         /* Index for looping through records and chunks */
+
+    if (getSnapshotCheck(1, NULL) == SNAPSHOT_CHECK_DAMAGED && check_job.store == getActiveEmployeeStore())
+    {
+        return MANAGE_ERR_IO;
+    }
+
+    /* The mapped file may be the one being replaced; its records may belong to another store */
+    if (snapshot_bytes != NULL)
+    {
+        previous = selectEmployeeStore(snapshot_store);
+        status = detachStoreRecords();
+        selectEmployeeStore(previous);
+        if (status != MANAGE_OK)
+        {
+            return MANAGE_ERR_NO_MEMORY;
+        }
+        unmapSnapshot(snapshot_bytes, snapshot_size);
+        snapshot_bytes = NULL;
+        snapshot_size = 0;
+        snapshot_store = NULL;
+    }
+
+    planLayout(getTotalEmployees(), getTotalDepartments(), &layout);
+    memset(&writer, 0, sizeof(writer));
+    prefix = calloc((size_t)layout.data_offset, 1);
+    writer.buffer = malloc(SNAPSHOT_CHUNK_SIZE);
+    writer.checksums = calloc((size_t)layout.chunk_count + 1, sizeof(*writer.checksums));
+    temp_path = malloc(strlen(path) + sizeof(SNAPSHOT_TEMP_SUFFIX));
+    if (prefix == NULL || writer.buffer == NULL || writer.checksums == NULL || temp_path == NULL)
+    {
+        free(prefix);
+        free(writer.buffer);
+        free(writer.checksums);
+        free(temp_path);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    strcpy(temp_path, path);
+    strcat(temp_path, SNAPSHOT_TEMP_SUFFIX);
+    writer.file = fopen(temp_path, "wb");
+    if (writer.file == NULL)
+    {
+        free(prefix);
+        free(writer.buffer);
+        free(writer.checksums);
+        free(temp_path);
+        return MANAGE_ERR_IO;
+    }
+
+    /* Leave room for the header and the chunk table, they are written once the data is */
+    ok &= (fwrite(prefix, 1, (size_t)layout.data_offset, writer.file) == layout.data_offset) ? 1u : 0u;
+    for (i = 0; i < layout.department_count && ok == 1; i++)
+    {
+        ok &= appendBytes(&writer, getDepartmentAt(i), sizeof(Department_t));
+    }
+    ok &= appendBytes(&writer, NULL, layout.department_bytes - (uint64_t)layout.department_count * sizeof(Department_t));
+    for (i = 0; i < layout.employee_count && ok == 1; i++)
+    {
+        ok &= appendBytes(&writer, getEmployeeAt(i), sizeof(Employee_t));
+    }
+    ok &= appendBytes(&writer, NULL, layout.data_size - layout.department_bytes
+                                     - (uint64_t)layout.employee_count * sizeof(Employee_t));
+    if (writer.fill > 0)
+    {
+        ok &= flushChunk(&writer);
+    }
+
+    memcpy(prefix, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LENGTH);
+    putU32(prefix + 8, SNAPSHOT_VERSION);
+    memcpy(prefix + 12, &byte_order, sizeof(byte_order));
+    putU32(prefix + 16, (uint32_t)sizeof(Employee_t));
+    putU32(prefix + 20, (uint32_t)sizeof(Department_t));
+    putU32(prefix + 24, layout.employee_count);
+    putU32(prefix + 28, layout.department_count);
+    putU32(prefix + 32, SNAPSHOT_CHUNK_SIZE);
+    putU32(prefix + 36, layout.chunk_count);
+    putU64(prefix + 40, layout.data_offset);
+    putU64(prefix + 48, layout.data_size);
+    for (i = 0; i < layout.chunk_count; i++)
+    {
+        putU64(prefix + SNAPSHOT_HEADER_SIZE + (size_t)i * 8, writer.checksums[i]);
+    }
+    putU64(prefix + 56, checksumBytes(prefix + SNAPSHOT_HEADER_SIZE, (uint64_t)layout.chunk_count * 8));
+    putU64(prefix + 64, checksumBytes(prefix, SNAPSHOT_CHECKED_HEADER_SIZE));
+    ok &= (ok == 1 && writer.chunk == layout.chunk_count && fseek(writer.file, 0, SEEK_SET) == 0) ? 1u : 0u;
+    ok &= (ok == 1 && fwrite(prefix, 1, (size_t)layout.data_offset, writer.file) == layout.data_offset) ? 1u : 0u;
+    ok &= (ok == 1 && fflush(writer.file) == 0) ? 1u : 0u;
+#ifndef _WIN32
+    /* The data must be on disk before the rename makes it the snapshot */
+    ok &= (ok == 1 && fsync(fileno(writer.file)) == 0) ? 1u : 0u;
+#endif
+    if (fclose(writer.file) != 0)
+    {
+        ok = 0;
+    }
+    /* Replace the old snapshot only with a complete file */
+    if (ok == 1)
+    {
+        ok = replaceFile(temp_path, path);
+    }
+    if (ok == 0)
+    {
+        remove(temp_path);
+    }
+
+    free(prefix);
+    free(writer.buffer);
+    free(writer.checksums);
+    free(temp_path);
+    return (ok == 1) ? MANAGE_OK : MANAGE_ERR_IO;
+}
+
+
+/**
+ * @brief Starts the empty store from a snapshot file.
+ *
+ * The file stays mapped for as long as the store uses its records: pages are read from the
+ * file when first touched and copied only when a record in them is changed. The store adopts
+ * the records once the header is checked; the chunks are checked in the background (see
+ * getSnapshotCheck()), so the time to the first query does not grow with the data.
+ */
+ManageStatus_t loadStoreSnapshot(const char *path, uint32_t thread_count, SnapshotReport_t *report)
+{
+    SnapshotReport_t unused_report;         /* Report used when the caller does not want one */
+    SnapshotLayout_t layout;                /* Where the records are */
+    uint8_t *bytes = NULL;                  /* The mapped file */
+    uint8_t *check_bytes = NULL;            /* Read-only view of the file for the chunk check */
+    uint64_t size = 0;                      /* Size of the mapped file */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the load */
+    PERF_START(perf_start);                 /* Start time of the load */
+
+    if (report == NULL)
+    {
+        report = &unused_report;
+    }
+    memset(report, 0, sizeof(*report));
+    report->damaged_chunk = SNAPSHOT_NO_CHUNK;
+    if (snapshot_bytes != NULL || getTotalEmployees() != 0 || getTotalDepartments() != 0)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    /* Only the last loaded snapshot is checked */
+    finishSnapshotCheck();
+    status = mapSnapshot(path, &bytes, &check_bytes, &size);
+    if (status != MANAGE_OK)
+    {
+        return status;
+    }
+    report->file_bytes = size;
+
+    if (checkHeader(bytes, size, &layout) == 0)
+    {
+        status = MANAGE_ERR_IO;
+    }
+    else
+    {
+        report->employee_count = layout.employee_count;
+        report->department_count = layout.department_count;
+        report->chunk_count = layout.chunk_count;
+        status = adoptStoreRecords(bytes + layout.data_offset + layout.department_bytes, layout.employee_count,
+                                   bytes + layout.data_offset, layout.department_count);
+    }
+
+    if (status == MANAGE_OK)
+    {
+        snapshot_bytes = bytes;
+        snapshot_size = size;
+        snapshot_store = getActiveEmployeeStore();
+
+        memset(&check_job, 0, sizeof(check_job));
+        check_job.bytes = check_bytes;
+        check_job.size = size;
+        check_job.layout = layout;
+        check_job.thread_count = thread_count;
+        check_job.damaged = SNAPSHOT_NO_CHUNK;
+        check_job.store = snapshot_store;
+        check_job.state = SNAPSHOT_CHECK_RUNNING;
+        check_started = (pthread_create(&check_thread, NULL, checkSnapshotThread, &check_job) == 0) ? 1u : 0u;
+        if (check_started == 0)
+        {
+            /* No thread for the check, it runs before the menu as it did before */
+            checkSnapshotThread(&check_job);
+            finishSnapshotCheck();
+        }
+    }
+    else
+    {
+        unmapSnapshot(bytes, size);
+        unmapSnapshot(check_bytes, size);
+    }
+    PERF_STOP(PERF_OP_LOAD_SNAPSHOT, perf_start);
+    return status;
+}
+
+
+/**
+ * @brief Loads SNAPSHOT_DEFAULT_PATH if it exists and tells the user what happened.
+ */
+void loadStartupSnapshot()
+{
+    SnapshotReport_t report;                /* What was loaded */
+    ManageStatus_t status = loadStoreSnapshot(SNAPSHOT_DEFAULT_PATH, 0, &report);  /* Result of the load */
+
+    if (status == MANAGE_OK)
+    {
+        printf("Loaded %u employees and %u departments from %s (%u chunks being checked)\n",
+               report.employee_count, report.department_count, SNAPSHOT_DEFAULT_PATH, report.chunk_count);
+        reportSnapshotCheck();
+    }
+    else if (status == MANAGE_ERR_IO)
+    {
+        printf("Snapshot %s is damaged or was written by another version, starting with no data!!!\n",
+               SNAPSHOT_DEFAULT_PATH);
+    }
+    else if (status == MANAGE_ERR_NO_MEMORY)
+    {
+        printf("Not enough memory to load snapshot %s, starting with no data!!!\n", SNAPSHOT_DEFAULT_PATH);
+    }
+    else
+    {
+        /* No snapshot yet, start with no data */
+    }
+}
+
+
+/**
+ * @brief Returns the state of the check of the chunks of the last loaded snapshot.
+ */
+SnapshotCheck_t getSnapshotCheck(uint32_t wait, SnapshotReport_t *report)
+{
+    if (check_started == 1 && (wait == 1 || __atomic_load_n(&check_job.done, __ATOMIC_ACQUIRE) == 1))
+    {
+        finishSnapshotCheck();
+    }
+    if (report != NULL)
+    {
+        memset(report, 0, sizeof(*report));
+        report->employee_count = check_job.layout.employee_count;
+        report->department_count = check_job.layout.department_count;
+        report->file_bytes = check_job.size;
+        report->chunk_count = check_job.layout.chunk_count;
+        report->damaged_chunk = SNAPSHOT_NO_CHUNK;
+        if (check_job.state != SNAPSHOT_CHECK_RUNNING)
+        {
+            report->thread_count = check_job.thread_count;
+            report->damaged_chunk = check_job.damaged;
+        }
+    }
+    return check_job.state;
+}
+
+
+/**
+ * @brief Tells the user the result of the snapshot check once it is known.
+ */
+void reportSnapshotCheck()
+{
+    SnapshotReport_t report;                /* Result of the check */
+    SnapshotCheck_t state = getSnapshotCheck(0, &report);  /* State of the check */
+
+    if (check_job.reported == 1 || state == SNAPSHOT_CHECK_NONE || state == SNAPSHOT_CHECK_RUNNING)
+    {
+        return;
+    }
+    check_job.reported = 1;
+    if (state == SNAPSHOT_CHECK_PASSED)
+    {
+        printf("Snapshot %s checked: %u chunks by %u threads, no damage found.\n",
+               SNAPSHOT_DEFAULT_PATH, report.chunk_count, report.thread_count);
+    }
+    else
+    {
+        printf("Snapshot %s is damaged (chunk %u), some loaded data is wrong and will not be saved!!!\n",
+               SNAPSHOT_DEFAULT_PATH, report.damaged_chunk);
+    }
+}
+
+
+/**
+ * @brief Saves the default store to SNAPSHOT_DEFAULT_PATH from the menu.
+ */
+void saveDataSnapshot()
+{
+    SnapshotReport_t report;                /* Result of the snapshot check */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the save */
+
+    if (getActiveEmployeeStore() != getDefaultEmployeeStore())
+    {
+        printf("Only the default company is saved to %s, select it first!!!\n", SNAPSHOT_DEFAULT_PATH);
+        return;
+    }
+    if (getSnapshotCheck(1, &report) == SNAPSHOT_CHECK_DAMAGED && check_job.store == getActiveEmployeeStore())
+    {
+        printf("Snapshot %s is damaged (chunk %u), its data is not saved again!!!\n",
+               SNAPSHOT_DEFAULT_PATH, report.damaged_chunk);
+        return;
+    }
+    status = saveStoreSnapshot(SNAPSHOT_DEFAULT_PATH);
+    if (status == MANAGE_OK)
+    {
+        printf("Saved %u employees and %u departments to %s\n",
+               getTotalEmployees(), getTotalDepartments(), SNAPSHOT_DEFAULT_PATH);
+    }
+    else if (status == MANAGE_ERR_NO_MEMORY)
+    {
+        printf("Not enough memory to save snapshot!!!\n");
+    }
+    else
+    {
+        printf("Cannot write file %s\n", SNAPSHOT_DEFAULT_PATH);
+    }
+}
+
+
+/**
+ * @brief Calculates where the records of a snapshot with the given counts are.
+ */
+static void planLayout(uint32_t employee_count, uint32_t department_count, SnapshotLayout_t *layout)
+{
+    uint64_t slab_records = RECORD_POOL_SLAB_RECORDS;   /* Records per slab */
+    uint64_t employee_slabs = (employee_count + slab_records - 1) / slab_records;       /* Slabs of employees */
+    uint64_t department_slabs = (department_count + slab_records - 1) / slab_records;   /* Slabs of departments */
+    uint64_t table_end = 0;                 /* Offset after the chunk table */
+
+    layout->employee_count = employee_count;
+    layout->department_count = department_count;
+    layout->department_bytes = department_slabs * slab_records * sizeof(Department_t);
+    layout->data_size = layout->department_bytes + employee_slabs * slab_records * sizeof(Employee_t);
+    layout->chunk_count = (uint32_t)((layout->data_size + SNAPSHOT_CHUNK_SIZE - 1) / SNAPSHOT_CHUNK_SIZE);
+    table_end = SNAPSHOT_HEADER_SIZE + (uint64_t)layout->chunk_count * 8;
+    layout->data_offset = (table_end + SNAPSHOT_DATA_ALIGNMENT - 1) / SNAPSHOT_DATA_ALIGNMENT * SNAPSHOT_DATA_ALIGNMENT;
+}
+
+
+/**
+ * @brief Checks the header and the chunk table of a mapped snapshot.
+ *
+ * @param bytes The mapped file, at least SNAPSHOT_HEADER_SIZE bytes.
+ * @param size Size of the mapped file.
+ * @param layout Receives where the records are.
+ * @return 1 if the snapshot was written by this program and its header is intact, 0 otherwise.
+ */
+static uint32_t checkHeader(const uint8_t *bytes, uint64_t size, SnapshotLayout_t *layout)
+{
+    uint32_t byte_order = 0;                /* Byte order marker of the file */
+
+    memcpy(&byte_order, bytes + 12, sizeof(byte_order));
+    if (memcmp(bytes, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LENGTH) != 0 || getU32(bytes + 8) != SNAPSHOT_VERSION
+        || byte_order != SNAPSHOT_BYTE_ORDER || getU32(bytes + 16) != sizeof(Employee_t)
+        || getU32(bytes + 20) != sizeof(Department_t) || getU32(bytes + 32) != SNAPSHOT_CHUNK_SIZE
+        || getU64(bytes + 64) != checksumBytes(bytes, SNAPSHOT_CHECKED_HEADER_SIZE))
+    {
+        return 0;
+    }
+    /* The counts decide the rest of the layout, the stored values must agree with it */
+    planLayout(getU32(bytes + 24), getU32(bytes + 28), layout);
+    if (getU32(bytes + 36) != layout->chunk_count || getU64(bytes + 40) != layout->data_offset
+        || getU64(bytes + 48) != layout->data_size || layout->data_offset + layout->data_size > size)
+    {
+        return 0;
+    }
+    return (getU64(bytes + 56) == checksumBytes(bytes + SNAPSHOT_HEADER_SIZE, (uint64_t)layout->chunk_count * 8)) ? 1u : 0u;
+}
+
+
+/**
+ * @brief Checks every chunk of a snapshot against the chunk table.
+ *
+ * The chunks are one range of the worker pool, split into ranges of at most
+ * SNAPSHOT_VERIFY_CHUNKS chunks while the threads work. If the pool cannot run, the calling
+ * thread checks every chunk.
+ *
+ * @param bytes The mapped file.
+ * @param layout Where the records are.
+ * @param thread_count Number of threads, 0 for one per processor.
+ * @param used_threads Receives the number of threads that checked the chunks.
+ * @return The first damaged chunk, or SNAPSHOT_NO_CHUNK.
+ */
+static uint32_t verifyChunks(const uint8_t *bytes, const SnapshotLayout_t *layout, uint32_t thread_count,
+                             uint32_t *used_threads)
+{
+    VerifyJob_t job;                        /* Work shared by the threads */
+    WorkerRange_t range;                    /* Every chunk */
+
+    job.data = bytes + layout->data_offset;
+    job.table = bytes + SNAPSHOT_HEADER_SIZE;
+    job.data_size = layout->data_size;
+    job.damaged = SNAPSHOT_NO_CHUNK;
+    range.group = 0;
+    range.first = 0;
+    range.end = layout->chunk_count;
+    *used_threads = workerPoolThreadCount(layout->chunk_count, SNAPSHOT_VERIFY_CHUNKS, thread_count);
+    if (runWorkerPool(&range, 1, SNAPSHOT_VERIFY_CHUNKS, *used_threads, verifyRange, &job) != MANAGE_OK)
+    {
+        verifyRange(&job, 0, &range);
+        *used_threads = 1;
+    }
+    return job.damaged;
+}
+
+
+/**
+ * @brief Checks the chunks of one range and lowers the first damaged chunk of the job.
+ *
+ * A range stops at its first damaged chunk, and ranges after a damaged chunk found by another
+ * thread are skipped: the chunks before the first damaged one are all checked by their ranges,
+ * so the lowest chunk kept is the first damaged chunk of the file.
+ */
+static void verifyRange(void *context, uint32_t worker, const WorkerRange_t *range)
+{
+    VerifyJob_t *job = context;             /* The shared work */
+    uint32_t damaged = 0;                   /* First damaged chunk known by the job */
+    uint64_t offset = 0;                    /* Offset of the chunk in the data */
+    uint64_t length = 0;                    /* Length of the chunk */
+    uint32_t c = 0;                         /* Index for looping through chunks */
+
+    for (c = range->first; c < range->end && c < __atomic_load_n(&job->damaged, __ATOMIC_RELAXED); c++)
+    {
+        offset = (uint64_t)c * SNAPSHOT_CHUNK_SIZE;
+        length = (job->data_size - offset < SNAPSHOT_CHUNK_SIZE) ? job->data_size - offset : SNAPSHOT_CHUNK_SIZE;
+        if (checksumBytes(job->data + offset, length) != getU64(job->table + (size_t)c * 8))
+        {
+            damaged = __atomic_load_n(&job->damaged, __ATOMIC_RELAXED);
+            while (c < damaged
+                   && __atomic_compare_exchange_n(&job->damaged, &damaged, c, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED) == 0)
+            {
+            }
+            return;
+        }
+    }
+}
+
+
+/**
+ * @brief Entry point of the background check of a loaded snapshot.
+ */
+static void* checkSnapshotThread(void *argument)
+{
+    SnapshotCheckJob_t *job = argument;     /* The check */
+
+    job->damaged = verifyChunks(job->bytes, &job->layout, job->thread_count, &job->thread_count);
+    __atomic_store_n(&job->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+
+/**
+ * @brief Waits for the background check, if any, and unmaps its view of the file.
+ */
+static void finishSnapshotCheck()
+{
+    if (check_started == 1)
+    {
+        pthread_join(check_thread, NULL);
+        check_started = 0;
+    }
+    if (check_job.bytes != NULL)
+    {
+        unmapSnapshot(check_job.bytes, check_job.size);
+        check_job.bytes = NULL;
+        check_job.state = (check_job.damaged == SNAPSHOT_NO_CHUNK) ? SNAPSHOT_CHECK_PASSED : SNAPSHOT_CHECK_DAMAGED;
+    }
+}
+
+
+/**
+ * @brief Returns a 64-bit checksum of a block of bytes.
+ *
+ * Four independent lanes each take every fourth 8-byte word (multiply, rotate, multiply), so
+ * the multiplications of consecutive words overlap and the checksum runs at memory speed.
+ */
+static uint64_t checksumBytes(const uint8_t *bytes, uint64_t length)
+{
+    uint64_t lanes[4] = {SNAPSHOT_PRIME_1 + SNAPSHOT_PRIME_2, SNAPSHOT_PRIME_2, 0, (uint64_t)0 - SNAPSHOT_PRIME_1};  /* Running state of each lane */
+    uint64_t word = 0;                      /* Word being added */
+    uint64_t hash = length * SNAPSHOT_PRIME_1;  /* Combined lanes */
+    uint64_t i = 0;                         /* Offset of the next word */
+    uint32_t lane = 0;                      /* Index for looping through lanes */
+
+    for (i = 0; i + 32 <= length; i += 32)
+    {
+        for (lane = 0; lane < 4; lane++)
+        {
+            memcpy(&word, bytes + i + lane * 8, sizeof(word));
+            lanes[lane] += word * SNAPSHOT_PRIME_2;
+            lanes[lane] = ((lanes[lane] << 31) | (lanes[lane] >> 33)) * SNAPSHOT_PRIME_1;
+        }
+    }
+    /* Remaining bytes, the last word padded with zeros */
+    for (lane = 0; i < length; i += 8, lane = (lane + 1) % 4)
+    {
+        word = 0;
+        memcpy(&word, bytes + i, (length - i < 8) ? (size_t)(length - i) : 8);
+        lanes[lane] += word * SNAPSHOT_PRIME_2;
+        lanes[lane] = ((lanes[lane] << 31) | (lanes[lane] >> 33)) * SNAPSHOT_PRIME_1;
+    }
+    for (lane = 0; lane < 4; lane++)
+    {
+        hash = (hash ^ lanes[lane]) * SNAPSHOT_PRIME_1;
+        hash = (hash << 27) | (hash >> 37);
+    }
+    hash ^= hash >> 33;
+    hash *= SNAPSHOT_PRIME_2;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+
+/**
+ * @brief Adds bytes to the data of a snapshot, writing every full chunk.
+ *
+ * @param writer The snapshot being written.
+ * @param data The bytes, or NULL to add zeros.
+ * @param length Number of bytes.
+ * @return 1 on success, 0 if the file could not be written.
+ */
+static uint32_t appendBytes(SnapshotWriter_t *writer, const void *data, uint64_t length)
+{
+    const uint8_t *source = data;           /* Next byte to add */
+    uint32_t part = 0;                      /* Bytes added to the current chunk */
+
+    while (length > 0)
+    {
+        part = SNAPSHOT_CHUNK_SIZE - writer->fill;
+        if (part > length)
+        {
+            part = (uint32_t)length;
+        }
+        if (source != NULL)
+        {
+            memcpy(writer->buffer + writer->fill, source, part);
+            source += part;
+        }
+        else
+        {
+            memset(writer->buffer + writer->fill, 0, part);
+        }
+        writer->fill += part;
+        length -= part;
+        if (writer->fill == SNAPSHOT_CHUNK_SIZE && flushChunk(writer) == 0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+/**
+ * @brief Checksums and writes the chunk being filled.
+ *
+ * @return 1 on success, 0 if the file could not be written.
+ */
+static uint32_t flushChunk(SnapshotWriter_t *writer)
+{
+    writer->checksums[writer->chunk] = checksumBytes(writer->buffer, writer->fill);
+    writer->chunk += 1;
+    if (fwrite(writer->buffer, 1, writer->fill, writer->file) != writer->fill)
+    {
+        return 0;
+    }
+    writer->fill = 0;
+    return 1;
+}
+
+
+/**
+ * @brief Maps a whole file copy-on-write: changes stay in memory and never reach the file.
+ *
+ * A second, read-only view of the same file is mapped for the chunk check: it keeps the bytes
+ * of the file when records are changed through the first view.
+ *
+ * @return MANAGE_OK, MANAGE_ERR_NOT_FOUND if the file cannot be opened, or MANAGE_ERR_IO if it
+ *         is too small or cannot be mapped.
+ */
+static ManageStatus_t mapSnapshot(const char *path, uint8_t **bytes, uint8_t **check_bytes, uint64_t *size)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);    /* The snapshot file */
+    HANDLE mapping = NULL;                  /* File mapping object */
+    LARGE_INTEGER file_size;                /* Size of the file */
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    if (GetFileSizeEx(file, &file_size) == 0 || file_size.QuadPart < SNAPSHOT_HEADER_SIZE
+        || (uint64_t)file_size.QuadPart > (uint64_t)SIZE_MAX)
+    {
+        CloseHandle(file);
+        return MANAGE_ERR_IO;
+    }
+    /* The view keeps the mapping and the file open */
+    mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL)
+    {
+        return MANAGE_ERR_IO;
+    }
+    *bytes = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    *check_bytes = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (*bytes == NULL || *check_bytes == NULL)
+    {
+        if (*bytes != NULL)
+        {
+            UnmapViewOfFile(*bytes);
+        }
+        if (*check_bytes != NULL)
+        {
+            UnmapViewOfFile(*check_bytes);
+        }
+        return MANAGE_ERR_IO;
+    }
+    *size = (uint64_t)file_size.QuadPart;
+    return MANAGE_OK;
+#else
+    int file = open(path, O_RDONLY);        /* The snapshot file */
+    struct stat info;                       /* Size of the file */
+    void *mapped = MAP_FAILED;              /* The mapped file */
+    void *check_mapped = MAP_FAILED;        /* Read-only view of the file */
+
+    if (file < 0)
+    {
+        return MANAGE_ERR_NOT_FOUND;
+    }
+    if (fstat(file, &info) != 0 || info.st_size < (off_t)SNAPSHOT_HEADER_SIZE
+        || (uint64_t)info.st_size > (uint64_t)SIZE_MAX)
+    {
+        close(file);
+        return MANAGE_ERR_IO;
+    }
+    /* The mapping keeps the file open */
+    mapped = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+    check_mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+    if (mapped == MAP_FAILED || check_mapped == MAP_FAILED)
+    {
+        if (mapped != MAP_FAILED)
+        {
+            munmap(mapped, (size_t)info.st_size);
+        }
+        if (check_mapped != MAP_FAILED)
+        {
+            munmap(check_mapped, (size_t)info.st_size);
+        }
+        return MANAGE_ERR_IO;
+    }
+    *bytes = mapped;
+    *check_bytes = check_mapped;
+    *size = (uint64_t)info.st_size;
+    return MANAGE_OK;
+#endif
+}
+
+
+/**
+ * @brief Unmaps a file mapped by mapSnapshot(), dropping the changes made to it.
+ */
+static void unmapSnapshot(uint8_t *bytes, uint64_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(bytes);
+#else
+    munmap(bytes, (size_t)size);
+#endif
+}
+
+
+/**
+ * @brief Renames a file over another one, replacing it in one step.
+ *
+ * @return 1 on success, 0 if the file could not be renamed.
+ */
+static uint32_t replaceFile(const char *from, const char *to)
+{
+#ifdef _WIN32
+    /* rename() does not replace an existing file on Windows */
+    return (MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0) ? 1u : 0u;
+#else
+    return (rename(from, to) == 0) ? 1u : 0u;
+#endif
+}
+
+
+/**
+ * @brief Stores a 32-bit value in little-endian order.
+ */
+static void putU32(uint8_t *bytes, uint32_t value)
+{
+    uint32_t i = 0;                         /* Index for looping through bytes */
+
+    for (i = 0; i < 4; i++)
+    {
+        bytes[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+
+/**
+ * @brief Stores a 64-bit value in little-endian order.
+ */
+static void putU64(uint8_t *bytes, uint64_t value)
+{
+    putU32(bytes, (uint32_t)value);
+    putU32(bytes + 4, (uint32_t)(value >> 32));
+}
+
+
+/**
+ * @brief Reads a little-endian 32-bit value.
+ */
+static uint32_t getU32(const uint8_t *bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+
+/**
+ * @brief Reads a little-endian 64-bit value.
+ */
+static uint64_t getU64(const uint8_t *bytes)
+{
+    return (uint64_t)getU32(bytes) | ((uint64_t)getU32(bytes + 4) << 32);
+} /* EOF */
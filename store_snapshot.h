@@ -0,0 +1,119 @@
+/**
+ * @file store_snapshot.h
+ * @brief This file contains the function prototypes for saving the store to a snapshot and starting from it.
+ *
+ * A snapshot holds the employee and department records exactly as they are laid out in the
+ * record pools, padded to whole slabs. Loading maps the file copy-on-write and hands the
+ * mapped slabs to the store (adoptStoreRecords()), so nothing is parsed or copied. Only the
+ * header and the chunk table are checked before the menu appears; the chunk checksums are
+ * verified by several threads in the background and the result is reported once known (see
+ * getSnapshotCheck()). The ID indexes are built on the first lookup.
+ *
+ * Layout: a header (magic "MESNAP01", record sizes, counts, chunk size, checksums), a table with
+ * the checksum of every SNAPSHOT_CHUNK_SIZE bytes of data, then, from a page-aligned offset, the
+ * department slabs and the employee slabs in store order. Records are written in the byte
+ * order and layout of the program that saved them; a snapshot from another build is rejected.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef STORE_SNAPSHOT_H
+#define STORE_SNAPSHOT_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for ManageStatus_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define SNAPSHOT_DEFAULT_PATH "employees.snap"  /* Snapshot loaded at startup and written from the menu */
+#define SNAPSHOT_CHUNK_SIZE (1u << 20)          /* Bytes of data covered by one checksum */
+#define SNAPSHOT_NO_CHUNK 0xFFFFFFFFu           /* No damaged chunk */
+
+/**
+ * @brief Outcome of loadStoreSnapshot() and of the check of its chunks.
+ */
+typedef struct SnapshotReport {
+    uint32_t employee_count;                /* Employees loaded */
+    uint32_t department_count;              /* Departments loaded */
+    uint64_t file_bytes;                    /* Size of the snapshot file */
+    uint32_t chunk_count;                   /* Number of checksummed chunks */
+    uint32_t thread_count;                  /* Threads that verified the chunks, 0 until the check ends */
+    uint32_t damaged_chunk;                 /* First chunk whose checksum differs, SNAPSHOT_NO_CHUNK if none */
+} SnapshotReport_t;
+
+/**
+ * @brief State of the check of the chunks of the last loaded snapshot.
+ */
+typedef enum SnapshotCheck {
+    SNAPSHOT_CHECK_NONE = 0,                /* No snapshot was loaded */
+    SNAPSHOT_CHECK_RUNNING,                 /* The chunks are being checked */
+    SNAPSHOT_CHECK_PASSED,                  /* Every chunk matches its checksum */
+    SNAPSHOT_CHECK_DAMAGED                  /* A chunk differs, see SnapshotReport_t.damaged_chunk */
+} SnapshotCheck_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Writes every stored employee and department to a snapshot file.
+ *
+ * The store selected by the calling thread is written to "<path>.tmp", which then replaces
+ * path, so the old snapshot stays whole if the save fails. If a store uses the records of a
+ * loaded snapshot, they are copied into memory first and the snapshot is unmapped.
+ *
+ * @param path The file to write.
+ * @return MANAGE_OK, MANAGE_ERR_IO if the file cannot be written or the store holds the
+ *         records of a snapshot found damaged, or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t saveStoreSnapshot(const char *path);
+
+/**
+ * @brief Starts the empty store from a snapshot file.
+ *
+ * @param path The file written by saveStoreSnapshot().
+ * @param thread_count Number of threads verifying the checksums, 0 for one per processor.
+ * @param report Receives what was loaded (may be NULL); the chunks are not checked yet.
+ * The store selected by the calling thread is started. It uses the mapped records until the
+ * next saveStoreSnapshot() and must not be destroyed before. The chunks are checked in the
+ * background, see getSnapshotCheck().
+ *
+ * @return MANAGE_OK, MANAGE_ERR_NOT_FOUND if the file cannot be opened, MANAGE_ERR_IO if its
+ *         header is damaged or it was not written by this program, MANAGE_ERR_INVALID_ARGUMENT if the
+ *         store is not empty or a snapshot is already loaded, or MANAGE_ERR_NO_MEMORY. On
+ *         failure the store is unchanged.
+ */
+ManageStatus_t loadStoreSnapshot(const char *path, uint32_t thread_count, SnapshotReport_t *report);
+
+/**
+ * @brief Returns the state of the check of the chunks of the last loaded snapshot.
+ *
+ * @param wait 1 to wait for the check to end, 0 to return at once.
+ * @param report Receives the result (may be NULL); damaged_chunk and thread_count are set
+ *        once the check has ended.
+ * @return The state of the check.
+ */
+SnapshotCheck_t getSnapshotCheck(uint32_t wait, SnapshotReport_t *report);
+
+/**
+ * @brief Tells the user the result of the snapshot check once it is known. Called from the menu loop.
+ */
+void reportSnapshotCheck();
+
+/**
+ * @brief Loads SNAPSHOT_DEFAULT_PATH if it exists and tells the user what happened.
+ */
+void loadStartupSnapshot();
+
+/**
+ * @brief Saves the default store to SNAPSHOT_DEFAULT_PATH from the menu.
+ *
+ * Only the default store is loaded at startup, so nothing is saved while another company is selected.
+ */
+void saveDataSnapshot();
+
+#endif /* STORE_SNAPSHOT_H */
@@ -0,0 +1,413 @@
+/**
+ * @file tenant_store.c
+ * @brief This file contains the implementation of the companies (tenants) served by one process.
+ *
+ * Each company is one range of the worker pool, its group being its position. Every part of
+ * it that a thread calculates adds its totals to the totals of the company with atomic
+ * additions; sums of whole numbers do not depend on the order, so the totals are the same for
+ * any number of threads.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdio.h>              /* Include standard input and output library for printf, fgets */
+#include <stdlib.h>             /* Include standard library for malloc, calloc, free */
+#include <string.h>             /* Include string manipulation library for memset, strcmp, strncpy */
+#include "tenant_store.h"       /* Include header file */
+#include "input_handler.h"      /* Include input handler header file for the prompts */
+#include "perf_stats.h"         /* Include instrumentation header file for measuring hot operations */
+#include "worker_pool.h"        /* Include worker pool header file for the payroll threads */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define TENANT_PATH_LENGTH 260              /* Size of a rules file name entered by the user */
+
+/**
+ * @brief Work shared by the payroll threads.
+ */
+typedef struct TenantJob {
+    const Tenant_t *tenants;                /* The companies */
+    TenantPayroll_t *results;               /* Totals of each company, added with atomic additions */
+} TenantJob_t;
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static void calculateRange(void *context, uint32_t worker, const WorkerRange_t *range);
+static void ensureDefaultTenant();
+static void printTenants();
+static void addTenant();
+static void chooseTenant();
+static void deleteTenant();
+static void printTenantPayrolls();
+
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static Tenant_t menu_tenants[TENANT_MAX];   /* Companies of the menu, the default one first */
+static uint32_t menu_tenant_count = 0;      /* Number of companies of the menu, 0 before the first use */
+static uint32_t selected_tenant = 0;        /* Company selected by the menu */
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Creates a company with an empty store.
+ */
+ManageStatus_t tenantCreate(Tenant_t *tenant, const int8_t *name, const PayrollRules_t *rules)
+{
+    memset(tenant, 0, sizeof(*tenant));
+    if (rules == NULL)
+    {
+        payrollRulesDefault(&tenant->rules);
+    }
+    else if (payrollRulesCheck(rules) != MANAGE_OK)
+    {
+        return MANAGE_ERR_INVALID_ARGUMENT;
+    }
+    else
+    {
+        tenant->rules = *rules;
+    }
+    tenant->store = createEmployeeStore();
+    if (tenant->store == NULL)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    strncpy((char*)tenant->name, (const char*)name, TENANT_NAME_LENGTH - 1);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Frees the store of a company and its menu data.
+ */
+void tenantDestroy(Tenant_t *tenant)
+{
+    destroyEmployeeStore(tenant->store);
+    tenant->store = NULL;
+    if (tenant->organization != NULL)
+    {
+        orgHierarchyFree(tenant->organization);
+        free(tenant->organization);
+        tenant->organization = NULL;
+    }
+    if (tenant->history != NULL)
+    {
+        payrollHistoryFree(tenant->history);
+        free(tenant->history);
+        tenant->history = NULL;
+    }
+}
+
+
+/**
+ * @brief Returns the company selected by the menu, the default one until another is selected.
+ */
+Tenant_t* getSelectedTenant()
+{
+    ensureDefaultTenant();
+    return &menu_tenants[selected_tenant];
+}
+
+
+/**
+ * @brief Calculates the payroll of many companies concurrently.
+ *
+ * Each company is one range of the worker pool, which splits and steals the ranges while the
+ * threads work. The calling thread is one of the threads.
+ */
+ManageStatus_t runTenantPayrolls(const Tenant_t *tenants, uint32_t tenant_count, uint32_t thread_count,
+                                 TenantPayroll_t *results)
+{
+    TenantJob_t job;                        /* Work shared by the threads */
+    WorkerRange_t *ranges = NULL;           /* Whole company of each range */
+    EmployeeStore_t *previous = NULL;       /* Store selected by the calling thread */
+    ManageStatus_t status = MANAGE_OK;      /* Result of the pool */
+    uint32_t i = 0;                         /* Index for looping through companies */
+    PERF_START(perf_start);                 /* Start time of the payroll */
+
+    for (i = 0; i < tenant_count; i++)
+    {
+        if (payrollRulesCheck(&tenants[i].rules) != MANAGE_OK)
+        {
+            return MANAGE_ERR_INVALID_ARGUMENT;
+        }
+    }
+    memset(results, 0, (size_t)tenant_count * sizeof(*results));
+    ranges = malloc(((size_t)tenant_count + 1) * sizeof(*ranges));
+    if (ranges == NULL)
+    {
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    previous = getActiveEmployeeStore();
+    for (i = 0; i < tenant_count; i++)
+    {
+        selectEmployeeStore(tenants[i].store);
+        ranges[i].group = i;
+        ranges[i].first = 0;
+        ranges[i].end = getTotalEmployees();
+    }
+    selectEmployeeStore(previous);
+
+    job.tenants = tenants;
+    job.results = results;
+    status = runWorkerPool(ranges, tenant_count, TENANT_CHUNK, thread_count, calculateRange, &job);
+    free(ranges);
+    PERF_STOP(PERF_OP_TENANT_PAYROLL, perf_start);
+    return status;
+}
+
+
+/**
+ * @brief Lists the companies and prompts the user to add, select or delete one, or to run
+ *        the payroll of all of them.
+ */
+void manageTenants()
+{
+    int8_t choice = 0;                      /* Action chosen by the user */
+
+    ensureDefaultTenant();
+    printTenants();
+    printf("Enter 'a' to add a company, 's' to select one, 'd' to delete one, 'p' to run the payroll\n"
+           "of every company, or any other key to go back: ");
+    choice = getSingleCharInput();
+    switch (choice)
+    {
+        case 'a':
+            addTenant();
+            break;
+        case 's':
+            chooseTenant();
+            break;
+        case 'd':
+            deleteTenant();
+            break;
+        case 'p':
+            printTenantPayrolls();
+            break;
+        default:
+            break;
+    }
+}
+
+
+/**
+ * @brief Selects the default store again and frees the companies added from the menu and the
+ *        menu data of every company.
+ */
+void stopTenants()
+{
+    uint32_t i = 0;                         /* Index for looping through companies */
+
+    selectEmployeeStore(NULL);
+    /* The default company has no store of its own, only its menu data is freed */
+    for (i = 0; i < menu_tenant_count; i++)
+    {
+        tenantDestroy(&menu_tenants[i]);
+    }
+    menu_tenant_count = 0;
+    selected_tenant = 0;
+}
+
+
+/**
+ * @brief Calculates the salaries of a range of employees and adds them to the totals of the company.
+ */
+static void calculateRange(void *context, uint32_t worker, const WorkerRange_t *range)
+{
+    TenantJob_t *job = context;             /* The shared work */
+    const Tenant_t *tenant = &job->tenants[range->group];   /* Company of the range */
+    TenantPayroll_t *result = &job->results[range->group];  /* Totals of the company */
+    EmployeeStore_t *previous = selectEmployeeStore(tenant->store);    /* Store selected before */
+    const Employee_t *employee = NULL;      /* Employee being calculated */
+    SalaryBreakdown_t breakdown;            /* Salary of the employee */
+    TenantPayroll_t part;                   /* Totals of the range */
+    uint32_t i = 0;                         /* Index for looping through employees */
+
+    memset(&part, 0, sizeof(part));
+    for (i = range->first; i < range->end; i++)
+    {
+        employee = getEmployeeAt(i);
+        calculateSalaryWithRules(employee, findDepartment(employee->department_id), &tenant->rules, &breakdown);
+        part.total_gross += breakdown.total_income;
+        part.total_insurance += breakdown.insurance;
+        part.total_tax += breakdown.tax;
+        part.total_net += breakdown.actual_salary;
+    }
+    selectEmployeeStore(previous);
+
+    __atomic_add_fetch(&result->employees, range->end - range->first, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&result->total_gross, part.total_gross, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&result->total_insurance, part.total_insurance, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&result->total_tax, part.total_tax, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&result->total_net, part.total_net, __ATOMIC_RELAXED);
+}
+
+
+/**
+ * @brief Makes the default store the first company of the menu.
+ */
+static void ensureDefaultTenant()
+{
+    if (menu_tenant_count == 0)
+    {
+        memset(&menu_tenants[0], 0, sizeof(menu_tenants[0]));
+        strcpy((char*)menu_tenants[0].name, "(default)");
+        payrollRulesDefault(&menu_tenants[0].rules);
+        menu_tenant_count = 1;
+        selected_tenant = 0;
+    }
+}
+
+
+/**
+ * @brief Prints the companies of the menu with their number of employees and departments.
+ */
+static void printTenants()
+{
+    EmployeeStore_t *previous = getActiveEmployeeStore();  /* Store selected by the menu */
+    uint32_t i = 0;                         /* Index for looping through companies */
+
+    printf("\nCompanies (* = selected):\n");
+    for (i = 0; i < menu_tenant_count; i++)
+    {
+        selectEmployeeStore(menu_tenants[i].store);
+        printf("%c %2u. %-32s %u employees, %u departments, rules \"%s\"\n", (i == selected_tenant) ? '*' : ' ',
+               i, menu_tenants[i].name, getTotalEmployees(), getTotalDepartments(), menu_tenants[i].rules.name);
+    }
+    selectEmployeeStore(previous);
+}
+
+
+/**
+ * @brief Prompts the user for a company code and its rules file and adds the company.
+ */
+static void addTenant()
+{
+    int8_t name[TENANT_NAME_LENGTH];        /* Code of the company entered by the user */
+    char path[TENANT_PATH_LENGTH];          /* Rules file entered by the user */
+    PayrollRules_t rules;                   /* Rules read from the file */
+    uint32_t count = 0;                     /* Number of rule sets read */
+    uint64_t error_line = 0;                /* Line of the first invalid rule set */
+    ManageStatus_t status = MANAGE_OK;      /* Result of reading the rules and creating the company */
+    uint32_t i = 0;                         /* Index for looping through companies */
+
+    if (menu_tenant_count == TENANT_MAX)
+    {
+        printf("At most %u companies are allowed!!!\n", TENANT_MAX);
+        return;
+    }
+    promptIdInput((const int8_t*)"Enter company code: ", name, sizeof(name));
+    for (i = 0; i < menu_tenant_count; i++)
+    {
+        if (strcmp((const char*)menu_tenants[i].name, (const char*)name) == 0)
+        {
+            printf("Company %s already exists!!!\n", name);
+            return;
+        }
+    }
+
+    printf("Enter payroll rules file, one scenario line (or press Enter for the current rules): ");
+    fflush(stdin);
+    if (fgets(path, sizeof(path), stdin) == NULL)
+    {
+        return;
+    }
+    /* Remove newline character, spaces are allowed in file names */
+    path[strcspn(path, "\r\n")] = '\0';
+    if (path[0] != '\0')
+    {
+        status = loadPayrollScenarios(path, &rules, 1, &count, &error_line);
+        if (status == MANAGE_ERR_IO)
+        {
+            printf("Cannot read file %s\n", path);
+            return;
+        }
+        if (status != MANAGE_OK || count == 0)
+        {
+            printf("The file must hold exactly one valid scenario line!!!\n");
+            return;
+        }
+    }
+
+    status = tenantCreate(&menu_tenants[menu_tenant_count], name, (path[0] != '\0') ? &rules : NULL);
+    if (status != MANAGE_OK)
+    {
+        printf("Not enough memory to add the company!!!\n");
+        return;
+    }
+    menu_tenant_count += 1;
+    printf("Added company %s, select it to add its employees.\n", name);
+}
+
+
+/**
+ * @brief Prompts the user for a company and makes the menu work on it.
+ */
+static void chooseTenant()
+{
+    uint32_t index = (uint32_t)promptUnsignedInput((const int8_t*)"Enter company number: ", menu_tenant_count - 1);
+
+    selectEmployeeStore(menu_tenants[index].store);
+    selected_tenant = index;
+    printf("The menu now works on company %s.\n", menu_tenants[index].name);
+}
+
+
+/**
+ * @brief Prompts the user for a company and deletes it with its employees and departments.
+ */
+static void deleteTenant()
+{
+    uint32_t index = (uint32_t)promptUnsignedInput((const int8_t*)"Enter company number: ", menu_tenant_count - 1);
+
+    if (index == 0)
+    {
+        printf("The default company cannot be deleted!!!\n");
+        return;
+    }
+    if (index == selected_tenant)
+    {
+        printf("Select another company before deleting this one!!!\n");
+        return;
+    }
+    printf("Deleted company %s.\n", menu_tenants[index].name);
+    tenantDestroy(&menu_tenants[index]);
+    memmove(&menu_tenants[index], &menu_tenants[index + 1], (menu_tenant_count - index - 1) * sizeof(menu_tenants[0]));
+    menu_tenant_count -= 1;
+    if (selected_tenant > index)
+    {
+        selected_tenant -= 1;
+    }
+}
+
+
+/**
+ * @brief Runs the payroll of every company of the menu and prints the totals of each.
+ */
+static void printTenantPayrolls()
+{
+    TenantPayroll_t results[TENANT_MAX];    /* Totals of each company */
+    uint32_t i = 0;                         /* Index for looping through companies */
+
+    if (runTenantPayrolls(menu_tenants, menu_tenant_count, 0, results) != MANAGE_OK)
+    {
+        printf("Not enough memory to run the payroll!!!\n");
+        return;
+    }
+    for (i = 0; i < menu_tenant_count; i++)
+    {
+        printf("\n---- %s (rules \"%s\") ----\n", menu_tenants[i].name, menu_tenants[i].rules.name);
+        printf("Employees: %s\n", formatNumberWithCommas(results[i].employees));
+        printf("Gross income: %s (VND)\n", formatNumberWithCommas(results[i].total_gross));
+        printf("Insurance: %s (VND)\n", formatNumberWithCommas(results[i].total_insurance));
+        printf("Tax: %s (VND)\n", formatNumberWithCommas(results[i].total_tax));
+        printf("Net salary: %s (VND)\n", formatNumberWithCommas(results[i].total_net));
+    }
+} /* EOF */
@@ -0,0 +1,112 @@
+/**
+ * @file tenant_store.h
+ * @brief This file contains the function prototypes of the companies (tenants) served by one process.
+ *
+ * Each company has its own employee store (see createEmployeeStore()), with its own department
+ * index, and its own payroll rules, so many companies are kept in one process instead of one
+ * process each. The menu works on the company selected with selectEmployeeStore(), and the
+ * organization and payroll history menus keep their data per company as well.
+ *
+ * runTenantPayrolls() calculates the payroll of many companies at once on the worker pool (see
+ * worker_pool.h). Each company is one range of employees, split into ranges of at most
+ * TENANT_CHUNK employees and stolen by idle threads, so a large company is shared by all
+ * threads while small ones are handled whole, without any planning.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef TENANT_STORE_H
+#define TENANT_STORE_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for EmployeeStore_t and ManageStatus_t */
+#include "payroll_simulation.h" /* Include payroll simulation header file for PayrollRules_t */
+#include "org_hierarchy.h"      /* Include organization hierarchy header file for OrgHierarchy_t */
+#include "payroll_history.h"    /* Include payroll history header file for PayrollHistory_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define TENANT_NAME_LENGTH 32               /* Size of a company name */
+#define TENANT_MAX 64                       /* Largest number of companies in the menu, the default one included */
+#define TENANT_CHUNK 4096u                  /* Largest range of employees calculated without splitting it */
+
+/**
+ * @brief A company: its employees and departments and its payroll rules.
+ */
+typedef struct Tenant {
+    int8_t name[TENANT_NAME_LENGTH];        /* Name of the company */
+    EmployeeStore_t *store;                 /* Employees and departments, NULL for the default store */
+    PayrollRules_t rules;                   /* Rules the payroll of the company is calculated with */
+    OrgHierarchy_t *organization;           /* Hierarchy used by the menu, NULL until it is first opened */
+    PayrollHistory_t *history;              /* Payroll history used by the menu, NULL until it is first opened */
+} Tenant_t;
+
+/**
+ * @brief Payroll totals of one company.
+ */
+typedef struct TenantPayroll {
+    uint64_t employees;                     /* Number of employees paid */
+    uint64_t total_gross;                   /* Sum of the gross incomes */
+    uint64_t total_insurance;               /* Sum of the insurance deductions */
+    uint64_t total_tax;                     /* Sum of the personal income taxes */
+    uint64_t total_net;                     /* Sum of the net salaries */
+} TenantPayroll_t;
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Creates a company with an empty store.
+ *
+ * @param tenant Receives the company.
+ * @param name Name of the company, cut to TENANT_NAME_LENGTH - 1 bytes.
+ * @param rules Payroll rules of the company, NULL for payrollRulesDefault().
+ * @return MANAGE_OK, MANAGE_ERR_INVALID_ARGUMENT if the rules fail payrollRulesCheck(),
+ *         or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t tenantCreate(Tenant_t *tenant, const int8_t *name, const PayrollRules_t *rules);
+
+/**
+ * @brief Frees the store of a company and its menu data; no thread may have it selected.
+ */
+void tenantDestroy(Tenant_t *tenant);
+
+/**
+ * @brief Returns the company selected by the menu, the default one until another is selected.
+ */
+Tenant_t* getSelectedTenant();
+
+/**
+ * @brief Calculates the payroll of many companies concurrently.
+ *
+ * The stores must not change while the payroll runs. The totals of a company do not depend
+ * on the number of threads.
+ *
+ * @param tenants The companies.
+ * @param tenant_count Number of companies.
+ * @param thread_count Number of threads, 0 to use one per processor.
+ * @param results Receives the totals of each company, in company order.
+ * @return MANAGE_OK, MANAGE_ERR_INVALID_ARGUMENT if the rules of a company fail
+ *         payrollRulesCheck(), or MANAGE_ERR_NO_MEMORY.
+ */
+ManageStatus_t runTenantPayrolls(const Tenant_t *tenants, uint32_t tenant_count, uint32_t thread_count,
+                                 TenantPayroll_t *results);
+
+/**
+ * @brief Lists the companies and prompts the user to add, select or delete one, or to run
+ *        the payroll of all of them.
+ */
+void manageTenants();
+
+/**
+ * @brief Selects the default store again and frees the companies added from the menu and the
+ *        menu data of every company. Called when the program exits.
+ */
+void stopTenants();
+
+#endif /* TENANT_STORE_H */
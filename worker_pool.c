@@ -0,0 +1,323 @@
+/**
+ * @file worker_pool.c
+ * @brief This file contains the implementation of the work-stealing pool that runs ranges of work on many threads.
+ *
+ * Queues are short arrays guarded by a mutex each: a thread locks a queue once per range it
+ * takes or queues, that is once per chunk at most, so the locks are rarely contended. The
+ * threads are started for each run and joined before it returns, so no thread is left behind
+ * between runs and nothing needs to be shut down when the program exits.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#include <stdlib.h>             /* Include standard library for malloc, calloc, free */
+#include <pthread.h>            /* Include POSIX threads library for the pool threads */
+#include <sched.h>              /* Include scheduling library for sched_yield */
+#include "worker_pool.h"        /* Include header file */
+#include "input_handler.h"      /* Include input handler header file for getProcessorCount */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define WORKER_QUEUE_SPARE 64u              /* Room of a queue for split ranges, above its seeded ranges */
+
+/**
+ * @brief Double-ended queue of ranges of one thread.
+ */
+typedef struct WorkerQueue {
+    pthread_mutex_t lock;                   /* Guards every field below */
+    WorkerRange_t *ranges;                  /* Ring of ranges */
+    uint32_t capacity;                      /* Number of ranges the ring can hold */
+    uint32_t oldest;                        /* Position of the oldest range, taken by other threads */
+    uint32_t count;                         /* Number of ranges queued */
+} WorkerQueue_t;
+
+/**
+ * @brief Work shared by the threads of a run.
+ */
+typedef struct WorkerJob {
+    WorkerRangeFn_t work;                   /* Handles a range */
+    void *context;                          /* Passed to work */
+    uint32_t chunk;                         /* Longest range handled without splitting it */
+    WorkerQueue_t *queues;                  /* Queue of each thread */
+    uint32_t queue_count;                   /* Number of threads and queues */
+    uint64_t remaining;                     /* Positions not handled yet, decreased with an atomic subtract */
+    EmployeeStore_t *store;                 /* Store of the thread that started the run */
+} WorkerJob_t;
+
+/**
+ * @brief One thread of a run.
+ */
+typedef struct Worker {
+    WorkerJob_t *job;                       /* The shared work */
+    uint32_t index;                         /* Position of the queue of this thread */
+} Worker_t;
+
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static void* workerThread(void *argument);
+static void runWorker(const Worker_t *worker);
+static uint32_t takeRange(WorkerJob_t *job, uint32_t index, WorkerRange_t *range);
+static uint32_t pushRange(WorkerQueue_t *queue, const WorkerRange_t *range);
+static uint32_t popNewestRange(WorkerQueue_t *queue, WorkerRange_t *range);
+static uint32_t popOldestRange(WorkerQueue_t *queue, WorkerRange_t *range);
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * @brief Returns the number of threads runWorkerPool() uses for an amount of work.
+ */
+uint32_t workerPoolThreadCount(uint64_t work, uint32_t chunk, uint32_t thread_count)
+{
+    if (thread_count == 0)
+    {
+        thread_count = getProcessorCount();
+    }
+    if (thread_count > WORKER_POOL_MAX_THREADS)
+    {
+        thread_count = WORKER_POOL_MAX_THREADS;
+    }
+    if (chunk > 0 && thread_count > work / chunk + 1)
+    {
+        thread_count = (uint32_t)(work / chunk + 1);
+    }
+    return (thread_count > 0) ? thread_count : 1;
+}
+
+
+/**
+ * @brief Handles ranges of work on a pool of threads and returns when all are handled.
+ *
+ * The ranges are dealt to the queues in turn; the threads split and steal them while they work
+ * (see runWorker()).
+ */
+ManageStatus_t runWorkerPool(const WorkerRange_t *ranges, uint32_t range_count, uint32_t chunk, uint32_t thread_count,
+                             WorkerRangeFn_t work, void *context)
+{
+    WorkerJob_t job;                        /* Work shared by the threads */
+    Worker_t workers[WORKER_POOL_MAX_THREADS];     /* Each thread */
+    pthread_t threads[WORKER_POOL_MAX_THREADS];    /* Threads started */
+    uint8_t started[WORKER_POOL_MAX_THREADS];      /* Flag set for each thread that was started */
+    WorkerRange_t *buffer = NULL;           /* Ranges of all queues */
+    uint32_t per_queue = 0;                 /* Number of ranges a queue can hold */
+    uint32_t seeded = 0;                    /* Number of ranges queued */
+    uint32_t i = 0;                         /* Index for looping through ranges */
+    uint32_t t = 0;                         /* Index for looping through threads */
+
+    job.work = work;
+    job.context = context;
+    job.chunk = (chunk > 0) ? chunk : 1;
+    job.remaining = 0;
+    job.store = getActiveEmployeeStore();
+    for (i = 0; i < range_count; i++)
+    {
+        job.remaining += (ranges[i].end > ranges[i].first) ? ranges[i].end - ranges[i].first : 0;
+    }
+    if (job.remaining == 0)
+    {
+        return MANAGE_OK;
+    }
+    thread_count = workerPoolThreadCount(job.remaining, job.chunk, thread_count);
+
+    per_queue = (range_count + thread_count - 1) / thread_count + WORKER_QUEUE_SPARE;
+    job.queue_count = thread_count;
+    job.queues = calloc(thread_count, sizeof(*job.queues));
+    buffer = malloc((size_t)thread_count * per_queue * sizeof(*buffer));
+    if (job.queues == NULL || buffer == NULL)
+    {
+        free(job.queues);
+        free(buffer);
+        return MANAGE_ERR_NO_MEMORY;
+    }
+    for (t = 0; t < thread_count; t++)
+    {
+        pthread_mutex_init(&job.queues[t].lock, NULL);
+        job.queues[t].ranges = &buffer[(size_t)t * per_queue];
+        job.queues[t].capacity = per_queue;
+    }
+    for (i = 0; i < range_count; i++)
+    {
+        if (ranges[i].end > ranges[i].first)
+        {
+            pushRange(&job.queues[seeded % thread_count], &ranges[i]);
+            seeded += 1;
+        }
+    }
+
+    for (t = 0; t < thread_count; t++)
+    {
+        workers[t].job = &job;
+        workers[t].index = t;
+        started[t] = (t > 0 && pthread_create(&threads[t], NULL, workerThread, &workers[t]) == 0) ? 1 : 0;
+    }
+    /* Ranges of threads that could not start are stolen, so the calling thread finishes the work */
+    for (t = 0; t < thread_count; t++)
+    {
+        if (started[t] == 0)
+        {
+            runWorker(&workers[t]);
+        }
+    }
+    for (t = 0; t < thread_count; t++)
+    {
+        if (started[t] == 1)
+        {
+            pthread_join(threads[t], NULL);
+        }
+    }
+    /* Only once every thread stopped: a thread still running may look into any queue */
+    for (t = 0; t < thread_count; t++)
+    {
+        pthread_mutex_destroy(&job.queues[t].lock);
+    }
+
+    free(job.queues);
+    free(buffer);
+    return MANAGE_OK;
+}
+
+
+/**
+ * @brief Entry point of a pool thread.
+ */
+static void* workerThread(void *argument)
+{
+    selectEmployeeStore(((const Worker_t*)argument)->job->store);
+    runWorker((const Worker_t*)argument);
+    return NULL;
+}
+
+
+/**
+ * @brief Handles ranges until every position of every range is handled.
+ *
+ * A range longer than the chunk is split: the upper half goes back to the queue of this
+ * thread, where other threads can steal it, and the lower half is split again. Splitting
+ * stops early if the queue is full; the range is then handled whole.
+ */
+static void runWorker(const Worker_t *worker)
+{
+    WorkerJob_t *job = worker->job;         /* The shared work */
+    WorkerQueue_t *queue = &job->queues[worker->index];    /* Queue of this thread */
+    WorkerRange_t range;                    /* Range being handled */
+    WorkerRange_t upper;                    /* Upper half of a split range */
+
+    for (;;)
+    {
+        if (takeRange(job, worker->index, &range) == 0)
+        {
+            if (__atomic_load_n(&job->remaining, __ATOMIC_ACQUIRE) == 0)
+            {
+                break;
+            }
+            /* Other threads still hold ranges they may split */
+            sched_yield();
+            continue;
+        }
+        while (range.end - range.first > job->chunk)
+        {
+            upper = range;
+            upper.first = range.first + (range.end - range.first) / 2;
+            if (pushRange(queue, &upper) == 0)
+            {
+                break;
+            }
+            range.end = upper.first;
+        }
+        job->work(job->context, worker->index, &range);
+        __atomic_sub_fetch(&job->remaining, range.end - range.first, __ATOMIC_RELEASE);
+    }
+}
+
+
+/**
+ * @brief Takes the newest range of a thread's own queue, or else the oldest range of another queue.
+ *
+ * @return 1 if a range was taken, 0 if every queue is empty.
+ */
+static uint32_t takeRange(WorkerJob_t *job, uint32_t index, WorkerRange_t *range)
+{
+    uint32_t t = 0;                         /* Index for looping through the other queues */
+
+    if (popNewestRange(&job->queues[index], range) == 1)
+    {
+        return 1;
+    }
+    for (t = 1; t < job->queue_count; t++)
+    {
+        if (popOldestRange(&job->queues[(index + t) % job->queue_count], range) == 1)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Queues a range as the newest one of a queue.
+ *
+ * @return 1 if the range was queued, 0 if the queue is full.
+ */
+static uint32_t pushRange(WorkerQueue_t *queue, const WorkerRange_t *range)
+{
+    uint32_t pushed = 0;                    /* Flag set if the range was queued */
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count < queue->capacity)
+    {
+        queue->ranges[(queue->oldest + queue->count) % queue->capacity] = *range;
+        queue->count += 1;
+        pushed = 1;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return pushed;
+}
+
+
+/**
+ * @brief Takes the newest range of a queue, the one its thread queued last.
+ *
+ * @return 1 if a range was taken, 0 if the queue is empty.
+ */
+static uint32_t popNewestRange(WorkerQueue_t *queue, WorkerRange_t *range)
+{
+    uint32_t taken = 0;                     /* Flag set if a range was taken */
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count > 0)
+    {
+        queue->count -= 1;
+        *range = queue->ranges[(queue->oldest + queue->count) % queue->capacity];
+        taken = 1;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return taken;
+}
+
+
+/**
+ * @brief Takes the oldest range of a queue, which is also its largest one.
+ *
+ * @return 1 if a range was taken, 0 if the queue is empty.
+ */
+static uint32_t popOldestRange(WorkerQueue_t *queue, WorkerRange_t *range)
+{
+    uint32_t taken = 0;                     /* Flag set if a range was taken */
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count > 0)
+    {
+        *range = queue->ranges[queue->oldest];
+        queue->oldest = (queue->oldest + 1) % queue->capacity;
+        queue->count -= 1;
+        taken = 1;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return taken;
+} /* EOF */
@@ -0,0 +1,82 @@
+/**
+ * @file worker_pool.h
+ * @brief This file contains the function prototypes of the work-stealing pool that runs ranges of work on many threads.
+ *
+ * Work is given as ranges of positions (employees of a store, chunks of a file, ...); a group
+ * number tells ranges of different sources apart, such as the companies of runTenantPayrolls().
+ * Every thread has a double-ended queue of ranges, seeded with the given ranges in turn. A
+ * thread takes the newest range of its own queue and splits it in halves, keeping the lower
+ * half and queueing the upper one, until it is at most one chunk long; a thread whose queue is
+ * empty steals the oldest, thus largest, range of another queue. A large range is so shared by
+ * all threads while small ones are handled whole, and a thread slowed down (by the file
+ * system, ...) does not hold the others back.
+ *
+ * The calling thread is one of the threads, and the ranges of a thread that cannot be started
+ * are stolen by the others. Every thread works on the store selected by the calling thread.
+ *
+ * @author Viet Ha Nguyen
+ * @date 3/30/2024
+ * @bug No known bugs
+ */
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+/*******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+#include <stdint.h>             /* Include standard integer types library for fixed-width integers like int8_t, uint64_t, etc. */
+#include "manage_employee.h"    /* Include manage employee header file for ManageStatus_t */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define WORKER_POOL_MAX_THREADS 64          /* Largest number of threads of a pool */
+
+/**
+ * @brief A range of work.
+ */
+typedef struct WorkerRange {
+    uint32_t group;                         /* Source of the range, chosen by the caller */
+    uint32_t first;                         /* First position of the range */
+    uint32_t end;                           /* Position after the last one of the range */
+} WorkerRange_t;
+
+/**
+ * @brief Handles a range of work.
+ *
+ * @param context Passed to runWorkerPool().
+ * @param worker Index of the thread, below the thread count, to keep state per thread.
+ * @param range The range, at most one chunk long unless the queue of the thread was full.
+ */
+typedef void (*WorkerRangeFn_t)(void *context, uint32_t worker, const WorkerRange_t *range);
+
+/*******************************************************************************
+ * Prototype
+ ******************************************************************************/
+/**
+ * @brief Returns the number of threads runWorkerPool() uses for an amount of work.
+ *
+ * More threads than chunks would only wait, so the number is at most work / chunk + 1.
+ *
+ * @param work Total length of the ranges.
+ * @param chunk Longest range handled without splitting it.
+ * @param thread_count Number of threads asked for, 0 to use one per processor.
+ * @return The number of threads, 1 to WORKER_POOL_MAX_THREADS.
+ */
+uint32_t workerPoolThreadCount(uint64_t work, uint32_t chunk, uint32_t thread_count);
+
+/**
+ * @brief Handles ranges of work on a pool of threads and returns when all are handled.
+ *
+ * @param ranges The ranges; empty ranges are skipped.
+ * @param range_count Number of ranges.
+ * @param chunk Longest range handled without splitting it, at least 1.
+ * @param thread_count Number of threads, see workerPoolThreadCount().
+ * @param work Called for every range, on any of the threads.
+ * @param context Passed to work.
+ * @return MANAGE_OK, or MANAGE_ERR_NO_MEMORY if the queues cannot be allocated; nothing is handled then.
+ */
+ManageStatus_t runWorkerPool(const WorkerRange_t *ranges, uint32_t range_count, uint32_t chunk, uint32_t thread_count,
+                             WorkerRangeFn_t work, void *context);
+
+#endif /* WORKER_POOL_H */